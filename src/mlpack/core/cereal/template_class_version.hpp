@@ -0,0 +1,56 @@
+/**
+ * @file core/cereal/template_class_version.hpp
+ *
+ * Define CEREAL_TEMPLATE_CLASS_VERSION, which sets the version of a class
+ * template in the same way as CEREAL_CLASS_VERSION does for classes.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_CEREAL_TEMPLATE_CLASS_VERSION_HPP
+#define MLPACK_CORE_CEREAL_TEMPLATE_CLASS_VERSION_HPP
+
+#include <cereal/cereal.hpp>
+#include <typeindex>
+
+//! Remove the parentheses around a macro argument that holds commas.
+#define MLPACK_CEREAL_REMOVE_PARENS(...) __VA_ARGS__
+
+/**
+ * Set the version of every instantiation of a class template.  The signature
+ * and the type must be given in parentheses, since they may hold commas; for
+ * instance:
+ *
+ * @code
+ * CEREAL_TEMPLATE_CLASS_VERSION(
+ *     (template<typename SortPolicy, typename MatType>),
+ *     (LSHSearch<SortPolicy, MatType>), (1));
+ * @endcode
+ *
+ * Archives written before a class had a version are loaded with version 0.
+ */
+#define CEREAL_TEMPLATE_CLASS_VERSION(SIGNATURE, T, VERSION_NUMBER)         \
+  namespace cereal {                                                        \
+  namespace detail {                                                        \
+  MLPACK_CEREAL_REMOVE_PARENS SIGNATURE                                     \
+  struct Version<MLPACK_CEREAL_REMOVE_PARENS T>                             \
+  {                                                                         \
+    static std::uint32_t registerVersion()                                  \
+    {                                                                       \
+      ::cereal::detail::StaticObject<Versions>::getInstance().mapping.emplace( \
+          std::type_index(typeid(MLPACK_CEREAL_REMOVE_PARENS T)).hash_code(), \
+          MLPACK_CEREAL_REMOVE_PARENS VERSION_NUMBER);                      \
+      return MLPACK_CEREAL_REMOVE_PARENS VERSION_NUMBER;                    \
+    }                                                                       \
+    static void unused() { (void) version; }                                \
+    static const std::uint32_t version;                                     \
+  };                                                                        \
+  MLPACK_CEREAL_REMOVE_PARENS SIGNATURE                                     \
+  const std::uint32_t Version<MLPACK_CEREAL_REMOVE_PARENS T>::version =     \
+      Version<MLPACK_CEREAL_REMOVE_PARENS T>::registerVersion();            \
+  } /* namespace detail */                                                  \
+  } /* namespace cereal */
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * @file core/data/chunked_file.hpp
+ *
+ * Definition of the ChunkedReader and ChunkedWriter classes, which read points
+ * from and write points to text files a chunk at a time, so that files too
+ * large to be held in memory can be processed.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_DATA_CHUNKED_FILE_HPP
+#define MLPACK_CORE_DATA_CHUNKED_FILE_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Read the points of a text file a chunk at a time.  As with data::Load(), the
+ * file holds one point per line, and each point is returned as a column; the
+ * values of a point may be separated by commas, spaces or tabs.  Empty lines
+ * are skipped.  Every point in the file must have the same dimensionality.
+ */
+class ChunkedReader
+{
+ public:
+  /**
+   * Open the given file.  A std::runtime_error is thrown if the file cannot be
+   * opened.
+   *
+   * @param filename Name of file to read.
+   */
+  ChunkedReader(const std::string& filename) :
+      filename(filename),
+      stream(filename),
+      dimensionality(0),
+      line(0)
+  {
+    if (!stream.is_open())
+      throw std::runtime_error("Unable to open file '" + filename + "'.");
+  }
+
+  /**
+   * Read at most the given number of points from the file into the given
+   * matrix, which is resized to hold them.  A std::runtime_error is thrown if a
+   * line cannot be parsed or has a different dimensionality than the lines
+   * before it.
+   *
+   * @param chunk Matrix to store the points in.
+   * @param maxPoints Maximum number of points to read.
+   * @return The number of points read; this is 0 once the file is exhausted.
+   */
+  template<typename eT>
+  size_t Read(arma::Mat<eT>& chunk, const size_t maxPoints)
+  {
+    std::vector<eT> values;
+    size_t points = 0;
+    std::string text;
+    while (points < maxPoints && std::getline(stream, text))
+    {
+      ++line;
+
+      // Treat every separator as whitespace.
+      std::replace(text.begin(), text.end(), ',', ' ');
+      std::replace(text.begin(), text.end(), '\r', ' ');
+      std::istringstream tokens(text);
+
+      size_t dims = 0;
+      eT value;
+      while (tokens >> value)
+      {
+        values.push_back(value);
+        ++dims;
+      }
+
+      if (!tokens.eof())
+      {
+        throw std::runtime_error("Unable to parse line " + std::to_string(line)
+            + " of file '" + filename + "'.");
+      }
+
+      if (dims == 0)
+        continue;
+
+      if (dimensionality == 0)
+        dimensionality = dims;
+      else if (dims != dimensionality)
+      {
+        throw std::runtime_error("Line " + std::to_string(line) + " of file '" +
+            filename + "' has " + std::to_string(dims) + " values, but " +
+            std::to_string(dimensionality) + " were expected.");
+      }
+
+      ++points;
+    }
+
+    // The values of each point are contiguous, as in a column-major matrix.
+    chunk.set_size(dimensionality, points);
+    std::copy(values.begin(), values.end(), chunk.memptr());
+    return points;
+  }
+
+  //! Get the dimensionality of the points (0 if none have been read yet).
+  size_t Dimensionality() const { return dimensionality; }
+
+ private:
+  //! The name of the file.
+  std::string filename;
+  //! The stream the file is read from.
+  std::ifstream stream;
+  //! The dimensionality of the points read so far.
+  size_t dimensionality;
+  //! The number of lines read so far.
+  size_t line;
+};
+
+/**
+ * Write points to a text file a chunk at a time.  As with data::Save() for CSV
+ * files, each column of a chunk is written on its own line, with its values
+ * separated by commas.
+ */
+class ChunkedWriter
+{
+ public:
+  /**
+   * Create (or truncate) the given file.  A std::runtime_error is thrown if the
+   * file cannot be opened.
+   *
+   * @param filename Name of file to write.
+   */
+  ChunkedWriter(const std::string& filename) :
+      filename(filename),
+      stream(filename)
+  {
+    if (!stream.is_open())
+      throw std::runtime_error("Unable to open file '" + filename + "'.");
+  }
+
+  /**
+   * Append the columns of the given matrix to the file.  Floating-point values
+   * are written with enough digits to be read back exactly.  A
+   * std::runtime_error is thrown if the file cannot be written.
+   *
+   * @param chunk Matrix whose columns are written.
+   */
+  template<typename eT>
+  void Write(const arma::Mat<eT>& chunk)
+  {
+    stream.precision(std::numeric_limits<eT>::max_digits10);
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+    {
+      for (size_t j = 0; j < chunk.n_rows; ++j)
+      {
+        if (j > 0)
+          stream << ',';
+        stream << chunk(j, i);
+      }
+      stream << '\n';
+    }
+
+    if (!stream)
+      throw std::runtime_error("Unable to write to file '" + filename + "'.");
+  }
+
+ private:
+  //! The name of the file.
+  std::string filename;
+  //! The stream the file is written to.
+  std::ofstream stream;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -19,6 +19,7 @@
 #include <mlpack/core/util/timers.hpp>
 
 #include "extension.hpp"
+#include "mapped_file.hpp"
 
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
@@ -49,6 +50,27 @@ bool Load(const std::string& filename,
       f = format::binary;
     else if (extension == "json")
       f = format::json;
+    else if (extension == "mmap")
+    {
+      // Memory-mapped files are not handled by cereal; the model maps the
+      // file itself.
+      try
+      {
+        LoadMapped(filename, t);
+        return true;
+      }
+      catch (std::exception& e)
+      {
+        if (fatal)
+          Log::Fatal << "Unable to load '" << filename
+              << "' as a memory-mapped model: " << e.what() << "." << std::endl;
+        else
+          Log::Warn << "Unable to load '" << filename
+              << "' as a memory-mapped model: " << e.what() << "." << std::endl;
+
+        return false;
+      }
+    }
     else
     {
       if (fatal)
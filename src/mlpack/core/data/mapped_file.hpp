@@ -0,0 +1,206 @@
+/**
+ * @file core/data/mapped_file.hpp
+ *
+ * Definition of the MappedFile class, which maps a file into memory so that a
+ * model stored in a flat binary layout can be used in place, without any
+ * deserialization step.  Also defines the traits used by data::Load() and
+ * data::Save() to detect models that support the memory-mapped format.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_DATA_MAPPED_FILE_HPP
+#define MLPACK_CORE_DATA_MAPPED_FILE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+#ifdef _WIN32
+  #include <fstream>
+  #include <vector>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A read-only view of a file that has been mapped into memory.  On POSIX
+ * systems the file is mapped with mmap() as a private mapping, so pages are
+ * only read from disk when they are touched and are shared between processes
+ * that map the same file; any write to the memory is copy-on-write and never
+ * reaches the file.  On other systems the contents of the file are read into
+ * an internal buffer instead.
+ *
+ * The memory is released when the MappedFile is destroyed, so any object that
+ * aliases the memory must not outlive the MappedFile.
+ */
+class MappedFile
+{
+ public:
+  /**
+   * Map the given file into memory.  A std::runtime_error is thrown if the
+   * file cannot be opened or mapped.
+   *
+   * @param filename Name of file to map.
+   */
+  MappedFile(const std::string& filename) : data(NULL), size(0)
+  {
+#ifdef _WIN32
+    std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+      throw std::runtime_error("Unable to open file '" + filename + "'.");
+
+    size = (size_t) ifs.tellg();
+    buffer.resize(size);
+    ifs.seekg(0);
+    if (size > 0 && !ifs.read(buffer.data(), size))
+      throw std::runtime_error("Unable to read file '" + filename + "'.");
+    data = buffer.data();
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Unable to open file '" + filename + "'.");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+      close(fd);
+      throw std::runtime_error("Unable to stat file '" + filename + "'.");
+    }
+
+    size = (size_t) st.st_size;
+    if (size > 0)
+    {
+      void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+          0);
+      if (memory == MAP_FAILED)
+      {
+        close(fd);
+        throw std::runtime_error("Unable to map file '" + filename + "'.");
+      }
+      data = static_cast<char*>(memory);
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+#endif
+  }
+
+  //! Unmap the file.
+  ~MappedFile()
+  {
+#ifndef _WIN32
+    if (data != NULL)
+      munmap(data, size);
+#endif
+  }
+
+  // A MappedFile cannot be copied, since objects alias its memory.
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  //! Get the mapped memory.
+  const char* Data() const { return data; }
+  //! Modify the mapped memory (modifications never reach the file).
+  char* Data() { return data; }
+
+  //! Get the size of the mapped memory in bytes.
+  size_t Size() const { return size; }
+
+ private:
+  //! The mapped memory.
+  char* data;
+  //! The size of the mapped memory.
+  size_t size;
+#ifdef _WIN32
+  //! Storage for the contents of the file.
+  std::vector<char> buffer;
+#endif
+};
+
+/**
+ * Round the given offset up to the alignment used for sections of
+ * memory-mapped model files, so that the data in each section is suitably
+ * aligned when the file is mapped.
+ */
+inline size_t MappedAlign(const size_t offset)
+{
+  return (offset + 63) & ~((size_t) 63);
+}
+
+/**
+ * Write zeros to the given stream until the given position (relative to the
+ * start of the section being written) is aligned with MappedAlign().  The new
+ * position is returned.
+ */
+inline size_t MappedPad(std::ostream& stream, const size_t position)
+{
+  const size_t aligned = MappedAlign(position);
+  const char zeros[64] = { 0 };
+  stream.write(zeros, aligned - position);
+  return aligned;
+}
+
+// This gives us HasLoadMappedCheck<T, U> and HasSaveMappedCheck<T, U> types
+// that can be used with SFINAE to detect whether a model can be loaded from or
+// saved to a memory-mapped file.
+HAS_MEM_FUNC(LoadMapped, HasLoadMappedCheck);
+HAS_MEM_FUNC(SaveMapped, HasSaveMappedCheck);
+
+/**
+ * Load the given model from the memory-mapped file with the given name, if the
+ * model type supports it.
+ */
+template<typename T>
+void LoadMapped(const std::string& filename,
+                T& t,
+                const typename std::enable_if<HasLoadMappedCheck<T,
+                    void(T::*)(const std::string&)>::value>::type* = 0)
+{
+  t.LoadMapped(filename);
+}
+
+template<typename T>
+void LoadMapped(const std::string& /* filename */,
+                T& /* t */,
+                const typename std::enable_if<!HasLoadMappedCheck<T,
+                    void(T::*)(const std::string&)>::value>::type* = 0)
+{
+  throw std::invalid_argument("this model type cannot be loaded from a "
+      "memory-mapped (.mmap) file");
+}
+
+/**
+ * Save the given model to the memory-mapped file format with the given name,
+ * if the model type supports it.
+ */
+template<typename T>
+void SaveMapped(const std::string& filename,
+                const T& t,
+                const typename std::enable_if<HasSaveMappedCheck<T,
+                    void(T::*)(const std::string&) const>::value>::type* = 0)
+{
+  t.SaveMapped(filename);
+}
+
+template<typename T>
+void SaveMapped(const std::string& /* filename */,
+                const T& /* t */,
+                const typename std::enable_if<!HasSaveMappedCheck<T,
+                    void(T::*)(const std::string&) const>::value>::type* = 0)
+{
+  throw std::invalid_argument("this model type cannot be saved to a "
+      "memory-mapped (.mmap) file");
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
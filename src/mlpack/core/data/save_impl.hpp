@@ -16,6 +16,7 @@
 #include "save.hpp"
 #include "extension.hpp"
 #include "detect_file_type.hpp"
+#include "mapped_file.hpp"
 
 #include <cereal/archives/xml.hpp>
 #include <cereal/archives/json.hpp>
@@ -277,6 +278,27 @@ bool Save(const std::string& filename,
       f = format::binary;
     else if (extension == "json")
       f = format::json;
+    else if (extension == "mmap")
+    {
+      // Memory-mapped files are not handled by cereal; the model writes its
+      // own flat layout.
+      try
+      {
+        SaveMapped(filename, t);
+        return true;
+      }
+      catch (std::exception& e)
+      {
+        if (fatal)
+          Log::Fatal << "Unable to save '" << filename
+              << "' as a memory-mapped model: " << e.what() << "." << std::endl;
+        else
+          Log::Warn << "Unable to save '" << filename
+              << "' as a memory-mapped model: " << e.what() << "." << std::endl;
+
+        return false;
+      }
+    }
     else
     {
       if (fatal)
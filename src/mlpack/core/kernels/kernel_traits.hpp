@@ -13,6 +13,8 @@
 #ifndef MLPACK_CORE_KERNELS_KERNEL_TRAITS_HPP
 #define MLPACK_CORE_KERNELS_KERNEL_TRAITS_HPP
 
+#include <mlpack/prereqs.hpp>
+
 namespace mlpack {
 namespace kernel {
 
@@ -38,6 +40,22 @@ class KernelTraits
   static const bool UsesSquaredDistance = false;
 };
 
+/**
+ * HasBatchEvaluate<KernelType, MatType>::value is true if the kernel can
+ * evaluate every pair of points of two sets of type MatType at once with
+ * BatchEvaluate(a, b, kernels) (such as LinearKernel and PolynomialKernel with
+ * dense matrices).
+ */
+template<typename KernelType, typename MatType, typename = void>
+struct HasBatchEvaluate : std::false_type { };
+
+template<typename KernelType, typename MatType>
+struct HasBatchEvaluate<KernelType, MatType, decltype(
+    std::declval<const KernelType&>().BatchEvaluate(
+        std::declval<const MatType&>(), std::declval<const MatType&>(),
+        std::declval<arma::Mat<typename MatType::elem_type>&>()), void())> :
+    std::true_type { };
+
 } // namespace kernel
 } // namespace mlpack
 
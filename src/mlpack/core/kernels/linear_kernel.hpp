@@ -55,6 +55,24 @@ class LinearKernel
     return arma::dot(a, b);
   }
 
+  /**
+   * Evaluate the kernel between every column of a and every column of b, so
+   * that kernels(i, j) holds K(a.col(i), b.col(j)).  This is a single matrix
+   * product, which is done by BLAS; the results can differ from Evaluate() by
+   * rounding error.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernels Matrix to store the kernel values in.
+   */
+  template<typename ElemType>
+  static void BatchEvaluate(const arma::Mat<ElemType>& a,
+                            const arma::Mat<ElemType>& b,
+                            arma::Mat<ElemType>& kernels)
+  {
+    kernels = a.t() * b;
+  }
+
   //! Serialize the kernel (it has no members... do nothing).
   template<typename Archive>
   void serialize(Archive& /* ar */, const uint32_t /* version */) { }
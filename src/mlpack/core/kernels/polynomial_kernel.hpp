@@ -57,6 +57,24 @@ class PolynomialKernel
     return pow((arma::dot(a, b) + offset), degree);
   }
 
+  /**
+   * Evaluate the kernel between every column of a and every column of b, so
+   * that kernels(i, j) holds K(a.col(i), b.col(j)).  The dot products are
+   * computed with a single matrix product, which is done by BLAS; the results
+   * can differ from Evaluate() by rounding error.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernels Matrix to store the kernel values in.
+   */
+  template<typename ElemType>
+  void BatchEvaluate(const arma::Mat<ElemType>& a,
+                     const arma::Mat<ElemType>& b,
+                     arma::Mat<ElemType>& kernels) const
+  {
+    kernels = arma::pow(a.t() * b + ElemType(offset), ElemType(degree));
+  }
+
   //! Get the degree of the polynomial.
   const double& Degree() const { return degree; }
   //! Modify the degree of the polynomial.
@@ -83,6 +83,25 @@ class LMetric
   static typename VecTypeA::elem_type Evaluate(const VecTypeA& a,
                                                const VecTypeB& b);
 
+  /**
+   * Computes the distances between every column of a and every column of b,
+   * so that distances(i, j) holds the distance between a.col(i) and b.col(j).
+   * For the L2 distance (squared or not), this uses the expansion
+   * ||a||^2 + ||b||^2 - 2 a^T b, so that nearly all of the work is one matrix
+   * product, which is done by BLAS; this is much faster than calling
+   * Evaluate() for each pair, but the results can differ from Evaluate() by
+   * rounding error.  For other powers, Evaluate() is called for each pair.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param distances Matrix to store the distances in.
+   * @return An upper bound on the absolute error of each computed distance.
+   */
+  template<typename ElemType>
+  static ElemType BatchEvaluate(const arma::Mat<ElemType>& a,
+                                const arma::Mat<ElemType>& b,
+                                arma::Mat<ElemType>& distances);
+
   //! Serialize the metric (nothing to do).
   template<typename Archive>
   void serialize(Archive& /* ar */, const uint32_t /* version */) { }
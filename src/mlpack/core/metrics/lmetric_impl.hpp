@@ -35,6 +35,22 @@ typename VecTypeA::elem_type LMetric<Power, TakeRoot>::Evaluate(
   return std::pow(sum, (1.0 / Power));
 }
 
+// Unspecialized batch implementation: evaluate each pair.
+template<int Power, bool TakeRoot>
+template<typename ElemType>
+ElemType LMetric<Power, TakeRoot>::BatchEvaluate(
+    const arma::Mat<ElemType>& a,
+    const arma::Mat<ElemType>& b,
+    arma::Mat<ElemType>& distances)
+{
+  distances.set_size(a.n_cols, b.n_cols);
+  for (size_t j = 0; j < b.n_cols; ++j)
+    for (size_t i = 0; i < a.n_cols; ++i)
+      distances(i, j) = Evaluate(a.col(i), b.col(j));
+
+  return 0;
+}
+
 // L1-metric specializations; the root doesn't matter.
 template<>
 template<typename VecTypeA, typename VecTypeB>
@@ -73,6 +89,48 @@ typename VecTypeA::elem_type LMetric<2, false>::Evaluate(
   return accu(arma::square(a - b));
 }
 
+// L2-metric batch specializations.
+template<>
+template<typename ElemType>
+ElemType LMetric<2, false>::BatchEvaluate(
+    const arma::Mat<ElemType>& a,
+    const arma::Mat<ElemType>& b,
+    arma::Mat<ElemType>& distances)
+{
+  const arma::Col<ElemType> aNorms = arma::sum(arma::square(a), 0).t();
+  const arma::Row<ElemType> bNorms = arma::sum(arma::square(b), 0);
+
+  distances = ElemType(-2) * a.t() * b;
+  distances.each_col() += aNorms;
+  distances.each_row() += bNorms;
+
+  // Cancellation can make small distances negative.
+  distances.transform([](const ElemType d)
+      { return std::max(d, ElemType(0)); });
+
+  // The rounding error of each dot product and norm is bounded relative to the
+  // squared norms of the points.
+  const ElemType maxNorms = (aNorms.n_elem == 0 ? 0 : aNorms.max()) +
+      (bNorms.n_elem == 0 ? 0 : bNorms.max());
+  return 2 * (a.n_rows + 2) * std::numeric_limits<ElemType>::epsilon() *
+      maxNorms;
+}
+
+template<>
+template<typename ElemType>
+ElemType LMetric<2, true>::BatchEvaluate(
+    const arma::Mat<ElemType>& a,
+    const arma::Mat<ElemType>& b,
+    arma::Mat<ElemType>& distances)
+{
+  const ElemType squaredError =
+      LMetric<2, false>::BatchEvaluate(a, b, distances);
+  distances = arma::sqrt(distances);
+
+  // |sqrt(x) - sqrt(y)| <= sqrt(|x - y|).
+  return std::sqrt(squaredError);
+}
+
 // L3-metric specialization (not very likely to be used, but just in case).
 template<>
 template<typename VecTypeA, typename VecTypeB>
@@ -15,6 +15,7 @@
 
 #include "../statistic.hpp"
 #include "midpoint_split.hpp"
+#include "mapped_layout.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
@@ -25,13 +26,23 @@ namespace tree /** Trees and tree-building procedures. */ {
  * the constructor with the dataset to build the tree on, and the entire tree
  * will be built.
  *
- * This particular tree does not allow growth, so you cannot add or delete nodes
- * from it.  If you need to add or delete a node, the better procedure is to
- * rebuild the tree entirely.
+ * Points can be added to or removed from the root of the tree with Insert() and
+ * Remove().  The bounds of the nodes are only grown when points are inserted;
+ * they are not shrunk when points are removed, so they may be looser than the
+ * bounds of a freshly built tree.  Leaves that hold too many points are split,
+ * and a subtree is rebuilt entirely when at least a quarter of its points have
+ * changed since it was built and one of its children holds more than three
+ * quarters of its points, in the manner of a scapegoat tree.  This is not
+ * available for UB trees.
  *
  * This tree does take one runtime parameter in the constructor, which is the
  * max leaf size to be used.
  *
+ * If mlpack is compiled with OpenMP, the children of nodes holding at least
+ * ParallelBuildThreshold points are built in parallel.  The trees built this
+ * way are identical to the trees built by a single thread, unless the
+ * SplitType is randomized.
+ *
  * @tparam MetricType The metric used for tree-building.  The BoundType may
  *     place restrictions on the metrics that can be used.
  * @tparam StatisticType Extra data contained in the node.  See statistic.hpp
@@ -61,6 +72,10 @@ class BinarySpaceTree
 
   typedef SplitType<BoundType<MetricType>, MatType> Split;
 
+  //! If OpenMP is available, nodes holding at least this many points build
+  //! their two children concurrently.
+  static const size_t ParallelBuildThreshold = 10000;
+
  private:
   //! The left child node.
   BinarySpaceTree* left;
@@ -88,6 +103,18 @@ class BinarySpaceTree
   //! The dataset.  If we are the root of the tree, we own the dataset and must
   //! delete it.
   MatType* dataset;
+  //! If true, the tree has been frozen with Freeze(), so this node does not own
+  //! its children.
+  bool frozen;
+  //! The contiguous array holding every node of a frozen tree but the root.
+  //! This is only non-NULL at the root of a frozen tree.
+  BinarySpaceTree* frozenNodes;
+  //! Contiguous storage for the bounds of the nodes in frozenNodes, if the
+  //! bound type allows it.  This is only non-NULL at the root of a frozen tree.
+  math::Range* frozenRanges;
+  //! The number of points inserted into or removed from the subtree rooted at
+  //! this node since the node was built.
+  size_t modifications;
 
  public:
   //! A single-tree traverser for binary space trees; see
@@ -308,6 +335,21 @@ class BinarySpaceTree
       Archive& ar,
       const typename std::enable_if_t<cereal::is_loading<Archive>()>* = 0);
 
+  /**
+   * Use in place the tree image written by SaveMapped() that starts at the
+   * given memory, without deserializing it: the dataset and the bounds of
+   * every node but the root alias the image, and the nodes are stored
+   * contiguously as in a frozen tree (see Freeze()).  The memory is never
+   * written to, but must be writable (a private memory mapping is sufficient),
+   * and it must outlive the tree.  Only the statistics are computed.  If the
+   * memory does not hold a valid image of this type of tree, a
+   * std::invalid_argument is thrown.
+   *
+   * @param image Memory holding the tree image.
+   * @param imageSize Number of bytes available at image.
+   */
+  BinarySpaceTree(char* image, const size_t imageSize);
+
   /**
    * Deletes this node, deallocating the memory for the children and calling
    * their destructors in turn.  This will invalidate any pointers or references
@@ -507,6 +549,68 @@ class BinarySpaceTree
   //! Store the center of the bounding region in the given vector.
   void Center(arma::vec& center) const { bound.Center(center); }
 
+  /**
+   * Store all of the nodes of the tree (except this one, which must be the
+   * root) contiguously in a single array, in breadth-first order.  If the
+   * bound type is HRectBound, the ranges of the bounds of those nodes are also
+   * stored contiguously.  This reduces cache and TLB misses when the tree is
+   * traversed.  The layout is transparent to traversals, but the tree should
+   * not be restructured afterwards; nodes of a frozen tree cannot be deleted
+   * individually.  Copies and deserialized trees are not frozen.
+   */
+  void Freeze();
+
+  //! Return whether or not the tree has been frozen with Freeze().
+  bool IsFrozen() const { return frozen; }
+
+  /**
+   * Insert the given points into the tree, which must be the root and must not
+   * be frozen.  Each point is added to the leaf whose bound is nearest to it,
+   * growing the bounds along the way, and the dataset is rearranged so that
+   * the points of every node stay contiguous; leaves that then hold more than
+   * maxLeafSize points are split, and unbalanced subtrees are rebuilt.  The
+   * inserted points are given the indices following the existing points in
+   * oldFromNew (so the i'th inserted point has index Dataset().n_cols + i
+   * before the call).  This takes time linear in the size of the dataset.
+   *
+   * @param points Points to insert.
+   * @param oldFromNew Mapping from the indices of points in the dataset to
+   *     their original indices; this is updated.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   */
+  void Insert(const MatType& points,
+              std::vector<size_t>& oldFromNew,
+              const size_t maxLeafSize = 20);
+
+  /**
+   * Remove the points with the given indices in the dataset from the tree,
+   * which must be the root and must not be frozen.  The remaining points keep
+   * their order, and their original indices in oldFromNew are renumbered as if
+   * the removed points had been deleted from the original dataset.  The bounds
+   * of the nodes are left as they are; nodes holding at most maxLeafSize points
+   * become leaves, and unbalanced subtrees are rebuilt.  This takes time linear
+   * in the size of the dataset.
+   *
+   * @param indices Indices of the points to remove in the dataset.
+   * @param oldFromNew Mapping from the indices of points in the dataset to
+   *     their original indices; this is updated.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   */
+  void Remove(const std::vector<size_t>& indices,
+              std::vector<size_t>& oldFromNew,
+              const size_t maxLeafSize = 20);
+
+  /**
+   * Write this tree (which must be the root) and its dataset to the given
+   * stream as a flat image that can be memory-mapped and used in place with
+   * the constructor that takes a memory image; see MappedTreeHeader for the
+   * layout.  Statistics are not saved.  This is only available for trees with
+   * HRectBound bounds built on dense Armadillo matrices.
+   *
+   * @param stream Stream to write the image to.
+   */
+  void SaveMapped(std::ostream& stream) const;
+
  private:
   /**
    * Splits the current node, assigning its left and right children recursively.
@@ -529,6 +633,153 @@ class BinarySpaceTree
                  const size_t maxLeafSize,
                  SplitType<BoundType<MetricType>, MatType>& splitter);
 
+  /**
+   * Construct this node as a child of the given parent, starting at column
+   * begin and using count points, and compute its bound, but do not split it.
+   * The node must then be split with PartitionNode(), and its statistic must be
+   * created.  This is used when the children of a node are built in parallel,
+   * since the bound of a right child may depend on the bound of its sibling.
+   *
+   * @param parent Parent of this node.
+   * @param begin Index of point to start tree construction with.
+   * @param count Number of points to use to construct tree.
+   */
+  BinarySpaceTree(BinarySpaceTree* parent,
+                  const size_t begin,
+                  const size_t count);
+
+  /**
+   * Splits the current node, whose bound has already been computed, and
+   * assigns its left and right children recursively.
+   *
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   */
+  void PartitionNode(const size_t maxLeafSize,
+                     SplitType<BoundType<MetricType>, MatType>& splitter);
+
+  /**
+   * Splits the current node, whose bound has already been computed, and
+   * assigns its left and right children recursively.  Also returns a list of
+   * the changed indices.
+   *
+   * @param oldFromNew Vector holding permuted indices.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   */
+  void PartitionNode(std::vector<size_t>& oldFromNew,
+                     const size_t maxLeafSize,
+                     SplitType<BoundType<MetricType>, MatType>& splitter);
+
+  /**
+   * Split the (already bounded) children of this node concurrently, using
+   * OpenMP tasks.  This must be called from inside a parallel region.
+   *
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   */
+  void PartitionChildren(const size_t maxLeafSize,
+                         SplitType<BoundType<MetricType>, MatType>& splitter);
+
+  /**
+   * Split the (already bounded) children of this node concurrently, using
+   * OpenMP tasks.  This must be called from inside a parallel region.
+   *
+   * @param oldFromNew Vector holding permuted indices.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   */
+  void PartitionChildren(std::vector<size_t>& oldFromNew,
+                         const size_t maxLeafSize,
+                         SplitType<BoundType<MetricType>, MatType>& splitter);
+
+  /**
+   * Route the given points through the subtree rooted at this node, growing the
+   * bounds on their way, and copy the points of each leaf, followed by the
+   * points routed to it, into the dataset (which must have room for them),
+   * starting at the given offset.  The offset is advanced past the points of
+   * this node.
+   *
+   * @param points Points being inserted.
+   * @param indices Indices of the points routed to this node.
+   * @param oldDataset The dataset before the insertion.
+   * @param oldMapping The mapping from indices in oldDataset to the original
+   *     indices of the points.
+   * @param oldFromNew The mapping being filled for the new dataset.
+   * @param offset Index of the first point of this node in the new dataset.
+   */
+  void InsertPoints(const MatType& points,
+                    const std::vector<size_t>& indices,
+                    const MatType& oldDataset,
+                    const std::vector<size_t>& oldMapping,
+                    std::vector<size_t>& oldFromNew,
+                    size_t& offset);
+
+  /**
+   * Copy the points of the subtree rooted at this node that are not removed
+   * into the dataset, starting at the given offset, and renumber their
+   * original indices.  The offset is advanced past the points of this node.
+   *
+   * @param removed Whether or not each point of oldDataset is removed.
+   * @param removedBefore For each original index, the number of removed points
+   *     with a smaller original index.
+   * @param oldDataset The dataset before the removal.
+   * @param oldMapping The mapping from indices in oldDataset to the original
+   *     indices of the points.
+   * @param oldFromNew The mapping being filled for the new dataset.
+   * @param offset Index of the first point of this node in the new dataset.
+   */
+  void RemovePoints(const std::vector<bool>& removed,
+                    const std::vector<size_t>& removedBefore,
+                    const MatType& oldDataset,
+                    const std::vector<size_t>& oldMapping,
+                    std::vector<size_t>& oldFromNew,
+                    size_t& offset);
+
+  /**
+   * Restore the structure of the subtree rooted at this node after points were
+   * inserted or removed: nodes holding too few points become leaves, leaves
+   * holding too many points are split, unbalanced subtrees are rebuilt, and
+   * the cached distances and statistics of modified nodes are recomputed.
+   *
+   * @param oldFromNew Vector holding permuted indices.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   */
+  void Restructure(std::vector<size_t>& oldFromNew,
+                   const size_t maxLeafSize,
+                   SplitType<BoundType<MetricType>, MatType>& splitter);
+
+  /**
+   * Delete the children of this node, taking into account whether or not the
+   * tree is frozen.  If this is the root of a frozen tree, the tree is no
+   * longer frozen afterwards.
+   */
+  void DeleteChildren();
+
+  /**
+   * Store the bounds of the given nodes (all but the first of which are in
+   * frozenNodes) contiguously, if the bound type allows it.  For most bound
+   * types this does nothing.
+   *
+   * @param rootBound The bound of the root (used for overload resolution).
+   * @param nodes The nodes of the tree, in breadth-first order.
+   */
+  template<typename BoundType2>
+  void FreezeBounds(BoundType2& rootBound,
+                    const std::vector<BinarySpaceTree*>& nodes);
+
+  /**
+   * Store the ranges of the bounds of the given nodes (all but the first of
+   * which are in frozenNodes) contiguously in frozenRanges.  This method is
+   * designed for HRectBound only.
+   *
+   * @param rootBound The bound of the root (used for overload resolution).
+   * @param nodes The nodes of the tree, in breadth-first order.
+   */
+  void FreezeBounds(bound::HRectBound<MetricType>& rootBound,
+                    const std::vector<BinarySpaceTree*>& nodes);
+
   /**
    * Update the bound of the current node. This method does not take into
    * account bound-specific properties.
@@ -15,8 +15,14 @@
 #include "binary_space_tree.hpp"
 
 #include <mlpack/core/util/log.hpp>
+#include <mlpack/core/data/mapped_file.hpp>
 #include <queue>
 
+// Use OpenMP to build large nodes in parallel, if available.
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace tree {
 
@@ -39,7 +45,11 @@ BinarySpaceTree(
     count(data.n_cols), /* and spans all of the dataset. */
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Do the actual splitting of this node.
   SplitType<BoundType<MetricType>, MatType> splitter;
@@ -67,7 +77,11 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(data.n_cols);
@@ -101,7 +115,11 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(data.n_cols);
@@ -136,7 +154,11 @@ BinarySpaceTree(MatType&& data, const size_t maxLeafSize) :
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Do the actual splitting of this node.
   SplitType<BoundType<MetricType>, MatType> splitter;
@@ -164,7 +186,11 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(dataset->n_cols);
@@ -198,7 +224,11 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(dataset->n_cols);
@@ -237,7 +267,11 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset().n_rows),
-    dataset(&parent->Dataset()) // Point to the parent's dataset.
+    dataset(&parent->Dataset()), // Point to the parent's dataset.
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Perform the actual splitting.
   SplitNode(maxLeafSize, splitter);
@@ -266,7 +300,11 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset().n_rows),
-    dataset(&parent->Dataset())
+    dataset(&parent->Dataset()),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -300,7 +338,11 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset()->n_rows),
-    dataset(&parent->Dataset())
+    dataset(&parent->Dataset()),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -342,7 +384,11 @@ BinarySpaceTree(
     furthestDescendantDistance(other.furthestDescendantDistance),
     minimumBoundDistance(other.minimumBoundDistance),
     // Copy matrix, but only if we are the root.
-    dataset((other.parent == NULL) ? new MatType(*other.dataset) : NULL)
+    dataset((other.parent == NULL) ? new MatType(*other.dataset) : NULL),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(other.modifications)
 {
   // Create left and right children (if any).
   if (other.Left())
@@ -398,11 +444,8 @@ operator=(const BinarySpaceTree& other)
 
   // Freeing memory that will not be used anymore.
   delete dataset;
-  delete left;
-  delete right;
+  DeleteChildren();
 
-  left = NULL;
-  right = NULL;
   parent = other.Parent();
   begin = other.Begin();
   count = other.Count();
@@ -411,6 +454,7 @@ operator=(const BinarySpaceTree& other)
   parentDistance = other.ParentDistance();
   furthestDescendantDistance = other.FurthestDescendantDistance();
   minimumBoundDistance = other.MinimumBoundDistance();
+  modifications = other.modifications;
   // Copy matrix, but only if we are the root.
   dataset = ((other.parent == NULL) ? new MatType(*other.dataset) : NULL);
 
@@ -470,8 +514,7 @@ operator=(BinarySpaceTree&& other)
 
   // Freeing memory that will not be used anymore.
   delete dataset;
-  delete left;
-  delete right;
+  DeleteChildren();
 
   parent = other.Parent();
   left = other.Left();
@@ -484,6 +527,10 @@ operator=(BinarySpaceTree&& other)
   furthestDescendantDistance = other.FurthestDescendantDistance();
   minimumBoundDistance = other.MinimumBoundDistance();
   dataset = other.dataset;
+  frozen = other.frozen;
+  frozenNodes = other.frozenNodes;
+  frozenRanges = other.frozenRanges;
+  modifications = other.modifications;
 
   other.left = NULL;
   other.right = NULL;
@@ -494,6 +541,10 @@ operator=(BinarySpaceTree&& other)
   other.furthestDescendantDistance = 0.0;
   other.minimumBoundDistance = 0.0;
   other.dataset = NULL;
+  other.frozen = false;
+  other.frozenNodes = NULL;
+  other.frozenRanges = NULL;
+  other.modifications = 0;
 
   return *this;
 }
@@ -520,7 +571,11 @@ BinarySpaceTree(BinarySpaceTree&& other) :
     parentDistance(other.parentDistance),
     furthestDescendantDistance(other.furthestDescendantDistance),
     minimumBoundDistance(other.minimumBoundDistance),
-    dataset(other.dataset)
+    dataset(other.dataset),
+    frozen(other.frozen),
+    frozenNodes(other.frozenNodes),
+    frozenRanges(other.frozenRanges),
+    modifications(other.modifications)
 {
   // Now we are a clone of the other tree.  But we must also clear the other
   // tree's contents, so it doesn't delete anything when it is destructed.
@@ -533,6 +588,10 @@ BinarySpaceTree(BinarySpaceTree&& other) :
   other.furthestDescendantDistance = 0.0;
   other.minimumBoundDistance = 0.0;
   other.dataset = NULL;
+  other.frozen = false;
+  other.frozenNodes = NULL;
+  other.frozenRanges = NULL;
+  other.modifications = 0;
 
   // Set new parent.
   if (left)
@@ -562,6 +621,146 @@ BinarySpaceTree(
   ar(CEREAL_NVP(*this));
 }
 
+/**
+ * Use a tree image in place.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+BinarySpaceTree(char* image, const size_t imageSize) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    begin(0),
+    count(0),
+    stat(*this),
+    parentDistance(0),
+    furthestDescendantDistance(0),
+    minimumBoundDistance(0),
+    dataset(NULL),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
+{
+  static_assert(std::is_same<BoundType<MetricType>,
+      bound::HRectBound<MetricType>>::value, "BinarySpaceTree: tree images "
+      "are only available with HRectBound");
+  static_assert(std::is_same<MatType, arma::Mat<ElemType>>::value,
+      "BinarySpaceTree: tree images are only available with dense matrices");
+
+  // Check the image thoroughly before anything is allocated, so that nothing
+  // leaks if it is invalid.
+  MappedTreeHeader header;
+  if (imageSize < sizeof(MappedTreeHeader))
+    throw std::invalid_argument("BinarySpaceTree: tree image is truncated");
+  std::memcpy(&header, image, sizeof(MappedTreeHeader));
+
+  const uint64_t dim = header.dimensionality;
+  const uint64_t nodes = header.nodes;
+  if (std::memcmp(header.magic, "MLPKBST", 8) != 0 ||
+      header.version != mappedTreeVersion)
+  {
+    throw std::invalid_argument("BinarySpaceTree: memory does not hold a tree "
+        "image of a supported version");
+  }
+  if (header.elemSize != sizeof(ElemType))
+  {
+    throw std::invalid_argument("BinarySpaceTree: tree image holds elements of "
+        "a different type");
+  }
+  if (header.size > imageSize || nodes == 0 ||
+      header.datasetOffset % 64 != 0 || header.nodesOffset % 64 != 0 ||
+      header.boundsOffset % 64 != 0 ||
+      header.datasetOffset + dim * header.points * sizeof(ElemType) >
+          header.nodesOffset ||
+      header.nodesOffset + nodes * sizeof(MappedTreeNode) >
+          header.boundsOffset ||
+      header.boundsOffset + nodes * dim * sizeof(math::Range) > header.size)
+  {
+    throw std::invalid_argument("BinarySpaceTree: tree image is truncated or "
+        "corrupt");
+  }
+
+  const MappedTreeNode* records =
+      reinterpret_cast<const MappedTreeNode*>(image + header.nodesOffset);
+  std::vector<bool> hasParent(nodes, false);
+  for (size_t i = 0; i < nodes; ++i)
+  {
+    const MappedTreeNode& r = records[i];
+    // Children always come after their parent in breadth-first order, and
+    // every node but the root has exactly one parent.
+    const bool badLeft = (r.left != 0) &&
+        (r.left <= i || r.left >= nodes || hasParent[r.left]);
+    if (!badLeft && r.left != 0)
+      hasParent[r.left] = true;
+    const bool badRight = (r.right != 0) &&
+        (r.right <= i || r.right >= nodes || hasParent[r.right]);
+    if (!badRight && r.right != 0)
+      hasParent[r.right] = true;
+
+    if (badLeft || badRight || r.begin > header.points ||
+        r.count > header.points - r.begin || (i > 0 && !hasParent[i]))
+    {
+      throw std::invalid_argument("BinarySpaceTree: tree image is corrupt");
+    }
+  }
+
+  // The dataset is used in place.  (Armadillo will not free this memory.)
+  dataset = new MatType(reinterpret_cast<ElemType*>(image +
+      header.datasetOffset), dim, header.points, false, true);
+
+  // Every node but the root is stored in one array, as in a frozen tree.
+  if (nodes > 1)
+    frozenNodes = new BinarySpaceTree[nodes - 1];
+
+  math::Range* ranges = reinterpret_cast<math::Range*>(image +
+      header.boundsOffset);
+  for (size_t i = 0; i < nodes; ++i)
+  {
+    const MappedTreeNode& r = records[i];
+    BinarySpaceTree* node = (i == 0) ? this : &frozenNodes[i - 1];
+
+    node->begin = r.begin;
+    node->count = r.count;
+    node->parentDistance = r.parentDistance;
+    node->furthestDescendantDistance = r.furthestDescendantDistance;
+    node->minimumBoundDistance = r.minimumBoundDistance;
+    node->dataset = dataset;
+    // The dataset lives in the image, so even a tree with a single node is
+    // frozen; this keeps it from being modified.
+    node->frozen = true;
+    node->left = (r.left == 0) ? NULL : &frozenNodes[r.left - 1];
+    node->right = (r.right == 0) ? NULL : &frozenNodes[r.right - 1];
+    if (node->left)
+      node->left->parent = node;
+    if (node->right)
+      node->right->parent = node;
+
+    // The root keeps its own memory, so that it can be unfrozen safely.
+    if (i == 0)
+    {
+      node->bound = bound::HRectBound<MetricType>(dim);
+      for (size_t d = 0; d < dim; ++d)
+        node->bound[d] = ranges[d];
+    }
+    else
+    {
+      node->bound.Alias(ranges + i * dim, dim);
+    }
+    node->bound.MinWidth() = r.minWidth;
+  }
+
+  // Statistics are built from the bottom of the tree up.
+  for (size_t i = nodes - 1; i > 0; --i)
+    frozenNodes[i - 1].stat = StatisticType(frozenNodes[i - 1]);
+  stat = StatisticType(*this);
+}
+
 /**
  * Deletes this node, deallocating the memory for the children and calling their
  * destructors in turn.  This will invalidate any pointers or references to any
@@ -576,8 +775,7 @@ template<typename MetricType,
 BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     ~BinarySpaceTree()
 {
-  delete left;
-  delete right;
+  DeleteChildren();
 
   // If we're the root, delete the matrix.
   if (!parent)
@@ -874,6 +1072,20 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
   // Calculate the furthest descendant distance.
   furthestDescendantDistance = 0.5 * bound.Diameter();
 
+  // Now split the node, if needed.
+  PartitionNode(maxLeafSize, splitter);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    PartitionNode(const size_t maxLeafSize,
+                  SplitType<BoundType<MetricType>, MatType>& splitter)
+{
   // Now, check if we need to split at all.
   if (count <= maxLeafSize)
     return; // We can't split this.
@@ -904,10 +1116,37 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
 
   // Now that we know the split column, we will recursively split the children
   // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, splitter,
-      maxLeafSize);
-  right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      splitter, maxLeafSize);
+  // Large nodes build their children in parallel.
+#ifdef HAS_OPENMP
+  if (count >= ParallelBuildThreshold && omp_get_max_threads() > 1)
+  {
+    // The bound of the right child may depend on the bound of the left child
+    // (see UpdateBound() for HollowBallBound), so both bounds are computed
+    // before either child is split.
+    left = new BinarySpaceTree(this, begin, splitCol - begin);
+    right = new BinarySpaceTree(this, splitCol, begin + count - splitCol);
+
+    if (omp_in_parallel())
+    {
+      PartitionChildren(maxLeafSize, splitter);
+    }
+    else
+    {
+      #pragma omp parallel
+      {
+        #pragma omp single
+        PartitionChildren(maxLeafSize, splitter);
+      }
+    }
+  }
+  else
+#endif
+  {
+    left = new BinarySpaceTree(this, begin, splitCol - begin, splitter,
+        maxLeafSize);
+    right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
+        splitter, maxLeafSize);
+  }
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -941,6 +1180,21 @@ SplitNode(std::vector<size_t>& oldFromNew,
   // Calculate the furthest descendant distance.
   furthestDescendantDistance = 0.5 * bound.Diameter();
 
+  // Now split the node, if needed.
+  PartitionNode(oldFromNew, maxLeafSize, splitter);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+PartitionNode(std::vector<size_t>& oldFromNew,
+              const size_t maxLeafSize,
+              SplitType<BoundType<MetricType>, MatType>& splitter)
+{
   // First, check if we need to split at all.
   if (count <= maxLeafSize)
     return; // We can't split this.
@@ -972,10 +1226,38 @@ SplitNode(std::vector<size_t>& oldFromNew,
 
   // Now that we know the split column, we will recursively split the children
   // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, oldFromNew,
-      splitter, maxLeafSize);
-  right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      oldFromNew, splitter, maxLeafSize);
+  // Large nodes build their children in parallel; each child only touches its
+  // own range of the dataset and of oldFromNew.
+#ifdef HAS_OPENMP
+  if (count >= ParallelBuildThreshold && omp_get_max_threads() > 1)
+  {
+    // The bound of the right child may depend on the bound of the left child
+    // (see UpdateBound() for HollowBallBound), so both bounds are computed
+    // before either child is split.
+    left = new BinarySpaceTree(this, begin, splitCol - begin);
+    right = new BinarySpaceTree(this, splitCol, begin + count - splitCol);
+
+    if (omp_in_parallel())
+    {
+      PartitionChildren(oldFromNew, maxLeafSize, splitter);
+    }
+    else
+    {
+      #pragma omp parallel
+      {
+        #pragma omp single
+        PartitionChildren(oldFromNew, maxLeafSize, splitter);
+      }
+    }
+  }
+  else
+#endif
+  {
+    left = new BinarySpaceTree(this, begin, splitCol - begin, oldFromNew,
+        splitter, maxLeafSize);
+    right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
+        oldFromNew, splitter, maxLeafSize);
+  }
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -992,6 +1274,615 @@ SplitNode(std::vector<size_t>& oldFromNew,
   right->ParentDistance() = rightParentDistance;
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+BinarySpaceTree(
+    BinarySpaceTree* parent,
+    const size_t begin,
+    const size_t count) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    begin(begin),
+    count(count),
+    bound(parent->Dataset().n_rows),
+    dataset(&parent->Dataset()), // Point to the parent's dataset.
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
+{
+  // We need to expand the bounds of this node properly.
+  UpdateBound(bound);
+
+  // Calculate the furthest descendant distance.
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+PartitionChildren(const size_t maxLeafSize,
+                  SplitType<BoundType<MetricType>, MatType>& splitter)
+{
+  // The children hold disjoint ranges of the dataset, so each of them can be
+  // split by a different thread.
+  #pragma omp task
+  {
+    left->PartitionNode(maxLeafSize, splitter);
+    left->stat = StatisticType(*left);
+  }
+
+  #pragma omp task
+  {
+    right->PartitionNode(maxLeafSize, splitter);
+    right->stat = StatisticType(*right);
+  }
+
+  #pragma omp taskwait
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+PartitionChildren(std::vector<size_t>& oldFromNew,
+                  const size_t maxLeafSize,
+                  SplitType<BoundType<MetricType>, MatType>& splitter)
+{
+  // The children hold disjoint ranges of the dataset and of oldFromNew, so
+  // each of them can be split by a different thread.
+  #pragma omp task
+  {
+    left->PartitionNode(oldFromNew, maxLeafSize, splitter);
+    left->stat = StatisticType(*left);
+  }
+
+  #pragma omp task
+  {
+    right->PartitionNode(oldFromNew, maxLeafSize, splitter);
+    right->stat = StatisticType(*right);
+  }
+
+  #pragma omp taskwait
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+Freeze()
+{
+  if (parent)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Freeze(): only the root of a "
+        "tree can be frozen!");
+  }
+
+  // Nothing to do if the tree is already frozen or has only one node.
+  if (frozen || !left)
+    return;
+
+  // Collect the nodes in breadth-first order, along with the indices of their
+  // children in that order.  The root is never a child, so index 0 denotes a
+  // missing child.
+  std::vector<BinarySpaceTree*> nodes;
+  std::vector<size_t> leftIndices, rightIndices;
+  nodes.push_back(this);
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    leftIndices.push_back(0);
+    rightIndices.push_back(0);
+    if (nodes[i]->left)
+    {
+      leftIndices[i] = nodes.size();
+      nodes.push_back(nodes[i]->left);
+    }
+    if (nodes[i]->right)
+    {
+      rightIndices[i] = nodes.size();
+      nodes.push_back(nodes[i]->right);
+    }
+  }
+
+  // Move every node but the root into one contiguous array.  Moving a node
+  // detaches it from its children, so the old node can be deleted right away.
+  frozenNodes = new BinarySpaceTree[nodes.size() - 1];
+  for (size_t i = 1; i < nodes.size(); ++i)
+  {
+    frozenNodes[i - 1] = std::move(*nodes[i]);
+    delete nodes[i];
+    nodes[i] = &frozenNodes[i - 1];
+  }
+
+  // Now link the nodes in the array.
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    nodes[i]->frozen = true;
+    nodes[i]->left = (leftIndices[i] == 0) ? NULL : nodes[leftIndices[i]];
+    nodes[i]->right = (rightIndices[i] == 0) ? NULL : nodes[rightIndices[i]];
+    if (nodes[i]->left)
+      nodes[i]->left->parent = nodes[i];
+    if (nodes[i]->right)
+      nodes[i]->right->parent = nodes[i];
+  }
+
+  // Store the bounds contiguously too, if we can.
+  FreezeBounds(bound, nodes);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+Insert(const MatType& points,
+       std::vector<size_t>& oldFromNew,
+       const size_t maxLeafSize)
+{
+  static_assert(!std::is_same<BoundType<MetricType>,
+      bound::CellBound<MetricType>>::value, "BinarySpaceTree: points cannot be "
+      "inserted into or removed from UB trees");
+
+  if (parent)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Insert(): points can only be "
+        "inserted at the root of a tree!");
+  }
+  if (frozen)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Insert(): a frozen tree "
+        "cannot be modified!");
+  }
+  if (points.n_rows != dataset->n_rows)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Insert(): the points must "
+        "have the same dimensionality as the dataset!");
+  }
+  if (oldFromNew.size() != dataset->n_cols)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Insert(): oldFromNew must "
+        "hold an index for every point in the dataset!");
+  }
+
+  if (points.n_cols == 0)
+    return;
+
+  // Lay the points out again in a new dataset, held in the same object so that
+  // every node still refers to it.
+  MatType oldDataset(std::move(*dataset));
+  std::vector<size_t> oldMapping(std::move(oldFromNew));
+  dataset->set_size(oldDataset.n_rows, oldDataset.n_cols + points.n_cols);
+  oldFromNew.resize(dataset->n_cols);
+
+  std::vector<size_t> indices(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    indices[i] = i;
+
+  size_t offset = 0;
+  InsertPoints(points, indices, oldDataset, oldMapping, oldFromNew, offset);
+
+  SplitType<BoundType<MetricType>, MatType> splitter;
+  Restructure(oldFromNew, maxLeafSize, splitter);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+Remove(const std::vector<size_t>& indices,
+       std::vector<size_t>& oldFromNew,
+       const size_t maxLeafSize)
+{
+  static_assert(!std::is_same<BoundType<MetricType>,
+      bound::CellBound<MetricType>>::value, "BinarySpaceTree: points cannot be "
+      "inserted into or removed from UB trees");
+
+  if (parent)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Remove(): points can only be "
+        "removed from the root of a tree!");
+  }
+  if (frozen)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Remove(): a frozen tree "
+        "cannot be modified!");
+  }
+  if (oldFromNew.size() != dataset->n_cols)
+  {
+    throw std::invalid_argument("BinarySpaceTree::Remove(): oldFromNew must "
+        "hold an index for every point in the dataset!");
+  }
+
+  // Mark the removed points, both by their index in the dataset and by their
+  // original index.  Duplicate indices are ignored.
+  std::vector<bool> removed(dataset->n_cols, false);
+  std::vector<size_t> removedBefore(dataset->n_cols, 0);
+  size_t numRemoved = 0;
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    if (indices[i] >= dataset->n_cols)
+    {
+      throw std::invalid_argument("BinarySpaceTree::Remove(): index " +
+          std::to_string(indices[i]) + " is out of range!");
+    }
+
+    if (!removed[indices[i]])
+    {
+      removed[indices[i]] = true;
+      removedBefore[oldFromNew[indices[i]]] = 1;
+      ++numRemoved;
+    }
+  }
+
+  if (numRemoved == 0)
+    return;
+
+  // Turn the marks on original indices into the number of removed points with
+  // a smaller original index.
+  size_t total = 0;
+  for (size_t i = 0; i < removedBefore.size(); ++i)
+  {
+    const size_t mark = removedBefore[i];
+    removedBefore[i] = total;
+    total += mark;
+  }
+
+  MatType oldDataset(std::move(*dataset));
+  std::vector<size_t> oldMapping(std::move(oldFromNew));
+  dataset->set_size(oldDataset.n_rows, oldDataset.n_cols - numRemoved);
+  oldFromNew.resize(dataset->n_cols);
+
+  size_t offset = 0;
+  RemovePoints(removed, removedBefore, oldDataset, oldMapping, oldFromNew,
+      offset);
+
+  SplitType<BoundType<MetricType>, MatType> splitter;
+  Restructure(oldFromNew, maxLeafSize, splitter);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+InsertPoints(const MatType& points,
+             const std::vector<size_t>& indices,
+             const MatType& oldDataset,
+             const std::vector<size_t>& oldMapping,
+             std::vector<size_t>& oldFromNew,
+             size_t& offset)
+{
+  // The bound of this node must contain every point routed through it.
+  for (size_t i = 0; i < indices.size(); ++i)
+    bound |= points.cols(indices[i], indices[i]);
+  modifications += indices.size();
+
+  if (IsLeaf())
+  {
+    // The old points of the leaf come first, then the new ones.
+    if (count > 0)
+    {
+      dataset->cols(offset, offset + count - 1) =
+          oldDataset.cols(begin, begin + count - 1);
+      for (size_t i = 0; i < count; ++i)
+        oldFromNew[offset + i] = oldMapping[begin + i];
+    }
+
+    begin = offset;
+    offset += count;
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+      dataset->col(offset) = points.col(indices[i]);
+      oldFromNew[offset] = oldDataset.n_cols + indices[i];
+      ++offset;
+    }
+    count += indices.size();
+    return;
+  }
+
+  // Send each point to the child whose bound is nearest to it.
+  std::vector<size_t> leftIndices, rightIndices;
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    if (left->MinDistance(points.col(indices[i])) <=
+        right->MinDistance(points.col(indices[i])))
+      leftIndices.push_back(indices[i]);
+    else
+      rightIndices.push_back(indices[i]);
+  }
+
+  left->InsertPoints(points, leftIndices, oldDataset, oldMapping, oldFromNew,
+      offset);
+  right->InsertPoints(points, rightIndices, oldDataset, oldMapping,
+      oldFromNew, offset);
+
+  begin = left->begin;
+  count = left->count + right->count;
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+RemovePoints(const std::vector<bool>& removed,
+             const std::vector<size_t>& removedBefore,
+             const MatType& oldDataset,
+             const std::vector<size_t>& oldMapping,
+             std::vector<size_t>& oldFromNew,
+             size_t& offset)
+{
+  if (IsLeaf())
+  {
+    const size_t newBegin = offset;
+    for (size_t i = begin; i < begin + count; ++i)
+    {
+      if (removed[i])
+        continue;
+
+      dataset->col(offset) = oldDataset.col(i);
+      oldFromNew[offset] = oldMapping[i] - removedBefore[oldMapping[i]];
+      ++offset;
+    }
+
+    modifications += count - (offset - newBegin);
+    begin = newBegin;
+    count = offset - newBegin;
+    return;
+  }
+
+  const size_t oldCount = count;
+  left->RemovePoints(removed, removedBefore, oldDataset, oldMapping,
+      oldFromNew, offset);
+  right->RemovePoints(removed, removedBefore, oldDataset, oldMapping,
+      oldFromNew, offset);
+
+  begin = left->begin;
+  count = left->count + right->count;
+  modifications += oldCount - count;
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+Restructure(std::vector<size_t>& oldFromNew,
+            const size_t maxLeafSize,
+            SplitType<BoundType<MetricType>, MatType>& splitter)
+{
+  if (!IsLeaf())
+  {
+    if (count <= maxLeafSize)
+    {
+      // The children are not worth keeping.  The bound still contains every
+      // point of the node, so it is kept.
+      DeleteChildren();
+    }
+    else if (4 * modifications >= count &&
+        4 * std::max(left->count, right->count) > 3 * count)
+    {
+      // Much of the subtree has changed since it was built, and it has become
+      // unbalanced, so build it again from scratch.  This also tightens the
+      // bounds.
+      DeleteChildren();
+      bound = BoundType<MetricType>(dataset->n_rows);
+      SplitNode(oldFromNew, maxLeafSize, splitter);
+      modifications = 0;
+      stat = StatisticType(*this);
+      return;
+    }
+    else
+    {
+      if (left->modifications > 0)
+        left->Restructure(oldFromNew, maxLeafSize, splitter);
+      if (right->modifications > 0)
+        right->Restructure(oldFromNew, maxLeafSize, splitter);
+    }
+  }
+
+  // Leaves that have grown too large are split.  The number of modifications
+  // only matters for nodes with children.
+  if (IsLeaf())
+  {
+    PartitionNode(oldFromNew, maxLeafSize, splitter);
+    modifications = 0;
+  }
+
+  // The bounds of this node and its children may have grown.
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+  if (left)
+  {
+    arma::vec center, leftCenter, rightCenter;
+    Center(center);
+    left->Center(leftCenter);
+    right->Center(rightCenter);
+
+    left->ParentDistance() = bound.Metric().Evaluate(center, leftCenter);
+    right->ParentDistance() = bound.Metric().Evaluate(center, rightCenter);
+  }
+
+  stat = StatisticType(*this);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+DeleteChildren()
+{
+  if (frozen)
+  {
+    // The nodes of a frozen tree are owned by the root.  The bounds must be
+    // freed after the nodes, since the nodes' bounds don't own their memory.
+    delete[] frozenNodes;
+    delete[] frozenRanges;
+    frozenNodes = NULL;
+    frozenRanges = NULL;
+  }
+  else
+  {
+    delete left;
+    delete right;
+  }
+
+  left = NULL;
+  right = NULL;
+  frozen = false;
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename BoundType2>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+FreezeBounds(BoundType2& /* rootBound */,
+             const std::vector<BinarySpaceTree*>& /* nodes */)
+{
+  // Nothing to do: the bound does not support external storage.
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+FreezeBounds(bound::HRectBound<MetricType>& rootBound,
+             const std::vector<BinarySpaceTree*>& nodes)
+{
+  // The root keeps its own memory, so that it can be unfrozen safely.
+  const size_t dim = rootBound.Dim();
+  frozenRanges = new math::Range[dim * (nodes.size() - 1)];
+  for (size_t i = 1; i < nodes.size(); ++i)
+    nodes[i]->bound.Relocate(frozenRanges + (i - 1) * dim);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+SaveMapped(std::ostream& stream) const
+{
+  static_assert(std::is_same<BoundType<MetricType>,
+      bound::HRectBound<MetricType>>::value, "BinarySpaceTree: tree images "
+      "are only available with HRectBound");
+  static_assert(std::is_same<MatType, arma::Mat<ElemType>>::value,
+      "BinarySpaceTree: tree images are only available with dense matrices");
+
+  if (parent)
+  {
+    throw std::invalid_argument("BinarySpaceTree::SaveMapped(): only the root "
+        "of a tree can be saved!");
+  }
+
+  // Collect the nodes in breadth-first order.
+  std::vector<const BinarySpaceTree*> nodes;
+  std::vector<MappedTreeNode> records;
+  nodes.push_back(this);
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const BinarySpaceTree* node = nodes[i];
+    MappedTreeNode r;
+    r.begin = node->begin;
+    r.count = node->count;
+    r.left = 0;
+    r.right = 0;
+    if (node->left)
+    {
+      r.left = nodes.size();
+      nodes.push_back(node->left);
+    }
+    if (node->right)
+    {
+      r.right = nodes.size();
+      nodes.push_back(node->right);
+    }
+    r.parentDistance = node->parentDistance;
+    r.furthestDescendantDistance = node->furthestDescendantDistance;
+    r.minimumBoundDistance = node->minimumBoundDistance;
+    r.minWidth = node->bound.MinWidth();
+    records.push_back(r);
+  }
+
+  const size_t dim = dataset->n_rows;
+  MappedTreeHeader header;
+  std::memset(&header, 0, sizeof(MappedTreeHeader));
+  std::memcpy(header.magic, "MLPKBST", 8);
+  header.version = mappedTreeVersion;
+  header.elemSize = sizeof(ElemType);
+  header.dimensionality = dim;
+  header.points = dataset->n_cols;
+  header.nodes = nodes.size();
+  header.datasetOffset = data::MappedAlign(sizeof(MappedTreeHeader));
+  header.nodesOffset = data::MappedAlign(header.datasetOffset +
+      dataset->n_elem * sizeof(ElemType));
+  header.boundsOffset = data::MappedAlign(header.nodesOffset +
+      nodes.size() * sizeof(MappedTreeNode));
+  header.size = header.boundsOffset + nodes.size() * dim * sizeof(math::Range);
+
+  stream.write(reinterpret_cast<const char*>(&header),
+      sizeof(MappedTreeHeader));
+  size_t position = data::MappedPad(stream, sizeof(MappedTreeHeader));
+
+  stream.write(reinterpret_cast<const char*>(dataset->memptr()),
+      dataset->n_elem * sizeof(ElemType));
+  position = data::MappedPad(stream, position +
+      dataset->n_elem * sizeof(ElemType));
+
+  stream.write(reinterpret_cast<const char*>(records.data()),
+      records.size() * sizeof(MappedTreeNode));
+  data::MappedPad(stream, position + records.size() * sizeof(MappedTreeNode));
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+    for (size_t d = 0; d < dim; ++d)
+      stream.write(reinterpret_cast<const char*>(&nodes[i]->bound[d]),
+          sizeof(math::Range));
+
+  if (!stream)
+  {
+    throw std::runtime_error("BinarySpaceTree::SaveMapped(): error writing "
+        "tree image");
+  }
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -1049,7 +1940,11 @@ BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     stat(*this),
     parentDistance(0),
     furthestDescendantDistance(0),
-    dataset(NULL)
+    dataset(NULL),
+    frozen(false),
+    frozenNodes(NULL),
+    frozenRanges(NULL),
+    modifications(0)
 {
   // Nothing to do.
 }
@@ -1070,16 +1965,11 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
   // If we're loading, and we have children, they need to be deleted.
   if (cereal::is_loading<Archive>())
   {
-    if (left)
-      delete left;
-    if (right)
-      delete right;
+    DeleteChildren();
     if (!parent)
       delete dataset;
 
     parent = NULL;
-    left = NULL;
-    right = NULL;
   }
 
   ar(CEREAL_NVP(begin));
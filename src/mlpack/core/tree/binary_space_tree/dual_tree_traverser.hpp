@@ -16,12 +16,18 @@
 #define MLPACK_CORE_TREE_BINARY_SPACE_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 #include "binary_space_tree.hpp"
 
 namespace mlpack {
 namespace tree {
 
+// This gives us a HasBatchBaseCaseCheck<T, U> type (where U is a function
+// pointer) that is used to detect rules that can evaluate the base cases of a
+// pair of leaves at once.
+HAS_MEM_FUNC(BatchBaseCase, HasBatchBaseCaseCheck);
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -86,6 +92,33 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Traversal information, held in the class so that it isn't continually
   //! being reallocated.
   typename RuleType::TraversalInfoType traversalInfo;
+
+  //! The query points of the current leaf that were not pruned, held in the
+  //! class so that it isn't continually being reallocated.
+  std::vector<size_t> batchQueries;
+
+  //! Signature of the batched base case of the rules, if they have one.
+  typedef void (RuleType::*BatchBaseCaseType)(const std::vector<size_t>&,
+                                              BinarySpaceTree&);
+
+  /**
+   * Evaluate the base cases between the points of two leaves.  Each query
+   * point is first scored against the reference leaf; if the rules have a
+   * BatchBaseCase(queryIndices, referenceNode) method, the base cases of all of
+   * the query points that were not pruned are then evaluated by a single call
+   * to it (std::true_type), and otherwise BaseCase() is called for each pair
+   * (std::false_type).
+   *
+   * @param queryNode The query leaf.
+   * @param referenceNode The reference leaf.
+   */
+  void LeafBaseCases(BinarySpaceTree& queryNode,
+                     BinarySpaceTree& referenceNode,
+                     const std::true_type& /* hasBatchBaseCase */);
+
+  void LeafBaseCases(BinarySpaceTree& queryNode,
+                     BinarySpaceTree& referenceNode,
+                     const std::false_type& /* hasBatchBaseCase */);
 };
 
 } // namespace tree
@@ -0,0 +1,83 @@
+/**
+ * @file core/tree/binary_space_tree/mapped_layout.hpp
+ *
+ * Definition of the records that make up the flat binary image of a
+ * BinarySpaceTree written by BinarySpaceTree::SaveMapped().  The image can be
+ * memory-mapped and used in place.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_LAYOUT_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_LAYOUT_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The header at the start of a tree image.  It is followed by three sections,
+ * each aligned to 64 bytes: the dataset (column-major, as stored by Armadillo),
+ * one MappedTreeNode per node in breadth-first order, and the ranges of the
+ * bound of each node (in the same order).  All offsets are relative to the
+ * start of the header.
+ */
+struct MappedTreeHeader
+{
+  //! Identifies the image; always "MLPKBST".
+  char magic[8];
+  //! Version of the layout.
+  uint64_t version;
+  //! Size in bytes of each element of the dataset.
+  uint64_t elemSize;
+  //! Dimensionality of the dataset.
+  uint64_t dimensionality;
+  //! Number of points in the dataset.
+  uint64_t points;
+  //! Number of nodes in the tree.
+  uint64_t nodes;
+  //! Offset of the dataset.
+  uint64_t datasetOffset;
+  //! Offset of the node records.
+  uint64_t nodesOffset;
+  //! Offset of the bound ranges.
+  uint64_t boundsOffset;
+  //! Total size of the image.
+  uint64_t size;
+};
+
+/**
+ * The record describing a single node of a tree image.  Children are given by
+ * their index in the breadth-first order; since the root is never a child, 0
+ * denotes a missing child.
+ */
+struct MappedTreeNode
+{
+  //! The index of the first point held by the node.
+  uint64_t begin;
+  //! The number of points held by the node.
+  uint64_t count;
+  //! The index of the left child, or 0.
+  uint64_t left;
+  //! The index of the right child, or 0.
+  uint64_t right;
+  //! The distance from the center of the node to the center of its parent.
+  double parentDistance;
+  //! The furthest descendant distance of the node.
+  double furthestDescendantDistance;
+  //! The minimum bound distance of the node.
+  double minimumBoundDistance;
+  //! The minimum width of the bound of the node.
+  double minWidth;
+};
+
+//! The current version of the tree image layout.
+static const uint64_t mappedTreeVersion = 1;
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
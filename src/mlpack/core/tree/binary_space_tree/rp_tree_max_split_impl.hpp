@@ -28,7 +28,9 @@ bool RPTreeMaxSplit<BoundType, MatType>::SplitNode(const BoundType& /* bound */,
 {
   splitInfo.direction.zeros(data.n_rows);
 
-  // Get the normal to the hyperplane.
+  // Get the normal to the hyperplane.  The random number generator is shared,
+  // so children that are built in parallel must take turns using it.
+  #pragma omp critical(binarySpaceTreeRandom)
   math::RandVector(splitInfo.direction);
 
   // Get the value according to which we will perform the split.
@@ -49,6 +51,7 @@ bool RPTreeMaxSplit<BoundType, MatType>::GetSplitVal(
   arma::uvec samples;
 
   // Get no more than numSamples distinct samples.
+  #pragma omp critical(binarySpaceTreeRandom)
   math::ObtainDistinctSamples(begin, begin + count, numSamples, samples);
 
   arma::Col<ElemType> values(samples.n_elem);
@@ -72,8 +75,11 @@ bool RPTreeMaxSplit<BoundType, MatType>::GetSplitVal(
   //   2. The proposed method does not appear to guarantee that a valid split
   //      value will be generated (i.e. it can produce a split value where there
   //      may be no points on the left or the right).
-  splitVal += math::Random((minimum - splitVal) * 0.75,
+  ElemType deviation;
+  #pragma omp critical(binarySpaceTreeRandom)
+  deviation = math::Random((minimum - splitVal) * 0.75,
       (maximum - splitVal) * 0.75);
+  splitVal += deviation;
 
   if (splitVal == maximum)
     splitVal = minimum;
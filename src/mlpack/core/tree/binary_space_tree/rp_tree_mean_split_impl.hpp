@@ -29,7 +29,10 @@ bool RPTreeMeanSplit<BoundType, MatType>::SplitNode(const BoundType&  bound,
   const size_t numSamples = std::min(maxNumSamples, count);
   arma::uvec samples;
 
-  // Get no more than numSamples distinct samples.
+  // Get no more than numSamples distinct samples.  The random number generator
+  // is shared, so children that are built in parallel must take turns using
+  // it.
+  #pragma omp critical(binarySpaceTreeRandom)
   math::ObtainDistinctSamples(begin, begin + count, numSamples, samples);
 
   // Find the average distance between points.
@@ -45,6 +48,7 @@ bool RPTreeMeanSplit<BoundType, MatType>::SplitNode(const BoundType&  bound,
     splitInfo.direction.zeros(data.n_rows);
 
     // Get a random normal vector.
+    #pragma omp critical(binarySpaceTreeRandom)
     math::RandVector(splitInfo.direction);
 
     // Get the median value of the scalar products of the normal and the
@@ -45,17 +45,30 @@ bool UBTreeSplit<BoundType, MatType>::SplitNode(BoundType& bound,
     splitInfo.addresses = NULL;
   }
 
+  // Set the minimum and the maximum addresses.
+  for (size_t k = 0; k < bound.Dim(); ++k)
+  {
+    bound.LoAddress()[k] = addresses[begin].first[k];
+    bound.HiAddress()[k] = addresses[begin + count - 1].first[k];
+  }
+  bound.UpdateAddressBounds(data.cols(begin, begin + count - 1));
+
   // The bound shouldn't contain too many subrectangles.
   // In order to minimize the number of hyperrectangles we set last bits
-  // of the last address in the node to 1 and last bits of the first  address
-  // in the next node to zero in such a way that the ordering is not
-  // disturbed.
-  if (begin + count < data.n_cols)
+  // of the last address in the left child to 1 and last bits of the first
+  // address in the right child to zero in such a way that the ordering is not
+  // disturbed.  This is done here rather than when the children are split, so
+  // that a node never modifies the addresses of points outside of it, and the
+  // children can be split in parallel.  PerformSplit() splits the node at
+  // splitCol.  (Equal addresses have no insignificant bits to replace.)
+  const size_t splitCol = begin + count / 2;
+  if (bound::addr::CompareAddresses(addresses[splitCol - 1].first,
+      addresses[splitCol].first) != 0)
   {
     // Omit leading equal bits.
     size_t row = 0;
-    arma::Col<AddressElemType>& lo = addresses[begin + count - 1].first;
-    const arma::Col<AddressElemType>& hi = addresses[begin + count].first;
+    arma::Col<AddressElemType>& lo = addresses[splitCol - 1].first;
+    const arma::Col<AddressElemType>& hi = addresses[splitCol].first;
 
     for (; row < data.n_rows; row++)
       if (lo[row] != hi[row])
@@ -88,17 +101,13 @@ bool UBTreeSplit<BoundType, MatType>::SplitNode(BoundType& bound,
         lo[row] |= ((AddressElemType) 1 << (order - 1 - bit));
   }
 
-  // The bound shouldn't contain too many subrectangles.
-  // In order to minimize the number of hyperrectangles we set last bits
-  // of the first address in the next node to 0 and last bits of the last
-  // address in the previous node to 1 in such a way that the ordering is not
-  // disturbed.
-  if (begin > 0)
+  if (bound::addr::CompareAddresses(addresses[splitCol - 1].first,
+      addresses[splitCol].first) != 0)
   {
     // Omit leading equal bits.
     size_t row = 0;
-    const arma::Col<AddressElemType>& lo = addresses[begin - 1].first;
-    arma::Col<AddressElemType>& hi = addresses[begin].first;
+    const arma::Col<AddressElemType>& lo = addresses[splitCol - 1].first;
+    arma::Col<AddressElemType>& hi = addresses[splitCol].first;
 
     for (; row < data.n_rows; row++)
       if (lo[row] != hi[row])
@@ -131,14 +140,6 @@ bool UBTreeSplit<BoundType, MatType>::SplitNode(BoundType& bound,
         hi[row] &= ~((AddressElemType) 1 << (order - 1 - bit));
   }
 
-  // Set the minimum and the maximum addresses.
-  for (size_t k = 0; k < bound.Dim(); ++k)
-  {
-    bound.LoAddress()[k] = addresses[begin].first[k];
-    bound.HiAddress()[k] = addresses[begin + count - 1].first[k];
-  }
-  bound.UpdateAddressBounds(data.cols(begin, begin + count - 1));
-
   return true;
 }
 
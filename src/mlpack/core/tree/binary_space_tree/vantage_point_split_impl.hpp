@@ -47,7 +47,10 @@ SelectVantagePoint(const MetricType& metric, const MatType& data,
   arma::uvec vantagePointCandidates;
   arma::Col<ElemType> distances(MaxNumSamples);
 
-  // Get no more than max(MaxNumSamples, count) vantage point candidates
+  // Get no more than max(MaxNumSamples, count) vantage point candidates.  The
+  // random number generator is shared, so children that are built in parallel
+  // must take turns using it.
+  #pragma omp critical(binarySpaceTreeRandom)
   math::ObtainDistinctSamples(begin, begin + count, MaxNumSamples,
       vantagePointCandidates);
 
@@ -58,6 +61,7 @@ SelectVantagePoint(const MetricType& metric, const MatType& data,
   for (size_t i = 0; i < vantagePointCandidates.n_elem; ++i)
   {
     // Get no more than min(MaxNumSamples, count) random samples
+    #pragma omp critical(binarySpaceTreeRandom)
     math::ObtainDistinctSamples(begin, begin + count, MaxNumSamples, samples);
 
     // Calculate the second moment of the distance to the vantage point
@@ -88,6 +88,27 @@ class HRectBound
    */
   void Clear();
 
+  /**
+   * Move the ranges of this bound into the given memory, which must hold at
+   * least Dim() ranges.  The bound will not free that memory, so it must
+   * outlive the bound.  This is used to store the bounds of many nodes of a
+   * tree contiguously (see BinarySpaceTree::Freeze()).
+   *
+   * @param memory Memory to store the ranges of this bound in.
+   */
+  void Relocate(math::RangeType<ElemType>* memory);
+
+  /**
+   * Make this bound use the ranges already stored in the given memory, without
+   * copying them.  The bound will not free that memory, so it must outlive the
+   * bound.  This is used when a tree is used in place from a memory-mapped
+   * file.  MinWidth() is not recomputed.
+   *
+   * @param memory Memory holding the ranges of this bound.
+   * @param dimension Dimensionality of the bound.
+   */
+  void Alias(math::RangeType<ElemType>* memory, const size_t dimension);
+
   //! Gets the dimensionality.
   size_t Dim() const { return dim; }
 
@@ -236,6 +257,8 @@ class HRectBound
   size_t dim;
   //! The bounds for each dimension.
   math::RangeType<ElemType>* bounds;
+  //! If true, the bound owns the memory of bounds and must free it.
+  bool ownsBounds;
   //! Cached minimum width of bound.
   ElemType minWidth;
   //! Instantiated metric (likely has size 0).
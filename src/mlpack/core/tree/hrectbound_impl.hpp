@@ -27,6 +27,7 @@ template<typename MetricType, typename ElemType>
 inline HRectBound<MetricType, ElemType>::HRectBound() :
     dim(0),
     bounds(NULL),
+    ownsBounds(true),
     minWidth(0)
 { /* Nothing to do. */ }
 
@@ -38,6 +39,7 @@ template<typename MetricType, typename ElemType>
 inline HRectBound<MetricType, ElemType>::HRectBound(const size_t dimension) :
     dim(dimension),
     bounds(new math::RangeType<ElemType>[dim]),
+    ownsBounds(true),
     minWidth(0)
 { /* Nothing to do. */ }
 
@@ -49,6 +51,7 @@ inline HRectBound<MetricType, ElemType>::HRectBound(
     const HRectBound<MetricType, ElemType>& other) :
     dim(other.Dim()),
     bounds(new math::RangeType<ElemType>[dim]),
+    ownsBounds(true),
     minWidth(other.MinWidth())
 {
   // Copy other bounds over.
@@ -71,11 +74,12 @@ inline HRectBound<
   if (dim != other.Dim())
   {
     // Reallocation is necessary.
-    if (bounds)
+    if (bounds && ownsBounds)
       delete[] bounds;
 
     dim = other.Dim();
     bounds = new math::RangeType<ElemType>[dim];
+    ownsBounds = true;
   }
 
   // Now copy each of the bound values.
@@ -95,11 +99,13 @@ inline HRectBound<MetricType, ElemType>::HRectBound(
     HRectBound<MetricType, ElemType>&& other) :
     dim(other.dim),
     bounds(other.bounds),
+    ownsBounds(other.ownsBounds),
     minWidth(other.minWidth)
 {
   // Fix the other bound.
   other.dim = 0;
   other.bounds = NULL;
+  other.ownsBounds = true;
   other.minWidth = 0.0;
 }
 
@@ -109,7 +115,7 @@ inline HRectBound<MetricType, ElemType>::HRectBound(
 template<typename MetricType, typename ElemType>
 inline HRectBound<MetricType, ElemType>::~HRectBound()
 {
-  if (bounds)
+  if (bounds && ownsBounds)
     delete[] bounds;
 }
 
@@ -124,6 +130,39 @@ inline void HRectBound<MetricType, ElemType>::Clear()
   minWidth = 0;
 }
 
+/**
+ * Move the ranges into the given memory, which the bound will not free.
+ */
+template<typename MetricType, typename ElemType>
+inline void HRectBound<MetricType, ElemType>::Relocate(
+    math::RangeType<ElemType>* memory)
+{
+  for (size_t i = 0; i < dim; ++i)
+    memory[i] = bounds[i];
+
+  if (bounds && ownsBounds)
+    delete[] bounds;
+
+  bounds = memory;
+  ownsBounds = false;
+}
+
+/**
+ * Use the ranges already stored in the given memory.
+ */
+template<typename MetricType, typename ElemType>
+inline void HRectBound<MetricType, ElemType>::Alias(
+    math::RangeType<ElemType>* memory,
+    const size_t dimension)
+{
+  if (bounds && ownsBounds)
+    delete[] bounds;
+
+  dim = dimension;
+  bounds = memory;
+  ownsBounds = false;
+}
+
 /***
  * Calculates the centroid of the range, placing it into the given vector.
  *
@@ -515,8 +554,10 @@ HRectBound<MetricType, ElemType>::operator|=(const MatType& data)
 {
   Log::Assert(data.n_rows == dim);
 
-  arma::Col<ElemType> mins(min(data, 1));
-  arma::Col<ElemType> maxs(max(data, 1));
+  // The data may be of lower precision than the bound (e.g. float data).
+  typedef typename MatType::elem_type DataElemType;
+  arma::Col<DataElemType> mins(min(data, 1));
+  arma::Col<DataElemType> maxs(max(data, 1));
 
   minWidth = std::numeric_limits<ElemType>::max();
   for (size_t i = 0; i < dim; ++i)
@@ -666,6 +707,13 @@ void HRectBound<MetricType, ElemType>::serialize(
     Archive& ar,
     const uint32_t /* version */)
 {
+  // If we're loading into memory we don't own, we must not free it.
+  if (cereal::is_loading<Archive>() && !ownsBounds)
+  {
+    bounds = NULL;
+    ownsBounds = true;
+  }
+
   // We can't serialize a raw array directly, so wrap it.
   ar(CEREAL_POINTER_ARRAY(bounds, dim));
   ar(CEREAL_NVP(minWidth));
@@ -16,6 +16,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/range_search/range_search.hpp>
 #include <mlpack/methods/emst/union_find.hpp>
+#include <mlpack/methods/emst/concurrent_union_find.hpp>
 #include "random_point_selection.hpp"
 #include "ordered_point_selection.hpp"
 #include <boost/dynamic_bitset.hpp>
@@ -44,6 +45,19 @@ namespace dbscan {
  * range search technique used and the point selection strategy by means of
  * template parameters.
  *
+ * In the batch and pointwise modes, every pair of points within epsilon of
+ * each other is linked, and clusters with fewer than minPoints points are
+ * discarded as noise.  The parallel mode (see Parallel()) follows the
+ * definitions of the paper instead: a point is a core point if at least
+ * minPoints points (including itself) are within epsilon of it; clusters are
+ * linked only through core points, and every other point joins the cluster of
+ * its core neighbor with the smallest index, or is noise if it has none.  The
+ * core points are found with a first pass that only counts neighbors, and the
+ * clusters are then linked while the range search runs, so that no neighbors
+ * are ever stored; both passes, and the linking (with a ConcurrentUnionFind),
+ * are done in parallel when OpenMP is available.  The point selection policy
+ * is not used in the parallel mode.
+ *
  * @tparam RangeSearchType Class to use for range searching.
  * @tparam PointSelectionPolicy Strategy for selecting next point to cluster
  *      with.
@@ -112,6 +126,12 @@ class DBSCAN
                  arma::Row<size_t>& assignments,
                  arma::mat& centroids);
 
+  //! Get whether the parallel mode is used.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the parallel mode is used.  If true, this overrides the
+  //! batch mode.
+  bool& Parallel() { return parallel; }
+
  private:
   //! Maximum distance between two points to be part of same cluster.
   double epsilon;
@@ -123,6 +143,9 @@ class DBSCAN
   //! Whether or not to perform the search in batch mode.  If false, single
   bool batchMode;
 
+  //! Whether or not to cluster with core points in parallel.
+  bool parallel;
+
   //! Instantiated range search policy.
   RangeSearchType rangeSearch;
 
@@ -155,6 +178,19 @@ class DBSCAN
   template<typename MatType>
   void BatchCluster(const MatType& data,
                     emst::UnionFind& uf);
+
+  /**
+   * Performs DBSCAN clustering on the data with core points, returning the
+   * number of clusters and also the list of cluster assignments.  The core
+   * points are found by counting neighbors, and the clusters are linked while
+   * the range search runs, in parallel.
+   *
+   * @param data Dataset to cluster.
+   * @param assignments Vector to store cluster assignments.
+   */
+  template<typename MatType>
+  size_t ParallelCluster(const MatType& data,
+                         arma::Row<size_t>& assignments);
 };
 
 } // namespace dbscan
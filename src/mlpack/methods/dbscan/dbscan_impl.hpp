@@ -30,6 +30,7 @@ DBSCAN<RangeSearchType, PointSelectionPolicy>::DBSCAN(
     epsilon(epsilon),
     minPoints(minPoints),
     batchMode(batchMode),
+    parallel(false),
     rangeSearch(rangeSearch),
     pointSelector(pointSelector)
 {
@@ -100,6 +101,12 @@ size_t DBSCAN<RangeSearchType, PointSelectionPolicy>::Cluster(
     const MatType& data,
     arma::Row<size_t>& assignments)
 {
+  if (parallel)
+  {
+    rangeSearch.Train(data);
+    return ParallelCluster(data, assignments);
+  }
+
   // Initialize the UnionFind object.
   emst::UnionFind uf(data.n_cols);
   rangeSearch.Train(data);
@@ -199,6 +206,78 @@ void DBSCAN<RangeSearchType, PointSelectionPolicy>::BatchCluster(
   }
 }
 
+/**
+ * Performs DBSCAN clustering on the data with core points, returning the number
+ * of clusters and also the list of cluster assignments.
+ */
+template<typename RangeSearchType, typename PointSelectionPolicy>
+template<typename MatType>
+size_t DBSCAN<RangeSearchType, PointSelectionPolicy>::ParallelCluster(
+    const MatType& data,
+    arma::Row<size_t>& assignments)
+{
+  const math::Range range(0.0, epsilon);
+
+  // A point is a core point if it has at least minNeighbors other points in its
+  // epsilon-neighborhood.  Only the number of neighbors is needed, so the
+  // neighbors are not stored.
+  const size_t minNeighbors = (minPoints > 0) ? minPoints - 1 : 0;
+  arma::Col<size_t> counts;
+  if (minNeighbors > 0)
+  {
+    Log::Info << "Counting neighbors." << std::endl;
+    rangeSearch.Count(range, counts);
+  }
+  else
+  {
+    counts.zeros(data.n_cols);
+  }
+
+  // Link the core points that are neighbors, and find the core neighbor with
+  // the smallest index of every other point.  All of the results of a point are
+  // given by the same thread, so only that thread writes its core neighbor.
+  emst::ConcurrentUnionFind uf(data.n_cols);
+  arma::Col<size_t> coreNeighbors(data.n_cols);
+  coreNeighbors.fill(SIZE_MAX);
+  Log::Info << "Linking core points." << std::endl;
+  rangeSearch.Search(range, [&](const size_t query,
+                                const size_t reference,
+                                const double /* distance */)
+  {
+    if (counts[reference] < minNeighbors)
+      return;
+
+    if (counts[query] >= minNeighbors)
+      uf.Union(query, reference);
+    else if (reference < coreNeighbors[query])
+      coreNeighbors[query] = reference;
+  });
+
+  // Number the clusters in the order of their first point.
+  assignments.set_size(data.n_cols);
+  arma::Col<size_t> labels(data.n_cols);
+  labels.fill(SIZE_MAX);
+  size_t numClusters = 0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const size_t core = (counts[i] >= minNeighbors) ? i : coreNeighbors[i];
+    if (core == SIZE_MAX)
+    {
+      assignments[i] = SIZE_MAX;
+      continue;
+    }
+
+    const size_t root = uf.Find(core);
+    if (labels[root] == SIZE_MAX)
+      labels[root] = numClusters++;
+    assignments[i] = labels[root];
+  }
+
+  Log::Info << numClusters << " clusters found." << std::endl;
+
+  return numClusters;
+}
+
 } // namespace dbscan
 } // namespace mlpack
 
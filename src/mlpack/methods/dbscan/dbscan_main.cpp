@@ -63,7 +63,17 @@ BINDING_LONG_DESC(
     " 'hilbert-r', 'r-plus', 'r-plus-plus', 'cover', 'ball'. The " +
     PRINT_PARAM_STRING("single_mode") + " parameter will force single-tree "
     "search (as opposed to the default dual-tree search), and '" +
-    PRINT_PARAM_STRING("naive") + " will force brute-force range search.");
+    PRINT_PARAM_STRING("naive") + " will force brute-force range search."
+    "\n\n"
+    "If the " + PRINT_PARAM_STRING("parallel") + " flag is given, the "
+    "clusters are found from core points (points with at least " +
+    PRINT_PARAM_STRING("min_size") + " points within " +
+    PRINT_PARAM_STRING("epsilon") + ", including themselves) as in the "
+    "original DBSCAN paper, in parallel: a first range search only counts the "
+    "neighbors of each point, and a second one links the core points as "
+    "their neighbors are found, so that no neighbors are stored.  This is "
+    "faster and uses less memory on large datasets.  Points that are not "
+    "core points join the cluster of a neighboring core point, or are noise.");
 
 // Example.
 BINDING_EXAMPLE(
@@ -98,6 +108,8 @@ PARAM_FLAG("single_mode", "If set, single-tree range search (not dual-tree) "
     "will be used.", "S");
 PARAM_FLAG("naive", "If set, brute-force range search (not tree-based) "
     "will be used.", "N");
+PARAM_FLAG("parallel", "If set, the clusters are found from core points in "
+    "parallel, without storing the neighbors of each point.", "P");
 
 // Actually run the clustering, and process the output.
 template<typename RangeSearchType, typename PointSelectionPolicy>
@@ -115,6 +127,7 @@ void RunDBSCAN(RangeSearchType rs,
 
   DBSCAN<RangeSearchType, PointSelectionPolicy> d(epsilon, minSize,
       !IO::HasParam("single_mode"), rs, pointSelector);
+  d.Parallel() = IO::HasParam("parallel");
 
   // If possible, avoid the overhead of calculating centroids.
   if (IO::HasParam("centroids"))
@@ -152,6 +165,7 @@ static void mlpackMain()
       "no output will be saved");
 
   ReportIgnoredParam({{ "naive", true }}, "single_mode");
+  ReportIgnoredParam({{ "parallel", true }}, "selection_type");
 
   RequireParamInSet<string>("tree_type", { "kd", "cover", "r", "r-star", "x",
       "hilbert-r", "r-plus", "r-plus-plus", "ball" }, true,
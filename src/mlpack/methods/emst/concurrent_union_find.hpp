@@ -0,0 +1,112 @@
+/**
+ * @file methods/emst/concurrent_union_find.hpp
+ *
+ * Implements a union-find data structure that may be used by several threads at
+ * once.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_EMST_CONCURRENT_UNION_FIND_HPP
+#define MLPACK_METHODS_EMST_CONCURRENT_UNION_FIND_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include <atomic>
+
+namespace mlpack {
+namespace emst {
+
+/**
+ * A lock-free Union-Find data structure, with the same interface as UnionFind,
+ * whose Find() and Union() may be called by several threads at once.
+ *
+ * The root of a component is always its point with the smallest index: Union()
+ * links the root with the larger index to the other one, with a
+ * compare-and-swap that is retried if another thread changed the root in the
+ * meantime.  Find() shortens the paths it follows by path halving.  Since
+ * linking by index does not bound the depth of the trees like union by rank
+ * does, the paths are only short in practice, not in the worst case.
+ */
+class ConcurrentUnionFind
+{
+ private:
+  //! The parent of each point; a root is its own parent.
+  std::vector<std::atomic<size_t>> parent;
+
+ public:
+  //! Construct the object with the given size.
+  ConcurrentUnionFind(const size_t size) : parent(size)
+  {
+    for (size_t i = 0; i < size; ++i)
+      parent[i].store(i, std::memory_order_relaxed);
+  }
+
+  //! Get the number of points.
+  size_t Size() const { return parent.size(); }
+
+  /**
+   * Returns the component containing an element, which is the smallest index of
+   * the points in the component.
+   *
+   * @param x the component to be found
+   * @return The index of the component containing x
+   */
+  size_t Find(size_t x)
+  {
+    while (true)
+    {
+      size_t xParent = parent[x].load(std::memory_order_relaxed);
+      if (xParent == x)
+        return x;
+
+      const size_t grandparent = parent[xParent].load(
+          std::memory_order_relaxed);
+      if (grandparent == xParent)
+        return xParent;
+
+      // Point x to its grandparent.  If another thread has changed the parent
+      // of x in the meantime, its new parent is at least as close to the root,
+      // so the failure can be ignored.
+      parent[x].compare_exchange_weak(xParent, grandparent,
+          std::memory_order_relaxed);
+      x = grandparent;
+    }
+  }
+
+  /**
+   * Union the components containing x and y.
+   *
+   * @param x one component
+   * @param y the other component
+   * @return true if the components were different and have been united, false
+   *     if x and y were already in the same component.
+   */
+  bool Union(size_t x, size_t y)
+  {
+    while (true)
+    {
+      x = Find(x);
+      y = Find(y);
+
+      if (x == y)
+        return false;
+
+      // Link the larger root to the smaller one.  This fails if the larger
+      // root has been linked by another thread since it was found.
+      if (x < y)
+        std::swap(x, y);
+      size_t expected = x;
+      if (parent[x].compare_exchange_strong(expected, y,
+          std::memory_order_acq_rel))
+        return true;
+    }
+  }
+}; // class ConcurrentUnionFind
+
+} // namespace emst
+} // namespace mlpack
+
+#endif // MLPACK_METHODS_EMST_CONCURRENT_UNION_FIND_HPP
@@ -25,6 +25,7 @@
 #ifndef MLPACK_METHODS_EMST_DTB_HPP
 #define MLPACK_METHODS_EMST_DTB_HPP
 
+#include "concurrent_union_find.hpp"
 #include "dtb_stat.hpp"
 #include "edge_pair.hpp"
 
@@ -68,6 +69,11 @@ namespace emst /** Euclidean Minimum Spanning Trees. */ {
  * More advanced usage of the class can use different types of trees, pass in an
  * already-built tree, or compute the MST using the O(n^2) naive algorithm.
  *
+ * When OpenMP is available, the nearest neighbors of the components are
+ * searched for in parallel in each Boruvka iteration (the tree is split into
+ * subtrees, whose points are searched for by different threads), and the edges
+ * that are found are added in parallel with a ConcurrentUnionFind.
+ *
  * @tparam MetricType The metric to use.
  * @tparam MatType The type of data matrix to use.
  * @tparam TreeType Type of tree to use.  This should follow the TreeType policy
@@ -103,14 +109,19 @@ class DualTreeBoruvka
   std::vector<EdgePair> edges; // We must use vector with non-numerical types.
 
   //! Connections.
-  UnionFind connections;
-
-  //! List of edge nodes.
-  arma::Col<size_t> neighborsInComponent;
-  //! List of edge nodes.
-  arma::Col<size_t> neighborsOutComponent;
-  //! List of edge distances.
-  arma::vec neighborsDistances;
+  ConcurrentUnionFind connections;
+
+  //! The component of each point in the current iteration.
+  arma::Col<size_t> components;
+  //! The distance of the candidate edge of each component.
+  std::vector<std::atomic<double>> componentDistances;
+  //! The distance of the candidate edge of each point.
+  arma::vec pointDistances;
+  //! The other endpoint of the candidate edge of each point.
+  arma::Col<size_t> pointNeighbors;
+  //! The core distance of each point (in the order of the tree's dataset), or
+  //! empty if the edges are weighted by the distance alone.
+  arma::vec coreDistances;
 
   //! Total distance of the tree.
   double totalDist;
@@ -118,12 +129,17 @@ class DualTreeBoruvka
   //! The instantiated metric.
   MetricType metric;
 
-  //! For sorting the edge list after the computation.
+  //! For sorting the edge list after the computation.  Since the edges may be
+  //! found in any order, edges with the same distance are sorted by index.
   struct SortEdgesHelper
   {
     bool operator()(const EdgePair& pairA, const EdgePair& pairB)
     {
-      return (pairA.Distance() < pairB.Distance());
+      if (pairA.Distance() != pairB.Distance())
+        return (pairA.Distance() < pairB.Distance());
+      if (pairA.Lesser() != pairB.Lesser())
+        return (pairA.Lesser() < pairB.Lesser());
+      return (pairA.Greater() < pairB.Greater());
     }
   } SortFun;
 
@@ -175,6 +191,20 @@ class DualTreeBoruvka
    */
   void ComputeMST(arma::mat& results);
 
+  /**
+   * Compute the minimum spanning tree of the points with the edges weighted by
+   * the mutual reachability distance, max(d(a, b), core(a), core(b)), instead
+   * of the distance d(a, b).  This is the spanning tree used by HDBSCAN.  The
+   * results have the same format as ComputeMST(results), with the mutual
+   * reachability distance in the third row.
+   *
+   * @param results Matrix which results will be stored in.
+   * @param coreDistances The core distance of each point, in the order of the
+   *     dataset that was given to the constructor; if empty, the edges are
+   *     weighted by the distance alone.
+   */
+  void ComputeMST(arma::mat& results, const arma::vec& coreDistances);
+
  private:
   /**
    * Adds a single edge to the edge list
@@ -186,6 +216,11 @@ class DualTreeBoruvka
    */
   void AddAllEdges();
 
+  /**
+   * Split the tree into subtrees whose points can be searched for in parallel.
+   */
+  std::vector<Tree*> QuerySubtrees() const;
+
   /**
    * Unpermute the edge list and output it to results.
    */
@@ -198,7 +233,8 @@ class DualTreeBoruvka
   void CleanupHelper(Tree* tree);
 
   /**
-   * The values stored in the tree must be reset on each iteration.
+   * The values stored in the tree must be reset on each iteration, and the
+   * components of the points are updated.
    */
   void Cleanup();
 }; // class DualTreeBoruvka
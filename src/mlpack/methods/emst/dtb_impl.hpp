@@ -14,6 +14,10 @@
 
 #include "dtb_rules.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace emst {
 
@@ -58,15 +62,22 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     ownTree(!naive),
     naive(naive),
     connections(dataset.n_cols),
+    componentDistances(dataset.n_cols),
     totalDist(0.0),
     metric(metric)
 {
   edges.reserve(data.n_cols - 1); // Set size.
 
-  neighborsInComponent.set_size(data.n_cols);
-  neighborsOutComponent.set_size(data.n_cols);
-  neighborsDistances.set_size(data.n_cols);
-  neighborsDistances.fill(DBL_MAX);
+  // Each point starts in its own component.
+  components.set_size(data.n_cols);
+  pointNeighbors.set_size(data.n_cols);
+  pointDistances.set_size(data.n_cols);
+  pointDistances.fill(DBL_MAX);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    components[i] = i;
+    componentDistances[i].store(DBL_MAX, std::memory_order_relaxed);
+  }
 }
 
 template<
@@ -83,15 +94,22 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     ownTree(false),
     naive(false),
     connections(data.n_cols),
+    componentDistances(data.n_cols),
     totalDist(0.0),
     metric(metric)
 {
   edges.reserve(data.n_cols - 1); // Fill with EdgePairs.
 
-  neighborsInComponent.set_size(data.n_cols);
-  neighborsOutComponent.set_size(data.n_cols);
-  neighborsDistances.set_size(data.n_cols);
-  neighborsDistances.fill(DBL_MAX);
+  // Each point starts in its own component.
+  components.set_size(data.n_cols);
+  pointNeighbors.set_size(data.n_cols);
+  pointDistances.set_size(data.n_cols);
+  pointDistances.fill(DBL_MAX);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    components[i] = i;
+    componentDistances[i].store(DBL_MAX, std::memory_order_relaxed);
+  }
 }
 
 template<
@@ -119,26 +137,94 @@ template<
 void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
     arma::mat& results)
 {
+  ComputeMST(results, arma::vec());
+}
+
+/**
+ * Iteratively find the nearest neighbor of each component with the mutual
+ * reachability distance until the MST is complete.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
+    arma::mat& results,
+    const arma::vec& coreDistances)
+{
+  if (coreDistances.n_elem != 0 && coreDistances.n_elem != data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "DualTreeBoruvka::ComputeMST(): the number of core distances ("
+        << coreDistances.n_elem << ") must be equal to the number of points ("
+        << data.n_cols << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The rules see the points in the order of the tree's dataset.
+  if (coreDistances.n_elem != 0 && !naive && ownTree &&
+      tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    this->coreDistances.set_size(data.n_cols);
+    for (size_t i = 0; i < data.n_cols; ++i)
+      this->coreDistances[i] = coreDistances[oldFromNew[i]];
+  }
+  else
+  {
+    this->coreDistances = coreDistances;
+  }
+  const arma::vec* core = (this->coreDistances.n_elem != 0) ?
+      &this->coreDistances : NULL;
+
   Timer::Start("emst/mst_computation");
 
   totalDist = 0; // Reset distance.
 
   typedef DTBRules<MetricType, Tree> RuleType;
-  RuleType rules(data, connections, neighborsDistances, neighborsInComponent,
-                 neighborsOutComponent, metric);
+
+  // The subtrees do not change between iterations.
+  const std::vector<Tree*> subtrees = naive ? std::vector<Tree*>() :
+      QuerySubtrees();
+
+  size_t baseCases = 0;
+  size_t scores = 0;
   while (edges.size() < (data.n_cols - 1))
   {
     if (naive)
     {
-      // Full O(N^2) traversal.
-      for (size_t i = 0; i < data.n_cols; ++i)
-        for (size_t j = 0; j < data.n_cols; ++j)
-          rules.BaseCase(i, j);
+      // Full O(N^2) traversal.  Each thread searches for the neighbors of its
+      // own query points.
+      #pragma omp parallel reduction(+:baseCases)
+      {
+        RuleType rules(data, components, componentDistances, pointDistances,
+            pointNeighbors, metric, core);
+
+        #pragma omp for schedule(dynamic)
+        for (omp_size_t i = 0; i < (omp_size_t) data.n_cols; ++i)
+          for (size_t j = 0; j < data.n_cols; ++j)
+            rules.BaseCase(i, j);
+
+        baseCases += rules.BaseCases();
+      }
     }
     else
     {
-      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-      traverser.Traverse(*tree, *tree);
+      // Each subtree is a query tree of its own, with its own traversal state.
+      #pragma omp parallel for \
+          schedule(dynamic) \
+          reduction(+:baseCases, scores)
+      for (omp_size_t i = 0; i < (omp_size_t) subtrees.size(); ++i)
+      {
+        RuleType rules(data, components, componentDistances, pointDistances,
+            pointNeighbors, metric, core);
+        typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+        traverser.Traverse(*subtrees[i], *tree);
+
+        baseCases += rules.BaseCases();
+        scores += rules.Scores();
+      }
     }
 
     AddAllEdges();
@@ -148,8 +234,8 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
     Log::Info << edges.size() << " edges found so far." << std::endl;
     if (!naive)
     {
-      Log::Info << rules.BaseCases() << " cumulative base cases." << std::endl;
-      Log::Info << rules.Scores() << " cumulative node combinations scored."
+      Log::Info << baseCases << " cumulative base cases." << std::endl;
+      Log::Info << scores << " cumulative node combinations scored."
           << std::endl;
     }
   }
@@ -195,22 +281,99 @@ template<
              typename TreeMatType> class TreeType>
 void DualTreeBoruvka<MetricType, MatType, TreeType>::AddAllEdges()
 {
+  // The candidate edge of each component is the candidate edge of its first
+  // point whose candidate edge is as short as the component's.  Only one edge
+  // may be added for each component: two edges of the same length from one
+  // component could make a cycle that is longer than the other edges of the
+  // iteration.
+  arma::Col<size_t> candidates(data.n_cols);
+  candidates.fill(SIZE_MAX);
   for (size_t i = 0; i < data.n_cols; ++i)
   {
-    size_t component = connections.Find(i);
-    size_t inEdge = neighborsInComponent[component];
-    size_t outEdge = neighborsOutComponent[component];
-    if (connections.Find(inEdge) != connections.Find(outEdge))
+    const size_t component = components[i];
+    if (candidates[component] == SIZE_MAX && pointDistances[i] != DBL_MAX &&
+        pointDistances[i] == componentDistances[component].load(
+        std::memory_order_relaxed))
+      candidates[component] = i;
+  }
+
+  // Add the edges of all components at once.  An edge is dropped if its
+  // endpoints have already been connected in this iteration (for instance, if
+  // both of its components found it).
+  #pragma omp parallel
+  {
+    std::vector<size_t> added;
+
+    #pragma omp for schedule(static)
+    for (omp_size_t c = 0; c < (omp_size_t) data.n_cols; ++c)
+    {
+      const size_t point = candidates[c];
+      if (point != SIZE_MAX && connections.Union(point, pointNeighbors[point]))
+        added.push_back(point);
+    }
+
+    #pragma omp critical
     {
-      // totalDist = totalDist + dist;
-      // changed to make this agree with the cover tree code
-      totalDist += neighborsDistances[component];
-      AddEdge(inEdge, outEdge, neighborsDistances[component]);
-      connections.Union(inEdge, outEdge);
+      for (size_t i = 0; i < added.size(); ++i)
+      {
+        // totalDist = totalDist + dist;
+        // changed to make this agree with the cover tree code
+        totalDist += pointDistances[added[i]];
+        AddEdge(added[i], pointNeighbors[added[i]], pointDistances[added[i]]);
+      }
     }
   }
 }
 
+/**
+ * Split the tree into subtrees whose points can be searched for in parallel.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+std::vector<typename DualTreeBoruvka<MetricType, MatType, TreeType>::Tree*>
+DualTreeBoruvka<MetricType, MatType, TreeType>::QuerySubtrees() const
+{
+  #ifdef HAS_OPENMP
+  const size_t numThreads = omp_get_max_threads();
+  #else
+  const size_t numThreads = 1;
+  #endif
+
+  // Descend one level at a time until there are enough subtrees to keep every
+  // thread busy, or until every subtree is a leaf.  Each point is a descendant
+  // of exactly one subtree (unless a point may be held by several nodes), so no
+  // two threads search for the neighbors of the same point.  Only the
+  // statistics of the nodes of a subtree are modified while it is searched.
+  std::vector<Tree*> subtrees(1, tree);
+  bool expanded = (numThreads > 1 &&
+      tree::TreeTraits<Tree>::UniqueNumDescendants);
+  while (expanded && subtrees.size() < 4 * numThreads)
+  {
+    expanded = false;
+    std::vector<Tree*> nextSubtrees;
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      if (subtrees[i]->NumChildren() == 0)
+      {
+        nextSubtrees.push_back(subtrees[i]);
+        continue;
+      }
+
+      for (size_t j = 0; j < subtrees[i]->NumChildren(); ++j)
+        nextSubtrees.push_back(&subtrees[i]->Child(j));
+      expanded = true;
+    }
+
+    subtrees.swap(nextSubtrees);
+  }
+
+  return subtrees;
+}
+
 /**
  * Unpermute the edge list (if necessary) and output it to results.
  */
@@ -291,7 +454,7 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::CleanupHelper(Tree* tree)
   // if all other components of children and points are the same.
   const int component = (tree->NumChildren() != 0) ?
       tree->Child(0).Stat().ComponentMembership() :
-      connections.Find(tree->Point(0));
+      components[tree->Point(0)];
 
   // Check components of children.
   for (size_t i = 0; i < tree->NumChildren(); ++i)
@@ -300,7 +463,7 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::CleanupHelper(Tree* tree)
 
   // Check components of points.
   for (size_t i = 0; i < tree->NumPoints(); ++i)
-    if (connections.Find(tree->Point(i)) != size_t(component))
+    if (components[tree->Point(i)] != size_t(component))
       return;
 
   // If we made it this far, all components are the same.
@@ -318,8 +481,15 @@ template<
              typename TreeMatType> class TreeType>
 void DualTreeBoruvka<MetricType, MatType, TreeType>::Cleanup()
 {
-  for (size_t i = 0; i < data.n_cols; ++i)
-    neighborsDistances[i] = DBL_MAX;
+  // The components do not change during an iteration, so the rules use the
+  // component of each point as it is found here.
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t i = 0; i < (omp_size_t) data.n_cols; ++i)
+  {
+    components[i] = connections.Find(i);
+    pointDistances[i] = DBL_MAX;
+    componentDistances[i].store(DBL_MAX, std::memory_order_relaxed);
+  }
 
   if (!naive)
     CleanupHelper(tree);
@@ -16,19 +16,53 @@
 
 #include <mlpack/core/tree/traversal_info.hpp>
 
+#include <atomic>
+
 namespace mlpack {
 namespace emst {
 
+/**
+ * The rules for one Boruvka iteration: for every component, find the closest
+ * pair of points with one point in the component and the other outside of it.
+ *
+ * The components do not change during an iteration, so they are given as a
+ * flat array.  The best candidate edge is stored for each query point, and only
+ * the distance of the best candidate edge of each component (which is used for
+ * pruning) is shared between points.  So, several DTBRules objects may search
+ * in parallel, as long as they are given different query points; the best edge
+ * of a component is the best edge of the points of the component.
+ *
+ * If core distances are given, the distance between two points is their mutual
+ * reachability distance, max(d(a, b), core(a), core(b)), as in HDBSCAN.  This
+ * is never smaller than the distance given by the metric, so the minimum
+ * distances between nodes are still valid lower bounds for pruning.
+ */
 template<typename MetricType, typename TreeType>
 class DTBRules
 {
  public:
+  /**
+   * Construct the rules.
+   *
+   * @param dataSet The data points.
+   * @param components The component of each point.
+   * @param componentDistances The distance of the best candidate edge found so
+   *     far for each component; this may be shared by several threads.
+   * @param pointDistances The distance of the best candidate edge found so far
+   *     for each point.
+   * @param pointNeighbors The other endpoint of the best candidate edge found
+   *     so far for each point.
+   * @param metric The instantiated metric.
+   * @param coreDistances The core distance of each point, if the edges should
+   *     be weighted by the mutual reachability distance, or NULL.
+   */
   DTBRules(const arma::mat& dataSet,
-           UnionFind& connections,
-           arma::vec& neighborsDistances,
-           arma::Col<size_t>& neighborsInComponent,
-           arma::Col<size_t>& neighborsOutComponent,
-           MetricType& metric);
+           const arma::Col<size_t>& components,
+           std::vector<std::atomic<double>>& componentDistances,
+           arma::vec& pointDistances,
+           arma::Col<size_t>& pointNeighbors,
+           MetricType& metric,
+           const arma::vec* coreDistances = NULL);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
@@ -101,28 +135,43 @@ class DTBRules
   //! The data points.
   const arma::mat& dataSet;
 
-  //! Stores the tree structure so far
-  UnionFind& connections;
+  //! The component of each point.
+  const arma::Col<size_t>& components;
 
   //! The distance to the candidate nearest neighbor for each component.
-  arma::vec& neighborsDistances;
+  std::vector<std::atomic<double>>& componentDistances;
 
-  //! The index of the point in the component that is an endpoint of the
-  //! candidate edge.
-  arma::Col<size_t>& neighborsInComponent;
+  //! The distance to the candidate nearest neighbor outside of its component
+  //! for each point.
+  arma::vec& pointDistances;
 
-  //! The index of the point outside of the component that is an endpoint
-  //! of the candidate edge.
-  arma::Col<size_t>& neighborsOutComponent;
+  //! The index of the candidate nearest neighbor outside of its component for
+  //! each point.
+  arma::Col<size_t>& pointNeighbors;
 
   //! The instantiated metric.
   MetricType& metric;
 
+  //! The core distance of each point, or NULL if the edges are weighted by the
+  //! metric alone.
+  const arma::vec* coreDistances;
+
   /**
    * Update the bound for the given query node.
    */
   inline double CalculateBound(TreeType& queryNode) const;
 
+  //! Get the distance to the candidate nearest neighbor of the given
+  //! component.
+  double ComponentDistance(const size_t component) const
+  {
+    return componentDistances[component].load(std::memory_order_relaxed);
+  }
+
+  //! Lower the distance to the candidate nearest neighbor of the given
+  //! component to the given distance, if it is closer.
+  void LowerComponentDistance(const size_t component, const double distance);
+
   TraversalInfoType traversalInfo;
 
   //! The number of base cases calculated.
@@ -18,18 +18,20 @@ namespace emst {
 template<typename MetricType, typename TreeType>
 DTBRules<MetricType, TreeType>::
 DTBRules(const arma::mat& dataSet,
-         UnionFind& connections,
-         arma::vec& neighborsDistances,
-         arma::Col<size_t>& neighborsInComponent,
-         arma::Col<size_t>& neighborsOutComponent,
-         MetricType& metric)
+         const arma::Col<size_t>& components,
+         std::vector<std::atomic<double>>& componentDistances,
+         arma::vec& pointDistances,
+         arma::Col<size_t>& pointNeighbors,
+         MetricType& metric,
+         const arma::vec* coreDistances)
 :
   dataSet(dataSet),
-  connections(connections),
-  neighborsDistances(neighborsDistances),
-  neighborsInComponent(neighborsInComponent),
-  neighborsOutComponent(neighborsOutComponent),
+  components(components),
+  componentDistances(componentDistances),
+  pointDistances(pointDistances),
+  pointNeighbors(pointNeighbors),
   metric(metric),
+  coreDistances(coreDistances),
   baseCases(0),
   scores(0)
 {
@@ -47,28 +49,36 @@ double DTBRules<MetricType, TreeType>::BaseCase(const size_t queryIndex,
   double newUpperBound = -1.0;
 
   // Find the index of the component the query is in.
-  size_t queryComponentIndex = connections.Find(queryIndex);
+  const size_t queryComponentIndex = components[queryIndex];
 
-  size_t referenceComponentIndex = connections.Find(referenceIndex);
+  const size_t referenceComponentIndex = components[referenceIndex];
 
   if (queryComponentIndex != referenceComponentIndex)
   {
     ++baseCases;
     double distance = metric.Evaluate(dataSet.col(queryIndex),
                                       dataSet.col(referenceIndex));
+    if (coreDistances)
+    {
+      distance = std::max(distance, std::max((*coreDistances)[queryIndex],
+          (*coreDistances)[referenceIndex]));
+    }
 
-    if (distance < neighborsDistances[queryComponentIndex])
+    // Only this object may have the query point, but the distance of the
+    // component may be lowered by other threads.
+    if (distance < pointDistances[queryIndex])
     {
       Log::Assert(queryIndex != referenceIndex);
 
-      neighborsDistances[queryComponentIndex] = distance;
-      neighborsInComponent[queryComponentIndex] = queryIndex;
-      neighborsOutComponent[queryComponentIndex] = referenceIndex;
+      pointDistances[queryIndex] = distance;
+      pointNeighbors[queryIndex] = referenceIndex;
+      LowerComponentDistance(queryComponentIndex, distance);
     }
   }
 
-  if (newUpperBound < neighborsDistances[queryComponentIndex])
-    newUpperBound = neighborsDistances[queryComponentIndex];
+  const double componentDistance = ComponentDistance(queryComponentIndex);
+  if (newUpperBound < componentDistance)
+    newUpperBound = componentDistance;
 
   Log::Assert(newUpperBound >= 0.0);
 
@@ -79,7 +89,7 @@ template<typename MetricType, typename TreeType>
 double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
                                              TreeType& referenceNode)
 {
-  size_t queryComponentIndex = connections.Find(queryIndex);
+  const size_t queryComponentIndex = components[queryIndex];
 
   // If the query belongs to the same component as all of the references,
   // then prune.  The cast is to stop a warning about comparing unsigned to
@@ -93,7 +103,7 @@ double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
 
   // If all the points in the reference node are farther than the candidate
   // nearest neighbor for the query's component, we prune.
-  return neighborsDistances[queryComponentIndex] < distance
+  return ComponentDistance(queryComponentIndex) < distance
       ? DBL_MAX : distance;
 }
 
@@ -104,7 +114,7 @@ double DTBRules<MetricType, TreeType>::Rescore(const size_t queryIndex,
 {
   // We don't need to check component membership again, because it can't
   // change inside a single iteration.
-  return (oldScore > neighborsDistances[connections.Find(queryIndex)])
+  return (oldScore > ComponentDistance(components[queryIndex]))
       ? DBL_MAX : oldScore;
 }
 
@@ -152,8 +162,8 @@ inline double DTBRules<MetricType, TreeType>::CalculateBound(
   // Now, find the best and worst point bounds.
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const size_t pointComponent = connections.Find(queryNode.Point(i));
-    const double bound = neighborsDistances[pointComponent];
+    const size_t pointComponent = components[queryNode.Point(i)];
+    const double bound = ComponentDistance(pointComponent);
 
     if (bound > worstPointBound)
       worstPointBound = bound;
@@ -176,9 +186,12 @@ inline double DTBRules<MetricType, TreeType>::CalculateBound(
   // Now calculate the actual bounds.
   const double worstBound = std::max(worstPointBound, worstChildBound);
   const double bestBound = std::min(bestPointBound, bestChildBound);
-  // We must check that bestBound != DBL_MAX; otherwise, we risk overflow.
-  const double bestAdjustedBound = (bestBound == DBL_MAX) ? DBL_MAX :
-      bestBound + 2 * queryNode.FurthestDescendantDistance();
+  // We must check that bestBound != DBL_MAX; otherwise, we risk overflow.  The
+  // adjusted bound assumes that two points of the node are no farther apart
+  // than twice the furthest descendant distance; this does not hold for the
+  // mutual reachability distance, which may be as large as a core distance.
+  const double bestAdjustedBound = (bestBound == DBL_MAX || coreDistances) ?
+      DBL_MAX : bestBound + 2 * queryNode.FurthestDescendantDistance();
 
   // Update the relevant quantities in the node.
   queryNode.Stat().MaxNeighborDistance() = worstBound;
@@ -188,6 +201,22 @@ inline double DTBRules<MetricType, TreeType>::CalculateBound(
   return queryNode.Stat().Bound();
 }
 
+template<typename MetricType, typename TreeType>
+inline void DTBRules<MetricType, TreeType>::LowerComponentDistance(
+    const size_t component,
+    const double distance)
+{
+  // If another thread changes the distance in the meantime, the new distance
+  // is loaded into componentDistance and compared again.
+  double componentDistance = ComponentDistance(component);
+  while (distance < componentDistance &&
+      !componentDistances[component].compare_exchange_weak(componentDistance,
+          distance, std::memory_order_relaxed))
+  {
+    // Nothing to do.
+  }
+}
+
 } // namespace emst
 } // namespace mlpack
 
@@ -14,8 +14,10 @@
 #define MLPACK_METHODS_FASTMKS_FASTMKS_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <mlpack/core/cereal/template_class_version.hpp>
 #include <mlpack/core/metrics/ip_metric.hpp>
 #include "fastmks_stat.hpp"
+#include "norm_bucket_index.hpp"
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <queue>
 
@@ -48,6 +50,22 @@ namespace fastmks /** Fast max-kernel search. */ {
  * on points in the dataset (and not centroids of regions or anything like
  * that).
  *
+ * If parallel search is enabled (see Parallel()) and OpenMP is available,
+ * naive, single-tree and norm bucket search split the query points between
+ * threads.  Dual-tree search always runs on a single thread.  For kernels that
+ * provide a batched evaluation (LinearKernel and PolynomialKernel) and dense
+ * data, naive search computes the kernel values between blocks of query and
+ * reference points with one matrix product per block pair.
+ *
+ * Instead of a tree, the search can use a NormBucketIndex (see NormBuckets()),
+ * which sorts the reference points by norm and stops searching for each query
+ * point once the Cauchy-Schwarz bound shows that no point left can enter the
+ * results.  The index is built from the reference set the first time it is
+ * needed and is not serialized.  Naive search takes precedence over it, and it
+ * takes precedence over single-tree search.  If NormBuckets() is set before
+ * Train() is called, no tree is built, and only the dataset is stored, as for
+ * naive search.
+ *
  * @tparam KernelType Type of kernel to run FastMKS with.
  * @tparam MatType Type of data matrix (usually arma::mat).
  * @tparam TreeType Type of tree to run FastMKS with; it must satisfy the
@@ -168,7 +186,8 @@ class FastMKS
 
   /**
    * "Train" the FastMKS model on the given reference set (this will just build
-   * a tree, if the current search mode is not naive mode).
+   * a tree, if the current search mode is not naive mode or norm bucket
+   * search).
    *
    * @param referenceSet Set of reference points.
    */
@@ -177,7 +196,7 @@ class FastMKS
   /**
    * "Train" the FastMKS model on the given reference set and use the given
    * kernel.  This will just build a tree and replace the metric, if the current
-   * search mode is not naive mode.
+   * search mode is not naive mode or norm bucket search.
    *
    * @param referenceSet Set of reference points.
    * @param kernel Kernel to use for search.
@@ -186,8 +205,8 @@ class FastMKS
 
   /**
    * "Train" the FastMKS model on the given reference set (this will just build
-   * a tree, if the current search mode is not naive mode).  This takes
-   * ownership of the reference set.
+   * a tree, if the current search mode is not naive mode or norm bucket
+   * search).  This takes ownership of the reference set.
    *
    * @param referenceSet Set of reference points.
    */
@@ -196,7 +215,8 @@ class FastMKS
   /**
    * "Train" the FastMKS model on the given reference set and use the given
    * kernel.  This will just build a tree and replace the metric, if the current
-   * search mode is not naive mode.  This takes ownership of the reference set.
+   * search mode is not naive mode or norm bucket search.  This takes ownership
+   * of the reference set.
    *
    * @param referenceSet Set of reference points.
    * @param kernel Kernel to use for search.
@@ -297,6 +317,21 @@ class FastMKS
   //! Modify whether or not brute-force (naive) search is used.
   bool& Naive() { return naive; }
 
+  //! Get whether or not the search is run in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether or not the search is run in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get whether or not the norm bucket index is used for search.
+  bool NormBuckets() const { return normBuckets; }
+  //! Modify whether or not the norm bucket index is used for search.
+  bool& NormBuckets() { return normBuckets; }
+
+  //! Get the number of points in each bucket of the norm bucket index.
+  size_t BucketSize() const { return bucketSize; }
+  //! Modify the number of points in each bucket of the norm bucket index.
+  size_t& BucketSize() { return bucketSize; }
+
   //! Serialize the model.
   template<typename Archive>
   void serialize(Archive& ar, const uint32_t /* version */);
@@ -316,6 +351,15 @@ class FastMKS
   bool singleMode;
   //! If true, naive (brute-force) search is used.
   bool naive;
+  //! If true, the search is run in parallel.  This is not serialized.
+  bool parallel;
+  //! If true, the norm bucket index is used for search.  This is not
+  //! serialized.
+  bool normBuckets;
+  //! The number of points in each bucket of the norm bucket index.
+  size_t bucketSize;
+  //! The norm bucket index, if it has been built.  This is not serialized.
+  NormBucketIndex<KernelType, MatType>* bucketIndex;
 
   //! The instantiated inner-product metric induced by the given kernel.
   metric::IPMetric<KernelType> metric;
@@ -334,11 +378,54 @@ class FastMKS
   //! Use a priority queue to represent the list of candidate points.
   typedef std::priority_queue<Candidate, std::vector<Candidate>,
       CandidateCmp> CandidateList;
+
+  /**
+   * Run brute-force search for the given query set, evaluating each pair of
+   * points (std::false_type) or blocks of pairs with the batched kernel
+   * evaluation (std::true_type).  If sameSet is true, the query set is the
+   * reference set and points are not returned as their own candidates.
+   */
+  void NaiveSearch(const MatType& querySet,
+                   const size_t k,
+                   arma::Mat<size_t>& indices,
+                   arma::mat& kernels,
+                   const bool sameSet,
+                   const std::false_type& /* hasBatchEvaluate */);
+
+  void NaiveSearch(const MatType& querySet,
+                   const size_t k,
+                   arma::Mat<size_t>& indices,
+                   arma::mat& kernels,
+                   const bool sameSet,
+                   const std::true_type& /* hasBatchEvaluate */);
+
+  //! Get the norm bucket index, building it if it doesn't exist yet or if the
+  //! bucket size has changed.
+  const NormBucketIndex<KernelType, MatType>& BucketIndex();
+
+  //! Delete the norm bucket index, after the reference set or the kernel has
+  //! changed.
+  void ResetBucketIndex();
+
+  /**
+   * Run single-tree search for the given query set; if parallel search is
+   * enabled, the query points are split between threads.
+   */
+  void SingleTreeSearch(const MatType& querySet,
+                        const size_t k,
+                        arma::Mat<size_t>& indices,
+                        arma::mat& kernels);
 };
 
 } // namespace fastmks
 } // namespace mlpack
 
+// Version 1 records whether the tree or only the dataset is stored.
+CEREAL_TEMPLATE_CLASS_VERSION((template<typename KernelType, typename MatType,
+    template<typename TreeMetricType, typename TreeStatType,
+             typename TreeMatType> class TreeType>),
+    (mlpack::fastmks::FastMKS<KernelType, MatType, TreeType>), (1));
+
 // Include implementation.
 #include "fastmks_impl.hpp"
 
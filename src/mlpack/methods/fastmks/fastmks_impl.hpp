@@ -19,6 +19,10 @@
 
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace fastmks {
 
@@ -35,7 +39,11 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(const bool singleMode,
     treeOwner(true),
     setOwner(true),
     singleMode(singleMode),
-    naive(naive)
+    naive(naive),
+    parallel(false),
+    normBuckets(false),
+    bucketSize(256),
+    bucketIndex(NULL)
 {
   Timer::Start("tree_building");
   if (!naive)
@@ -58,7 +66,11 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(
     treeOwner(true),
     setOwner(false),
     singleMode(singleMode),
-    naive(naive)
+    naive(naive),
+    parallel(false),
+    normBuckets(false),
+    bucketSize(256),
+    bucketIndex(NULL)
 {
   Timer::Start("tree_building");
   if (!naive)
@@ -82,6 +94,10 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(const MatType& referenceSet,
     setOwner(false),
     singleMode(singleMode),
     naive(naive),
+    parallel(false),
+    normBuckets(false),
+    bucketSize(256),
+    bucketIndex(NULL),
     metric(kernel)
 {
   Timer::Start("tree_building");
@@ -108,7 +124,11 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(
     treeOwner(true),
     setOwner(naive),
     singleMode(singleMode),
-    naive(naive)
+    naive(naive),
+    parallel(false),
+    normBuckets(false),
+    bucketSize(256),
+    bucketIndex(NULL)
 {
   Timer::Start("tree_building");
   if (!naive)
@@ -135,6 +155,10 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(MatType&& referenceSet,
     setOwner(naive),
     singleMode(singleMode),
     naive(naive),
+    parallel(false),
+    normBuckets(false),
+    bucketSize(256),
+    bucketIndex(NULL),
     metric(kernel)
 {
   Timer::Start("tree_building");
@@ -163,6 +187,10 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(Tree* referenceTree,
     setOwner(false),
     singleMode(singleMode),
     naive(false),
+    parallel(false),
+    normBuckets(false),
+    bucketSize(256),
+    bucketIndex(NULL),
     metric(referenceTree->Metric())
 {
   // Nothing to do.
@@ -180,6 +208,10 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(const FastMKS& other) :
     setOwner(other.referenceTree == NULL),
     singleMode(other.singleMode),
     naive(other.naive),
+    parallel(other.parallel),
+    normBuckets(other.normBuckets),
+    bucketSize(other.bucketSize),
+    bucketIndex(NULL),
     metric(other.metric)
 {
   // Set reference set correctly.
@@ -201,6 +233,10 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(FastMKS&& other) :
     setOwner(other.setOwner),
     singleMode(other.singleMode),
     naive(other.naive),
+    parallel(other.parallel),
+    normBuckets(other.normBuckets),
+    bucketSize(other.bucketSize),
+    bucketIndex(other.bucketIndex),
     metric(std::move(other.metric))
 {
   // Clear information from the other.
@@ -210,6 +246,9 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(FastMKS&& other) :
   other.setOwner = false;
   other.singleMode = false;
   other.naive = false;
+  other.parallel = false;
+  other.normBuckets = false;
+  other.bucketIndex = NULL;
 }
 
 template<typename KernelType,
@@ -246,8 +285,13 @@ FastMKS<KernelType, MatType, TreeType>::operator=(const FastMKS& other)
     setOwner = true;
   }
 
+  ResetBucketIndex();
+
   singleMode = other.singleMode;
   naive = other.naive;
+  parallel = other.parallel;
+  normBuckets = other.normBuckets;
+  bucketSize = other.bucketSize;
 }
 
 template<typename KernelType,
@@ -262,6 +306,7 @@ FastMKS<KernelType, MatType, TreeType>::~FastMKS()
     delete referenceTree;
   if (setOwner)
     delete referenceSet;
+  delete bucketIndex;
 }
 
 template<typename KernelType,
@@ -271,19 +316,28 @@ template<typename KernelType,
                   typename TreeMatType> class TreeType>
 void FastMKS<KernelType, MatType, TreeType>::Train(const MatType& referenceSet)
 {
+  ResetBucketIndex();
+
   if (setOwner)
     delete this->referenceSet;
 
   this->referenceSet = &referenceSet;
   this->setOwner = false;
 
-  if (!naive)
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+
+  // Naive and norm bucket search don't need the tree.
+  if (!naive && !normBuckets)
   {
-    if (treeOwner && referenceTree)
-      delete referenceTree;
     referenceTree = new Tree(referenceSet, metric);
     treeOwner = true;
   }
+  else
+  {
+    referenceTree = NULL;
+    treeOwner = false;
+  }
 }
 
 template<typename KernelType,
@@ -294,6 +348,8 @@ template<typename KernelType,
 void FastMKS<KernelType, MatType, TreeType>::Train(const MatType& referenceSet,
                                                    KernelType& kernel)
 {
+  ResetBucketIndex();
+
   if (setOwner)
     delete this->referenceSet;
 
@@ -301,13 +357,20 @@ void FastMKS<KernelType, MatType, TreeType>::Train(const MatType& referenceSet,
   this->metric = metric::IPMetric<KernelType>(kernel);
   this->setOwner = false;
 
-  if (!naive)
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+
+  // Naive and norm bucket search don't need the tree.
+  if (!naive && !normBuckets)
   {
-    if (treeOwner && referenceTree)
-      delete referenceTree;
     referenceTree = new Tree(referenceSet, metric);
     treeOwner = true;
   }
+  else
+  {
+    referenceTree = NULL;
+    treeOwner = false;
+  }
 }
 
 template<typename KernelType,
@@ -317,15 +380,19 @@ template<typename KernelType,
                   typename TreeMatType> class TreeType>
 void FastMKS<KernelType, MatType, TreeType>::Train(MatType&& referenceSet)
 {
+  ResetBucketIndex();
+
   if (setOwner)
     delete this->referenceSet;
 
-  if (!naive)
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+
+  // Naive and norm bucket search don't need the tree.
+  if (!naive && !normBuckets)
   {
-    if (treeOwner && referenceTree)
-      delete referenceTree;
     referenceTree = new Tree(std::move(referenceSet), metric);
-    referenceSet = referenceTree->Dataset();
+    this->referenceSet = &referenceTree->Dataset();
     treeOwner = true;
     setOwner = false;
   }
@@ -333,6 +400,8 @@ void FastMKS<KernelType, MatType, TreeType>::Train(MatType&& referenceSet)
   {
     this->referenceSet = new MatType(std::move(referenceSet));
     this->setOwner = true;
+    referenceTree = NULL;
+    treeOwner = false;
   }
 }
 
@@ -344,16 +413,21 @@ template<typename KernelType,
 void FastMKS<KernelType, MatType, TreeType>::Train(MatType&& referenceSet,
                                                    KernelType& kernel)
 {
+  ResetBucketIndex();
+
   if (setOwner)
     delete this->referenceSet;
 
   this->metric = metric::IPMetric<KernelType>(kernel);
 
-  if (!naive)
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+
+  // Naive and norm bucket search don't need the tree.
+  if (!naive && !normBuckets)
   {
-    if (treeOwner && referenceTree)
-      delete referenceTree;
     referenceTree = new Tree(std::move(referenceSet), metric);
+    this->referenceSet = &referenceTree->Dataset();
     treeOwner = true;
     setOwner = false;
   }
@@ -361,6 +435,8 @@ void FastMKS<KernelType, MatType, TreeType>::Train(MatType&& referenceSet,
   {
     this->referenceSet = new MatType(std::move(referenceSet));
     this->setOwner = true;
+    referenceTree = NULL;
+    treeOwner = false;
   }
 }
 
@@ -375,6 +451,8 @@ void FastMKS<KernelType, MatType, TreeType>::Train(Tree* tree)
     throw std::invalid_argument("cannot call FastMKS::Train() with a tree when "
         "in naive search mode");
 
+  ResetBucketIndex();
+
   if (setOwner)
     delete this->referenceSet;
 
@@ -417,6 +495,12 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     throw std::invalid_argument(ss.str());
   }
 
+  if (!naive && !normBuckets && !referenceTree)
+  {
+    throw std::invalid_argument("no tree was built on the reference set; call "
+        "Train() again for tree search");
+  }
+
   Timer::Start("computing_products");
 
   // No remapping will be necessary because we are using the cover tree.
@@ -426,56 +510,27 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < querySet.n_cols; ++q)
-    {
-      const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
-      std::vector<Candidate> cList(k, def);
-      CandidateList pqueue(CandidateCmp(), std::move(cList));
+    NaiveSearch(querySet, k, indices, kernels, false,
+        kernel::HasBatchEvaluate<KernelType, MatType>());
 
-      for (size_t r = 0; r < referenceSet->n_cols; ++r)
-      {
-        const double eval = metric.Kernel().Evaluate(querySet.col(q),
-                                                     referenceSet->col(r));
-
-        if (eval > pqueue.top().first)
-        {
-          Candidate c = std::make_pair(eval, r);
-          pqueue.pop();
-          pqueue.push(c);
-        }
-      }
+    Timer::Stop("computing_products");
+    return;
+  }
 
-      for (size_t j = 1; j <= k; ++j)
-      {
-        indices(k - j, q) = pqueue.top().second;
-        kernels(k - j, q) = pqueue.top().first;
-        pqueue.pop();
-      }
-    }
+  // Norm bucket implementation.
+  if (normBuckets)
+  {
+    BucketIndex().Search(querySet, metric.Kernel(), k, indices, kernels, false,
+        parallel);
 
     Timer::Stop("computing_products");
-
     return;
   }
 
   // Single-tree implementation.
   if (singleMode)
   {
-    // Create rules object (this will store the results).  This constructor
-    // precalculates each self-kernel value.
-    typedef FastMKSRules<KernelType, Tree> RuleType;
-    RuleType rules(*referenceSet, querySet, k, metric.Kernel());
-
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    Log::Info << rules.BaseCases() << " base cases." << std::endl;
-    Log::Info << rules.Scores() << " scores." << std::endl;
-
-    rules.GetResults(indices, kernels);
+    SingleTreeSearch(querySet, k, indices, kernels);
 
     Timer::Stop("computing_products");
     return;
@@ -518,11 +573,18 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     throw std::invalid_argument(ss.str());
   }
 
-  // If either naive mode or single mode is specified, this must fail.
-  if (naive || singleMode)
+  // If naive mode, single mode or the norm bucket index is specified, this
+  // must fail.
+  if (naive || singleMode || normBuckets)
   {
     throw std::invalid_argument("can't call Search() with a query tree when "
-        "single mode or naive search is enabled");
+        "single mode, naive search or norm buckets are enabled");
+  }
+
+  if (!referenceTree)
+  {
+    throw std::invalid_argument("no tree was built on the reference set; call "
+        "Train() again for tree search");
   }
 
   // No remapping will be necessary because we are using the cover tree.
@@ -555,6 +617,12 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     arma::Mat<size_t>& indices,
     arma::mat& kernels)
 {
+  if (!naive && !normBuckets && !referenceTree)
+  {
+    throw std::invalid_argument("no tree was built on the reference set; call "
+        "Train() again for tree search");
+  }
+
   // No remapping will be necessary because we are using the cover tree.
   Timer::Start("computing_products");
   indices.set_size(k, referenceSet->n_cols);
@@ -563,73 +631,255 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < referenceSet->n_cols; ++q)
+    // Don't return the points as their own candidates.
+    NaiveSearch(*referenceSet, k, indices, kernels, true,
+        kernel::HasBatchEvaluate<KernelType, MatType>());
+
+    Timer::Stop("computing_products");
+    return;
+  }
+
+  // Norm bucket implementation.
+  if (normBuckets)
+  {
+    // Don't return the points as their own candidates.
+    BucketIndex().Search(*referenceSet, metric.Kernel(), k, indices, kernels,
+        true, parallel);
+
+    Timer::Stop("computing_products");
+    return;
+  }
+
+  // Single-tree implementation.
+  if (singleMode)
+  {
+    SingleTreeSearch(*referenceSet, k, indices, kernels);
+
+    Timer::Stop("computing_products");
+    return;
+  }
+
+  // Dual-tree implementation.
+  Timer::Stop("computing_products");
+
+  Search(referenceTree, k, indices, kernels);
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::NaiveSearch(
+    const MatType& querySet,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels,
+    const bool sameSet,
+    const std::false_type& /* hasBatchEvaluate */)
+{
+  // Simple double loop.  Stupid, slow, but a good benchmark.
+  #pragma omp parallel for schedule(dynamic) if (parallel)
+  for (omp_size_t q = 0; q < (omp_size_t) querySet.n_cols; ++q)
+  {
+    const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
+    std::vector<Candidate> cList(k, def);
+    CandidateList pqueue(CandidateCmp(), std::move(cList));
+
+    for (size_t r = 0; r < referenceSet->n_cols; ++r)
     {
-      const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
-      std::vector<Candidate> cList(k, def);
-      CandidateList pqueue(CandidateCmp(), std::move(cList));
+      if (sameSet && (size_t) q == r)
+        continue; // Don't return the point as its own candidate.
+
+      const double eval = metric.Kernel().Evaluate(querySet.col(q),
+                                                   referenceSet->col(r));
 
-      for (size_t r = 0; r < referenceSet->n_cols; ++r)
+      if (eval > pqueue.top().first)
       {
-        if (q == r)
-          continue; // Don't return the point as its own candidate.
+        Candidate c = std::make_pair(eval, r);
+        pqueue.pop();
+        pqueue.push(c);
+      }
+    }
 
-        const double eval = metric.Kernel().Evaluate(referenceSet->col(q),
-                                                     referenceSet->col(r));
+    for (size_t j = 1; j <= k; ++j)
+    {
+      indices(k - j, q) = pqueue.top().second;
+      kernels(k - j, q) = pqueue.top().first;
+      pqueue.pop();
+    }
+  }
+}
 
-        if (eval > pqueue.top().first)
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::NaiveSearch(
+    const MatType& querySet,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels,
+    const bool sameSet,
+    const std::true_type& /* hasBatchEvaluate */)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The kernel values between a block of query points and a block of reference
+  // points are computed at once; the blocks are small enough for the kernel
+  // values of each thread to stay in cache.
+  const size_t blockSize = 256;
+  const size_t numQueryBlocks = (querySet.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic) if (parallel)
+  for (omp_size_t b = 0; b < (omp_size_t) numQueryBlocks; ++b)
+  {
+    const size_t firstQuery = b * blockSize;
+    const size_t numQueries = std::min(blockSize,
+        (size_t) querySet.n_cols - firstQuery);
+
+    // Alias the block of query points instead of copying it.
+    const MatType queries(const_cast<ElemType*>(querySet.colptr(firstQuery)),
+        querySet.n_rows, numQueries, false, true);
+
+    const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
+    std::vector<CandidateList> pqueues(numQueries,
+        CandidateList(CandidateCmp(), std::vector<Candidate>(k, def)));
+
+    arma::Mat<ElemType> blockKernels;
+    for (size_t firstRef = 0; firstRef < referenceSet->n_cols;
+         firstRef += blockSize)
+    {
+      const size_t numRefs = std::min(blockSize,
+          (size_t) referenceSet->n_cols - firstRef);
+      const MatType references(
+          const_cast<ElemType*>(referenceSet->colptr(firstRef)),
+          referenceSet->n_rows, numRefs, false, true);
+
+      metric.Kernel().BatchEvaluate(references, queries, blockKernels);
+
+      for (size_t q = 0; q < numQueries; ++q)
+      {
+        CandidateList& pqueue = pqueues[q];
+        for (size_t r = 0; r < numRefs; ++r)
         {
-          Candidate c = std::make_pair(eval, r);
-          pqueue.pop();
-          pqueue.push(c);
+          if (sameSet && firstQuery + q == firstRef + r)
+            continue; // Don't return the point as its own candidate.
+
+          const double eval = blockKernels(r, q);
+          if (eval > pqueue.top().first)
+          {
+            pqueue.pop();
+            pqueue.push(std::make_pair(eval, firstRef + r));
+          }
         }
       }
+    }
 
+    for (size_t q = 0; q < numQueries; ++q)
+    {
+      CandidateList& pqueue = pqueues[q];
       for (size_t j = 1; j <= k; ++j)
       {
-        indices(k - j, q) = pqueue.top().second;
-        kernels(k - j, q) = pqueue.top().first;
+        indices(k - j, firstQuery + q) = pqueue.top().second;
+        kernels(k - j, firstQuery + q) = pqueue.top().first;
         pqueue.pop();
       }
     }
-
-    Timer::Stop("computing_products");
-
-    return;
   }
+}
 
-  // Single-tree implementation.
-  if (singleMode)
-  {
-    // Create rules object (this will store the results).  This constructor
-    // precalculates each self-kernel value.
-    typedef FastMKSRules<KernelType, Tree> RuleType;
-    RuleType rules(*referenceSet, *referenceSet, k, metric.Kernel());
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::SingleTreeSearch(
+    const MatType& querySet,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels)
+{
+  // Create rules object (this will store the results).  This constructor
+  // precalculates each self-kernel value.
+  typedef FastMKSRules<KernelType, Tree> RuleType;
+  RuleType rules(*referenceSet, querySet, k, metric.Kernel());
 
+  size_t baseCases = 0;
+  size_t scores = 0;
+  size_t numPrunes = 0;
+  if (!parallel)
+  {
     typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
 
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
+    for (size_t i = 0; i < querySet.n_cols; ++i)
       traverser.Traverse(i, *referenceTree);
 
-    // Save the number of pruned nodes.
-    const size_t numPrunes = traverser.NumPrunes();
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+    numPrunes = traverser.NumPrunes();
+  }
+  else
+  {
+    #pragma omp parallel reduction(+:baseCases, scores, numPrunes)
+    {
+      // Each thread has its own rules, which share the candidate lists and the
+      // self-kernels of the rules above; every query point is only searched
+      // for by one thread.
+      RuleType threadRules(*referenceSet, querySet, k, metric.Kernel(),
+          &rules);
+
+      typename Tree::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+      #pragma omp for schedule(dynamic)
+      for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+        traverser.Traverse(i, *referenceTree);
+
+      baseCases += threadRules.BaseCases();
+      scores += threadRules.Scores();
+      numPrunes += traverser.NumPrunes();
+    }
+  }
 
-    Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
+  Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
 
-    Log::Info << rules.BaseCases() << " base cases." << std::endl;
-    Log::Info << rules.Scores() << " scores." << std::endl;
+  Log::Info << baseCases << " base cases." << std::endl;
+  Log::Info << scores << " scores." << std::endl;
 
-    rules.GetResults(indices, kernels);
+  rules.GetResults(indices, kernels);
+}
 
-    Timer::Stop("computing_products");
-    return;
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+const NormBucketIndex<KernelType, MatType>&
+FastMKS<KernelType, MatType, TreeType>::BucketIndex()
+{
+  if (bucketIndex && bucketIndex->BucketSize() != bucketSize)
+    ResetBucketIndex();
+
+  if (!bucketIndex)
+  {
+    bucketIndex = new NormBucketIndex<KernelType, MatType>(*referenceSet,
+        metric.Kernel(), bucketSize);
   }
 
-  // Dual-tree implementation.
-  Timer::Stop("computing_products");
+  return *bucketIndex;
+}
 
-  Search(referenceTree, k, indices, kernels);
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::ResetBucketIndex()
+{
+  delete bucketIndex;
+  bucketIndex = NULL;
 }
 
 //! Serialize the model.
@@ -640,21 +890,36 @@ template<typename KernelType,
                   typename TreeMatType> class TreeType>
 template<typename Archive>
 void FastMKS<KernelType, MatType, TreeType>::serialize(
-    Archive& ar, const uint32_t /* version */)
+    Archive& ar, const uint32_t version)
 {
   // Serialize preferences for search.
   ar(CEREAL_NVP(naive));
   ar(CEREAL_NVP(singleMode));
 
-  // If we are doing naive search, serialize the dataset.  Otherwise we
-  // serialize the tree.
-  if (naive)
+  // The norm bucket index is built again from the loaded reference set.
+  if (cereal::is_loading<Archive>())
+    ResetBucketIndex();
+
+  // If no tree was built (for naive or norm bucket search), serialize the
+  // dataset.  Otherwise we serialize the tree.  Before version 1, the tree was
+  // stored unless naive search was used.
+  bool hasTree = !naive;
+  if (cereal::is_saving<Archive>())
+    hasTree = hasTree && (referenceTree != NULL);
+  if (version > 0)
+    ar(CEREAL_NVP(hasTree));
+
+  if (!hasTree)
   {
     if (cereal::is_loading<Archive>())
     {
+      if (treeOwner && referenceTree)
+        delete referenceTree;
       if (setOwner && referenceSet)
         delete referenceSet;
 
+      referenceTree = NULL;
+      treeOwner = false;
       setOwner = true;
     }
 
@@ -64,7 +64,20 @@ BINDING_EXAMPLE(
     "\n\n"
     "This program performs FastMKS using a cover tree.  The base used to build "
     "the cover tree can be specified with the " + PRINT_PARAM_STRING("base") +
-    " parameter.");
+    " parameter.  If the " + PRINT_PARAM_STRING("parallel") + " flag is given, "
+    "naive, single-tree and norm bucket search split the query points between "
+    "multiple threads."
+    "\n\n"
+    "If the " + PRINT_PARAM_STRING("norm_buckets") + " flag is given, the "
+    "reference points are sorted by norm and split into buckets of size " +
+    PRINT_PARAM_STRING("bucket_size") + " instead of using the tree; the "
+    "search for each query point stops once no bucket left can hold a better "
+    "point.  This is fastest when the norms of the reference points vary a "
+    "lot, such as for maximum inner product search with the linear kernel.  "
+    "A model built with " + PRINT_PARAM_STRING("norm_buckets") + " holds no "
+    "tree, so it can only be searched with " +
+    PRINT_PARAM_STRING("norm_buckets") + " or " + PRINT_PARAM_STRING("naive") +
+    ".");
 
 // See also...
 BINDING_SEE_ALSO("Fast max-kernel search tutorial (fastmks)",
@@ -101,6 +114,12 @@ PARAM_INT_IN("k", "Number of maximum kernels to find.", "k", 0);
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single", "If true, single-tree search is used (as opposed to "
     "dual-tree search.", "S");
+PARAM_FLAG("parallel", "If true, naive, single-tree and norm bucket search "
+    "split the query points between multiple threads.", "l");
+PARAM_FLAG("norm_buckets", "If true, the reference points are sorted by norm "
+    "and searched in buckets instead of with the tree.", "B");
+PARAM_INT_IN("bucket_size", "Number of points in each bucket, for norm bucket "
+    "search.", "z", 256);
 
 PARAM_MATRIX_OUT("kernels", "Output matrix of kernels.", "p");
 PARAM_UMATRIX_OUT("indices", "Output matrix of indices.", "i");
@@ -146,6 +165,19 @@ static void mlpackMain()
   // Naive mode overrides single mode.
   ReportIgnoredParam({{ "naive", true }}, "single");
 
+  // Naive mode overrides norm buckets.
+  ReportIgnoredParam({{ "naive", true }}, "norm_buckets");
+
+  // Norm buckets override single mode.
+  ReportIgnoredParam({{ "norm_buckets", true }}, "single");
+  ReportIgnoredParam({{ "norm_buckets", false }}, "bucket_size");
+
+  if (IO::HasParam("bucket_size"))
+  {
+    RequireParamValue<int>("bucket_size", [](int x) { return x > 0; }, true,
+        "bucket size must be greater than 0");
+  }
+
   FastMKSModel* model;
   arma::mat referenceData;
   if (IO::HasParam("reference"))
@@ -169,48 +201,56 @@ static void mlpackMain()
     // Search preferences.
     const bool naive = IO::HasParam("naive");
     const bool single = IO::HasParam("single");
+    const bool normBuckets = IO::HasParam("norm_buckets");
 
     if (kernelType == "linear")
     {
       LinearKernel lk;
       model->KernelType() = FastMKSModel::LINEAR_KERNEL;
-      model->BuildModel(std::move(referenceData), lk, single, naive, base);
+      model->BuildModel(std::move(referenceData), lk, single, naive, base,
+          normBuckets);
     }
     else if (kernelType == "polynomial")
     {
       PolynomialKernel pk(degree, offset);
       model->KernelType() = FastMKSModel::POLYNOMIAL_KERNEL;
-      model->BuildModel(std::move(referenceData), pk, single, naive, base);
+      model->BuildModel(std::move(referenceData), pk, single, naive, base,
+          normBuckets);
     }
     else if (kernelType == "cosine")
     {
       CosineDistance cd;
       model->KernelType() = FastMKSModel::COSINE_DISTANCE;
-      model->BuildModel(std::move(referenceData), cd, single, naive, base);
+      model->BuildModel(std::move(referenceData), cd, single, naive, base,
+          normBuckets);
     }
     else if (kernelType == "gaussian")
     {
       GaussianKernel gk(bandwidth);
       model->KernelType() = FastMKSModel::GAUSSIAN_KERNEL;
-      model->BuildModel(std::move(referenceData), gk, single, naive, base);
+      model->BuildModel(std::move(referenceData), gk, single, naive, base,
+          normBuckets);
     }
     else if (kernelType == "epanechnikov")
     {
       EpanechnikovKernel ek(bandwidth);
       model->KernelType() = FastMKSModel::EPANECHNIKOV_KERNEL;
-      model->BuildModel(std::move(referenceData), ek, single, naive, base);
+      model->BuildModel(std::move(referenceData), ek, single, naive, base,
+          normBuckets);
     }
     else if (kernelType == "triangular")
     {
       TriangularKernel tk(bandwidth);
       model->KernelType() = FastMKSModel::TRIANGULAR_KERNEL;
-      model->BuildModel(std::move(referenceData), tk, single, naive, base);
+      model->BuildModel(std::move(referenceData), tk, single, naive, base,
+          normBuckets);
     }
     else if (kernelType == "hyptan")
     {
       HyperbolicTangentKernel htk(scale, offset);
       model->KernelType() = FastMKSModel::HYPTAN_KERNEL;
-      model->BuildModel(std::move(referenceData), htk, single, naive, base);
+      model->BuildModel(std::move(referenceData), htk, single, naive, base,
+          normBuckets);
     }
   }
   else
@@ -222,6 +262,9 @@ static void mlpackMain()
   // Set search preferences.
   model->Naive() = IO::HasParam("naive");
   model->SingleMode() = IO::HasParam("single");
+  model->Parallel() = IO::HasParam("parallel");
+  model->NormBuckets() = IO::HasParam("norm_buckets");
+  model->BucketSize() = (size_t) IO::GetParam<int>("bucket_size");
 
   // Should we do search?
   if (IO::HasParam("k"))
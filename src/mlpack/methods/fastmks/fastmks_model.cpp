@@ -219,6 +219,144 @@ bool& FastMKSModel::SingleMode()
   throw std::runtime_error("invalid model type");
 }
 
+bool FastMKSModel::Parallel() const
+{
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      return linear->Parallel();
+    case POLYNOMIAL_KERNEL:
+      return polynomial->Parallel();
+    case COSINE_DISTANCE:
+      return cosine->Parallel();
+    case GAUSSIAN_KERNEL:
+      return gaussian->Parallel();
+    case EPANECHNIKOV_KERNEL:
+      return epan->Parallel();
+    case TRIANGULAR_KERNEL:
+      return triangular->Parallel();
+    case HYPTAN_KERNEL:
+      return hyptan->Parallel();
+  }
+
+  throw std::runtime_error("invalid model type");
+}
+
+bool& FastMKSModel::Parallel()
+{
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      return linear->Parallel();
+    case POLYNOMIAL_KERNEL:
+      return polynomial->Parallel();
+    case COSINE_DISTANCE:
+      return cosine->Parallel();
+    case GAUSSIAN_KERNEL:
+      return gaussian->Parallel();
+    case EPANECHNIKOV_KERNEL:
+      return epan->Parallel();
+    case TRIANGULAR_KERNEL:
+      return triangular->Parallel();
+    case HYPTAN_KERNEL:
+      return hyptan->Parallel();
+  }
+
+  throw std::runtime_error("invalid model type");
+}
+
+bool FastMKSModel::NormBuckets() const
+{
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      return linear->NormBuckets();
+    case POLYNOMIAL_KERNEL:
+      return polynomial->NormBuckets();
+    case COSINE_DISTANCE:
+      return cosine->NormBuckets();
+    case GAUSSIAN_KERNEL:
+      return gaussian->NormBuckets();
+    case EPANECHNIKOV_KERNEL:
+      return epan->NormBuckets();
+    case TRIANGULAR_KERNEL:
+      return triangular->NormBuckets();
+    case HYPTAN_KERNEL:
+      return hyptan->NormBuckets();
+  }
+
+  throw std::runtime_error("invalid model type");
+}
+
+bool& FastMKSModel::NormBuckets()
+{
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      return linear->NormBuckets();
+    case POLYNOMIAL_KERNEL:
+      return polynomial->NormBuckets();
+    case COSINE_DISTANCE:
+      return cosine->NormBuckets();
+    case GAUSSIAN_KERNEL:
+      return gaussian->NormBuckets();
+    case EPANECHNIKOV_KERNEL:
+      return epan->NormBuckets();
+    case TRIANGULAR_KERNEL:
+      return triangular->NormBuckets();
+    case HYPTAN_KERNEL:
+      return hyptan->NormBuckets();
+  }
+
+  throw std::runtime_error("invalid model type");
+}
+
+size_t FastMKSModel::BucketSize() const
+{
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      return linear->BucketSize();
+    case POLYNOMIAL_KERNEL:
+      return polynomial->BucketSize();
+    case COSINE_DISTANCE:
+      return cosine->BucketSize();
+    case GAUSSIAN_KERNEL:
+      return gaussian->BucketSize();
+    case EPANECHNIKOV_KERNEL:
+      return epan->BucketSize();
+    case TRIANGULAR_KERNEL:
+      return triangular->BucketSize();
+    case HYPTAN_KERNEL:
+      return hyptan->BucketSize();
+  }
+
+  throw std::runtime_error("invalid model type");
+}
+
+size_t& FastMKSModel::BucketSize()
+{
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      return linear->BucketSize();
+    case POLYNOMIAL_KERNEL:
+      return polynomial->BucketSize();
+    case COSINE_DISTANCE:
+      return cosine->BucketSize();
+    case GAUSSIAN_KERNEL:
+      return gaussian->BucketSize();
+    case EPANECHNIKOV_KERNEL:
+      return epan->BucketSize();
+    case TRIANGULAR_KERNEL:
+      return triangular->BucketSize();
+    case HYPTAN_KERNEL:
+      return hyptan->BucketSize();
+  }
+
+  throw std::runtime_error("invalid model type");
+}
+
 void FastMKSModel::Search(const arma::mat& querySet,
                           const size_t k,
                           arma::Mat<size_t>& indices,
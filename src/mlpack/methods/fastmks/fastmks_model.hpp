@@ -67,14 +67,16 @@ class FastMKSModel
 
   /**
    * Build the model on the given reference set.  Make sure kernelType is equal
-   * to the correct entry in KernelTypes for the given KernelType class!
+   * to the correct entry in KernelTypes for the given KernelType class!  If
+   * naive or normBuckets is true, no tree is built.
    */
   template<typename TKernelType>
   void BuildModel(arma::mat&& referenceData,
                   TKernelType& kernel,
                   const bool singleMode,
                   const bool naive,
-                  const double base);
+                  const double base,
+                  const bool normBuckets = false);
 
   //! Get whether or not naive search is used.
   bool Naive() const;
@@ -86,6 +88,21 @@ class FastMKSModel
   //! Set whether or not single-tree search is used.
   bool& SingleMode();
 
+  //! Get whether or not the search is run in parallel.
+  bool Parallel() const;
+  //! Set whether or not the search is run in parallel.
+  bool& Parallel();
+
+  //! Get whether or not the norm bucket index is used for search.
+  bool NormBuckets() const;
+  //! Set whether or not the norm bucket index is used for search.
+  bool& NormBuckets();
+
+  //! Get the number of points in each bucket of the norm bucket index.
+  size_t BucketSize() const;
+  //! Set the number of points in each bucket of the norm bucket index.
+  size_t& BucketSize();
+
   //! Get the kernel type.
   int KernelType() const { return kernelType; }
   //! Modify the kernel type.
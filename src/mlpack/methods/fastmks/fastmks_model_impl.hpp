@@ -22,7 +22,8 @@ template<typename KernelType>
 void BuildFastMKSModel(FastMKS<KernelType>& f,
                        KernelType& k,
                        arma::mat&& referenceData,
-                       const double base)
+                       const double base,
+                       const bool normBuckets)
 {
   // Do we need to build the tree?
   if (base <= 1.0)
@@ -30,7 +31,9 @@ void BuildFastMKSModel(FastMKS<KernelType>& f,
     throw std::invalid_argument("base must be greater than 1");
   }
 
-  if (f.Naive())
+  // Naive and norm bucket search only need the dataset.
+  f.NormBuckets() = normBuckets;
+  if (f.Naive() || f.NormBuckets())
   {
     f.Train(std::move(referenceData), k);
   }
@@ -54,7 +57,8 @@ template<typename KernelType,
 void BuildFastMKSModel(FastMKSType& /* f */,
                        KernelType& /* k */,
                        arma::mat&& /* referenceData */,
-                       const double /* base */)
+                       const double /* base */,
+                       const bool /* normBuckets */)
 {
   throw std::invalid_argument("FastMKSModel::BuildModel(): given kernel type is"
       " not equal to kernel type of the model!");
@@ -65,7 +69,8 @@ void FastMKSModel::BuildModel(arma::mat&& referenceData,
                               TKernelType& kernel,
                               const bool singleMode,
                               const bool naive,
-                              const double base)
+                              const double base,
+                              const bool normBuckets)
 {
   // Clean memory if necessary.
   if (linear)
@@ -96,37 +101,44 @@ void FastMKSModel::BuildModel(arma::mat&& referenceData,
   {
     case LINEAR_KERNEL:
       linear = new FastMKS<kernel::LinearKernel>(singleMode, naive);
-      BuildFastMKSModel(*linear, kernel, std::move(referenceData), base);
+      BuildFastMKSModel(*linear, kernel, std::move(referenceData), base,
+          normBuckets);
       break;
 
     case POLYNOMIAL_KERNEL:
       polynomial = new FastMKS<kernel::PolynomialKernel>(singleMode, naive);
-      BuildFastMKSModel(*polynomial, kernel, std::move(referenceData), base);
+      BuildFastMKSModel(*polynomial, kernel, std::move(referenceData), base,
+          normBuckets);
       break;
 
     case COSINE_DISTANCE:
       cosine = new FastMKS<kernel::CosineDistance>(singleMode, naive);
-      BuildFastMKSModel(*cosine, kernel, std::move(referenceData), base);
+      BuildFastMKSModel(*cosine, kernel, std::move(referenceData), base,
+          normBuckets);
       break;
 
     case GAUSSIAN_KERNEL:
       gaussian = new FastMKS<kernel::GaussianKernel>(singleMode, naive);
-      BuildFastMKSModel(*gaussian, kernel, std::move(referenceData), base);
+      BuildFastMKSModel(*gaussian, kernel, std::move(referenceData), base,
+          normBuckets);
       break;
 
     case EPANECHNIKOV_KERNEL:
       epan = new FastMKS<kernel::EpanechnikovKernel>(singleMode, naive);
-      BuildFastMKSModel(*epan, kernel, std::move(referenceData), base);
+      BuildFastMKSModel(*epan, kernel, std::move(referenceData), base,
+          normBuckets);
       break;
 
     case TRIANGULAR_KERNEL:
       triangular = new FastMKS<kernel::TriangularKernel>(singleMode, naive);
-      BuildFastMKSModel(*triangular, kernel, std::move(referenceData), base);
+      BuildFastMKSModel(*triangular, kernel, std::move(referenceData), base,
+          normBuckets);
       break;
 
     case HYPTAN_KERNEL:
       hyptan = new FastMKS<kernel::HyperbolicTangentKernel>(singleMode, naive);
-      BuildFastMKSModel(*hyptan, kernel, std::move(referenceData), base);
+      BuildFastMKSModel(*hyptan, kernel, std::move(referenceData), base,
+          normBuckets);
       break;
   }
 }
@@ -204,7 +216,7 @@ void FastMKSModel::Search(FastMKSType& f,
                           arma::mat& kernels,
                           const double base)
 {
-  if (f.Naive() || f.SingleMode())
+  if (f.Naive() || f.SingleMode() || f.NormBuckets())
   {
     f.Search(querySet, k, indices, kernels);
   }
@@ -14,10 +14,13 @@
 
 #include <mlpack/prereqs.hpp>
 #include <mlpack/core/kernels/kernel_traits.hpp>
+#include <mlpack/core/math/make_alias.hpp>
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 #include <mlpack/core/tree/traversal_info.hpp>
 #include <boost/heap/priority_queue.hpp>
 
+#include <unordered_map>
+
 namespace mlpack {
 namespace fastmks {
 
@@ -42,11 +45,18 @@ class FastMKSRules
    * @param querySet Set of query data.
    * @param k Number of candidates to search for.
    * @param kernel Kernel to run FastMKS with.
+   * @param sharedRules If given, the candidate lists and the self-kernels of
+   *     these rules (which must have been built with the same sets) are used
+   *     instead of being computed, so that the rules of several threads can
+   *     search for different query points at once.  The kernel values of the
+   *     reference nodes are then kept in the rules instead of the statistics of
+   *     the reference tree.
    */
   FastMKSRules(const typename TreeType::Mat& referenceSet,
                const typename TreeType::Mat& querySet,
                const size_t k,
-               KernelType& kernel);
+               KernelType& kernel,
+               FastMKSRules* sharedRules = NULL);
 
   /**
    * Store the list of candidates for each query point in the given matrices.
@@ -152,8 +162,10 @@ class FastMKSRules
   typedef boost::heap::priority_queue<Candidate,
       boost::heap::compare<CandidateCmp>> CandidateList;
 
+  //! Set of candidates for each point, if they are not shared.
+  std::vector<CandidateList> ownCandidates;
   //! Set of candidates for each point.
-  std::vector<CandidateList> candidates;
+  std::vector<CandidateList>& candidates;
 
   //! Number of points to search for.
   const size_t k;
@@ -173,6 +185,24 @@ class FastMKSRules
   //! The last kernel evaluation resulting from BaseCase().
   double lastKernel;
 
+  //! If true, the candidates are shared with other rules, which search the same
+  //! reference tree at once in other threads.
+  bool shared;
+  //! The query index of the last single-tree Score() call of shared rules.
+  size_t lastScoreQueryIndex;
+  //! The kernel value between the current query point and the centroid of
+  //! each reference node that has been scored in single-tree search, for shared
+  //! rules.  Other rules keep it in the statistics of the reference tree.
+  std::unordered_map<const TreeType*, double> lastKernels;
+
+  //! Get the kernel value between the current query point and the centroid of
+  //! the given reference node, as computed by the last call to Score().
+  double& LastKernel(TreeType& referenceNode)
+  {
+    return shared ? lastKernels[&referenceNode] :
+        referenceNode.Stat().LastKernel();
+  }
+
   //! Calculate the bound for a given query node.
   double CalculateBound(TreeType& queryNode) const;
 
@@ -23,17 +23,34 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
     const typename TreeType::Mat& referenceSet,
     const typename TreeType::Mat& querySet,
     const size_t k,
-    KernelType& kernel) :
+    KernelType& kernel,
+    FastMKSRules* sharedRules) :
     referenceSet(referenceSet),
     querySet(querySet),
+    candidates(sharedRules ? sharedRules->candidates : ownCandidates),
     k(k),
+    queryKernels(sharedRules ?
+        math::MakeAlias(sharedRules->queryKernels, false) : arma::vec()),
+    referenceKernels(sharedRules ?
+        math::MakeAlias(sharedRules->referenceKernels, false) : arma::vec()),
     kernel(kernel),
     lastQueryIndex(-1),
     lastReferenceIndex(-1),
     lastKernel(0.0),
+    shared(sharedRules != NULL),
+    lastScoreQueryIndex(-1),
     baseCases(0),
     scores(0)
 {
+  // Set to invalid memory, so that the first node combination does not try to
+  // dereference null pointers.
+  traversalInfo.LastQueryNode() = (TreeType*) this;
+  traversalInfo.LastReferenceNode() = (TreeType*) this;
+
+  // The self-kernels and the candidates of shared rules are used as they are.
+  if (sharedRules)
+    return;
+
   // Precompute each self-kernel.
   queryKernels.set_size(querySet.n_cols);
   for (size_t i = 0; i < querySet.n_cols; ++i)
@@ -45,11 +62,6 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
     referenceKernels[i] = sqrt(kernel.Evaluate(referenceSet.col(i),
                                                referenceSet.col(i)));
 
-  // Set to invalid memory, so that the first node combination does not try to
-  // dereference null pointers.
-  traversalInfo.LastQueryNode() = (TreeType*) this;
-  traversalInfo.LastReferenceNode() = (TreeType*) this;
-
   // Let's build the list of candidate points for each query point.
   // It will be initialized with k candidates: (-DBL_MAX, size_t() - 1)
   // The list of candidates will be updated when visiting new points with the
@@ -61,7 +73,7 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
   for (size_t i = 0; i < k; ++i)
     pqueue.push(def);
   std::vector<CandidateList> tmp(querySet.n_cols, pqueue);
-  candidates.swap(tmp);
+  ownCandidates.swap(tmp);
 }
 
 template<typename KernelType, typename TreeType>
@@ -128,6 +140,14 @@ template<typename KernelType, typename TreeType>
 double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
                                                  TreeType& referenceNode)
 {
+  // The kernel values of shared rules are only kept for the current query
+  // point, since every node is scored again for each query point.
+  if (shared && queryIndex != lastScoreQueryIndex)
+  {
+    lastKernels.clear();
+    lastScoreQueryIndex = queryIndex;
+  }
+
   // Compare with the current best.
   const double bestKernel = candidates[queryIndex].top().first;
 
@@ -138,7 +158,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     double maxKernelBound;
     const double parentDist = referenceNode.ParentDistance();
     const double combinedDistBound = parentDist + furthestDist;
-    const double lastKernel = referenceNode.Parent()->Stat().LastKernel();
+    const double lastKernel = LastKernel(*referenceNode.Parent());
     if (kernel::KernelTraits<KernelType>::IsNormalized)
     {
       const double squaredDist = std::pow(combinedDistBound, 2.0);
@@ -175,7 +195,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
         referenceNode.Parent() != NULL &&
         referenceNode.Point(0) == referenceNode.Parent()->Point(0))
     {
-      kernelEval = referenceNode.Parent()->Stat().LastKernel();
+      kernelEval = LastKernel(*referenceNode.Parent());
     }
     else
     {
@@ -190,7 +210,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     kernelEval = kernel.Evaluate(querySet.col(queryIndex), refCenter);
   }
 
-  referenceNode.Stat().LastKernel() = kernelEval;
+  LastKernel(referenceNode) = kernelEval;
 
   double maxKernel;
   if (kernel::KernelTraits<KernelType>::IsNormalized)
@@ -0,0 +1,154 @@
+/**
+ * @file methods/fastmks/norm_bucket_index.hpp
+ *
+ * Definition of NormBucketIndex, an index for max-kernel search that groups the
+ * reference points by their norm in the kernel space.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_FASTMKS_NORM_BUCKET_INDEX_HPP
+#define MLPACK_METHODS_FASTMKS_NORM_BUCKET_INDEX_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/kernels/kernel_traits.hpp>
+#include <queue>
+
+namespace mlpack {
+namespace fastmks {
+
+/**
+ * An index for exact max-kernel search (such as maximum inner product search
+ * with the linear kernel) that sorts the reference points by their norm in the
+ * kernel space, ||r|| = sqrt(K(r, r)), and splits them into buckets of
+ * consecutive points.  By the Cauchy-Schwarz inequality,
+ * K(q, r) <= ||q|| ||r||, so the points are searched from the highest norm
+ * down, and the search for a query point stops as soon as ||q|| times the norm
+ * of the next point is no greater than the k'th best kernel value found so far.
+ * This prunes well when the norms of the reference points vary a lot, which is
+ * common for the item factors of recommender systems, and does not prune at
+ * all for normalized kernels.  The bound, and so the search, is only exact for
+ * positive semidefinite kernels; the constructor throws if the kernel value of
+ * a reference point with itself is negative, as it can be for the hyperbolic
+ * tangent kernel.
+ *
+ * For kernels that provide a batched evaluation (see kernel::HasBatchEvaluate)
+ * and dense data, the kernel values between a whole bucket and the query points
+ * of a block that are left are computed with one matrix product, so the search
+ * only stops at the start of a bucket.  The index holds a copy of the
+ * reference set, in sorted order.
+ *
+ * @tparam KernelType Type of kernel to search with.
+ * @tparam MatType Type of data matrix (usually arma::mat).
+ */
+template<typename KernelType, typename MatType = arma::mat>
+class NormBucketIndex
+{
+ public:
+  /**
+   * Build the index on the given reference set.
+   *
+   * @param referenceSet Set of reference points.
+   * @param kernel Kernel to compute the norms with; it must be positive
+   *     semidefinite.
+   * @param bucketSize Number of points in each bucket.
+   */
+  NormBucketIndex(const MatType& referenceSet,
+                  KernelType& kernel,
+                  const size_t bucketSize = 256);
+
+  /**
+   * Find the k reference points with maximum kernel value for each query
+   * point.  The results are stored in the same way as by FastMKS::Search(),
+   * with the indices of the points in the reference set the index was built
+   * on.
+   *
+   * @param querySet Set of query points.
+   * @param kernel Kernel to search with; it must be the kernel the index was
+   *     built with.
+   * @param k Number of maximum kernels to find.
+   * @param indices Matrix to store resulting indices of max-kernel search in.
+   * @param kernels Matrix to store resulting max-kernel values in.
+   * @param sameSet If true, the query set is the reference set, and points are
+   *     not returned as their own candidates.
+   * @param parallel If true, the query points are split between threads.
+   */
+  void Search(const MatType& querySet,
+              KernelType& kernel,
+              const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& kernels,
+              const bool sameSet = false,
+              const bool parallel = false) const;
+
+  //! Get the number of points in each bucket.
+  size_t BucketSize() const { return bucketSize; }
+
+  //! Get the number of buckets.
+  size_t NumBuckets() const
+  {
+    return (sortedSet.n_cols + bucketSize - 1) / bucketSize;
+  }
+
+ private:
+  //! The reference points, sorted by decreasing norm.
+  MatType sortedSet;
+  //! The norm of each sorted reference point.
+  arma::vec norms;
+  //! The index in the original reference set of each sorted reference point.
+  std::vector<size_t> oldFromNew;
+  //! The number of points in each bucket.
+  size_t bucketSize;
+
+  //! Candidate represents a possible candidate point (value, index).
+  typedef std::pair<double, size_t> Candidate;
+
+  //! Compare two candidates based on the value.
+  struct CandidateCmp {
+    bool operator()(const Candidate& c1, const Candidate& c2)
+    {
+      return c1.first > c2.first;
+    };
+  };
+
+  //! Use a priority queue to represent the list of candidate points.
+  typedef std::priority_queue<Candidate, std::vector<Candidate>,
+      CandidateCmp> CandidateList;
+
+  //! Search for each query point separately, evaluating each pair of points,
+  //! and return the number of kernel evaluations.  queryNorms holds the norm
+  //! of each query point.
+  size_t BucketSearch(const MatType& querySet,
+                      const arma::vec& queryNorms,
+                      KernelType& kernel,
+                      const size_t k,
+                      arma::Mat<size_t>& indices,
+                      arma::mat& kernels,
+                      const bool sameSet,
+                      const bool parallel,
+                      const std::false_type& /* hasBatchEvaluate */) const;
+
+  //! Search for blocks of query points, evaluating the kernel values between
+  //! a bucket and the query points that are left in a block at once, and
+  //! return the number of kernel evaluations.  queryNorms holds the norm of
+  //! each query point.
+  size_t BucketSearch(const MatType& querySet,
+                      const arma::vec& queryNorms,
+                      KernelType& kernel,
+                      const size_t k,
+                      arma::Mat<size_t>& indices,
+                      arma::mat& kernels,
+                      const bool sameSet,
+                      const bool parallel,
+                      const std::true_type& /* hasBatchEvaluate */) const;
+};
+
+} // namespace fastmks
+} // namespace mlpack
+
+// Include implementation.
+#include "norm_bucket_index_impl.hpp"
+
+#endif
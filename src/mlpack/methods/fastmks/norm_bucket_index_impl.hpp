@@ -0,0 +1,303 @@
+/**
+ * @file methods/fastmks/norm_bucket_index_impl.hpp
+ *
+ * Implementation of NormBucketIndex.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_FASTMKS_NORM_BUCKET_INDEX_IMPL_HPP
+#define MLPACK_METHODS_FASTMKS_NORM_BUCKET_INDEX_IMPL_HPP
+
+// In case it hasn't yet been included.
+#include "norm_bucket_index.hpp"
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace fastmks {
+
+template<typename KernelType, typename MatType>
+NormBucketIndex<KernelType, MatType>::NormBucketIndex(
+    const MatType& referenceSet,
+    KernelType& kernel,
+    const size_t bucketSize) :
+    bucketSize(bucketSize)
+{
+  if (bucketSize == 0)
+  {
+    throw std::invalid_argument("NormBucketIndex: the bucket size must be "
+        "greater than 0");
+  }
+
+  arma::vec referenceNorms(referenceSet.n_cols);
+  for (size_t i = 0; i < referenceSet.n_cols; ++i)
+  {
+    const double selfKernel = kernel.Evaluate(referenceSet.col(i),
+                                              referenceSet.col(i));
+
+    // A negative self-kernel value means that the kernel is not positive
+    // semidefinite, and the Cauchy-Schwarz bound does not hold.
+    if (!(selfKernel >= 0.0))
+    {
+      std::stringstream ss;
+      ss << "NormBucketIndex: the kernel value of reference point " << i
+          << " with itself is " << selfKernel << "; the kernel must be "
+          << "positive semidefinite";
+      throw std::invalid_argument(ss.str());
+    }
+
+    referenceNorms[i] = std::sqrt(selfKernel);
+  }
+
+  // Sort the points by decreasing norm.
+  const arma::uvec order = arma::sort_index(referenceNorms, "descend");
+
+  sortedSet.set_size(referenceSet.n_rows, referenceSet.n_cols);
+  norms.set_size(referenceSet.n_cols);
+  oldFromNew.resize(referenceSet.n_cols);
+  for (size_t i = 0; i < order.n_elem; ++i)
+  {
+    sortedSet.col(i) = referenceSet.col(order[i]);
+    norms[i] = referenceNorms[order[i]];
+    oldFromNew[i] = order[i];
+  }
+}
+
+template<typename KernelType, typename MatType>
+void NormBucketIndex<KernelType, MatType>::Search(
+    const MatType& querySet,
+    KernelType& kernel,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels,
+    const bool sameSet,
+    const bool parallel) const
+{
+  if (k > sortedSet.n_cols)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << sortedSet.n_cols << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  if (querySet.n_rows != sortedSet.n_rows)
+  {
+    std::stringstream ss;
+    ss << "The number of dimensions in the query set (" << querySet.n_rows
+        << ") must be equal to the number of dimensions in the reference set ("
+        << sortedSet.n_rows << ")!";
+    throw std::invalid_argument(ss.str());
+  }
+
+  arma::vec queryNorms(querySet.n_cols);
+  #pragma omp parallel for if (parallel)
+  for (omp_size_t q = 0; q < (omp_size_t) querySet.n_cols; ++q)
+  {
+    queryNorms[q] = std::sqrt(kernel.Evaluate(querySet.col(q),
+                                              querySet.col(q)));
+  }
+
+  // As for the reference points, the bound needs a positive semidefinite
+  // kernel.
+  for (size_t q = 0; q < querySet.n_cols; ++q)
+  {
+    if (std::isnan(queryNorms[q]))
+    {
+      std::stringstream ss;
+      ss << "NormBucketIndex::Search(): the kernel value of query point " << q
+          << " with itself is negative; the kernel must be positive "
+          << "semidefinite";
+      throw std::invalid_argument(ss.str());
+    }
+  }
+
+  indices.set_size(k, querySet.n_cols);
+  kernels.set_size(k, querySet.n_cols);
+
+  const size_t evaluations = BucketSearch(querySet, queryNorms, kernel, k,
+      indices, kernels, sameSet, parallel,
+      kernel::HasBatchEvaluate<KernelType, MatType>());
+
+  Log::Info << evaluations << " kernel evaluations." << std::endl;
+}
+
+template<typename KernelType, typename MatType>
+size_t NormBucketIndex<KernelType, MatType>::BucketSearch(
+    const MatType& querySet,
+    const arma::vec& queryNorms,
+    KernelType& kernel,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels,
+    const bool sameSet,
+    const bool parallel,
+    const std::false_type& /* hasBatchEvaluate */) const
+{
+  size_t evaluations = 0;
+  #pragma omp parallel for schedule(dynamic) if (parallel) \
+      reduction(+:evaluations)
+  for (omp_size_t q = 0; q < (omp_size_t) querySet.n_cols; ++q)
+  {
+    const double queryNorm = queryNorms[q];
+
+    const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
+    std::vector<Candidate> cList(k, def);
+    CandidateList pqueue(CandidateCmp(), std::move(cList));
+
+    // Without batches, the search can stop at any point, not only at the
+    // start of a bucket.
+    for (size_t r = 0; r < sortedSet.n_cols; ++r)
+    {
+      // No point from here on can have a larger kernel value.
+      if (pqueue.top().first >= queryNorm * norms[r])
+        break;
+
+      const size_t index = oldFromNew[r];
+      if (sameSet && index == (size_t) q)
+        continue; // Don't return the point as its own candidate.
+
+      const double eval = kernel.Evaluate(querySet.col(q), sortedSet.col(r));
+      ++evaluations;
+
+      if (eval > pqueue.top().first)
+      {
+        pqueue.pop();
+        pqueue.push(std::make_pair(eval, index));
+      }
+    }
+
+    for (size_t j = 1; j <= k; ++j)
+    {
+      indices(k - j, q) = pqueue.top().second;
+      kernels(k - j, q) = pqueue.top().first;
+      pqueue.pop();
+    }
+  }
+
+  return evaluations;
+}
+
+template<typename KernelType, typename MatType>
+size_t NormBucketIndex<KernelType, MatType>::BucketSearch(
+    const MatType& querySet,
+    const arma::vec& queryNorms,
+    KernelType& kernel,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels,
+    const bool sameSet,
+    const bool parallel,
+    const std::true_type& /* hasBatchEvaluate */) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t blockSize = 256;
+  const size_t numQueryBlocks = (querySet.n_cols + blockSize - 1) / blockSize;
+
+  size_t evaluations = 0;
+  #pragma omp parallel for schedule(dynamic) if (parallel) \
+      reduction(+:evaluations)
+  for (omp_size_t b = 0; b < (omp_size_t) numQueryBlocks; ++b)
+  {
+    const size_t firstQuery = b * blockSize;
+    const size_t numQueries = std::min(blockSize,
+        (size_t) querySet.n_cols - firstQuery);
+
+    // Alias the block of query points instead of copying it.
+    const MatType queries(const_cast<ElemType*>(querySet.colptr(firstQuery)),
+        querySet.n_rows, numQueries, false, true);
+
+    const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
+    std::vector<CandidateList> pqueues(numQueries,
+        CandidateList(CandidateCmp(), std::vector<Candidate>(k, def)));
+
+    // The query points of the block whose candidates can still change.
+    std::vector<size_t> active(numQueries);
+    for (size_t q = 0; q < numQueries; ++q)
+      active[q] = q;
+
+    MatType activeQueries;
+    arma::Mat<ElemType> bucketKernels;
+    for (size_t firstRef = 0; firstRef < sortedSet.n_cols;
+         firstRef += bucketSize)
+    {
+      // The first point of the bucket has the largest norm of this bucket and
+      // all of the buckets after it.
+      size_t numActive = 0;
+      for (size_t i = 0; i < active.size(); ++i)
+      {
+        const size_t q = active[i];
+        const double queryNorm = queryNorms[firstQuery + q];
+        if (pqueues[q].top().first < queryNorm * norms[firstRef])
+          active[numActive++] = q;
+      }
+      active.resize(numActive);
+
+      if (numActive == 0)
+        break;
+
+      const size_t numRefs = std::min(bucketSize,
+          (size_t) sortedSet.n_cols - firstRef);
+      const MatType references(
+          const_cast<ElemType*>(sortedSet.colptr(firstRef)),
+          sortedSet.n_rows, numRefs, false, true);
+
+      if (numActive == numQueries)
+      {
+        kernel.BatchEvaluate(references, queries, bucketKernels);
+      }
+      else
+      {
+        activeQueries.set_size(queries.n_rows, numActive);
+        for (size_t i = 0; i < numActive; ++i)
+          activeQueries.col(i) = queries.col(active[i]);
+
+        kernel.BatchEvaluate(references, activeQueries, bucketKernels);
+      }
+      evaluations += numRefs * numActive;
+
+      for (size_t i = 0; i < numActive; ++i)
+      {
+        const size_t q = active[i];
+        CandidateList& pqueue = pqueues[q];
+        for (size_t r = 0; r < numRefs; ++r)
+        {
+          const size_t index = oldFromNew[firstRef + r];
+          if (sameSet && index == firstQuery + q)
+            continue; // Don't return the point as its own candidate.
+
+          const double eval = bucketKernels(r, i);
+          if (eval > pqueue.top().first)
+          {
+            pqueue.pop();
+            pqueue.push(std::make_pair(eval, index));
+          }
+        }
+      }
+    }
+
+    for (size_t q = 0; q < numQueries; ++q)
+    {
+      CandidateList& pqueue = pqueues[q];
+      for (size_t j = 1; j <= k; ++j)
+      {
+        indices(k - j, firstQuery + q) = pqueue.top().second;
+        kernels(k - j, firstQuery + q) = pqueue.top().first;
+        pqueue.pop();
+      }
+    }
+  }
+
+  return evaluations;
+}
+
+} // namespace fastmks
+} // namespace mlpack
+
+#endif
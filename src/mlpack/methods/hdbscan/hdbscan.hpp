@@ -0,0 +1,173 @@
+/**
+ * @file methods/hdbscan/hdbscan.hpp
+ *
+ * An implementation of the HDBSCAN clustering method, which computes the
+ * minimum spanning tree it is built on with DualTreeBoruvka.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_HDBSCAN_HDBSCAN_HPP
+#define MLPACK_METHODS_HDBSCAN_HDBSCAN_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/emst/dtb.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+namespace mlpack {
+namespace hdbscan {
+
+/**
+ * HDBSCAN (Hierarchical DBSCAN) is a clustering technique described in the
+ * following paper:
+ *
+ * @code
+ * @inproceedings{campello2013density,
+ *   title={Density-based clustering based on hierarchical density estimates},
+ *   author={Campello, R.J.G.B. and Moulavi, D. and Sander, J.},
+ *   booktitle={Pacific-Asia Conference on Knowledge Discovery and Data Mining
+ *       (PAKDD 2013)},
+ *   pages={160--172},
+ *   year={2013}
+ * }
+ * @endcode
+ *
+ * HDBSCAN does not need the radius that DBSCAN does.  The core distance of
+ * each point is the distance to its (minPoints - 1)'th nearest neighbor, and
+ * the points are linked by the minimum spanning tree of the mutual
+ * reachability distance max(d(a, b), core(a), core(b)).  Removing the edges of
+ * this tree from the longest to the shortest gives the hierarchy of the
+ * clusters of every DBSCAN radius; in the condensed tree, a cluster only splits
+ * when both parts have at least minClusterSize points, and otherwise points
+ * fall out of the cluster as noise.  The clusters with the largest stability
+ * (excess of mass) are then selected from the condensed tree.
+ *
+ * The core distances are computed with NeighborSearch and the minimum spanning
+ * tree with DualTreeBoruvka, both with the given tree type.  The hierarchy is
+ * built from the n - 1 edges of the spanning tree, so it takes O(n) memory.
+ *
+ * @tparam MetricType The metric to use.
+ * @tparam MatType The type of data matrix to use.
+ * @tparam TreeType Type of tree to use for the neighbor search and the
+ *      minimum spanning tree.
+ */
+template<
+    typename MetricType = metric::EuclideanDistance,
+    typename MatType = arma::mat,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType = tree::KDTree
+>
+class HDBSCAN
+{
+ public:
+  /**
+   * Construct the HDBSCAN object with the given parameters.
+   *
+   * @param minClusterSize Minimum number of points of a cluster; this must be
+   *     at least 2.
+   * @param minPoints Number of points (including the point itself) in the
+   *     neighborhood that defines the core distance of a point.
+   * @param naive If true, the O(n^2) naive algorithms are used instead of
+   *     trees.
+   */
+  HDBSCAN(const size_t minClusterSize = 5,
+          const size_t minPoints = 5,
+          const bool naive = false);
+
+  /**
+   * Performs HDBSCAN clustering on the data, returning the number of clusters.
+   * The assignment of each point is between 0 and the number of clusters minus
+   * one; noise points are assigned SIZE_MAX.
+   *
+   * @param data Dataset to cluster.
+   * @param assignments Vector to store cluster assignments.
+   */
+  size_t Cluster(const MatType& data, arma::Row<size_t>& assignments);
+
+  /**
+   * Performs HDBSCAN clustering on the data, returning the number of clusters,
+   * the assignment of each point (SIZE_MAX for noise points), and the
+   * condensed tree.
+   *
+   * The condensed tree has four rows and one column for each point or cluster
+   * that falls out of, or splits from, a cluster: the parent cluster, the
+   * child, the lambda value (the inverse of the distance) at which the child
+   * leaves the parent, and the number of points of the child.  Points are
+   * numbered from 0 to n - 1 and clusters from n; cluster n is the root, which
+   * holds every point.
+   *
+   * @param data Dataset to cluster.
+   * @param assignments Vector to store cluster assignments.
+   * @param condensedTree Matrix to store the condensed tree.
+   */
+  size_t Cluster(const MatType& data,
+                 arma::Row<size_t>& assignments,
+                 arma::mat& condensedTree);
+
+  //! Get the minimum number of points of a cluster.
+  size_t MinClusterSize() const { return minClusterSize; }
+  //! Modify the minimum number of points of a cluster.
+  size_t& MinClusterSize() { return minClusterSize; }
+
+  //! Get the number of points in the neighborhood of the core distance.
+  size_t MinPoints() const { return minPoints; }
+  //! Modify the number of points in the neighborhood of the core distance.
+  size_t& MinPoints() { return minPoints; }
+
+  //! Get whether the naive algorithms are used.
+  bool Naive() const { return naive; }
+  //! Modify whether the naive algorithms are used.
+  bool& Naive() { return naive; }
+
+ private:
+  /**
+   * Compute the core distance of every point.
+   *
+   * @param data Dataset to cluster.
+   * @param coreDistances Vector to store the core distances in.
+   */
+  void CoreDistances(const MatType& data, arma::vec& coreDistances) const;
+
+  /**
+   * Build the single linkage tree from the edges of the minimum spanning tree,
+   * sorted by distance.  Node i < n is point i, and node n + i is the node
+   * made by the i'th edge.
+   *
+   * @param mst The minimum spanning tree, as given by DualTreeBoruvka.
+   * @param children The two children of each node made by an edge.
+   * @param sizes The number of points under each node.
+   */
+  static void SingleLinkage(const arma::mat& mst,
+                            arma::Mat<size_t>& children,
+                            arma::Col<size_t>& sizes);
+
+  /**
+   * Condense the single linkage tree, and select the clusters.
+   *
+   * @param mst The minimum spanning tree, as given by DualTreeBoruvka.
+   * @param assignments Vector to store cluster assignments.
+   * @param condensedTree Matrix to store the condensed tree.
+   * @return The number of clusters.
+   */
+  size_t ExtractClusters(const arma::mat& mst,
+                         arma::Row<size_t>& assignments,
+                         arma::mat& condensedTree) const;
+
+  //! Minimum number of points of a cluster.
+  size_t minClusterSize;
+  //! Number of points in the neighborhood of the core distance.
+  size_t minPoints;
+  //! Whether the naive algorithms are used.
+  bool naive;
+};
+
+} // namespace hdbscan
+} // namespace mlpack
+
+// Include implementation.
+#include "hdbscan_impl.hpp"
+
+#endif
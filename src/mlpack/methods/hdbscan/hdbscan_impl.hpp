@@ -0,0 +1,341 @@
+/**
+ * @file methods/hdbscan/hdbscan_impl.hpp
+ *
+ * Implementation of HDBSCAN.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_HDBSCAN_HDBSCAN_IMPL_HPP
+#define MLPACK_METHODS_HDBSCAN_HDBSCAN_IMPL_HPP
+
+#include "hdbscan.hpp"
+
+#include <mlpack/methods/emst/union_find.hpp>
+
+namespace mlpack {
+namespace hdbscan {
+
+/**
+ * Construct the HDBSCAN object with the given parameters.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+HDBSCAN<MetricType, MatType, TreeType>::HDBSCAN(const size_t minClusterSize,
+                                                const size_t minPoints,
+                                                const bool naive) :
+    minClusterSize(minClusterSize),
+    minPoints(minPoints),
+    naive(naive)
+{
+  // Nothing to do.
+}
+
+/**
+ * Performs HDBSCAN clustering on the data, returning the number of clusters.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+size_t HDBSCAN<MetricType, MatType, TreeType>::Cluster(
+    const MatType& data,
+    arma::Row<size_t>& assignments)
+{
+  arma::mat condensedTree;
+  return Cluster(data, assignments, condensedTree);
+}
+
+/**
+ * Performs HDBSCAN clustering on the data, returning the number of clusters
+ * and the condensed tree.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+size_t HDBSCAN<MetricType, MatType, TreeType>::Cluster(
+    const MatType& data,
+    arma::Row<size_t>& assignments,
+    arma::mat& condensedTree)
+{
+  if (minClusterSize < 2)
+  {
+    throw std::invalid_argument("HDBSCAN::Cluster(): the minimum cluster size "
+        "must be at least 2!");
+  }
+
+  if (minPoints == 0 || minPoints > data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "HDBSCAN::Cluster(): minPoints (" << minPoints << ") must be "
+        << "between 1 and the number of points (" << data.n_cols << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // A single point has no spanning tree, and is noise.
+  if (data.n_cols < 2)
+  {
+    assignments.set_size(data.n_cols);
+    assignments.fill(SIZE_MAX);
+    condensedTree.set_size(4, 0);
+    return 0;
+  }
+
+  arma::vec coreDistances;
+  CoreDistances(data, coreDistances);
+
+  arma::mat mst;
+  emst::DualTreeBoruvka<MetricType, MatType, TreeType> dtb(data, naive);
+  dtb.ComputeMST(mst, coreDistances);
+
+  return ExtractClusters(mst, assignments, condensedTree);
+}
+
+/**
+ * Compute the core distance of every point.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void HDBSCAN<MetricType, MatType, TreeType>::CoreDistances(
+    const MatType& data,
+    arma::vec& coreDistances) const
+{
+  // The point itself is the first point of its neighborhood, but it is not
+  // returned by a monochromatic search.
+  if (minPoints == 1)
+  {
+    coreDistances.zeros(data.n_cols);
+    return;
+  }
+
+  neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType, MatType,
+      TreeType> knn(data, naive ? neighbor::NAIVE_MODE :
+      neighbor::DUAL_TREE_MODE);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(minPoints - 1, neighbors, distances);
+
+  coreDistances = distances.row(minPoints - 2).t();
+}
+
+/**
+ * Build the single linkage tree from the edges of the minimum spanning tree.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void HDBSCAN<MetricType, MatType, TreeType>::SingleLinkage(
+    const arma::mat& mst,
+    arma::Mat<size_t>& children,
+    arma::Col<size_t>& sizes)
+{
+  const size_t numPoints = mst.n_cols + 1;
+
+  children.set_size(2, mst.n_cols);
+  sizes.set_size(numPoints + mst.n_cols);
+  sizes.subvec(0, numPoints - 1).ones();
+
+  // The node that holds the points of each component so far.
+  emst::UnionFind components(numPoints);
+  arma::Col<size_t> componentNodes =
+      arma::regspace<arma::Col<size_t>>(0, numPoints - 1);
+
+  // The edges are sorted by distance, so every edge joins the two components
+  // with the node of the largest distance so far.
+  for (size_t i = 0; i < mst.n_cols; ++i)
+  {
+    const size_t a = components.Find((size_t) mst(0, i));
+    const size_t b = components.Find((size_t) mst(1, i));
+
+    children(0, i) = componentNodes[a];
+    children(1, i) = componentNodes[b];
+    sizes[numPoints + i] = sizes[children(0, i)] + sizes[children(1, i)];
+
+    components.Union(a, b);
+    componentNodes[components.Find(a)] = numPoints + i;
+  }
+}
+
+/**
+ * Condense the single linkage tree, and select the clusters.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+size_t HDBSCAN<MetricType, MatType, TreeType>::ExtractClusters(
+    const arma::mat& mst,
+    arma::Row<size_t>& assignments,
+    arma::mat& condensedTree) const
+{
+  const size_t numPoints = mst.n_cols + 1;
+
+  arma::Mat<size_t> children;
+  arma::Col<size_t> sizes;
+  SingleLinkage(mst, children, sizes);
+
+  // The entries of the condensed tree.
+  std::vector<size_t> entryParents, entryChildren, entrySizes;
+  std::vector<double> entryLambdas;
+
+  // The parent of each cluster, and the lambda value it was created at.  The
+  // root is cluster 0, and a cluster always comes after its parent.
+  std::vector<size_t> clusterParents(1, SIZE_MAX);
+  std::vector<double> clusterBirths(1, 0.0);
+
+  // Walk down the single linkage tree from the root without recursion, since
+  // the tree may be as deep as the number of points.  Each node that is
+  // reached belongs to a cluster of the condensed tree.
+  std::vector<size_t> nodeClusters(mst.n_cols, SIZE_MAX);
+  std::vector<size_t> nodes(1, numPoints + mst.n_cols - 1);
+  nodeClusters[mst.n_cols - 1] = 0;
+  std::vector<size_t> fallenNodes;
+  while (!nodes.empty())
+  {
+    const size_t edge = nodes.back() - numPoints;
+    nodes.pop_back();
+
+    const size_t cluster = nodeClusters[edge];
+    const double lambda = (mst(2, edge) > 0.0) ? 1.0 / mst(2, edge) :
+        std::numeric_limits<double>::infinity();
+
+    // Both parts are large enough: the cluster splits into two new clusters.
+    // Since minClusterSize is at least 2, a large enough part is never a single
+    // point.
+    const bool split = (sizes[children(0, edge)] >= minClusterSize &&
+        sizes[children(1, edge)] >= minClusterSize);
+    for (size_t i = 0; i < 2; ++i)
+    {
+      const size_t child = children(i, edge);
+      if (split)
+      {
+        const size_t childCluster = clusterParents.size();
+        clusterParents.push_back(cluster);
+        clusterBirths.push_back(lambda);
+
+        entryParents.push_back(cluster);
+        entryChildren.push_back(numPoints + childCluster);
+        entryLambdas.push_back(lambda);
+        entrySizes.push_back(sizes[child]);
+
+        nodeClusters[child - numPoints] = childCluster;
+        nodes.push_back(child);
+      }
+      else if (sizes[child] >= minClusterSize)
+      {
+        // The cluster goes on in the larger part.
+        nodeClusters[child - numPoints] = cluster;
+        nodes.push_back(child);
+      }
+      else
+      {
+        // Every point of the smaller part falls out of the cluster.
+        fallenNodes.push_back(child);
+        while (!fallenNodes.empty())
+        {
+          const size_t node = fallenNodes.back();
+          fallenNodes.pop_back();
+          if (node < numPoints)
+          {
+            entryParents.push_back(cluster);
+            entryChildren.push_back(node);
+            entryLambdas.push_back(lambda);
+            entrySizes.push_back(1);
+          }
+          else
+          {
+            fallenNodes.push_back(children(0, node - numPoints));
+            fallenNodes.push_back(children(1, node - numPoints));
+          }
+        }
+      }
+    }
+  }
+
+  // The stability of a cluster is the sum, over its points, of the lambda
+  // values for which the point is in the cluster.  The lambda values of points
+  // and clusters that leave at the birth of the cluster (which may both be
+  // infinite) add nothing.
+  const size_t numClusters = clusterParents.size();
+  std::vector<double> stabilities(numClusters, 0.0);
+  for (size_t i = 0; i < entryParents.size(); ++i)
+  {
+    const size_t cluster = entryParents[i];
+    if (entryLambdas[i] > clusterBirths[cluster])
+    {
+      stabilities[cluster] += (entryLambdas[i] - clusterBirths[cluster]) *
+          entrySizes[i];
+    }
+  }
+
+  // Select the clusters by excess of mass, from the leaves up: a cluster is
+  // selected unless its children together are more stable.  The root is never
+  // selected.
+  std::vector<double> childStabilities(numClusters, 0.0);
+  std::vector<bool> hasChildren(numClusters, false);
+  std::vector<bool> selected(numClusters, false);
+  for (size_t c = numClusters - 1; c > 0; --c)
+  {
+    if (hasChildren[c] && childStabilities[c] > stabilities[c])
+      stabilities[c] = childStabilities[c];
+    else
+      selected[c] = true;
+
+    childStabilities[clusterParents[c]] += stabilities[c];
+    hasChildren[clusterParents[c]] = true;
+  }
+
+  // Each selected cluster that has no selected ancestor is a final cluster,
+  // and its descendants belong to it.
+  std::vector<size_t> labels(numClusters, SIZE_MAX);
+  size_t numFinalClusters = 0;
+  for (size_t c = 1; c < numClusters; ++c)
+  {
+    if (labels[clusterParents[c]] != SIZE_MAX)
+      labels[c] = labels[clusterParents[c]];
+    else if (selected[c])
+      labels[c] = numFinalClusters++;
+  }
+
+  assignments.set_size(numPoints);
+  assignments.fill(SIZE_MAX);
+  condensedTree.set_size(4, entryParents.size());
+  for (size_t i = 0; i < entryParents.size(); ++i)
+  {
+    if (entryChildren[i] < numPoints)
+      assignments[entryChildren[i]] = labels[entryParents[i]];
+
+    condensedTree(0, i) = numPoints + entryParents[i];
+    condensedTree(1, i) = entryChildren[i];
+    condensedTree(2, i) = entryLambdas[i];
+    condensedTree(3, i) = entrySizes[i];
+  }
+
+  return numFinalClusters;
+}
+
+} // namespace hdbscan
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file methods/hdbscan/hdbscan_main.cpp
+ *
+ * Implementation of program to run HDBSCAN.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/io.hpp>
+#include <mlpack/core/util/mlpack_main.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include "hdbscan.hpp"
+
+using namespace mlpack;
+using namespace mlpack::hdbscan;
+using namespace mlpack::metric;
+using namespace mlpack::tree;
+using namespace mlpack::util;
+using namespace std;
+
+// Program Name.
+BINDING_NAME("HDBSCAN clustering");
+
+// Short description.
+BINDING_SHORT_DESC(
+    "An implementation of HDBSCAN clustering.  Given a dataset, this can "
+    "compute and return a clustering of that dataset, without a radius "
+    "parameter.");
+
+// Long description.
+BINDING_LONG_DESC(
+    "This program implements the HDBSCAN algorithm for clustering, which finds "
+    "the clusters of every DBSCAN radius at once and selects the most stable "
+    "ones.  The core distance of each point (the distance to the " +
+    PRINT_PARAM_STRING("min_points") + "'th point of its neighborhood, "
+    "including itself) is computed with a tree-based neighbor search, and the "
+    "cluster hierarchy is built from the minimum spanning tree of the mutual "
+    "reachability distance, which is computed with the dual-tree Boruvka "
+    "algorithm."
+    "\n\n"
+    "The input dataset to be clustered may be specified with the " +
+    PRINT_PARAM_STRING("input") + " parameter, and the minimum number of "
+    "points in a cluster may be specified with the " +
+    PRINT_PARAM_STRING("min_cluster_size") + " parameter.  If " +
+    PRINT_PARAM_STRING("min_points") + " is not specified, it is equal to " +
+    PRINT_PARAM_STRING("min_cluster_size") + "."
+    "\n\n"
+    "The " + PRINT_PARAM_STRING("assignments") + " output parameter contains "
+    "the cluster assignment of each point; noise points are assigned the "
+    "largest representable index.  The " +
+    PRINT_PARAM_STRING("condensed_tree") + " output parameter contains the "
+    "condensed cluster tree, with one column for each point or cluster that "
+    "leaves a cluster: the parent cluster, the child, the lambda value "
+    "(inverse distance) at which the child leaves, and the number of points "
+    "of the child.  Points are numbered from 0 and clusters from the number of "
+    "points; the first cluster is the root."
+    "\n\n"
+    "The type of tree may be chosen with the " +
+    PRINT_PARAM_STRING("tree_type") + " parameter ('kd', 'ball', 'cover'), "
+    "and the " + PRINT_PARAM_STRING("naive") + " parameter will force "
+    "brute-force computation instead.");
+
+// Example.
+BINDING_EXAMPLE(
+    "An example usage to run HDBSCAN on the dataset in " +
+    PRINT_DATASET("input") + " with a minimum cluster size of 10 is given "
+    "below:"
+    "\n\n" +
+    PRINT_CALL("hdbscan", "input", "input", "min_cluster_size", 10,
+        "assignments", "assignments"));
+
+// See also...
+BINDING_SEE_ALSO("@dbscan", "#dbscan");
+BINDING_SEE_ALSO("@emst", "#emst");
+BINDING_SEE_ALSO("Density-based clustering based on hierarchical density "
+        "estimates", "https://doi.org/10.1007/978-3-642-37456-2_14");
+BINDING_SEE_ALSO("mlpack::hdbscan::HDBSCAN class documentation",
+        "@doxygen/classmlpack_1_1hdbscan_1_1HDBSCAN.html");
+
+PARAM_MATRIX_IN_REQ("input", "Input dataset to cluster.", "i");
+PARAM_UROW_OUT("assignments", "Output matrix for assignments of each "
+    "point.", "a");
+PARAM_MATRIX_OUT("condensed_tree", "Matrix to save the condensed cluster tree "
+    "to.", "C");
+
+PARAM_INT_IN("min_cluster_size", "Minimum number of points for a cluster.",
+    "m", 5);
+PARAM_INT_IN("min_points", "Number of points in the neighborhood that defines "
+    "the core distance of a point (0 means min_cluster_size).", "p", 0);
+
+PARAM_STRING_IN("tree_type", "The type of tree to use ('kd', 'ball', "
+    "'cover').", "t", "kd");
+PARAM_FLAG("naive", "If set, brute-force computation (not tree-based) will be "
+    "used.", "N");
+
+// Actually run the clustering, and process the output.
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RunHDBSCAN()
+{
+  arma::mat dataset = std::move(IO::GetParam<arma::mat>("input"));
+  const size_t minClusterSize = (size_t) IO::GetParam<int>("min_cluster_size");
+  const size_t minPoints = (IO::GetParam<int>("min_points") == 0) ?
+      minClusterSize : (size_t) IO::GetParam<int>("min_points");
+
+  if (minPoints > dataset.n_cols)
+  {
+    Log::Fatal << "The value of " << PRINT_PARAM_STRING("min_points")
+        << " (" << minPoints << ") must not be larger than the number of "
+        << "points (" << dataset.n_cols << ")!" << endl;
+  }
+
+  HDBSCAN<EuclideanDistance, arma::mat, TreeType> h(minClusterSize, minPoints,
+      IO::HasParam("naive"));
+
+  arma::Row<size_t> assignments;
+  arma::mat condensedTree;
+  Timer::Start("clustering");
+  const size_t numClusters = h.Cluster(dataset, assignments, condensedTree);
+  Timer::Stop("clustering");
+
+  Log::Info << "Found " << numClusters << " clusters; "
+      << arma::accu(assignments == SIZE_MAX) << " points are noise." << endl;
+
+  if (IO::HasParam("assignments"))
+    IO::GetParam<arma::Row<size_t>>("assignments") = std::move(assignments);
+  if (IO::HasParam("condensed_tree"))
+    IO::GetParam<arma::mat>("condensed_tree") = std::move(condensedTree);
+}
+
+static void mlpackMain()
+{
+  RequireAtLeastOnePassed({ "assignments", "condensed_tree" }, false,
+      "no output will be saved");
+
+  ReportIgnoredParam({{ "naive", true }}, "tree_type");
+
+  RequireParamInSet<string>("tree_type", { "kd", "ball", "cover" }, true,
+      "unknown tree type");
+
+  RequireParamValue<int>("min_cluster_size", [](int x) { return x >= 2; },
+      true, "min_cluster_size must be at least 2");
+
+  RequireParamValue<int>("min_points", [](int x) { return x >= 0; },
+      true, "min_points must not be negative");
+
+  const string treeType = IO::GetParam<string>("tree_type");
+  if (treeType == "kd")
+    RunHDBSCAN<KDTree>();
+  else if (treeType == "ball")
+    RunHDBSCAN<BallTree>();
+  else if (treeType == "cover")
+    RunHDBSCAN<StandardCoverTree>();
+}
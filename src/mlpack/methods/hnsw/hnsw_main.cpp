@@ -0,0 +1,253 @@
+/**
+ * @file methods/hnsw/hnsw_main.cpp
+ *
+ * This file computes the approximate nearest-neighbors using a hierarchical
+ * navigable small world graph.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/io.hpp>
+#include <mlpack/core/util/mlpack_main.hpp>
+
+#include "hnsw_search.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+using namespace mlpack::util;
+
+// Program Name.
+BINDING_NAME("K-Approximate-Nearest-Neighbor Search with HNSW");
+
+// Short description.
+BINDING_SHORT_DESC(
+    "An implementation of approximate k-nearest-neighbor search with a "
+    "hierarchical navigable small world (HNSW) graph.  Given a set of reference"
+    " points and a set of query points, this will compute the k approximate "
+    "nearest neighbors of each query point in the reference set; models can be "
+    "saved for future use.");
+
+// Long description.
+BINDING_LONG_DESC(
+    "This program will calculate the k approximate-nearest-neighbors of a set "
+    "of points by searching a hierarchical navigable small world graph built on"
+    " the reference set.  You may specify a separate set of reference points "
+    "and query points, or just a reference set which will be used as both the "
+    "reference and query set.  The input and output matrices have the same "
+    "format as those of the knn and lsh programs, so the results can be "
+    "compared directly."
+    "\n\n"
+    "The graph is controlled by the " + PRINT_PARAM_STRING("links") +
+    " parameter (M in the HNSW paper), the number of links of each point "
+    "(points have twice as many links on the bottom layer), and the " +
+    PRINT_PARAM_STRING("ef_construction") + " parameter, the size of the "
+    "candidate list used while building the graph.  The search is controlled "
+    "by the " + PRINT_PARAM_STRING("ef") + " parameter, the size of the "
+    "candidate list used while searching.  Larger values of all three "
+    "parameters give higher recall but take longer.");
+
+// Example.
+BINDING_EXAMPLE(
+    "For example, the following will return 5 neighbors from the data for each "
+    "point in " + PRINT_DATASET("input") + " and store the distances in " +
+    PRINT_DATASET("distances") + " and the neighbors in " +
+    PRINT_DATASET("neighbors") + ":"
+    "\n\n" +
+    PRINT_CALL("hnsw", "k", 5, "reference", "input", "distances", "distances",
+        "neighbors", "neighbors") +
+    "\n\n"
+    "The output is organized such that row i and column j in the neighbors "
+    "output corresponds to the index of the point in the reference set which "
+    "is the j'th nearest neighbor from the point in the query set with index "
+    "i.  Row j and column i in the distances output file corresponds to the "
+    "distance between those two points."
+    "\n\n"
+    "If the true neighbors are given with " +
+    PRINT_PARAM_STRING("true_neighbors") + " (for instance, as computed by the"
+    " knn program), the recall of the search is printed.  Because the graph is "
+    "random, results may be different from run to run; the " +
+    PRINT_PARAM_STRING("seed") + " parameter can be specified to set the random"
+    " seed.");
+
+// See also...
+BINDING_SEE_ALSO("@knn", "#knn");
+BINDING_SEE_ALSO("@lsh", "#lsh");
+BINDING_SEE_ALSO("@krann", "#krann");
+BINDING_SEE_ALSO("Efficient and robust approximate nearest neighbor search "
+        "using Hierarchical Navigable Small World graphs (pdf)",
+        "https://arxiv.org/pdf/1603.09320.pdf");
+BINDING_SEE_ALSO("mlpack::neighbor::HNSWSearch C++ class documentation",
+        "@doxygen/classmlpack_1_1neighbor_1_1HNSWSearch.html");
+
+// Define our input parameters that this program will take.
+PARAM_MATRIX_IN("reference", "Matrix containing the reference dataset.", "r");
+PARAM_MATRIX_OUT("distances", "Matrix to output distances into.", "d");
+PARAM_UMATRIX_OUT("neighbors", "Matrix to output neighbors into.", "n");
+
+// We can load or save models.
+PARAM_MODEL_IN(HNSWSearch<>, "input_model", "Input HNSW model.", "m");
+PARAM_MODEL_OUT(HNSWSearch<>, "output_model", "Output for trained HNSW model.",
+    "M");
+
+// For testing recall.
+PARAM_UMATRIX_IN("true_neighbors", "Matrix of true neighbors to compute "
+    "recall with (the recall is printed when -v is specified).", "t");
+
+PARAM_INT_IN("k", "Number of nearest neighbors to find.", "k", 0);
+PARAM_MATRIX_IN("query", "Matrix containing query points (optional).", "q");
+
+PARAM_INT_IN("links", "The number of links of each point in the graph (the "
+    "bottom layer has twice as many).", "L", 16);
+PARAM_INT_IN("ef_construction", "The size of the candidate list used while "
+    "building the graph.", "c", 200);
+PARAM_INT_IN("ef", "The size of the candidate list used while searching.  If "
+    "0, the value stored in the model (50 for new models) is used.", "e", 0);
+PARAM_INT_IN("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+
+static void mlpackMain()
+{
+  if (IO::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) IO::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) time(NULL));
+
+  // Get all the parameters after checking them.
+  if (IO::HasParam("k"))
+  {
+    RequireParamValue<int>("k", [](int x) { return x > 0; }, true,
+        "k must be greater than 0");
+  }
+  RequireParamValue<int>("links", [](int x) { return x >= 2; }, true,
+      "links must be at least 2");
+  RequireParamValue<int>("ef_construction", [](int x) { return x > 0; }, true,
+      "ef_construction must be greater than 0");
+  RequireParamValue<int>("ef", [](int x) { return x >= 0; }, true,
+      "ef must not be negative");
+
+  RequireOnlyOnePassed({ "input_model", "reference" }, true);
+  RequireAtLeastOnePassed({ "neighbors", "distances", "output_model" }, false,
+      "no results will be saved");
+
+  ReportIgnoredParam({{ "k", false }}, "neighbors");
+  ReportIgnoredParam({{ "k", false }}, "distances");
+  ReportIgnoredParam({{ "k", false }}, "true_neighbors");
+  ReportIgnoredParam({{ "k", false }}, "query");
+
+  ReportIgnoredParam({{ "reference", false }}, "links");
+  ReportIgnoredParam({{ "reference", false }}, "ef_construction");
+
+  if (IO::HasParam("input_model") && !IO::HasParam("k"))
+  {
+    Log::Warn << PRINT_PARAM_STRING("k") << " not passed; no search will be "
+        << "performed!" << std::endl;
+  }
+
+  const size_t k = (size_t) IO::GetParam<int>("k");
+  const size_t m = (size_t) IO::GetParam<int>("links");
+  const size_t efConstruction = (size_t) IO::GetParam<int>("ef_construction");
+
+  HNSWSearch<>* hnsw;
+  if (IO::HasParam("reference"))
+  {
+    hnsw = new HNSWSearch<>();
+    Log::Info << "Using reference data from "
+        << IO::GetPrintableParam<arma::mat>("reference") << "." << endl;
+    arma::mat& referenceData = IO::GetParam<arma::mat>("reference");
+
+    Log::Info << "Building HNSW graph with links = " << m << " and "
+        << "ef_construction = " << efConstruction << "." << endl;
+    Timer::Start("graph_building");
+    hnsw->Train(std::move(referenceData), m, efConstruction);
+    Timer::Stop("graph_building");
+    Log::Info << hnsw->DistanceEvaluations() << " distance evaluations "
+        << "performed while building the graph." << endl;
+  }
+  else // We must have an input model.
+  {
+    hnsw = IO::GetParam<HNSWSearch<>*>("input_model");
+  }
+
+  if (IO::GetParam<int>("ef") != 0)
+    hnsw->Ef() = (size_t) IO::GetParam<int>("ef");
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  if (IO::HasParam("k"))
+  {
+    Log::Info << "Computing " << k << " approximate nearest neighbors with ef "
+        << "= " << hnsw->Ef() << "." << endl;
+
+    if (k > hnsw->ReferenceSet().n_cols ||
+        (!IO::HasParam("query") && k >= hnsw->ReferenceSet().n_cols))
+    {
+      const size_t points = hnsw->ReferenceSet().n_cols;
+      if (IO::HasParam("reference"))
+        delete hnsw;
+      Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less "
+          << "than the number of reference points (" << points << ")." << endl;
+    }
+
+    Timer::Start("computing_neighbors");
+    if (IO::HasParam("query"))
+    {
+      Log::Info << "Loaded query data from "
+          << IO::GetPrintableParam<arma::mat>("query") << "." << endl;
+      const arma::mat& queryData = IO::GetParam<arma::mat>("query");
+      if (queryData.n_rows != hnsw->ReferenceSet().n_rows)
+      {
+        const size_t dimensionality = hnsw->ReferenceSet().n_rows;
+        if (IO::HasParam("reference"))
+          delete hnsw;
+        Log::Fatal << "Query has invalid dimensions(" << queryData.n_rows
+            << "); should be " << dimensionality << "!" << endl;
+      }
+
+      hnsw->Search(queryData, k, neighbors, distances);
+    }
+    else
+    {
+      hnsw->Search(k, neighbors, distances);
+    }
+    Timer::Stop("computing_neighbors");
+
+    Log::Info << "Neighbors computed with " << hnsw->DistanceEvaluations()
+        << " distance evaluations and " << hnsw->VisitedNodes() << " visited "
+        << "nodes." << endl;
+
+    // Compute recall, if desired.
+    if (IO::HasParam("true_neighbors"))
+    {
+      Log::Info << "Using true neighbor indices from '"
+          << IO::GetPrintableParam<arma::Mat<size_t>>("true_neighbors") << "'."
+          << endl;
+
+      const arma::Mat<size_t>& trueNeighbors =
+          IO::GetParam<arma::Mat<size_t>>("true_neighbors");
+
+      if (trueNeighbors.n_rows != neighbors.n_rows ||
+          trueNeighbors.n_cols != neighbors.n_cols)
+      {
+        // Delete the model if needed.
+        if (IO::HasParam("reference"))
+          delete hnsw;
+        Log::Fatal << "The true neighbors file must have the same number of "
+            << "values as the set of neighbors being queried!" << endl;
+      }
+
+      // Compute recall and print it.
+      const double recallPercentage = 100 * HNSWSearch<>::ComputeRecall(
+          neighbors, trueNeighbors);
+
+      Log::Info << "Recall: " << recallPercentage << endl;
+    }
+
+    IO::GetParam<arma::mat>("distances") = std::move(distances);
+    IO::GetParam<arma::Mat<size_t>>("neighbors") = std::move(neighbors);
+  }
+
+  IO::GetParam<HNSWSearch<>*>("output_model") = hnsw;
+}
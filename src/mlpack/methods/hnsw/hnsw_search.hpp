@@ -0,0 +1,330 @@
+/**
+ * @file methods/hnsw/hnsw_search.hpp
+ *
+ * Defines the HNSWSearch class, which performs approximate nearest neighbor
+ * search with a hierarchical navigable small world (HNSW) graph built on the
+ * reference set.
+ *
+ * The details of this method can be found in the following paper:
+ *
+ * @code
+ * @article{malkov2020efficient,
+ *  title={Efficient and robust approximate nearest neighbor search using
+ *      hierarchical navigable small world graphs},
+ *  author={Malkov, Yu A. and Yashunin, Dmitry A.},
+ *  journal={IEEE Transactions on Pattern Analysis and Machine Intelligence},
+ *  volume={42},
+ *  number={4},
+ *  pages={824--836},
+ *  year={2020}
+ * }
+ * @endcode
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_HNSW_HNSW_SEARCH_HPP
+#define MLPACK_METHODS_HNSW_HNSW_SEARCH_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_set>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The HNSWSearch class builds a hierarchical navigable small world graph on
+ * the reference set and uses it to compute the approximate nearest neighbors
+ * of given queries.  Every reference point is assigned a random level, and is
+ * linked to (approximately) its closest points on every layer up to that
+ * level; the number of points on each layer decreases exponentially.  A query
+ * is answered by greedily descending the layers from a fixed entry point, and
+ * then running a beam search of width ef on the bottom layer.
+ *
+ * The quality of the graph is controlled by M (the number of links each point
+ * has on every layer but the bottom one, which has 2M) and efConstruction (the
+ * beam width used when inserting points); the speed and recall of the search
+ * are controlled by ef.  Larger values give higher recall at a higher cost.
+ *
+ * Points are inserted in parallel when OpenMP is available, and queries are
+ * answered in parallel.  Because points are inserted concurrently, the graph
+ * (and therefore the results) may differ slightly from run to run even with
+ * the same random seed.
+ *
+ * @tparam MetricType The metric to use for computation.
+ * @tparam MatType Type of matrix to use to store the data.
+ */
+template<
+    typename MetricType = metric::EuclideanDistance,
+    typename MatType = arma::mat
+>
+class HNSWSearch
+{
+ public:
+  //! The type of the elements in the data.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Build the graph on the given reference set.  In order to avoid copying the
+   * reference set, it is suggested to pass that parameter with std::move().
+   *
+   * @param referenceSet Set of reference points.
+   * @param m Number of links of each point on the upper layers (the bottom
+   *     layer holds up to 2 * m links).  Values between 8 and 48 are typical.
+   * @param efConstruction Size of the candidate list used while building the
+   *     graph.
+   * @param ef Size of the candidate list used while searching; this may be
+   *     changed later with Ef().
+   * @param metric An optional instance of the metric.
+   */
+  HNSWSearch(MatType referenceSet,
+             const size_t m = 16,
+             const size_t efConstruction = 200,
+             const size_t ef = 50,
+             const MetricType metric = MetricType());
+
+  /**
+   * Create an untrained HNSW model.  Be careful!  Make sure you call Train()
+   * before calling Search(), otherwise an exception will be thrown.
+   */
+  HNSWSearch();
+
+  /**
+   * Build the graph on the given reference set, replacing any existing graph.
+   * Points are inserted in parallel when OpenMP is available.  In order to
+   * avoid copying the reference set, consider passing that parameter with
+   * std::move().
+   *
+   * @param referenceSet Set of reference points.
+   * @param m Number of links of each point on the upper layers (the bottom
+   *     layer holds up to 2 * m links).
+   * @param efConstruction Size of the candidate list used while building the
+   *     graph.
+   */
+  void Train(MatType referenceSet,
+             const size_t m = 16,
+             const size_t efConstruction = 200);
+
+  /**
+   * Compute the approximate nearest neighbors of the points in the given query
+   * set and store the output in the given matrices.  The matrices will be set
+   * to the size of n columns by k rows, where n is the number of points in the
+   * query dataset and k is the number of neighbors being searched for.  If
+   * fewer than k points can be reached, the remaining neighbors are set to
+   * SIZE_MAX and the distances to DBL_MAX.  Queries are answered in parallel
+   * when OpenMP is available.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const MatType& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Compute the approximate nearest neighbors of every point in the reference
+   * set (not including the point itself) and store the output in the given
+   * matrices.
+   *
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each point.
+   * @param distances Matrix storing distances of neighbors for each point.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Compute the recall (% of neighbors found) given the neighbors returned by
+   * HNSWSearch::Search and a "ground truth" set of neighbors.  The recall
+   * returned will be in the range [0, 1].
+   *
+   * @param foundNeighbors Set of neighbors to compute recall of.
+   * @param realNeighbors Set of "ground truth" neighbors to compute recall
+   *     against.
+   */
+  static double ComputeRecall(const arma::Mat<size_t>& foundNeighbors,
+                              const arma::Mat<size_t>& realNeighbors);
+
+  /**
+   * Serialize the HNSW model.
+   *
+   * @param ar Archive to serialize to.
+   * @param version serialize class version to provide backward compatibility
+   */
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t version);
+
+  //! Return the number of distance evaluations performed by the last call to
+  //! Train() or Search().
+  size_t DistanceEvaluations() const { return distanceEvaluations; }
+  //! Modify the number of distance evaluations performed.
+  size_t& DistanceEvaluations() { return distanceEvaluations; }
+
+  //! Return the number of graph nodes visited by the last call to Train() or
+  //! Search().
+  size_t VisitedNodes() const { return visitedNodes; }
+  //! Modify the number of graph nodes visited.
+  size_t& VisitedNodes() { return visitedNodes; }
+
+  //! Return the reference dataset.
+  const MatType& ReferenceSet() const { return referenceSet; }
+
+  //! Get the number of links of each point on the upper layers.
+  size_t M() const { return m; }
+  //! Get the size of the candidate list used while building the graph.
+  size_t EfConstruction() const { return efConstruction; }
+
+  //! Get the size of the candidate list used while searching.
+  size_t Ef() const { return ef; }
+  //! Modify the size of the candidate list used while searching.
+  size_t& Ef() { return ef; }
+
+  //! Get the highest layer of the graph.
+  size_t MaxLevel() const { return maxLevel; }
+  //! Get the point every search starts from.
+  size_t EntryPoint() const { return entryPoint; }
+
+  //! Get the links of the given point on the given layer.
+  const std::vector<size_t>& Links(const size_t point, const size_t layer) const
+  { return links[point][layer]; }
+  //! Get the highest layer the given point is linked on.
+  size_t Level(const size_t point) const { return links[point].size() - 1; }
+
+  //! Access the metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the metric.
+  MetricType& Metric() { return metric; }
+
+ private:
+  //! Candidate represents a possible neighbor (distance, index).
+  typedef std::pair<double, size_t> Candidate;
+
+  /**
+   * Insert the given point into the graph.  This is safe to call from several
+   * threads at once, as long as every thread passes the same locks.
+   *
+   * @param point Index of the reference point to insert.
+   * @param level Highest layer the point is linked on.
+   * @param locks One lock per reference point, guarding its links.
+   * @param entryLock Lock guarding the entry point and the highest layer.
+   * @param evaluations Counter of distance evaluations.
+   * @param visits Counter of visited nodes.
+   */
+  void Insert(const size_t point,
+              const size_t level,
+              std::vector<std::mutex>& locks,
+              std::mutex& entryLock,
+              size_t& evaluations,
+              size_t& visits);
+
+  /**
+   * Find the closest points to the query point on the given layer, starting
+   * from the given entry points; this is the beam search of the paper.  The
+   * result holds at most ef points, sorted by increasing distance.
+   *
+   * @param query Query point.
+   * @param entries Points to start the search from.
+   * @param ef Maximum number of points to return.
+   * @param layer Layer to search.
+   * @param locks One lock per reference point, used while the graph is being
+   *     built; nullptr if the graph is not modified concurrently.
+   * @param results Points found by the search.
+   * @param evaluations Counter of distance evaluations.
+   * @param visits Counter of visited nodes.
+   */
+  template<typename VecType>
+  void SearchLayer(const VecType& query,
+                   const std::vector<Candidate>& entries,
+                   const size_t ef,
+                   const size_t layer,
+                   std::vector<std::mutex>* locks,
+                   std::vector<Candidate>& results,
+                   size_t& evaluations,
+                   size_t& visits) const;
+
+  /**
+   * Search for the approximate neighbors of a single query point, starting
+   * from the entry point of the graph.
+   *
+   * @param query Query point.
+   * @param ef Size of the candidate list.
+   * @param results Points found, sorted by increasing distance.
+   * @param evaluations Counter of distance evaluations.
+   * @param visits Counter of visited nodes.
+   */
+  template<typename VecType>
+  void SearchPoint(const VecType& query,
+                   const size_t ef,
+                   std::vector<Candidate>& results,
+                   size_t& evaluations,
+                   size_t& visits) const;
+
+  /**
+   * Choose at most maxLinks links among the given candidates, which must be
+   * sorted by increasing distance to the point being linked.  A candidate is
+   * kept only if it is closer to the point than to every candidate kept so
+   * far; this is the neighbor selection heuristic of the paper, which keeps
+   * the graph connected across clusters.
+   *
+   * @param candidates Candidate links, sorted by increasing distance.
+   * @param maxLinks Maximum number of links to keep.
+   * @param selected Indices of the chosen links.
+   * @param evaluations Counter of distance evaluations.
+   */
+  void SelectNeighbors(const std::vector<Candidate>& candidates,
+                       const size_t maxLinks,
+                       std::vector<size_t>& selected,
+                       size_t& evaluations) const;
+
+  //! Compute the distance between two reference points.
+  double Distance(const size_t a, const size_t b) const
+  { return metric.Evaluate(referenceSet.col(a), referenceSet.col(b)); }
+
+  //! Get the maximum number of links of a point on the given layer.
+  size_t MaxLinks(const size_t layer) const { return (layer == 0) ? 2 * m : m; }
+
+  //! Reference dataset.
+  MatType referenceSet;
+  //! Instantiation of the metric.
+  MetricType metric;
+
+  //! The number of links of each point on the upper layers.
+  size_t m;
+  //! The size of the candidate list used while building the graph.
+  size_t efConstruction;
+  //! The size of the candidate list used while searching.
+  size_t ef;
+
+  //! The links of every point on every layer it is linked on.
+  std::vector<std::vector<std::vector<size_t>>> links;
+  //! The point every search starts from.
+  size_t entryPoint;
+  //! The highest layer of the graph.
+  size_t maxLevel;
+
+  //! The number of distance evaluations.
+  size_t distanceEvaluations;
+  //! The number of visited nodes.
+  size_t visitedNodes;
+}; // class HNSWSearch
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "hnsw_search_impl.hpp"
+
+#endif
@@ -0,0 +1,490 @@
+/**
+ * @file methods/hnsw/hnsw_search_impl.hpp
+ *
+ * Implementation of the HNSWSearch class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_HNSW_HNSW_SEARCH_IMPL_HPP
+#define MLPACK_METHODS_HNSW_HNSW_SEARCH_IMPL_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/math/random.hpp>
+
+// In case it hasn't been included yet.
+#include "hnsw_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename MetricType, typename MatType>
+HNSWSearch<MetricType, MatType>::HNSWSearch(MatType referenceSet,
+                                            const size_t m,
+                                            const size_t efConstruction,
+                                            const size_t ef,
+                                            const MetricType metric) :
+    metric(metric),
+    m(m),
+    efConstruction(efConstruction),
+    ef(ef),
+    entryPoint(0),
+    maxLevel(0),
+    distanceEvaluations(0),
+    visitedNodes(0)
+{
+  // Pass work to training function.
+  Train(std::move(referenceSet), m, efConstruction);
+}
+
+template<typename MetricType, typename MatType>
+HNSWSearch<MetricType, MatType>::HNSWSearch() :
+    m(16),
+    efConstruction(200),
+    ef(50),
+    entryPoint(0),
+    maxLevel(0),
+    distanceEvaluations(0),
+    visitedNodes(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename MatType>
+void HNSWSearch<MetricType, MatType>::Train(MatType referenceSetIn,
+                                            const size_t mIn,
+                                            const size_t efConstructionIn)
+{
+  if (mIn < 2)
+  {
+    throw std::invalid_argument("HNSWSearch::Train(): m must be at least 2");
+  }
+  if (efConstructionIn == 0)
+  {
+    throw std::invalid_argument("HNSWSearch::Train(): efConstruction must be "
+        "greater than 0");
+  }
+
+  referenceSet = std::move(referenceSetIn);
+  m = mIn;
+  efConstruction = efConstructionIn;
+
+  const size_t n = referenceSet.n_cols;
+  links.clear();
+  links.resize(n);
+  entryPoint = 0;
+  maxLevel = 0;
+  distanceEvaluations = 0;
+  visitedNodes = 0;
+
+  if (n == 0)
+    return;
+
+  // Draw the level of every point up front, so that the levels depend only on
+  // the random seed and not on the order the threads insert points in.  The
+  // number of points on each layer decreases by a factor of m.
+  const double levelMultiplier = 1.0 / std::log((double) m);
+  std::vector<size_t> levels(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    // math::Random() is in [0, 1), so the argument of the log is never 0.
+    levels[i] = (size_t) std::floor(-std::log(1.0 - math::Random()) *
+        levelMultiplier);
+    links[i].resize(levels[i] + 1);
+  }
+
+  // The first point is the initial entry point; it has no links to build.
+  entryPoint = 0;
+  maxLevel = levels[0];
+
+  std::vector<std::mutex> locks(n);
+  std::mutex entryLock;
+  size_t totalDistanceEvaluations = 0;
+  size_t totalVisitedNodes = 0;
+
+  #pragma omp parallel for \
+      schedule(dynamic) \
+      reduction(+:totalDistanceEvaluations, totalVisitedNodes)
+  for (omp_size_t i = 1; i < (omp_size_t) n; ++i)
+  {
+    Insert(i, levels[i], locks, entryLock, totalDistanceEvaluations,
+        totalVisitedNodes);
+  }
+
+  distanceEvaluations = totalDistanceEvaluations;
+  visitedNodes = totalVisitedNodes;
+}
+
+template<typename MetricType, typename MatType>
+void HNSWSearch<MetricType, MatType>::Search(const MatType& querySet,
+                                             const size_t k,
+                                             arma::Mat<size_t>& neighbors,
+                                             arma::mat& distances)
+{
+  // Ensure the dimensionality of the query set is correct.
+  if (querySet.n_rows != referenceSet.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "HNSWSearch::Search(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality the model "
+        << "was trained on (" << referenceSet.n_rows << ")!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (k > referenceSet.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "HNSWSearch::Search(): requested " << k << " approximate nearest "
+        << "neighbors, but reference set has " << referenceSet.n_cols
+        << " points!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(SIZE_MAX);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(DBL_MAX);
+
+  if (k == 0)
+    return;
+
+  // The candidate list must be able to hold all k neighbors.
+  const size_t searchEf = std::max(ef, k);
+  size_t totalDistanceEvaluations = 0;
+  size_t totalVisitedNodes = 0;
+
+  #pragma omp parallel for \
+      schedule(dynamic) \
+      reduction(+:totalDistanceEvaluations, totalVisitedNodes)
+  for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+  {
+    std::vector<Candidate> results;
+    SearchPoint(querySet.col(i), searchEf, results, totalDistanceEvaluations,
+        totalVisitedNodes);
+
+    for (size_t j = 0; j < std::min(k, results.size()); ++j)
+    {
+      neighbors(j, i) = results[j].second;
+      distances(j, i) = results[j].first;
+    }
+  }
+
+  distanceEvaluations = totalDistanceEvaluations;
+  visitedNodes = totalVisitedNodes;
+}
+
+template<typename MetricType, typename MatType>
+void HNSWSearch<MetricType, MatType>::Search(const size_t k,
+                                             arma::Mat<size_t>& neighbors,
+                                             arma::mat& distances)
+{
+  // Each point is its own nearest neighbor and is not returned.
+  if (k >= referenceSet.n_cols && k > 0)
+  {
+    std::ostringstream oss;
+    oss << "HNSWSearch::Search(): requested " << k << " approximate nearest "
+        << "neighbors, but reference set has " << referenceSet.n_cols
+        << " points!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  neighbors.set_size(k, referenceSet.n_cols);
+  neighbors.fill(SIZE_MAX);
+  distances.set_size(k, referenceSet.n_cols);
+  distances.fill(DBL_MAX);
+
+  if (k == 0)
+    return;
+
+  const size_t searchEf = std::max(ef, k + 1);
+  size_t totalDistanceEvaluations = 0;
+  size_t totalVisitedNodes = 0;
+
+  #pragma omp parallel for \
+      schedule(dynamic) \
+      reduction(+:totalDistanceEvaluations, totalVisitedNodes)
+  for (omp_size_t i = 0; i < (omp_size_t) referenceSet.n_cols; ++i)
+  {
+    std::vector<Candidate> results;
+    SearchPoint(referenceSet.col(i), searchEf, results,
+        totalDistanceEvaluations, totalVisitedNodes);
+
+    size_t j = 0;
+    for (size_t r = 0; r < results.size() && j < k; ++r)
+    {
+      if (results[r].second == (size_t) i)
+        continue;
+
+      neighbors(j, i) = results[r].second;
+      distances(j, i) = results[r].first;
+      ++j;
+    }
+  }
+
+  distanceEvaluations = totalDistanceEvaluations;
+  visitedNodes = totalVisitedNodes;
+}
+
+template<typename MetricType, typename MatType>
+double HNSWSearch<MetricType, MatType>::ComputeRecall(
+    const arma::Mat<size_t>& foundNeighbors,
+    const arma::Mat<size_t>& realNeighbors)
+{
+  if (foundNeighbors.n_rows != realNeighbors.n_rows ||
+      foundNeighbors.n_cols != realNeighbors.n_cols)
+    throw std::invalid_argument("HNSWSearch::ComputeRecall(): matrices "
+        "provided must have equal size");
+
+  // The recall is the set intersection of found and real neighbors.
+  size_t found = 0;
+  for (size_t col = 0; col < foundNeighbors.n_cols; ++col)
+    for (size_t row = 0; row < realNeighbors.n_rows; ++row)
+      for (size_t nei = 0; nei < foundNeighbors.n_rows; ++nei)
+        if (realNeighbors(row, col) == foundNeighbors(nei, col))
+        {
+          found++;
+          break;
+        }
+
+  return ((double) found) / realNeighbors.n_elem;
+}
+
+template<typename MetricType, typename MatType>
+template<typename Archive>
+void HNSWSearch<MetricType, MatType>::serialize(Archive& ar,
+                                                const uint32_t /* version */)
+{
+  ar(CEREAL_NVP(referenceSet));
+  ar(CEREAL_NVP(metric));
+  ar(CEREAL_NVP(m));
+  ar(CEREAL_NVP(efConstruction));
+  ar(CEREAL_NVP(ef));
+  ar(CEREAL_NVP(links));
+  ar(CEREAL_NVP(entryPoint));
+  ar(CEREAL_NVP(maxLevel));
+  ar(CEREAL_NVP(distanceEvaluations));
+  ar(CEREAL_NVP(visitedNodes));
+}
+
+template<typename MetricType, typename MatType>
+void HNSWSearch<MetricType, MatType>::Insert(const size_t point,
+                                             const size_t level,
+                                             std::vector<std::mutex>& locks,
+                                             std::mutex& entryLock,
+                                             size_t& evaluations,
+                                             size_t& visits)
+{
+  size_t currentEntry, currentMaxLevel;
+  {
+    std::lock_guard<std::mutex> lock(entryLock);
+    currentEntry = entryPoint;
+    currentMaxLevel = maxLevel;
+  }
+
+  std::vector<Candidate> entries(1, Candidate(Distance(point, currentEntry),
+      currentEntry));
+  ++evaluations;
+  std::vector<Candidate> results;
+
+  // Greedily descend the layers the point is not linked on.
+  for (size_t layer = currentMaxLevel; layer > level; --layer)
+  {
+    SearchLayer(referenceSet.col(point), entries, 1, layer, &locks, results,
+        evaluations, visits);
+    entries.swap(results);
+  }
+
+  // Link the point on every layer it shares with the graph, from the top down.
+  std::vector<size_t> selected;
+  for (size_t layer = std::min(level, currentMaxLevel) + 1; layer-- > 0; )
+  {
+    SearchLayer(referenceSet.col(point), entries, efConstruction, layer,
+        &locks, results, evaluations, visits);
+
+    // Another thread may already have linked to this point, so the search can
+    // find the point itself.
+    results.erase(std::remove_if(results.begin(), results.end(),
+        [point](const Candidate& c) { return c.second == point; }),
+        results.end());
+
+    SelectNeighbors(results, m, selected, evaluations);
+    {
+      std::lock_guard<std::mutex> lock(locks[point]);
+      links[point][layer] = selected;
+    }
+
+    // Add the reverse links; when a list overflows, choose its links again.
+    for (const size_t neighbor : selected)
+    {
+      std::lock_guard<std::mutex> lock(locks[neighbor]);
+      std::vector<size_t>& neighborLinks = links[neighbor][layer];
+      if (neighborLinks.size() < MaxLinks(layer))
+      {
+        neighborLinks.push_back(point);
+        continue;
+      }
+
+      std::vector<Candidate> candidates;
+      candidates.reserve(neighborLinks.size() + 1);
+      candidates.emplace_back(Distance(neighbor, point), point);
+      for (const size_t link : neighborLinks)
+        candidates.emplace_back(Distance(neighbor, link), link);
+      evaluations += candidates.size();
+
+      std::sort(candidates.begin(), candidates.end());
+      SelectNeighbors(candidates, MaxLinks(layer), neighborLinks,
+          evaluations);
+    }
+
+    if (!results.empty())
+      entries.swap(results);
+  }
+
+  // If the point reaches higher than the graph, it becomes the entry point.
+  if (level > currentMaxLevel)
+  {
+    std::lock_guard<std::mutex> lock(entryLock);
+    if (level > maxLevel)
+    {
+      maxLevel = level;
+      entryPoint = point;
+    }
+  }
+}
+
+template<typename MetricType, typename MatType>
+template<typename VecType>
+void HNSWSearch<MetricType, MatType>::SearchLayer(
+    const VecType& query,
+    const std::vector<Candidate>& entries,
+    const size_t ef,
+    const size_t layer,
+    std::vector<std::mutex>* locks,
+    std::vector<Candidate>& results,
+    size_t& evaluations,
+    size_t& visits) const
+{
+  std::unordered_set<size_t> visited;
+
+  // The closest unexpanded candidate is on top of 'candidates', and the
+  // furthest of the (at most ef) best points found is on top of 'best'.
+  std::priority_queue<Candidate, std::vector<Candidate>,
+      std::greater<Candidate>> candidates;
+  std::priority_queue<Candidate> best;
+  for (const Candidate& entry : entries)
+  {
+    if (visited.insert(entry.second).second)
+    {
+      candidates.push(entry);
+      best.push(entry);
+    }
+  }
+  while (best.size() > ef)
+    best.pop();
+
+  std::vector<size_t> linksCopy;
+  while (!candidates.empty())
+  {
+    const Candidate current = candidates.top();
+    if (best.size() >= ef && current.first > best.top().first)
+      break;
+    candidates.pop();
+    ++visits;
+
+    // While the graph is being built, the links may change under us.
+    const std::vector<size_t>* currentLinks = &links[current.second][layer];
+    if (locks)
+    {
+      std::lock_guard<std::mutex> lock((*locks)[current.second]);
+      linksCopy = *currentLinks;
+      currentLinks = &linksCopy;
+    }
+
+    for (const size_t neighbor : *currentLinks)
+    {
+      if (!visited.insert(neighbor).second)
+        continue;
+
+      const double distance = metric.Evaluate(query,
+          referenceSet.col(neighbor));
+      ++evaluations;
+
+      if (best.size() < ef || distance < best.top().first)
+      {
+        candidates.emplace(distance, neighbor);
+        best.emplace(distance, neighbor);
+        if (best.size() > ef)
+          best.pop();
+      }
+    }
+  }
+
+  results.resize(best.size());
+  for (size_t i = results.size(); i > 0; --i)
+  {
+    results[i - 1] = best.top();
+    best.pop();
+  }
+}
+
+template<typename MetricType, typename MatType>
+template<typename VecType>
+void HNSWSearch<MetricType, MatType>::SearchPoint(
+    const VecType& query,
+    const size_t ef,
+    std::vector<Candidate>& results,
+    size_t& evaluations,
+    size_t& visits) const
+{
+  std::vector<Candidate> entries(1, Candidate(metric.Evaluate(query,
+      referenceSet.col(entryPoint)), entryPoint));
+  ++evaluations;
+
+  for (size_t layer = maxLevel; layer > 0; --layer)
+  {
+    SearchLayer(query, entries, 1, layer, nullptr, results,
+        evaluations, visits);
+    entries.swap(results);
+  }
+
+  SearchLayer(query, entries, ef, 0, nullptr, results, evaluations,
+      visits);
+}
+
+template<typename MetricType, typename MatType>
+void HNSWSearch<MetricType, MatType>::SelectNeighbors(
+    const std::vector<Candidate>& candidates,
+    const size_t maxLinks,
+    std::vector<size_t>& selected,
+    size_t& evaluations) const
+{
+  selected.clear();
+  for (const Candidate& candidate : candidates)
+  {
+    if (selected.size() == maxLinks)
+      break;
+
+    // Skip the candidate if a point already chosen is closer to it than the
+    // point being linked; the candidate is reachable through that point.
+    bool keep = true;
+    for (const size_t s : selected)
+    {
+      ++evaluations;
+      if (Distance(candidate.second, s) < candidate.first)
+      {
+        keep = false;
+        break;
+      }
+    }
+
+    if (keep)
+      selected.push_back(candidate.second);
+  }
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file methods/kde/gaussian_series_expansion.hpp
+ *
+ * Far-field Taylor series expansion of the Gaussian kernel, as used by the
+ * improved fast Gauss transform, for kernel density estimation.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_KDE_GAUSSIAN_SERIES_EXPANSION_HPP
+#define MLPACK_METHODS_KDE_GAUSSIAN_SERIES_EXPANSION_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include "kde_stat.hpp"
+
+namespace mlpack {
+namespace kde {
+
+/**
+ * A truncated Taylor series expansion of the sum of Gaussian kernels centered
+ * at the points of a reference node, as in the improved fast Gauss transform:
+ *
+ * @code
+ * @inproceedings{yang2003improved,
+ *   title={Improved fast Gauss transform and efficient kernel density
+ *       estimation},
+ *   author={Yang, C. and Duraiswami, R. and Gumerov, N.A. and Davis, L.},
+ *   booktitle={Proceedings of the Ninth IEEE International Conference on
+ *       Computer Vision (ICCV 2003)},
+ *   pages={664--671},
+ *   year={2003}
+ * }
+ * @endcode
+ *
+ * With h = sqrt(2) * bandwidth, c the center of the node and u = x - c for
+ * each point x of the node, the sum of the kernels at a query point q with
+ * d = q - c is
+ *
+ *   exp(-|d|^2 / h^2) sum_x exp(-|u|^2 / h^2) exp(2 d^T u / h^2),
+ *
+ * and the last exponential is expanded into the monomials of total degree less
+ * than the order of the expansion.  The coefficients of the expansion only
+ * depend on the points of the node, so they are computed once for each node
+ * and stored in its KDEStat; the expansion can then be evaluated at any query
+ * point with a number of operations that does not depend on the number of
+ * points of the node.  The number of coefficients is (order - 1 + D) choose D
+ * in D dimensions, so expansions are only useful in low dimensions.
+ *
+ * The error of the expansion for each point of the node is bounded by
+ *
+ *   (2 |d| r / h^2)^p / p! exp(-max(|d| - r, 0)^2 / h^2),
+ *
+ * where p is the order and r the largest distance between the center and a
+ * point of the node.
+ */
+class GaussianSeriesExpansion
+{
+ public:
+  /**
+   * Create the expansion for the given dimensionality and order.
+   *
+   * @param dimensionality Dimensionality of the points.
+   * @param order Number of terms of the Taylor series of the exponential; the
+   *     monomials of total degree less than the order are used.
+   * @param bandwidth Bandwidth of the Gaussian kernel.
+   */
+  GaussianSeriesExpansion(const size_t dimensionality,
+                          const size_t order,
+                          const double bandwidth);
+
+  /**
+   * Compute the coefficients of the expansion of the given node, and store
+   * them in its statistic.  Nothing is done if the statistic already holds
+   * the coefficients of this expansion.
+   *
+   * @param node Node to compute the expansion of.
+   */
+  template<typename TreeType>
+  void ComputeCoefficients(TreeType& node) const;
+
+  /**
+   * Evaluate the expansion of a node at the given point.
+   *
+   * @param stat Statistic of the node, holding its coefficients.
+   * @param point Point to evaluate the expansion at.
+   * @param monomials Workspace for the monomials of the point.
+   */
+  template<typename VecType>
+  double Evaluate(const KDEStat& stat,
+                  const VecType& point,
+                  arma::vec& monomials) const;
+
+  /**
+   * Get the largest error of the expansion for each point of a node, for
+   * query points whose distances to the center of the node are between the
+   * given bounds.
+   *
+   * @param minDistance Lower bound of the distance to the center.
+   * @param maxDistance Upper bound of the distance to the center.
+   * @param radius Largest distance between the center and a point of the node.
+   */
+  double MaxError(const double minDistance,
+                  const double maxDistance,
+                  const double radius) const;
+
+  //! Check whether the statistic holds the coefficients of this expansion.
+  bool IsComputed(const KDEStat& stat) const
+  {
+    return stat.SeriesOrder() == order && stat.SeriesBandwidth() == bandwidth;
+  }
+
+  //! Get the order of the expansion.
+  size_t Order() const { return order; }
+
+  //! Get the number of coefficients of the expansion.
+  size_t NumTerms() const { return constants.n_elem; }
+
+  //! Get the bandwidth of the kernel.
+  double Bandwidth() const { return bandwidth; }
+
+ private:
+  //! Compute the monomials of the given (scaled) vector.
+  template<typename VecType>
+  void Monomials(const VecType& v, arma::vec& monomials) const;
+
+  //! Dimensionality of the points.
+  size_t dimensionality;
+
+  //! Order of the expansion.
+  size_t order;
+
+  //! Bandwidth of the kernel.
+  double bandwidth;
+
+  //! The scale h = sqrt(2) * bandwidth of the expansion.
+  double scale;
+
+  //! The earlier monomial that each monomial (but the first) is computed from.
+  std::vector<size_t> parents;
+
+  //! The dimension that the earlier monomial is multiplied by.
+  std::vector<size_t> dimensions;
+
+  //! The constant factor 2^|alpha| / alpha! of each monomial.
+  arma::vec constants;
+};
+
+} // namespace kde
+} // namespace mlpack
+
+// Include implementation.
+#include "gaussian_series_expansion_impl.hpp"
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file methods/kde/gaussian_series_expansion_impl.hpp
+ *
+ * Implementation of the far-field Taylor series expansion of the Gaussian
+ * kernel.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_KDE_GAUSSIAN_SERIES_EXPANSION_IMPL_HPP
+#define MLPACK_METHODS_KDE_GAUSSIAN_SERIES_EXPANSION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "gaussian_series_expansion.hpp"
+
+namespace mlpack {
+namespace kde {
+
+inline GaussianSeriesExpansion::GaussianSeriesExpansion(
+    const size_t dimensionality,
+    const size_t order,
+    const double bandwidth) :
+    dimensionality(dimensionality),
+    order(order),
+    bandwidth(bandwidth),
+    scale(std::sqrt(2.0) * bandwidth)
+{
+  if (order == 0)
+  {
+    throw std::invalid_argument("GaussianSeriesExpansion: the order of the "
+        "expansion must be at least 1");
+  }
+
+  // The monomials are built one degree at a time.  Each monomial of degree k
+  // is the product of its lowest dimension i and a monomial of degree k - 1
+  // that only holds dimensions i and above; those monomials are contiguous,
+  // and start at the first monomial of degree k - 1 that was made with
+  // dimension i.
+  std::vector<size_t> exponents(dimensionality, 0);
+  std::vector<double> factors(1, 1.0);
+  std::vector<size_t> heads(dimensionality, 0);
+  parents.assign(1, 0);
+  dimensions.assign(1, 0);
+  size_t end = 1;
+  for (size_t k = 1; k < order; ++k)
+  {
+    for (size_t i = 0; i < dimensionality; ++i)
+    {
+      const size_t head = heads[i];
+      heads[i] = parents.size();
+      for (size_t j = head; j < end; ++j)
+      {
+        parents.push_back(j);
+        dimensions.push_back(i);
+        for (size_t l = 0; l < dimensionality; ++l)
+        {
+          const size_t exponent = exponents[j * dimensionality + l];
+          exponents.push_back((l == i) ? exponent + 1 : exponent);
+        }
+
+        // 2^|alpha| / alpha! grows by 2 / alpha_i.
+        factors.push_back(factors[j] * 2.0 /
+            exponents[(parents.size() - 1) * dimensionality + i]);
+      }
+    }
+
+    end = parents.size();
+  }
+
+  constants = arma::vec(factors);
+}
+
+template<typename TreeType>
+void GaussianSeriesExpansion::ComputeCoefficients(TreeType& node) const
+{
+  KDEStat& stat = node.Stat();
+  if (IsComputed(stat))
+    return;
+
+  arma::vec center;
+  node.Center(center);
+
+  arma::vec coefficients(NumTerms(), arma::fill::zeros);
+  arma::vec monomials;
+  double radius = 0.0;
+  for (size_t i = 0; i < node.NumDescendants(); ++i)
+  {
+    const arma::vec u = node.Dataset().col(node.Descendant(i)) - center;
+    const double distance = arma::norm(u);
+    radius = std::max(radius, distance);
+
+    Monomials(arma::vec(u / scale), monomials);
+    coefficients += std::exp(-distance * distance / (scale * scale)) *
+        monomials;
+  }
+  coefficients %= constants;
+
+  stat.SeriesCenter() = std::move(center);
+  stat.SeriesCoefficients() = std::move(coefficients);
+  stat.SeriesRadius() = radius;
+  stat.SeriesOrder() = order;
+  stat.SeriesBandwidth() = bandwidth;
+}
+
+template<typename VecType>
+double GaussianSeriesExpansion::Evaluate(const KDEStat& stat,
+                                         const VecType& point,
+                                         arma::vec& monomials) const
+{
+  const arma::vec d = (point - stat.SeriesCenter()) / scale;
+  Monomials(d, monomials);
+  return std::exp(-arma::dot(d, d)) *
+      arma::dot(stat.SeriesCoefficients(), monomials);
+}
+
+inline double GaussianSeriesExpansion::MaxError(const double minDistance,
+                                                const double maxDistance,
+                                                const double radius) const
+{
+  if (radius == 0.0 || maxDistance == 0.0)
+    return 0.0;
+
+  // The bound increases with the distance d until its logarithm, which is
+  // p log(d) - (d - r)^2 / h^2 (plus a constant), stops increasing, and then
+  // decreases.
+  const double h2 = scale * scale;
+  const double peak = (radius + std::sqrt(radius * radius + 2 * order * h2)) /
+      2.0;
+  const double d = std::min(std::max(peak, minDistance), maxDistance);
+
+  double logError = order * std::log(2 * d * radius / h2) -
+      std::lgamma(order + 1.0);
+  if (d > radius)
+    logError -= (d - radius) * (d - radius) / h2;
+
+  return std::exp(logError);
+}
+
+template<typename VecType>
+void GaussianSeriesExpansion::Monomials(const VecType& v,
+                                        arma::vec& monomials) const
+{
+  monomials.set_size(NumTerms());
+  monomials[0] = 1.0;
+  for (size_t t = 1; t < monomials.n_elem; ++t)
+    monomials[t] = monomials[parents[t]] * v[dimensions[t]];
+}
+
+} // namespace kde
+} // namespace mlpack
+
+#endif
@@ -17,6 +17,7 @@
 #include <mlpack/core/tree/binary_space_tree.hpp>
 
 #include "kde_stat.hpp"
+#include "gaussian_series_expansion.hpp"
 
 namespace mlpack {
 namespace kde /** Kernel Density Estimation. */ {
@@ -55,6 +56,12 @@ struct KDEDefaultParams
 
   //! Monte Carlo break coefficient.
   static constexpr double mcBreakCoef = 0.4;
+
+  //! Whether to use series expansions when possible.
+  static constexpr bool seriesExpansion = false;
+
+  //! Order of series expansions.
+  static constexpr size_t seriesOrder = 6;
 };
 
 /**
@@ -64,6 +71,31 @@ struct KDEDefaultParams
  * This implementation performs this estimation using a tree-independent
  * dual-tree algorithm. Details about this algorithm are available in KDERules.
  *
+ * If parallel evaluation is enabled (see Parallel()) and OpenMP is available,
+ * the query tree is split into subtrees that are traversed at the same time by
+ * different threads, and in single-tree mode the query points are split
+ * between the threads.  The error tolerance is accounted for each query point
+ * and in the statistics of the query nodes, which belong to a single subtree,
+ * so the results still meet the relative and absolute error tolerances.
+ * Monte Carlo estimations are always computed on a single thread, since they
+ * use the global random number generator.
+ *
+ * With the Gaussian kernel and the Euclidean distance, the far-field series
+ * expansions of the improved fast Gauss transform (see
+ * GaussianSeriesExpansion) may also be used (see SeriesExpansion()): when the
+ * kernel bounds of a combination of nodes are too loose to prune it, but the
+ * error of the expansion of the reference node is within the tolerance, the
+ * expansion is evaluated at each query point instead of recursing.  The
+ * expansions of the reference nodes are computed before each evaluation if
+ * they are not up to date, and the error tolerances still hold.  They are
+ * mostly useful in low dimensions.
+ *
+ * The reference set of a trained model can be updated, for instance for a
+ * sliding window of points, with InsertReferencePoints() and
+ * ExpireReferencePoints().  If the tree type can insert and delete points (the
+ * RectangleTree types and the BinarySpaceTree types other than the UB tree),
+ * the reference tree is updated in place; otherwise it is rebuilt.
+ *
  * @tparam KernelType Kernel function to use for KDE calculations.
  * @tparam MetricType Metric to use for KDE calculations.
  * @tparam MatType Type of data to use.
@@ -173,6 +205,30 @@ class KDE
    */
   void Train(Tree* referenceTree, std::vector<size_t>* oldFromNewReferences);
 
+  /**
+   * Add points to the reference set of the trained model, after the points
+   * that are already in it.  If the tree type can insert points, they are
+   * inserted into the reference tree (even if the tree was given with
+   * Train(Tree*, std::vector<size_t>*)); otherwise the reference tree is
+   * rebuilt.
+   *
+   * @pre The model has to be previously trained.
+   * @param newPoints Points to add to the reference set.
+   */
+  void InsertReferencePoints(const MatType& newPoints);
+
+  /**
+   * Remove the oldest points of the reference set of the trained model: the
+   * first points of the set the model was trained with, and then the points
+   * added with InsertReferencePoints(), in order.  If the tree type can delete
+   * points, they are deleted from the reference tree; otherwise the reference
+   * tree is rebuilt.
+   *
+   * @pre The model has to be previously trained.
+   * @param count Number of points to remove; at least one point must be left.
+   */
+  void ExpireReferencePoints(const size_t count);
+
   /**
    * Estimate density of each point in the query set given the data of the
    * reference set. The result is stored in an estimations vector.
@@ -259,6 +315,30 @@ class KDE
   //! Modify the mode of KDE.
   KDEMode& Mode() { return mode; }
 
+  //! Get whether the evaluation is run in parallel.
+  bool Parallel() const { return parallel; }
+
+  //! Modify whether the evaluation is run in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get whether series expansions are used when possible.
+  bool SeriesExpansion() const { return seriesExpansion; }
+
+  //! Modify whether series expansions are used when possible.
+  bool& SeriesExpansion() { return seriesExpansion; }
+
+  //! Get the order of series expansions.
+  size_t SeriesOrder() const { return seriesOrder; }
+
+  //! Modify the order of series expansions (newOrder >= 1).
+  void SeriesOrder(const size_t newOrder);
+
+  //! Get the number of base cases of the last evaluation.
+  size_t BaseCases() const { return baseCases; }
+
+  //! Get the number of node combinations scored in the last evaluation.
+  size_t Scores() const { return scores; }
+
   //! Get whether Monte Carlo estimations are being used or not.
   bool MonteCarlo() const { return monteCarlo; }
 
@@ -322,6 +402,23 @@ class KDE
   //! Mode of the KDE algorithm.
   KDEMode mode;
 
+  //! If true, the evaluation is run in parallel.  This is not serialized.
+  bool parallel;
+
+  //! If true, series expansions will be used when possible.  This is not
+  //! serialized.
+  bool seriesExpansion;
+
+  //! Order of series expansions.  This is not serialized.
+  size_t seriesOrder;
+
+  //! The number of base cases of the last evaluation.  This is not serialized.
+  size_t baseCases;
+
+  //! The number of node combinations scored in the last evaluation.  This is
+  //! not serialized.
+  size_t scores;
+
   //! If true Monte Carlo approximations will be used when possible.
   bool monteCarlo;
 
@@ -344,6 +441,55 @@ class KDE
   //! Check whether absolute and relative error values are compatible.
   static void CheckErrorValues(const double relError, const double absError);
 
+  /**
+   * Run the dual-tree traversal of the given query tree with the reference
+   * tree, with one traversal for each subtree given by QuerySubtrees() if the
+   * evaluation is run in parallel.
+   *
+   * @param queryTree Tree of query points to get the density of.
+   * @param estimations Object which will hold the density of each query point.
+   * @param sameSet Whether the query tree is the reference tree.
+   */
+  void DualTreeEvaluate(Tree& queryTree,
+                        arma::vec& estimations,
+                        const bool sameSet);
+
+  /**
+   * Run the single-tree traversal of the reference tree for each query point,
+   * with the query points split between threads if the evaluation is run in
+   * parallel.
+   *
+   * @param querySet Set of query points to get the density of.
+   * @param estimations Object which will hold the density of each query point.
+   * @param sameSet Whether the query set is the reference set.
+   */
+  void SingleTreeEvaluate(const MatType& querySet,
+                          arma::vec& estimations,
+                          const bool sameSet);
+
+  //! Whether the evaluation can be run in parallel with the current settings.
+  bool UseParallel() const;
+
+  /**
+   * Create the series expansion for the current kernel, and compute the
+   * expansions of every reference node with more descendants than the
+   * expansion has terms.  NULL is returned if series expansions are not used;
+   * otherwise the caller must delete the returned object.
+   */
+  GaussianSeriesExpansion* BuildSeriesExpansion();
+
+  /**
+   * Rebuild the reference tree with the reference points from the given index
+   * on (in the order they were added in) followed by the given new points.
+   */
+  void RebuildReferenceTree(const size_t firstPoint, const MatType& newPoints);
+
+  //! Reset the statistics of the reference tree after it was updated.
+  void ResetReferenceStatistics();
+
+  //! Split the query tree into subtrees that can be traversed in parallel.
+  static std::vector<Tree*> QuerySubtrees(Tree& queryTree);
+
   //! Rearrange estimations vector if required.
   static void RearrangeEstimations(const std::vector<size_t>& oldFromNew,
                                    arma::vec& estimations);
@@ -13,6 +13,12 @@
 #include "kde.hpp"
 #include "kde_rules.hpp"
 
+#include <mlpack/core/tree/rectangle_tree/is_rectangle_tree.hpp>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kde {
 
@@ -38,6 +44,169 @@ TreeType* BuildTree(
   return new TreeType(std::forward<MatType>(dataset));
 }
 
+//! Binary space trees can insert and remove points, except UB trees.
+template<typename TreeType>
+struct CanModifyBinarySpaceTree
+{
+  static const bool value = false;
+};
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+struct CanModifyBinarySpaceTree<tree::BinarySpaceTree<MetricType,
+    StatisticType, MatType, BoundType, SplitType>>
+{
+  static const bool value = !std::is_same<BoundType<MetricType>,
+      bound::CellBound<MetricType>>::value;
+};
+
+//! Insert points into a rectangle tree.
+template<typename TreeType, typename MatType>
+bool InsertPoints(
+    TreeType& tree,
+    const MatType& points,
+    std::vector<size_t>* /* oldFromNew */,
+    const typename std::enable_if<
+        tree::IsRectangleTree<TreeType>::value>::type* = 0)
+{
+  const size_t oldSize = tree.Dataset().n_cols;
+  tree.Dataset().insert_cols(oldSize, points);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    tree.InsertPoint(oldSize + i);
+
+  return true;
+}
+
+//! Insert points into a binary space tree, unless it is frozen.
+template<typename TreeType, typename MatType>
+bool InsertPoints(
+    TreeType& tree,
+    const MatType& points,
+    std::vector<size_t>* oldFromNew,
+    const typename std::enable_if<
+        CanModifyBinarySpaceTree<TreeType>::value>::type* = 0)
+{
+  if (tree.IsFrozen() || !oldFromNew ||
+      oldFromNew->size() != tree.Dataset().n_cols)
+    return false;
+
+  tree.Insert(points, *oldFromNew);
+  return true;
+}
+
+//! Other trees can't insert points.
+template<typename TreeType, typename MatType>
+bool InsertPoints(
+    TreeType& /* tree */,
+    const MatType& /* points */,
+    std::vector<size_t>* /* oldFromNew */,
+    const typename std::enable_if<
+        !tree::IsRectangleTree<TreeType>::value &&
+        !CanModifyBinarySpaceTree<TreeType>::value>::type* = 0)
+{
+  return false;
+}
+
+//! Delete the first points of the dataset of a rectangle tree.
+template<typename TreeType>
+bool DeleteFirstPoints(
+    TreeType& tree,
+    const size_t count,
+    std::vector<size_t>* /* oldFromNew */,
+    const typename std::enable_if<
+        tree::IsRectangleTree<TreeType>::value>::type* = 0)
+{
+  for (size_t i = 0; i < count; ++i)
+    tree.DeletePoint(i);
+  tree.Dataset().shed_cols(0, count - 1);
+
+  // Renumber the points that are left.
+  std::vector<TreeType*> stack(1, &tree);
+  while (!stack.empty())
+  {
+    TreeType* node = stack.back();
+    stack.pop_back();
+
+    for (size_t i = 0; i < node->NumPoints(); ++i)
+      node->Point(i) -= count;
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      stack.push_back(&node->Child(i));
+  }
+
+  return true;
+}
+
+//! Delete the points with the first original indices from a binary space tree,
+//! unless it is frozen.
+template<typename TreeType>
+bool DeleteFirstPoints(
+    TreeType& tree,
+    const size_t count,
+    std::vector<size_t>* oldFromNew,
+    const typename std::enable_if<
+        CanModifyBinarySpaceTree<TreeType>::value>::type* = 0)
+{
+  if (tree.IsFrozen() || !oldFromNew ||
+      oldFromNew->size() != tree.Dataset().n_cols)
+    return false;
+
+  // The remaining original indices are renumbered by Remove().
+  std::vector<size_t> indices;
+  indices.reserve(count);
+  for (size_t i = 0; i < oldFromNew->size(); ++i)
+    if ((*oldFromNew)[i] < count)
+      indices.push_back(i);
+
+  tree.Remove(indices, *oldFromNew);
+  return true;
+}
+
+//! Other trees can't delete points.
+template<typename TreeType>
+bool DeleteFirstPoints(
+    TreeType& /* tree */,
+    const size_t /* count */,
+    std::vector<size_t>* /* oldFromNew */,
+    const typename std::enable_if<
+        !tree::IsRectangleTree<TreeType>::value &&
+        !CanModifyBinarySpaceTree<TreeType>::value>::type* = 0)
+{
+  return false;
+}
+
+//! Series expansions are available for the Gaussian kernel and the Euclidean
+//! distance.
+inline bool HasSeriesExpansion(const kernel::GaussianKernel& /* kernel */,
+                               const metric::EuclideanDistance& /* metric */)
+{
+  return true;
+}
+
+//! Series expansions are not available for other kernels and metrics.
+template<typename KernelType, typename MetricType>
+bool HasSeriesExpansion(const KernelType& /* kernel */,
+                        const MetricType& /* metric */)
+{
+  return false;
+}
+
+//! Get the bandwidth of a Gaussian kernel.
+inline double SeriesBandwidth(const kernel::GaussianKernel& kernel)
+{
+  return kernel.Bandwidth();
+}
+
+//! Other kernels have no series expansion.
+template<typename KernelType>
+double SeriesBandwidth(const KernelType& /* kernel */)
+{
+  return 0.0;
+}
+
 template<typename KernelType,
          typename MetricType,
          typename MatType,
@@ -71,6 +240,11 @@ KDE(const double relError,
     ownsReferenceTree(false),
     trained(false),
     mode(mode),
+    parallel(false),
+    seriesExpansion(KDEDefaultParams::seriesExpansion),
+    seriesOrder(KDEDefaultParams::seriesOrder),
+    baseCases(0),
+    scores(0),
     monteCarlo(monteCarlo),
     initialSampleSize(initialSampleSize)
 {
@@ -102,6 +276,11 @@ KDE(const KDE& other) :
     ownsReferenceTree(other.ownsReferenceTree),
     trained(other.trained),
     mode(other.mode),
+    parallel(other.parallel),
+    seriesExpansion(other.seriesExpansion),
+    seriesOrder(other.seriesOrder),
+    baseCases(other.baseCases),
+    scores(other.scores),
     monteCarlo(other.monteCarlo),
     mcProb(other.mcProb),
     initialSampleSize(other.initialSampleSize),
@@ -148,6 +327,11 @@ KDE(KDE&& other) :
     ownsReferenceTree(other.ownsReferenceTree),
     trained(other.trained),
     mode(other.mode),
+    parallel(other.parallel),
+    seriesExpansion(other.seriesExpansion),
+    seriesOrder(other.seriesOrder),
+    baseCases(other.baseCases),
+    scores(other.scores),
     monteCarlo(other.monteCarlo),
     mcProb(other.mcProb),
     initialSampleSize(other.initialSampleSize),
@@ -163,6 +347,11 @@ KDE(KDE&& other) :
   other.ownsReferenceTree = false;
   other.trained = false;
   other.mode = KDEDefaultParams::mode;
+  other.parallel = false;
+  other.seriesExpansion = KDEDefaultParams::seriesExpansion;
+  other.seriesOrder = KDEDefaultParams::seriesOrder;
+  other.baseCases = 0;
+  other.scores = 0;
   other.monteCarlo = KDEDefaultParams::monteCarlo;
   other.mcProb = KDEDefaultParams::mcProb;
   other.initialSampleSize = KDEDefaultParams::initialSampleSize;
@@ -209,6 +398,11 @@ operator=(KDE other)
   this->ownsReferenceTree = other.ownsReferenceTree;
   this->trained = other.trained;
   this->mode = other.mode;
+  this->parallel = other.parallel;
+  this->seriesExpansion = other.seriesExpansion;
+  this->seriesOrder = other.seriesOrder;
+  this->baseCases = other.baseCases;
+  this->scores = other.scores;
   this->monteCarlo = other.monteCarlo;
   this->mcProb = other.mcProb;
   this->initialSampleSize = other.initialSampleSize;
@@ -314,6 +508,152 @@ Train(Tree* referenceTree, std::vector<size_t>* oldFromNewReferences)
   this->trained = true;
 }
 
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+InsertReferencePoints(const MatType& newPoints)
+{
+  // Check whether has already been trained.
+  if (!trained)
+  {
+    throw std::runtime_error("cannot insert reference points: model needs to "
+                             "be trained first");
+  }
+
+  // Check whether dimensions match.
+  if (newPoints.n_rows != referenceTree->Dataset().n_rows)
+  {
+    throw std::invalid_argument("cannot insert reference points: dimensions "
+                                "don't match the reference set");
+  }
+
+  if (newPoints.n_cols == 0)
+    return;
+
+  Timer::Start("updating_reference_tree");
+  if (InsertPoints(*referenceTree, newPoints, oldFromNewReferences))
+    ResetReferenceStatistics();
+  else
+    RebuildReferenceTree(0, newPoints);
+  Timer::Stop("updating_reference_tree");
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+ExpireReferencePoints(const size_t count)
+{
+  // Check whether has already been trained.
+  if (!trained)
+  {
+    throw std::runtime_error("cannot expire reference points: model needs to "
+                             "be trained first");
+  }
+
+  if (count == 0)
+    return;
+
+  if (count >= referenceTree->Dataset().n_cols)
+  {
+    throw std::invalid_argument("cannot expire reference points: at least one "
+                                "reference point must be left");
+  }
+
+  Timer::Start("updating_reference_tree");
+  if (DeleteFirstPoints(*referenceTree, count, oldFromNewReferences))
+    ResetReferenceStatistics();
+  else
+    RebuildReferenceTree(count, MatType());
+  Timer::Stop("updating_reference_tree");
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+RebuildReferenceTree(const size_t firstPoint, const MatType& newPoints)
+{
+  const MatType& dataset = referenceTree->Dataset();
+  const size_t oldPoints = dataset.n_cols - firstPoint;
+  MatType referenceSet(dataset.n_rows, oldPoints + newPoints.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    // Get the position of the point in the order the points were added in.
+    const size_t index = tree::TreeTraits<Tree>::RearrangesDataset ?
+        (*oldFromNewReferences)[i] : i;
+    if (index >= firstPoint)
+      referenceSet.col(index - firstPoint) = dataset.col(i);
+  }
+
+  if (newPoints.n_cols > 0)
+    referenceSet.cols(oldPoints, referenceSet.n_cols - 1) = newPoints;
+
+  Train(std::move(referenceSet));
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+ResetReferenceStatistics()
+{
+  // The Monte Carlo alpha values depend on the shape of the tree and the series
+  // expansions on the descendants of each node, so the statistics of every
+  // node are reset.
+  std::vector<Tree*> stack(1, referenceTree);
+  while (!stack.empty())
+  {
+    Tree* node = stack.back();
+    stack.pop_back();
+
+    node->Stat() = KDEStat(*node);
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      stack.push_back(&node->Child(i));
+  }
+}
+
 template<typename KernelType,
          typename MetricType,
          typename MatType,
@@ -380,35 +720,10 @@ Evaluate(MatType querySet, arma::vec& estimations)
     Timer::Start("computing_kde");
 
     // Evaluate.
-    typedef KDERules<MetricType, KernelType, Tree> RuleType;
-    RuleType rules = RuleType(referenceTree->Dataset(),
-                              querySet,
-                              estimations,
-                              relError,
-                              absError,
-                              mcProb,
-                              initialSampleSize,
-                              mcEntryCoef,
-                              mcBreakCoef,
-                              metric,
-                              kernel,
-                              monteCarlo,
-                              false);
-
-    // Create traverser.
-    SingleTreeTraversalType<RuleType> traverser(rules);
-
-    // Traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    SingleTreeEvaluate(querySet, estimations, false);
 
     estimations /= referenceTree->Dataset().n_cols;
     Timer::Stop("computing_kde");
-
-    Log::Info << rules.Scores() << " node combinations were scored."
-              << std::endl;
-    Log::Info << rules.BaseCases() << " base cases were calculated."
-              << std::endl;
   }
 }
 
@@ -478,32 +793,12 @@ Evaluate(Tree* queryTree,
   Timer::Start("computing_kde");
 
   // Evaluate.
-  typedef KDERules<MetricType, KernelType, Tree> RuleType;
-  RuleType rules = RuleType(referenceTree->Dataset(),
-                            queryTree->Dataset(),
-                            estimations,
-                            relError,
-                            absError,
-                            mcProb,
-                            initialSampleSize,
-                            mcEntryCoef,
-                            mcBreakCoef,
-                            metric,
-                            kernel,
-                            monteCarlo,
-                            false);
-
-  // Create traverser.
-  DualTreeTraversalType<RuleType> traverser(rules);
-  traverser.Traverse(*queryTree, *referenceTree);
+  DualTreeEvaluate(*queryTree, estimations, false);
   estimations /= referenceTree->Dataset().n_cols;
   Timer::Stop("computing_kde");
 
   // Rearrange if necessary.
   RearrangeEstimations(oldFromNewQueries, estimations);
-
-  Log::Info << rules.Scores() << " node combinations were scored." << std::endl;
-  Log::Info << rules.BaseCases() << " base cases were calculated." << std::endl;
 }
 
 template<typename KernelType,
@@ -547,41 +842,256 @@ Evaluate(arma::vec& estimations)
   Timer::Start("computing_kde");
 
   // Evaluate.
+  if (mode == DUAL_TREE_MODE)
+    DualTreeEvaluate(*referenceTree, estimations, true);
+  else if (mode == SINGLE_TREE_MODE)
+    SingleTreeEvaluate(referenceTree->Dataset(), estimations, true);
+
+  estimations /= referenceTree->Dataset().n_cols;
+  // Rearrange if necessary.
+  RearrangeEstimations(*oldFromNewReferences, estimations);
+  Timer::Stop("computing_kde");
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+DualTreeEvaluate(Tree& queryTree,
+                 arma::vec& estimations,
+                 const bool sameSet)
+{
   typedef KDERules<MetricType, KernelType, Tree> RuleType;
-  RuleType rules = RuleType(referenceTree->Dataset(),
-                            referenceTree->Dataset(),
-                            estimations,
-                            relError,
-                            absError,
-                            mcProb,
-                            initialSampleSize,
-                            mcEntryCoef,
-                            mcBreakCoef,
-                            metric,
-                            kernel,
-                            monteCarlo,
-                            true);
 
-  if (mode == DUAL_TREE_MODE)
+  const std::vector<Tree*> subtrees = UseParallel() ?
+      QuerySubtrees(queryTree) : std::vector<Tree*>(1, &queryTree);
+
+  // Each query point is a descendant of only one subtree, so the error
+  // tolerance accumulated for each query point can be shared by the rules of
+  // every subtree.
+  arma::vec accumError(queryTree.Dataset().n_cols, arma::fill::zeros);
+
+  const GaussianSeriesExpansion* series = BuildSeriesExpansion();
+
+  size_t baseCases = 0;
+  size_t scores = 0;
+  #pragma omp parallel for \
+      schedule(dynamic) \
+      reduction(+:baseCases, scores)
+  for (omp_size_t i = 0; i < (omp_size_t) subtrees.size(); ++i)
   {
+    RuleType rules(referenceTree->Dataset(), queryTree.Dataset(), estimations,
+        relError, absError, mcProb, initialSampleSize, mcEntryCoef,
+        mcBreakCoef, metric, kernel, monteCarlo, sameSet, &accumError,
+        series);
+
     // Create traverser.
     DualTreeTraversalType<RuleType> traverser(rules);
-    traverser.Traverse(*referenceTree, *referenceTree);
+    traverser.Traverse(*subtrees[i], *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
   }
-  else if (mode == SINGLE_TREE_MODE)
+
+  delete series;
+
+  this->baseCases = baseCases;
+  this->scores = scores;
+
+  Log::Info << scores << " node combinations were scored." << std::endl;
+  Log::Info << baseCases << " base cases were calculated." << std::endl;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+SingleTreeEvaluate(const MatType& querySet,
+                   arma::vec& estimations,
+                   const bool sameSet)
+{
+  typedef KDERules<MetricType, KernelType, Tree> RuleType;
+
+  // Each query point is only traversed by one thread.
+  arma::vec accumError(querySet.n_cols, arma::fill::zeros);
+
+  const GaussianSeriesExpansion* series = BuildSeriesExpansion();
+
+  size_t baseCases = 0;
+  size_t scores = 0;
+  #pragma omp parallel if (UseParallel()) reduction(+:baseCases, scores)
   {
+    RuleType rules(referenceTree->Dataset(), querySet, estimations, relError,
+        absError, mcProb, initialSampleSize, mcEntryCoef, mcBreakCoef, metric,
+        kernel, monteCarlo, sameSet, &accumError, series);
+
+    // Create traverser.
     SingleTreeTraversalType<RuleType> traverser(rules);
-    for (size_t i = 0; i < referenceTree->Dataset().n_cols; ++i)
+
+    // Traverse for each point.
+    #pragma omp for schedule(dynamic)
+    for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
       traverser.Traverse(i, *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
   }
 
-  estimations /= referenceTree->Dataset().n_cols;
-  // Rearrange if necessary.
-  RearrangeEstimations(*oldFromNewReferences, estimations);
-  Timer::Stop("computing_kde");
+  delete series;
 
-  Log::Info << rules.Scores() << " node combinations were scored." << std::endl;
-  Log::Info << rules.BaseCases() << " base cases were calculated." << std::endl;
+  this->baseCases = baseCases;
+  this->scores = scores;
+
+  Log::Info << scores << " node combinations were scored." << std::endl;
+  Log::Info << baseCases << " base cases were calculated." << std::endl;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+bool KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+UseParallel() const
+{
+  // Monte Carlo estimations use the global random number generator, and
+  // update the statistics of the reference nodes as they are traversed.
+  return parallel &&
+      !(monteCarlo && std::is_same<KernelType, kernel::GaussianKernel>::value);
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+GaussianSeriesExpansion* KDE<KernelType,
+                             MetricType,
+                             MatType,
+                             TreeType,
+                             DualTreeTraversalType,
+                             SingleTreeTraversalType>::
+BuildSeriesExpansion()
+{
+  if (!seriesExpansion || !HasSeriesExpansion(kernel, metric))
+    return NULL;
+
+  GaussianSeriesExpansion* series = new GaussianSeriesExpansion(
+      referenceTree->Dataset().n_rows, seriesOrder, SeriesBandwidth(kernel));
+
+  // Only the expansions of nodes with more descendants than the expansion has
+  // terms are ever used.
+  std::vector<Tree*> nodes;
+  std::vector<Tree*> stack(1, referenceTree);
+  while (!stack.empty())
+  {
+    Tree* node = stack.back();
+    stack.pop_back();
+    if (node->NumDescendants() <= series->NumTerms())
+      continue;
+
+    nodes.push_back(node);
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      stack.push_back(&node->Child(i));
+  }
+
+  Timer::Start("computing_series_expansions");
+  #pragma omp parallel for schedule(dynamic) if (parallel)
+  for (omp_size_t i = 0; i < (omp_size_t) nodes.size(); ++i)
+    series->ComputeCoefficients(*nodes[i]);
+  Timer::Stop("computing_series_expansions");
+
+  return series;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+std::vector<typename KDE<KernelType,
+                        MetricType,
+                        MatType,
+                        TreeType,
+                        DualTreeTraversalType,
+                        SingleTreeTraversalType>::Tree*>
+KDE<KernelType,
+    MetricType,
+    MatType,
+    TreeType,
+    DualTreeTraversalType,
+    SingleTreeTraversalType>::
+QuerySubtrees(Tree& queryTree)
+{
+  #ifdef HAS_OPENMP
+  const size_t numThreads = omp_get_max_threads();
+  #else
+  const size_t numThreads = 1;
+  #endif
+
+  // Descend one level at a time until there are enough subtrees to keep every
+  // thread busy, or until every subtree is a leaf.  Each query point is a
+  // descendant of exactly one subtree (unless a point may be held by several
+  // nodes), and only the statistics of the nodes of a subtree are modified
+  // while it is traversed.
+  std::vector<Tree*> subtrees(1, &queryTree);
+  bool expanded = (numThreads > 1 &&
+      tree::TreeTraits<Tree>::UniqueNumDescendants);
+  while (expanded && subtrees.size() < 4 * numThreads)
+  {
+    expanded = false;
+    std::vector<Tree*> nextSubtrees;
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      if (subtrees[i]->NumChildren() == 0)
+      {
+        nextSubtrees.push_back(subtrees[i]);
+        continue;
+      }
+
+      for (size_t j = 0; j < subtrees[i]->NumChildren(); ++j)
+        nextSubtrees.push_back(&subtrees[i]->Child(j));
+      expanded = true;
+    }
+
+    subtrees.swap(nextSubtrees);
+  }
+
+  return subtrees;
 }
 
 template<typename KernelType,
@@ -624,6 +1134,30 @@ AbsoluteError(const double newError)
   absError = newError;
 }
 
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void KDE<KernelType,
+         MetricType,
+         MatType,
+         TreeType,
+         DualTreeTraversalType,
+         SingleTreeTraversalType>::
+SeriesOrder(const size_t newOrder)
+{
+  if (newOrder == 0)
+  {
+    throw std::invalid_argument("Order of series expansions must be greater "
+                                "than 0");
+  }
+  seriesOrder = newOrder;
+}
+
 template<typename KernelType,
          typename MetricType,
          typename MatType,
@@ -56,6 +56,25 @@ BINDING_LONG_DESC(
     "use dual-tree algorithm or single-tree algorithm using the " +
     PRINT_PARAM_STRING("algorithm") + " option."
     "\n\n"
+    "If the " + PRINT_PARAM_STRING("parallel") + " flag is given, the "
+    "estimations are computed with multiple threads (if mlpack was built with "
+    "OpenMP): the query tree is split into subtrees that are traversed in "
+    "parallel, or the query points are split between threads for the "
+    "single-tree algorithm.  The results still meet the requested error "
+    "tolerances.  Monte Carlo estimations are always computed on a single "
+    "thread."
+    "\n\n"
+    "When the Gaussian kernel is used, the " +
+    PRINT_PARAM_STRING("series_expansion") + " flag enables far-field Taylor "
+    "series expansions of the kernel sums of reference nodes (as in the "
+    "improved fast Gauss transform), which can replace the evaluation of many "
+    "kernels when the bandwidth is large compared to the size of the nodes.  "
+    "The number of terms of the Taylor series may be set with " +
+    PRINT_PARAM_STRING("series_order") + "; the number of coefficients of each "
+    "expansion grows quickly with the dimensionality of the data, so "
+    "expansions are mostly useful in low dimensions.  The requested error "
+    "tolerances are still met."
+    "\n\n"
     "Monte Carlo estimations can be used to accelerate the KDE estimate when "
     "the Gaussian Kernel is used. This provides a probabilistic guarantee on "
     "the the error of the resulting KDE instead of an absolute guarantee."
@@ -162,6 +181,17 @@ PARAM_DOUBLE_IN("abs_error",
                 "Relative error tolerance for the prediction.",
                 "E",
                 KDEDefaultParams::absError);
+PARAM_FLAG("parallel",
+           "Whether to compute the estimations with multiple threads.",
+           "l");
+PARAM_FLAG("series_expansion",
+           "Whether to use series expansions of the Gaussian kernel when "
+           "possible.",
+           "x");
+PARAM_INT_IN("series_order",
+             "Number of terms of the Taylor series of series expansions.",
+             "o",
+             KDEDefaultParams::seriesOrder);
 PARAM_FLAG("monte_carlo",
            "Whether to use Monte Carlo estimations when possible.",
            "S");
@@ -202,6 +232,9 @@ static void mlpackMain()
   const double relError = IO::GetParam<double>("rel_error");
   const double absError = IO::GetParam<double>("abs_error");
   const bool monteCarlo = IO::GetParam<bool>("monte_carlo");
+  const bool parallel = IO::GetParam<bool>("parallel");
+  const bool seriesExpansion = IO::GetParam<bool>("series_expansion");
+  const int seriesOrder = IO::GetParam<int>("series_order");
   const double mcProb = IO::GetParam<double>("mc_probability");
   const int initialSampleSize = IO::GetParam<int>("initial_sample_size");
   const double mcEntryCoef = IO::GetParam<double>("mc_entry_coef");
@@ -220,12 +253,25 @@ static void mlpackMain()
   ReportIgnoredParam({{ "monte_carlo", false }}, "initial_sample_size");
   ReportIgnoredParam({{ "monte_carlo", false }}, "mc_entry_coef");
   ReportIgnoredParam({{ "monte_carlo", false }}, "mc_break_coef");
+  if (monteCarlo && parallel && kernelStr == "gaussian")
+  {
+    ReportIgnoredParam("parallel",
+                       "Monte Carlo estimations use a single thread");
+  }
   if (monteCarlo && kernelStr != "gaussian")
   {
     ReportIgnoredParam("monte_carlo",
                        "Monte Carlo only works with Gaussian kernel");
   }
 
+  // Series expansions are only available for the Gaussian kernel.
+  ReportIgnoredParam({{ "series_expansion", false }}, "series_order");
+  if (seriesExpansion && kernelStr != "gaussian")
+  {
+    ReportIgnoredParam("series_expansion",
+                       "series expansions only work with Gaussian kernel");
+  }
+
   // Requirements for parameter values.
   RequireParamInSet<string>("kernel", { "gaussian", "epanechnikov",
       "laplacian", "spherical", "triangular" }, true, "unknown kernel type");
@@ -243,6 +289,8 @@ static void mlpackMain()
       "than 1");
   RequireParamValue<int>("initial_sample_size", [](int x){return x > 0;},
       true, "initial sample size must be greater than 0");
+  RequireParamValue<int>("series_order", [](int x){return x > 0;},
+      true, "order of series expansions must be greater than 0");
   RequireParamValue<double>("mc_entry_coef", [](double x){return x >= 1;},
       true, "Monte Carlo entry coefficient must be greater than or equal to 1");
   RequireParamValue<double>("mc_break_coef",
@@ -306,6 +354,9 @@ static void mlpackMain()
   kde->MCInitialSampleSize(initialSampleSize);
   kde->MCEntryCoefficient(mcEntryCoef);
   kde->MCBreakCoefficient(mcBreakCoef);
+  kde->Parallel() = parallel;
+  kde->SeriesExpansion() = seriesExpansion;
+  kde->SeriesOrder((size_t) seriesOrder);
 
   // Evaluation.
   if (IO::HasParam("query"))
@@ -171,6 +171,43 @@ class TrainVisitor : public boost::static_visitor<void>
   TrainVisitor(arma::mat&& referenceSet);
 };
 
+/**
+ * InsertReferencePointsVisitor adds points to the reference set of a KDEType.
+ */
+class InsertReferencePointsVisitor : public boost::static_visitor<void>
+{
+ private:
+  //! The points to add.
+  const arma::mat& newPoints;
+
+ public:
+  //! Add the points to the reference set of the KDEType instance.
+  template<typename KDEType>
+  void operator()(KDEType* kde) const;
+
+  //! InsertReferencePointsVisitor constructor.
+  InsertReferencePointsVisitor(const arma::mat& newPoints);
+};
+
+/**
+ * ExpireReferencePointsVisitor removes the oldest points of the reference set
+ * of a KDEType.
+ */
+class ExpireReferencePointsVisitor : public boost::static_visitor<void>
+{
+ private:
+  //! The number of points to remove.
+  const size_t count;
+
+ public:
+  //! Remove the oldest reference points of the KDEType instance.
+  template<typename KDEType>
+  void operator()(KDEType* kde) const;
+
+  //! ExpireReferencePointsVisitor constructor.
+  ExpireReferencePointsVisitor(const size_t count);
+};
+
 /**
  * BandwidthVisitor modifies the bandwidth of a KDEType kernel.
  */
@@ -351,6 +388,57 @@ class ModeVisitor : public boost::static_visitor<KDEMode&>
   KDEMode& operator()(KDEType* kde) const;
 };
 
+/**
+ * ParallelVisitor exposes the Parallel() method of the KDEType.
+ */
+class ParallelVisitor : public boost::static_visitor<bool&>
+{
+ public:
+  //! Return whether the evaluation of the KDEType instance is parallel.
+  template<typename KDEType>
+  bool& operator()(KDEType* kde) const;
+};
+
+/**
+ * SeriesExpansionVisitor exposes the SeriesExpansion() method of the KDEType.
+ */
+class SeriesExpansionVisitor : public boost::static_visitor<bool&>
+{
+ public:
+  //! Return whether the KDEType instance uses series expansions.
+  template<typename KDEType>
+  bool& operator()(KDEType* kde) const;
+};
+
+/**
+ * SeriesOrderVisitor returns the order of the series expansions.
+ */
+class SeriesOrderVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  //! Return the order of the series expansions of the KDEType instance.
+  template<typename KDEType>
+  size_t operator()(KDEType* kde) const;
+};
+
+/**
+ * SetSeriesOrderVisitor sets the order of the series expansions.
+ */
+class SetSeriesOrderVisitor : public boost::static_visitor<void>
+{
+ private:
+  //! Order of the series expansions.
+  const size_t order;
+
+ public:
+  //! Set the order of the series expansions of the KDEType instance.
+  template<typename KDEType>
+  void operator()(KDEType* kde) const;
+
+  //! SetSeriesOrderVisitor constructor.
+  SetSeriesOrderVisitor(const size_t order);
+};
+
 class DeleteVisitor : public boost::static_visitor<void>
 {
  public:
@@ -566,6 +654,24 @@ class KDEModel
   //! Modify the mode of the model.
   KDEMode& Mode();
 
+  //! Get whether the evaluation of the model is run in parallel.
+  bool Parallel() const;
+
+  //! Modify whether the evaluation of the model is run in parallel.
+  bool& Parallel();
+
+  //! Get whether series expansions are used (Gaussian kernel only).
+  bool SeriesExpansion() const;
+
+  //! Modify whether series expansions are used (Gaussian kernel only).
+  bool& SeriesExpansion();
+
+  //! Get the order of the series expansions.
+  size_t SeriesOrder() const;
+
+  //! Modify the order of the series expansions.
+  void SeriesOrder(const size_t newOrder);
+
   /**
    * Build the KDE model with the given parameters and then trains it with the
    * given reference data.
@@ -576,6 +682,25 @@ class KDEModel
    */
   void BuildModel(arma::mat&& referenceSet);
 
+  /**
+   * Add points to the reference set of the trained model, without rebuilding
+   * the reference tree if the tree type can insert points (R tree).
+   *
+   * @pre The model has to be previously created with BuildModel.
+   * @param newPoints Points to add to the reference set.
+   */
+  void InsertReferencePoints(const arma::mat& newPoints);
+
+  /**
+   * Remove the oldest points of the reference set of the trained model (in
+   * the order they were added in), without rebuilding the reference tree if
+   * the tree type can delete points (R tree).
+   *
+   * @pre The model has to be previously created with BuildModel.
+   * @param count Number of points to remove; at least one point must be left.
+   */
+  void ExpireReferencePoints(const size_t count);
+
   /**
    * Perform kernel density estimation on the given query set.
    * Takes possession of the query set to avoid a copy, so the query set
@@ -267,6 +267,20 @@ inline void KDEModel::BuildModel(arma::mat&& referenceSet)
   boost::apply_visitor(train, kdeModel);
 }
 
+// Add points to the reference set.
+inline void KDEModel::InsertReferencePoints(const arma::mat& newPoints)
+{
+  InsertReferencePointsVisitor insert(newPoints);
+  boost::apply_visitor(insert, kdeModel);
+}
+
+// Remove the oldest points of the reference set.
+inline void KDEModel::ExpireReferencePoints(const size_t count)
+{
+  ExpireReferencePointsVisitor expire(count);
+  boost::apply_visitor(expire, kdeModel);
+}
+
 // Perform bichromatic evaluation.
 inline void KDEModel::Evaluate(arma::mat&& querySet, arma::vec& estimations)
 {
@@ -361,6 +375,38 @@ void TrainVisitor::operator()(KDEType<KernelType, TreeType>* kde) const
     throw std::runtime_error("no KDE model initialized");
 }
 
+// Set points to add to the reference set.
+inline InsertReferencePointsVisitor::InsertReferencePointsVisitor(
+    const arma::mat& newPoints) :
+    newPoints(newPoints)
+{}
+
+// Add points to the reference set.
+template<typename KDEType>
+void InsertReferencePointsVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    kde->InsertReferencePoints(newPoints);
+  else
+    throw std::runtime_error("no KDE model initialized");
+}
+
+// Set number of reference points to remove.
+inline ExpireReferencePointsVisitor::ExpireReferencePointsVisitor(
+    const size_t count) :
+    count(count)
+{}
+
+// Remove the oldest reference points.
+template<typename KDEType>
+void ExpireReferencePointsVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    kde->ExpireReferencePoints(count);
+  else
+    throw std::runtime_error("no KDE model initialized");
+}
+
 // Modify kernel bandwidth.
 BandwidthVisitor::BandwidthVisitor(const double bandwidth) :
     bandwidth(bandwidth)
@@ -523,6 +569,51 @@ KDEMode& ModeVisitor::operator()(KDEType* kde) const
     throw std::runtime_error("no KDE model initialized");
 }
 
+// Whether the evaluation of the model is parallel.
+template<typename KDEType>
+bool& ParallelVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->Parallel();
+  else
+    throw std::runtime_error("no KDE model initialized");
+}
+
+// Whether the model uses series expansions.
+template<typename KDEType>
+bool& SeriesExpansionVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->SeriesExpansion();
+  else
+    throw std::runtime_error("no KDE model initialized");
+}
+
+// Order of the series expansions of the model.
+template<typename KDEType>
+size_t SeriesOrderVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->SeriesOrder();
+  else
+    throw std::runtime_error("no KDE model initialized");
+}
+
+// Set order of the series expansions.
+inline SetSeriesOrderVisitor::SetSeriesOrderVisitor(const size_t order) :
+    order(order)
+{}
+
+// Set order of the series expansions of the model.
+template<typename KDEType>
+void SetSeriesOrderVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    kde->SeriesOrder(order);
+  else
+    throw std::runtime_error("no KDE model initialized");
+}
+
 // Get mode of model.
 KDEMode KDEModel::Mode() const
 {
@@ -535,6 +626,43 @@ KDEMode& KDEModel::Mode()
   return boost::apply_visitor(ModeVisitor(), kdeModel);
 }
 
+// Get whether the evaluation of the model is parallel.
+inline bool KDEModel::Parallel() const
+{
+  return boost::apply_visitor(ParallelVisitor(), kdeModel);
+}
+
+// Modify whether the evaluation of the model is parallel.
+inline bool& KDEModel::Parallel()
+{
+  return boost::apply_visitor(ParallelVisitor(), kdeModel);
+}
+
+// Get whether the model uses series expansions.
+inline bool KDEModel::SeriesExpansion() const
+{
+  return boost::apply_visitor(SeriesExpansionVisitor(), kdeModel);
+}
+
+// Modify whether the model uses series expansions.
+inline bool& KDEModel::SeriesExpansion()
+{
+  return boost::apply_visitor(SeriesExpansionVisitor(), kdeModel);
+}
+
+// Get the order of the series expansions of the model.
+inline size_t KDEModel::SeriesOrder() const
+{
+  return boost::apply_visitor(SeriesOrderVisitor(), kdeModel);
+}
+
+// Modify the order of the series expansions of the model.
+inline void KDEModel::SeriesOrder(const size_t newOrder)
+{
+  SetSeriesOrderVisitor setSeriesOrderVisitor(newOrder);
+  boost::apply_visitor(setSeriesOrderVisitor, kdeModel);
+}
+
 // Serialize the model.
 template<typename Archive>
 void KDEModel::serialize(Archive& ar, const uint32_t /* version */)
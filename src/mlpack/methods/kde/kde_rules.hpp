@@ -15,6 +15,8 @@
 
 #include <mlpack/core/tree/traversal_info.hpp>
 
+#include "gaussian_series_expansion.hpp"
+
 namespace mlpack {
 namespace kde {
 
@@ -45,6 +47,14 @@ class KDERules
    *                   possible.
    * @param sameSet True if query and reference sets are the same
    *                (monochromatic evaluation).
+   * @param sharedAccumError If given, the error tolerance accumulated for each
+   *                         query point is stored in this vector instead of in
+   *                         the rules, so that rules that traverse different
+   *                         query points at the same time can share it.
+   * @param series If given, the series expansions of the reference nodes,
+   *               which must have been computed for every reference node with
+   *               more descendants than the expansion has terms, are used
+   *               when their error is within the tolerance.
    */
   KDERules(const arma::mat& referenceSet,
            const arma::mat& querySet,
@@ -58,11 +68,25 @@ class KDERules
            MetricType& metric,
            KernelType& kernel,
            const bool monteCarlo,
-           const bool sameSet);
+           const bool sameSet,
+           arma::vec* sharedAccumError = NULL,
+           const GaussianSeriesExpansion* series = NULL);
 
   //! Base Case.
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Base cases between each of the given query points and every point held by
+   * the given reference node.  For other metrics than the (squared) Euclidean
+   * distance, BaseCase() is called for each pair.  For the Euclidean distance,
+   * all of the distances are computed in one batch (see
+   * metric::LMetric::BatchEvaluate()), and only the pairs whose kernel value
+   * is not known within the error tolerance, given the rounding error of the
+   * batch, are passed to BaseCase().
+   */
+  void BatchBaseCase(const std::vector<size_t>& queryIndices,
+                     TreeType& referenceNode);
+
   //! SingleTree Rescore.
   double Score(const size_t queryIndex, TreeType& referenceNode);
 
@@ -106,9 +130,48 @@ class KDERules
   double EvaluateKernel(const arma::vec& query,
                         const arma::vec& reference) const;
 
+  //! Get the accumulated not used error tolerance of a query point.
+  double& AccumError(const size_t queryIndex)
+  {
+    return (sharedAccumError != NULL) ? (*sharedAccumError)(queryIndex) :
+        accumError(queryIndex);
+  }
+
+  /**
+   * Get the largest error of the series expansion of the reference node for
+   * each of its points at each point of the query node, or DBL_MAX if the
+   * expansion cannot be used.
+   */
+  double SeriesError(TreeType& queryNode,
+                     TreeType& referenceNode,
+                     const double minDistance,
+                     const bool alreadyDidRefPoint0) const;
+
+  /**
+   * Get the largest error of the series expansion of the reference node for
+   * each of its points at the query point, or DBL_MAX if the expansion cannot
+   * be used.
+   */
+  double SeriesError(const size_t queryIndex,
+                     TreeType& referenceNode,
+                     const double minDistance,
+                     const bool alreadyDidRefPoint0) const;
+
   //! Calculate depth alpha for some node.
   double CalculateAlpha(TreeType* node);
 
+  //! Base cases for metrics that have no batched kernel.
+  template<typename MetricType2>
+  void BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                         TreeType& referenceNode,
+                         MetricType2& metric);
+
+  //! Base cases with the batched L2 kernel.
+  template<bool TakeRoot>
+  void BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                         TreeType& referenceNode,
+                         metric::LMetric<2, TakeRoot>& metric);
+
   //! The reference set.
   const arma::mat& referenceSet;
 
@@ -155,9 +218,19 @@ class KDERules
   //! Accumulated not used error tolerance for each query point.
   arma::vec accumError;
 
+  //! Accumulated not used error tolerance for each query point, if it is not
+  //! held by these rules.
+  arma::vec* sharedAccumError;
+
   //! Whether reference and query sets are the same.
   const bool sameSet;
 
+  //! Series expansions of the reference nodes, if they are used.
+  const GaussianSeriesExpansion* series;
+
+  //! Workspace for the monomials of series expansions.
+  arma::vec seriesMonomials;
+
   //! Whether the kernel used for the rule is the Gaussian Kernel.
   constexpr static bool kernelIsGaussian =
       std::is_same<KernelType, kernel::GaussianKernel>::value;
@@ -36,7 +36,9 @@ KDERules<MetricType, KernelType, TreeType>::KDERules(
     MetricType& metric,
     KernelType& kernel,
     const bool monteCarlo,
-    const bool sameSet) :
+    const bool sameSet,
+    arma::vec* sharedAccumError,
+    const GaussianSeriesExpansion* series) :
     referenceSet(referenceSet),
     querySet(querySet),
     densities(densities),
@@ -49,15 +51,18 @@ KDERules<MetricType, KernelType, TreeType>::KDERules(
     metric(metric),
     kernel(kernel),
     monteCarlo(monteCarlo),
+    sharedAccumError(sharedAccumError),
     sameSet(sameSet),
+    series(series),
     absErrorTol(absError / referenceSet.n_cols),
     lastQueryIndex(querySet.n_cols),
     lastReferenceIndex(referenceSet.n_cols),
     baseCases(0),
     scores(0)
 {
-  // Initialize accumError.
-  accumError = arma::vec(querySet.n_cols, arma::fill::zeros);
+  // Initialize accumError, unless it is held elsewhere.
+  if (sharedAccumError == NULL)
+    accumError = arma::vec(querySet.n_cols, arma::fill::zeros);
 
   // Initialize accumMCAlpha only if Monte Carlo estimations are available.
   if (monteCarlo && kernelIsGaussian)
@@ -87,7 +92,7 @@ double KDERules<MetricType, KernelType, TreeType>::BaseCase(
   densities(queryIndex) += kernelValue;
 
   // Update accumulated relative error tolerance for single-tree pruning.
-  accumError(queryIndex) += 2 * relError * kernelValue;
+  AccumError(queryIndex) += 2 * relError * kernelValue;
 
   ++baseCases;
   lastQueryIndex = queryIndex;
@@ -96,6 +101,81 @@ double KDERules<MetricType, KernelType, TreeType>::BaseCase(
   return distance;
 }
 
+template<typename MetricType, typename KernelType, typename TreeType>
+inline void KDERules<MetricType, KernelType, TreeType>::BatchBaseCase(
+    const std::vector<size_t>& queryIndices,
+    TreeType& referenceNode)
+{
+  BatchBaseCaseImpl(queryIndices, referenceNode, metric);
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+template<typename MetricType2>
+inline void KDERules<MetricType, KernelType, TreeType>::BatchBaseCaseImpl(
+    const std::vector<size_t>& queryIndices,
+    TreeType& referenceNode,
+    MetricType2& /* metric */)
+{
+  for (size_t i = 0; i < queryIndices.size(); ++i)
+    for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+      BaseCase(queryIndices[i], referenceNode.Point(j));
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+template<bool TakeRoot>
+inline void KDERules<MetricType, KernelType, TreeType>::BatchBaseCaseImpl(
+    const std::vector<size_t>& queryIndices,
+    TreeType& referenceNode,
+    metric::LMetric<2, TakeRoot>& /* metric */)
+{
+  arma::uvec queries(queryIndices.size());
+  for (size_t i = 0; i < queryIndices.size(); ++i)
+    queries[i] = queryIndices[i];
+  arma::uvec references(referenceNode.NumPoints());
+  for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+    references[j] = referenceNode.Point(j);
+
+  arma::mat distances;
+  const double tolerance = metric::LMetric<2, TakeRoot>::BatchEvaluate(
+      arma::mat(querySet.cols(queries)),
+      arma::mat(referenceSet.cols(references)), distances);
+
+  for (size_t i = 0; i < queries.n_elem; ++i)
+  {
+    const size_t queryIndex = queries[i];
+    for (size_t j = 0; j < references.n_elem; ++j)
+    {
+      // We don't want to compute the estimation of a point with itself.
+      if (sameSet && (queryIndex == references[j]))
+        continue;
+
+      // The true distance is within the tolerance of the batched one, so the
+      // kernel value is bounded in the same way as for a pruned node (see
+      // Score()).  If the bound does not fit in the error tolerance of the
+      // pair and the leftover tolerance of the query, the pair is evaluated
+      // exactly.
+      const double maxKernel = kernel.Evaluate(std::max(distances(i, j) -
+          tolerance, 0.0));
+      const double minKernel = kernel.Evaluate(distances(i, j) + tolerance);
+      const double bound = maxKernel - minKernel;
+      const double errorTolerance = absErrorTol + relError * minKernel;
+      if (bound > 2 * errorTolerance + AccumError(queryIndex))
+      {
+        BaseCase(queryIndex, references[j]);
+        continue;
+      }
+
+      densities(queryIndex) += (maxKernel + minKernel) / 2.0;
+      AccumError(queryIndex) -= bound - 2 * errorTolerance;
+      ++baseCases;
+
+      lastQueryIndex = queryIndex;
+      lastReferenceIndex = references[j];
+      traversalInfo.LastBaseCase() = distances(i, j);
+    }
+  }
+}
+
 //! Single-tree scoring function.
 template<typename MetricType, typename KernelType, typename TreeType>
 inline double KDERules<MetricType, KernelType, TreeType>::
@@ -156,11 +236,17 @@ Score(const size_t queryIndex, TreeType& referenceNode)
   // it here to prune more.
   double pointAccumErrorTol;
   if (alreadyDidRefPoint0)
-    pointAccumErrorTol = accumError(queryIndex) / (refNumDesc - 1);
+    pointAccumErrorTol = AccumError(queryIndex) / (refNumDesc - 1);
   else
-    pointAccumErrorTol = accumError(queryIndex) / refNumDesc;
+    pointAccumErrorTol = AccumError(queryIndex) / refNumDesc;
+
+  // The error of the series expansion is only needed if the bounds cannot
+  // prune.
+  const bool boundPrune = (bound <= 2 * errorTolerance + pointAccumErrorTol);
+  const double seriesError = boundPrune ? DBL_MAX :
+      SeriesError(queryIndex, referenceNode, minDistance, alreadyDidRefPoint0);
 
-  if (bound <= 2 * errorTolerance + pointAccumErrorTol)
+  if (boundPrune)
   {
     // Estimate kernel value.
     const double kernelValue = (maxKernel + minKernel) / 2.0;
@@ -176,9 +262,25 @@ Score(const size_t queryIndex, TreeType& referenceNode)
     // Subtract used error tolerance or add extra available tolerace from this
     // prune.
     if (alreadyDidRefPoint0)
-      accumError(queryIndex) -= (refNumDesc - 1) * (bound - 2 * errorTolerance);
+      AccumError(queryIndex) -= (refNumDesc - 1) * (bound - 2 * errorTolerance);
     else
-      accumError(queryIndex) -= refNumDesc * (bound - 2 * errorTolerance);
+      AccumError(queryIndex) -= refNumDesc * (bound - 2 * errorTolerance);
+
+    // Store not used alpha for Monte Carlo.
+    if (kernelIsGaussian && monteCarlo)
+      accumMCAlpha(queryIndex) += depthAlpha;
+  }
+  else if (2 * seriesError <= 2 * errorTolerance + pointAccumErrorTol)
+  {
+    // Evaluate the series expansion of the reference node.
+    densities(queryIndex) += series->Evaluate(referenceNode.Stat(),
+        querySet.unsafe_col(queryIndex), seriesMonomials);
+
+    // Don't explore this tree branch.
+    score = DBL_MAX;
+
+    // Subtract used error tolerance or add extra available tolerance.
+    AccumError(queryIndex) -= refNumDesc * 2 * (seriesError - errorTolerance);
 
     // Store not used alpha for Monte Carlo.
     if (kernelIsGaussian && monteCarlo)
@@ -276,9 +378,9 @@ Score(const size_t queryIndex, TreeType& referenceNode)
     if (referenceNode.IsLeaf())
     {
       if (alreadyDidRefPoint0)
-        accumError(queryIndex) += (refNumDesc - 1) * 2 * absErrorTol;
+        AccumError(queryIndex) += (refNumDesc - 1) * 2 * absErrorTol;
       else
-        accumError(queryIndex) += refNumDesc * 2 * absErrorTol;
+        AccumError(queryIndex) += refNumDesc * 2 * absErrorTol;
     }
 
     // If node is going to be exactly computed, reclaim not used alpha for
@@ -367,8 +469,14 @@ Score(TreeType& queryNode, TreeType& referenceNode)
   // it here to prune more.
   const double pointAccumErrorTol = queryStat.AccumError() / refNumDesc;
 
+  // The error of the series expansion is only needed if the bounds cannot
+  // prune.
+  const bool boundPrune = (bound <= 2 * errorTolerance + pointAccumErrorTol);
+  const double seriesError = boundPrune ? DBL_MAX :
+      SeriesError(queryNode, referenceNode, minDistance, alreadyDidRefPoint0);
+
   // If possible, avoid some calculations because of the error tolerance.
-  if (bound <= 2 * errorTolerance + pointAccumErrorTol)
+  if (boundPrune)
   {
     // Estimate kernel value.
     const double kernelValue = (maxKernel + minKernel) / 2.0;
@@ -393,6 +501,27 @@ Score(TreeType& queryNode, TreeType& referenceNode)
     if (kernelIsGaussian && monteCarlo)
       queryStat.AccumAlpha() += depthAlpha;
   }
+  else if (2 * seriesError <= 2 * errorTolerance + pointAccumErrorTol)
+  {
+    // Evaluate the series expansion of the reference node for each query
+    // point.
+    for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+    {
+      const size_t queryIndex = queryNode.Descendant(i);
+      densities(queryIndex) += series->Evaluate(referenceNode.Stat(),
+          querySet.unsafe_col(queryIndex), seriesMonomials);
+    }
+
+    // Prune.
+    score = DBL_MAX;
+
+    // Subtract used error tolerance or add extra available tolerance.
+    queryStat.AccumError() -= refNumDesc * 2 * (seriesError - errorTolerance);
+
+    // Store not used alpha for Monte Carlo.
+    if (kernelIsGaussian && monteCarlo)
+      queryStat.AccumAlpha() += depthAlpha;
+  }
   else if (monteCarlo &&
            refNumDesc >= mcAccessCoef * initialSampleSize &&
            kernelIsGaussian)
@@ -528,6 +657,48 @@ Rescore(TreeType& /*queryNode*/,
   return oldScore;
 }
 
+template<typename MetricType, typename KernelType, typename TreeType>
+inline double KDERules<MetricType, KernelType, TreeType>::SeriesError(
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    const double minDistance,
+    const bool alreadyDidRefPoint0) const
+{
+  // The expansion holds every point of the reference node, so it can't be used
+  // if one of them was already computed or may be a query point.  It is only
+  // cheaper than the base cases if it has fewer terms than the node has
+  // points.
+  const KDEStat& referenceStat = referenceNode.Stat();
+  if (series == NULL || alreadyDidRefPoint0 ||
+      (sameSet && minDistance == 0.0) ||
+      referenceNode.NumDescendants() <= series->NumTerms() ||
+      !series->IsComputed(referenceStat))
+    return DBL_MAX;
+
+  const math::Range r = queryNode.RangeDistance(referenceStat.SeriesCenter());
+  return series->MaxError(r.Lo(), r.Hi(), referenceStat.SeriesRadius());
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+inline double KDERules<MetricType, KernelType, TreeType>::SeriesError(
+    const size_t queryIndex,
+    TreeType& referenceNode,
+    const double minDistance,
+    const bool alreadyDidRefPoint0) const
+{
+  // See the dual-tree version.
+  const KDEStat& referenceStat = referenceNode.Stat();
+  if (series == NULL || alreadyDidRefPoint0 ||
+      (sameSet && minDistance == 0.0) ||
+      referenceNode.NumDescendants() <= series->NumTerms() ||
+      !series->IsComputed(referenceStat))
+    return DBL_MAX;
+
+  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+      referenceStat.SeriesCenter());
+  return series->MaxError(distance, distance, referenceStat.SeriesRadius());
+}
+
 template<typename MetricType, typename KernelType, typename TreeType>
 inline force_inline double KDERules<MetricType, KernelType, TreeType>::
 EvaluateKernel(const size_t queryIndex,
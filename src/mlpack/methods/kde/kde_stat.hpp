@@ -29,7 +29,10 @@ class KDEStat
       mcBeta(0),
       mcAlpha(0),
       accumAlpha(0),
-      accumError(0)
+      accumError(0),
+      seriesRadius(0),
+      seriesOrder(0),
+      seriesBandwidth(0)
   { /* Nothing to do.*/ }
 
   //! Initialization for a fully initialized node.
@@ -38,7 +41,10 @@ class KDEStat
       mcBeta(0),
       mcAlpha(0),
       accumAlpha(0),
-      accumError(0)
+      accumError(0),
+      seriesRadius(0),
+      seriesOrder(0),
+      seriesBandwidth(0)
   { /* Nothing to do. */ }
 
   //! Get accumulated Monte Carlo alpha of the node.
@@ -65,7 +71,39 @@ class KDEStat
   //! Modify Monte Carlo alpha of the node.
   inline double& MCAlpha() { return mcAlpha; }
 
-  //! Serialize the statistic to/from an archive.
+  //! Get the center of the series expansion of the node.
+  inline const arma::vec& SeriesCenter() const { return seriesCenter; }
+
+  //! Modify the center of the series expansion of the node.
+  inline arma::vec& SeriesCenter() { return seriesCenter; }
+
+  //! Get the coefficients of the series expansion of the node.
+  inline const arma::vec& SeriesCoefficients() const
+  { return seriesCoefficients; }
+
+  //! Modify the coefficients of the series expansion of the node.
+  inline arma::vec& SeriesCoefficients() { return seriesCoefficients; }
+
+  //! Get the largest distance between the center and a point of the node.
+  inline double SeriesRadius() const { return seriesRadius; }
+
+  //! Modify the largest distance between the center and a point of the node.
+  inline double& SeriesRadius() { return seriesRadius; }
+
+  //! Get the order of the series expansion of the node (0 if there is none).
+  inline size_t SeriesOrder() const { return seriesOrder; }
+
+  //! Modify the order of the series expansion of the node.
+  inline size_t& SeriesOrder() { return seriesOrder; }
+
+  //! Get the kernel bandwidth of the series expansion of the node.
+  inline double SeriesBandwidth() const { return seriesBandwidth; }
+
+  //! Modify the kernel bandwidth of the series expansion of the node.
+  inline double& SeriesBandwidth() { return seriesBandwidth; }
+
+  //! Serialize the statistic to/from an archive.  The series expansion is not
+  //! serialized; it is computed again when it is needed.
   template<typename Archive>
   void serialize(Archive& ar, const uint32_t /* version */)
   {
@@ -73,6 +111,9 @@ class KDEStat
     ar(CEREAL_NVP(mcAlpha));
     ar(CEREAL_NVP(accumAlpha));
     ar(CEREAL_NVP(accumError));
+
+    if (cereal::is_loading<Archive>())
+      seriesOrder = 0;
   }
 
  private:
@@ -87,6 +128,21 @@ class KDEStat
 
   //! Accumulated not used error tolerance in the current node.
   double accumError;
+
+  //! Center of the series expansion.
+  arma::vec seriesCenter;
+
+  //! Coefficients of the series expansion.
+  arma::vec seriesCoefficients;
+
+  //! Largest distance between the center and a point of the node.
+  double seriesRadius;
+
+  //! Order of the series expansion, or 0 if it has not been computed.
+  size_t seriesOrder;
+
+  //! Kernel bandwidth for which the series expansion was computed.
+  double seriesBandwidth;
 };
 
 } // namespace kde
@@ -39,7 +39,12 @@ BINDING_LONG_DESC(
     "This program will calculate the k approximate-nearest-neighbors of a set "
     "of points using locality-sensitive hashing. You may specify a separate set"
     " of reference points and query points, or just a reference set which will "
-    "be used as both the reference and query set. ");
+    "be used as both the reference and query set."
+    "\n\n"
+    "Models can also be saved to and loaded from files with the '.mmap' "
+    "extension.  These files hold the reference set and hash tables in a flat "
+    "layout that is memory-mapped when the model is loaded, so that large "
+    "models are used in place instead of being deserialized.");
 
 // Example.
 BINDING_EXAMPLE(
@@ -61,6 +66,16 @@ BINDING_EXAMPLE(
     "different from run to run.  Thus, the " + PRINT_PARAM_STRING("seed") +
     " parameter can be specified to set the random seed."
     "\n\n"
+    "The time spent on each query can be bounded with a probing budget: if "
+    + PRINT_PARAM_STRING("candidate_target") + " or " +
+    PRINT_PARAM_STRING("time_limit") + " is specified, the buckets of each "
+    "query are probed in order of likelihood (up to " +
+    PRINT_PARAM_STRING("num_probes") + " additional buckets per table) until "
+    "that many distinct candidates have been found or that many seconds have "
+    "passed.  The number of buckets probed, candidates scanned and distance "
+    "evaluations of each query can be saved with " +
+    PRINT_PARAM_STRING("probe_statistics") + "."
+    "\n\n"
     "This program also has many other parameters to control its functionality;"
     " see the parameter-specific documentation for more information.");
 
@@ -99,10 +114,17 @@ PARAM_DOUBLE_IN("hash_width", "The hash width for the first-level hashing in "
     "a hash width for its use.", "H", 0.0);
 PARAM_INT_IN("num_probes", "Number of additional probes for multiprobe LSH; if "
     "0, traditional LSH is used.", "T", 0);
+PARAM_INT_IN("candidate_target", "If nonzero, probing for a query stops once "
+    "this many distinct candidates have been found.", "c", 0);
+PARAM_DOUBLE_IN("time_limit", "If nonzero, probing for a query stops once this "
+    "many seconds have passed since the query started.", "l", 0.0);
+PARAM_UMATRIX_OUT("probe_statistics", "Matrix to output the statistics of each "
+    "query into: the number of buckets probed, the number of candidates "
+    "scanned, and the number of distance evaluations.", "p");
 PARAM_INT_IN("second_hash_size", "The size of the second level hash table.",
     "S", 99901);
-PARAM_INT_IN("bucket_size", "The size of a bucket in the second level hash.",
-    "B", 500);
+PARAM_INT_IN("bucket_size", "The maximum number of points stored in a bucket "
+    "of the second level hash (0 means no limit).", "B", 500);
 PARAM_INT_IN("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
 static void mlpackMain()
@@ -120,8 +142,12 @@ static void mlpackMain()
   }
   RequireParamValue<int>("second_hash_size", [](int x) { return x > 0; }, true,
       "second hash size must be greater than 0");
-  RequireParamValue<int>("bucket_size", [](int x) { return x > 0; }, true,
-      "bucket size must be greater than 0");
+  RequireParamValue<int>("bucket_size", [](int x) { return x >= 0; }, true,
+      "bucket size must not be negative");
+  RequireParamValue<int>("candidate_target", [](int x) { return x >= 0; },
+      true, "candidate target must not be negative");
+  RequireParamValue<double>("time_limit", [](double x) { return x >= 0.0; },
+      true, "time limit must not be negative");
 
   size_t k = IO::GetParam<int>("k");
   size_t secondHashSize = IO::GetParam<int>("second_hash_size");
@@ -146,6 +172,7 @@ static void mlpackMain()
 
   ReportIgnoredParam({{ "k", false }}, "neighbors");
   ReportIgnoredParam({{ "k", false }}, "distances");
+  ReportIgnoredParam({{ "k", false }}, "probe_statistics");
 
   ReportIgnoredParam({{ "reference", false }}, "bucket_size");
   ReportIgnoredParam({{ "reference", false }}, "second_hash_size");
@@ -166,9 +193,17 @@ static void mlpackMain()
   const size_t numTables = IO::GetParam<int>("tables");
   const double hashWidth = IO::GetParam<double>("hash_width");
   const size_t numProbes = (size_t) IO::GetParam<int>("num_probes");
+  const size_t candidateTarget = (size_t) IO::GetParam<int>("candidate_target");
+  const double timeLimit = IO::GetParam<double>("time_limit");
+
+  // The probing budget is only used by the adaptive search, which also
+  // reports the statistics of each query.
+  const bool adaptive = (candidateTarget > 0 || timeLimit > 0.0 ||
+      IO::HasParam("probe_statistics"));
 
   arma::Mat<size_t> neighbors;
   arma::mat distances;
+  arma::Mat<size_t> probeStatistics;
 
   if (hashWidth == 0.0)
     Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
@@ -205,7 +240,20 @@ static void mlpackMain()
           << IO::GetPrintableParam<arma::mat>("query") << "." << endl;
       queryData = std::move(IO::GetParam<arma::mat>("query"));
 
-      allkann->Search(queryData, k, neighbors, distances, 0, numProbes);
+      if (adaptive)
+      {
+        allkann->AdaptiveSearch(queryData, k, neighbors, distances,
+            probeStatistics, candidateTarget, numProbes, timeLimit);
+      }
+      else
+      {
+        allkann->Search(queryData, k, neighbors, distances, 0, numProbes);
+      }
+    }
+    else if (adaptive)
+    {
+      allkann->AdaptiveSearch(k, neighbors, distances, probeStatistics,
+          candidateTarget, numProbes, timeLimit);
     }
     else
     {
@@ -248,6 +296,8 @@ static void mlpackMain()
   {
     IO::GetParam<arma::mat>("distances") = std::move(distances);
     IO::GetParam<arma::Mat<size_t>>("neighbors") = std::move(neighbors);
+    IO::GetParam<arma::Mat<size_t>>("probe_statistics") =
+        std::move(probeStatistics);
   }
   IO::GetParam<LSHSearch<>*>("output_model") = allkann;
 }
@@ -48,7 +48,9 @@
 #define MLPACK_METHODS_NEIGHBOR_SEARCH_LSH_SEARCH_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <mlpack/core/cereal/template_class_version.hpp>
 
+#include <mlpack/core/data/mapped_file.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
 
@@ -167,7 +169,9 @@ class LSHSearch
    * Train the LSH model on the given dataset.  If a correctly-sized projection
    * cube is not provided, this means building new hash tables. Otherwise, we
    * use the projections provided by the user.  In order to avoid copying the
-   * reference set, consider passing that parameter with std::move().
+   * reference set, consider passing that parameter with std::move().  The
+   * tables are hashed and filled in parallel when OpenMP is available; the
+   * resulting model does not depend on the number of threads.
    *
    * @param referenceSet Set of reference points and the set of queries.
    * @param numProj Number of projections in each hash table (anything between
@@ -249,6 +253,70 @@ class LSHSearch
               const size_t numTablesToSearch = 0,
               size_t T = 0);
 
+  /**
+   * Compute the nearest neighbors of the points in the given query set with a
+   * per-query probing budget.  The buckets of each query are probed in order of
+   * likelihood: first the primary bucket of every table, then the first
+   * additional multiprobe bucket of every table, and so on, up to T additional
+   * buckets per table.  The probing of a query stops early once
+   * candidateTarget distinct candidates have been found, or once timeLimit
+   * seconds have passed since the query started; at least one bucket is
+   * always probed.  This bounds the time spent on each query, which is useful
+   * when queries must be answered with a bounded latency.
+   *
+   * The statistics of each query are stored in a column of probeStatistics:
+   * row 0 holds the number of buckets probed, row 1 the number of candidates
+   * scanned in those buckets (including duplicates), and row 2 the number of
+   * distance evaluations (the number of distinct candidates).
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   * @param probeStatistics Matrix storing the statistics of each query.
+   * @param candidateTarget Number of distinct candidates after which probing
+   *     stops; if 0, there is no target.
+   * @param T Maximum number of additional probing bins per table.
+   * @param timeLimit Time (in seconds) after which the probing of a query
+   *     stops; if 0, there is no time limit.
+   */
+  void AdaptiveSearch(const MatType& querySet,
+                      const size_t k,
+                      arma::Mat<size_t>& resultingNeighbors,
+                      arma::mat& distances,
+                      arma::Mat<size_t>& probeStatistics,
+                      const size_t candidateTarget,
+                      const size_t T,
+                      const double timeLimit = 0.0);
+
+  /**
+   * Compute the nearest neighbors of every point in the reference set with a
+   * per-query probing budget; see the other overload of AdaptiveSearch() for
+   * the meaning of the budget and of the statistics.  A std::invalid_argument
+   * is thrown if k is not less than the number of reference points.
+   *
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   * @param probeStatistics Matrix storing the statistics of each query.
+   * @param candidateTarget Number of distinct candidates after which probing
+   *     stops; if 0, there is no target.
+   * @param T Maximum number of additional probing bins per table.
+   * @param timeLimit Time (in seconds) after which the probing of a query
+   *     stops; if 0, there is no time limit.
+   */
+  void AdaptiveSearch(const size_t k,
+                      arma::Mat<size_t>& resultingNeighbors,
+                      arma::mat& distances,
+                      arma::Mat<size_t>& probeStatistics,
+                      const size_t candidateTarget,
+                      const size_t T,
+                      const double timeLimit = 0.0);
+
   /**
    * Compute the recall (% of neighbors found) given the neighbors returned by
    * LSHSearch::Search and a "ground truth" set of neighbors.  The recall
@@ -270,6 +338,29 @@ class LSHSearch
   template<typename Archive>
   void serialize(Archive& ar, const uint32_t version);
 
+  /**
+   * Save the model to the given file in a flat binary format that can be
+   * memory-mapped by LoadMapped(), so that the reference set and the buckets
+   * of the second hash table are used in place instead of being deserialized.
+   * This is only available for dense reference sets; otherwise a
+   * std::invalid_argument is thrown.  data::Save() calls this for files with
+   * the extension ".mmap".
+   *
+   * @param filename File to save the model to.
+   */
+  void SaveMapped(const std::string& filename) const;
+
+  /**
+   * Load a model saved with SaveMapped() by memory-mapping the given file.  The
+   * file stays mapped until the model is retrained, reloaded or destroyed.  A
+   * std::runtime_error is thrown if the file cannot be mapped, and a
+   * std::invalid_argument if it does not hold a valid model.  data::Load()
+   * calls this for files with the extension ".mmap".
+   *
+   * @param filename File to load the model from.
+   */
+  void LoadMapped(const std::string& filename);
+
   //! Return the number of distance evaluations performed.
   size_t DistanceEvaluations() const { return distanceEvaluations; }
   //! Modify the number of distance evaluations performed.
@@ -290,9 +381,12 @@ class LSHSearch
   //! Get the bucket size of the second hash.
   size_t BucketSize() const { return bucketSize; }
 
-  //! Get the second hash table.
-  const std::vector<arma::Col<size_t>>& SecondHashTable() const
-      { return secondHashTable; }
+  //! Get the first position of each bucket of the second hash table in
+  //! BucketPoints(), followed by the size of BucketPoints().
+  const arma::Col<size_t>& BucketOffsets() const { return bucketOffsets; }
+
+  //! Get the points of every bucket of the second hash table.
+  const arma::Col<size_t>& BucketPoints() const { return bucketPoints; }
 
   //! Get the projection tables.
   const arma::cube& Projections() { return projections; }
@@ -306,6 +400,56 @@ class LSHSearch
   }
 
  private:
+  /**
+   * Hash the query into the given number of tables, and compute the bucket of
+   * the second hash table of its primary bin and of its T additional probing
+   * bins in each table.
+   *
+   * @param queryPoint The query point.
+   * @param numTablesToSearch The number of tables to hash the query into.
+   * @param T The number of additional probing bins per table.
+   * @param hashMat Matrix to store the buckets in; row p holds the buckets of
+   *     probe p, and column i those of table i.
+   */
+  template<typename VecType>
+  void ProbingBins(const VecType& queryPoint,
+                   const size_t numTablesToSearch,
+                   const size_t T,
+                   arma::Mat<size_t>& hashMat) const;
+
+  /**
+   * Search for the neighbors of one query within the given probing budget, and
+   * store its neighbors, distances and statistics in the given column.
+   *
+   * @param queryPoint The query point.
+   * @param queryIndex The column to store the results of the query in.
+   * @param k Number of neighbors to search for.
+   * @param candidateTarget Number of distinct candidates after which probing
+   *     stops; if 0, there is no target.
+   * @param T Maximum number of additional probing bins per table.
+   * @param timeLimit Time (in seconds) after which probing stops; if 0, there
+   *     is no time limit.
+   * @param candidateMarks The generation in which each reference point was
+   *     last seen (see ReturnIndicesFromTable()).  Points marked with the
+   *     current generation before the call are never returned.
+   * @param generation The generation of this query.
+   * @param neighbors Matrix holding output neighbors.
+   * @param distances Matrix holding output distances.
+   * @param probeStatistics Matrix holding the statistics of each query.
+   */
+  template<typename VecType>
+  void AdaptiveBaseCase(const VecType& queryPoint,
+                        const size_t queryIndex,
+                        const size_t k,
+                        const size_t candidateTarget,
+                        const size_t T,
+                        const double timeLimit,
+                        std::vector<size_t>& candidateMarks,
+                        const size_t generation,
+                        arma::Mat<size_t>& neighbors,
+                        arma::mat& distances,
+                        arma::Mat<size_t>& probeStatistics) const;
+
   /**
    * This function takes a query and hashes it into each of the hash tables to
    * get keys for the query and then the key is hashed to a bucket of the second
@@ -320,12 +464,51 @@ class LSHSearch
    *    0, all tables are searched.
    * @param T The number of additional probing bins for multiprobe LSH. If 0,
    *    single-probe is used.
+   * @param candidateMarks The generation in which each reference point was
+   *    last returned; this must hold one element per reference point, and is
+   *    reused across the queries of a thread so that duplicates are discarded
+   *    without sorting the candidates.
+   * @param generation The generation of this query; it must be larger than
+   *    every element of candidateMarks.
    */
   template<typename VecType>
   void ReturnIndicesFromTable(const VecType& queryPoint,
                               arma::uvec& referenceIndices,
                               size_t numTablesToSearch,
-                              const size_t T) const;
+                              const size_t T,
+                              std::vector<size_t>& candidateMarks,
+                              const size_t generation) const;
+
+  /**
+   * Compute the distances between the query point and the given candidates.
+   * For dense data the candidates are gathered in blocks, so that the
+   * distances of a whole block are computed with vectorized operations.
+   *
+   * @param queryPoint The query point.
+   * @param referenceIndices The indices of the candidates.
+   * @param candidateDistances Vector to store the distances in.
+   */
+  template<typename VecType, typename RefMatType = MatType>
+  void CandidateDistances(
+      const VecType& queryPoint,
+      const arma::uvec& referenceIndices,
+      arma::vec& candidateDistances,
+      const std::enable_if_t<!arma::is_SpMat<RefMatType>::value>* = 0) const;
+
+  /**
+   * Compute the distances between the query point and the given candidates,
+   * one candidate at a time, for sparse data.
+   *
+   * @param queryPoint The query point.
+   * @param referenceIndices The indices of the candidates.
+   * @param candidateDistances Vector to store the distances in.
+   */
+  template<typename VecType, typename RefMatType = MatType>
+  void CandidateDistances(
+      const VecType& queryPoint,
+      const arma::uvec& referenceIndices,
+      arma::vec& candidateDistances,
+      const std::enable_if_t<arma::is_SpMat<RefMatType>::value>* = 0) const;
 
   /**
    * This is a helper function that computes the distance of the query to the
@@ -424,6 +607,119 @@ class LSHSearch
    */
   bool PerturbationValid(const std::vector<bool>& A) const;
 
+  /**
+   * Replace the reference set and the buckets by empty matrices and unmap the
+   * memory-mapped file, if any.  This must be called before these members are
+   * replaced, since they may alias the mapped memory.
+   */
+  void ReleaseMapped();
+
+  //! Destroy the given object and construct it again with the given
+  //! arguments.
+  template<typename T, typename... Args>
+  static void Reconstruct(T& object, Args&&... args)
+  {
+    object.~T();
+    new (&object) T(std::forward<Args>(args)...);
+  }
+
+  //! Make the given dense matrix an alias of the given memory.
+  static void MappedAlias(arma::mat& matrix,
+                          double* memory,
+                          const size_t rows,
+                          const size_t cols)
+  {
+    Reconstruct(matrix, memory, rows, cols, false, true);
+  }
+
+  //! Make the given vector hold the given 64-bit indices.  They are used in
+  //! place if size_t is 64 bits wide, and copied otherwise.
+  static void MappedIndices(arma::Col<size_t>& indices,
+                            uint64_t* memory,
+                            const size_t elements)
+  {
+    if (sizeof(size_t) == sizeof(uint64_t))
+    {
+      Reconstruct(indices, reinterpret_cast<size_t*>(memory), elements, false,
+          true);
+    }
+    else
+    {
+      Reconstruct(indices, elements);
+      for (size_t i = 0; i < elements; ++i)
+        indices[i] = (size_t) memory[i];
+    }
+  }
+
+  //! Write the given indices to the given stream as 64-bit integers.
+  static void WriteMappedIndices(std::ostream& stream,
+                                 const arma::Col<size_t>& indices)
+  {
+    if (sizeof(size_t) == sizeof(uint64_t))
+    {
+      stream.write(reinterpret_cast<const char*>(indices.memptr()),
+          indices.n_elem * sizeof(uint64_t));
+    }
+    else
+    {
+      const std::vector<uint64_t> converted(indices.begin(), indices.end());
+      stream.write(reinterpret_cast<const char*>(converted.data()),
+          converted.size() * sizeof(uint64_t));
+    }
+  }
+
+  //! Sparse matrices cannot alias memory-mapped data.
+  template<typename OtherMatType>
+  static void MappedAlias(OtherMatType& /* matrix */,
+                          double* /* memory */,
+                          const size_t /* rows */,
+                          const size_t /* cols */)
+  {
+    throw std::invalid_argument("LSHSearch::LoadMapped(): only models with "
+        "dense reference sets can be memory-mapped");
+  }
+
+  //! Get the memory of a dense matrix.
+  static const double* MappedMemory(const arma::mat& matrix)
+  {
+    return matrix.memptr();
+  }
+
+  //! Sparse matrices cannot be written to memory-mapped files.
+  template<typename OtherMatType>
+  static const double* MappedMemory(const OtherMatType& /* matrix */)
+  {
+    throw std::invalid_argument("LSHSearch::SaveMapped(): only models with "
+        "dense reference sets can be memory-mapped");
+  }
+
+  /**
+   * The header of a memory-mapped model file.  It is followed by the reference
+   * set, the projections, the offsets, the second hash weights, the bucket
+   * offsets and the bucket points.  Each section is aligned to 64 bytes, and
+   * all offsets are from the start of the file.
+   */
+  struct MappedHeader
+  {
+    char magic[8];
+    uint64_t version;
+    uint64_t dimensionality;
+    uint64_t points;
+    uint64_t numProj;
+    uint64_t numTables;
+    double hashWidth;
+    uint64_t secondHashSize;
+    uint64_t bucketSize;
+    uint64_t referenceOffset;
+    uint64_t projectionsOffset;
+    uint64_t offsetsOffset;
+    uint64_t weightsOffset;
+    uint64_t bucketOffsetsOffset;
+    uint64_t bucketPointsSize;
+    uint64_t bucketPointsOffset;
+    uint64_t size;
+  };
+
   //! Reference dataset.
   MatType referenceSet;
 
@@ -450,17 +746,19 @@ class LSHSearch
   //! The bucket size of the second hash.
   size_t bucketSize;
 
-  //! The final hash table; should be (< secondHashSize) vectors each with
-  //! (<= bucketSize) elements.
-  std::vector<arma::Col<size_t>> secondHashTable;
+  //! The first position of each bucket of the second hash table in
+  //! bucketPoints, followed by the number of elements of bucketPoints; the
+  //! points of bucket h are bucketPoints[bucketOffsets[h]] to
+  //! bucketPoints[bucketOffsets[h + 1] - 1].  Length secondHashSize + 1.
+  arma::Col<size_t> bucketOffsets;
 
-  //! The number of elements present in each hash bucket; should be
-  //! secondHashSize.
-  arma::Col<size_t> bucketContentSize;
+  //! The points of every bucket of the second hash table, one bucket after the
+  //! other, with no padding.
+  arma::Col<size_t> bucketPoints;
 
-  //! For a particular hash value, points to the row in secondHashTable
-  //! corresponding to this value. Length secondHashSize.
-  arma::Col<size_t> bucketRowInHashTable;
+  //! The memory-mapped file holding the reference set and the buckets, if the
+  //! model was loaded with LoadMapped().
+  std::shared_ptr<data::MappedFile> mappedFile;
 
   //! The number of distance evaluations.
   size_t distanceEvaluations;
@@ -484,6 +782,11 @@ class LSHSearch
 } // namespace neighbor
 } // namespace mlpack
 
+// Version 1 stores the buckets as packed offsets and points; version 0 stored
+// them in a padded table.
+CEREAL_TEMPLATE_CLASS_VERSION((template<typename SortPolicy, typename MatType>),
+    (mlpack::neighbor::LSHSearch<SortPolicy, MatType>), (1));
+
 // Include implementation.
 #include "lsh_search_impl.hpp"
 
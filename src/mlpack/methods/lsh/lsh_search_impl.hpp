@@ -15,6 +15,12 @@
 #include <mlpack/prereqs.hpp>
 #include <mlpack/core/math/random.hpp>
 
+#include <chrono>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace neighbor {
 
@@ -83,12 +89,11 @@ LSHSearch<SortPolicy, MatType>::LSHSearch(const LSHSearch& other) :
     secondHashSize(other.secondHashSize),
     secondHashWeights(other.secondHashWeights),
     bucketSize(other.bucketSize),
-    secondHashTable(other.secondHashTable),
-    bucketContentSize(other.bucketContentSize),
-    bucketRowInHashTable(other.bucketRowInHashTable),
+    bucketOffsets(other.bucketOffsets),
+    bucketPoints(other.bucketPoints),
     distanceEvaluations(other.distanceEvaluations)
 {
-  // Nothing to do.
+  // Nothing to do; the copied matrices never alias a mapped file.
 }
 
 // Move constructor.
@@ -103,9 +108,11 @@ LSHSearch<SortPolicy, MatType>::LSHSearch(LSHSearch&& other) :
     secondHashSize(other.secondHashSize),
     secondHashWeights(std::move(other.secondHashWeights)),
     bucketSize(other.bucketSize),
-    secondHashTable(std::move(other.secondHashTable)),
-    bucketContentSize(std::move(other.bucketContentSize)),
-    bucketRowInHashTable(std::move(other.bucketRowInHashTable)),
+    bucketOffsets(std::move(other.bucketOffsets)),
+    bucketPoints(std::move(other.bucketPoints)),
+    // The mapped file is shared, since the matrices of either model may alias
+    // it after the move.
+    mappedFile(other.mappedFile),
     distanceEvaluations(other.distanceEvaluations)
 {
   // Reset other model to defaults.
@@ -122,6 +129,10 @@ template<typename SortPolicy, typename MatType>
 LSHSearch<SortPolicy, MatType>& LSHSearch<SortPolicy, MatType>::operator=(
     const LSHSearch& other)
 {
+  if (this == &other)
+    return *this;
+
+  ReleaseMapped();
   referenceSet = other.referenceSet;
   numProj = other.numProj;
   numTables = other.numTables;
@@ -131,9 +142,8 @@ LSHSearch<SortPolicy, MatType>& LSHSearch<SortPolicy, MatType>::operator=(
   secondHashSize = other.secondHashSize;
   secondHashWeights = other.secondHashWeights;
   bucketSize = other.bucketSize;
-  secondHashTable = other.secondHashTable;
-  bucketContentSize = other.bucketContentSize;
-  bucketRowInHashTable = other.bucketRowInHashTable;
+  bucketOffsets = other.bucketOffsets;
+  bucketPoints = other.bucketPoints;
   distanceEvaluations = other.distanceEvaluations;
 
   return *this;
@@ -144,6 +154,10 @@ template<typename SortPolicy, typename MatType>
 LSHSearch<SortPolicy, MatType>& LSHSearch<SortPolicy, MatType>::operator=(
     LSHSearch&& other)
 {
+  if (this == &other)
+    return *this;
+
+  ReleaseMapped();
   referenceSet = std::move(other.referenceSet);
   numProj = other.numProj;
   numTables = other.numTables;
@@ -153,9 +167,9 @@ LSHSearch<SortPolicy, MatType>& LSHSearch<SortPolicy, MatType>::operator=(
   secondHashSize = other.secondHashSize;
   secondHashWeights = std::move(other.secondHashWeights);
   bucketSize = other.bucketSize;
-  secondHashTable = std::move(other.secondHashTable);
-  bucketContentSize = std::move(other.bucketContentSize);
-  bucketRowInHashTable = std::move(other.bucketRowInHashTable);
+  bucketOffsets = std::move(other.bucketOffsets);
+  bucketPoints = std::move(other.bucketPoints);
+  mappedFile = other.mappedFile;
   distanceEvaluations = other.distanceEvaluations;
 
   // Reset other model to defaults.
@@ -180,6 +194,7 @@ void LSHSearch<SortPolicy, MatType>::Train(MatType referenceSet,
                                            const arma::cube& projection)
 {
   // Set new reference set.
+  ReleaseMapped();
   this->referenceSet = std::move(referenceSet);
 
   // Set new parameters.
@@ -219,13 +234,6 @@ void LSHSearch<SortPolicy, MatType>::Train(MatType referenceSet,
   secondHashWeights = arma::floor(arma::randu(numProj) *
                                   (double) secondHashSize);
 
-  // Instead of putting the points in the row corresponding to the bucket, we
-  // chose the next empty row and keep track of the row in which the bucket
-  // lies. This allows us to stack together and slice out the empty buckets at
-  // the end of the hashing.
-  bucketRowInHashTable.set_size(secondHashSize);
-  bucketRowInHashTable.fill(secondHashSize);
-
   // Step II: The offsets for all projections in all tables.
   // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets'
   // as randu(numProj, numTables) * hashWidth.
@@ -254,11 +262,13 @@ void LSHSearch<SortPolicy, MatType>::Train(MatType referenceSet,
   }
 
   // We will store the second hash vectors in this matrix; the second hash
-  // vector for table i will be held in row i.  We have to use int and not
-  // size_t, otherwise negative numbers are cast to 0.
-  arma::Mat<size_t> secondHashVectors(numTables, this->referenceSet.n_cols);
+  // vector for table i will be held in column i, so that the tables can be
+  // hashed in parallel without sharing any memory.
+  const size_t numPoints = this->referenceSet.n_cols;
+  arma::Mat<size_t> secondHashVectors(numPoints, numTables);
 
-  for (size_t i = 0; i < numTables; ++i)
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t i = 0; i < (omp_size_t) numTables; ++i)
   {
     // Step IV: create the 'numProj'-dimensional key for each point in each
     // table.
@@ -271,10 +281,8 @@ void LSHSearch<SortPolicy, MatType>::Train(MatType referenceSet,
     // and the corresponding offset be 'offset_i'.  Then the key of a single
     // point is obtained as:
     // key = { floor((<proj_i, point> + offset_i) / 'hashWidth') forall i }
-    arma::mat offsetMat = arma::repmat(offsets.unsafe_col(i), 1,
-                                       this->referenceSet.n_cols);
     arma::mat hashMat = projections.slice(i).t() * (this->referenceSet);
-    hashMat += offsetMat;
+    hashMat.each_col() += offsets.col(i);
     hashMat /= hashWidth;
 
     // Step V: Putting the points in the 'secondHashTable' by hashing the key.
@@ -287,66 +295,90 @@ void LSHSearch<SortPolicy, MatType>::Train(MatType referenceSet,
       if (unmodVector[j] >= 0.0)
       {
         const size_t key = size_t(fmod(unmodVector[j], shs));
-        secondHashVectors(i, j) = key;
+        secondHashVectors(j, i) = key;
       }
       else
       {
         const double mod = fmod(-unmodVector[j], shs);
         const size_t key = (mod < 1.0) ? 0 : secondHashSize - size_t(mod);
-        secondHashVectors(i, j) = key;
+        secondHashVectors(j, i) = key;
       }
     }
   }
 
-  // Now, using the hash vectors for each table, count the number of rows we
-  // have in the second hash table.
-  arma::Row<size_t> secondHashBinCounts(secondHashSize, arma::fill::zeros);
-  for (size_t i = 0; i < secondHashVectors.n_elem; ++i)
-    secondHashBinCounts[secondHashVectors[i]]++;
+  // Now we fill the second hash table with a parallel counting sort: the
+  // (table, point) pairs are split into contiguous chunks, and each chunk
+  // first counts its points in every bucket.  A prefix sum over the chunks
+  // then gives each chunk its own range of every bucket, so the chunks can be
+  // placed without locks, and every bucket holds its points in the same
+  // (table-major) order as a sequential fill would.
+  #ifdef HAS_OPENMP
+  const size_t numChunks = omp_get_max_threads();
+  #else
+  const size_t numChunks = 1;
+  #endif
+  const size_t numEntries = secondHashVectors.n_elem;
+
+  arma::Mat<size_t> chunkPositions(secondHashSize, numChunks,
+      arma::fill::zeros);
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t c = 0; c < (omp_size_t) numChunks; ++c)
+  {
+    const size_t begin = (c * numEntries) / numChunks;
+    const size_t end = ((c + 1) * numEntries) / numChunks;
+    for (size_t e = begin; e < end; ++e)
+      chunkPositions(secondHashVectors[e], c)++;
+  }
 
-  // Enforce the maximum bucket size.
+  // Turn the counts into the first position of each chunk in each bucket, and
+  // count the number of points in each bucket.
+  arma::Row<size_t> secondHashBinCounts(secondHashSize);
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t h = 0; h < (omp_size_t) secondHashSize; ++h)
+  {
+    size_t total = 0;
+    for (size_t c = 0; c < numChunks; ++c)
+    {
+      const size_t count = chunkPositions(h, c);
+      chunkPositions(h, c) = total;
+      total += count;
+    }
+    secondHashBinCounts[h] = total;
+  }
+
+  // Enforce the maximum bucket size, if any.  The buckets are packed one after
+  // the other, so they take no more space than the points they hold.
   const size_t effectiveBucketSize = (bucketSize == 0) ? SIZE_MAX : bucketSize;
   secondHashBinCounts.transform([effectiveBucketSize](size_t val)
       { return std::min(val, effectiveBucketSize); });
 
-  const size_t numRowsInTable = arma::accu(secondHashBinCounts > 0);
-  bucketContentSize.zeros(numRowsInTable);
-  secondHashTable.resize(numRowsInTable);
+  bucketOffsets.set_size(secondHashSize + 1);
+  bucketOffsets[0] = 0;
+  for (size_t h = 0; h < secondHashSize; ++h)
+    bucketOffsets[h + 1] = bucketOffsets[h] + secondHashBinCounts[h];
+  bucketPoints.set_size(bucketOffsets[secondHashSize]);
 
-  // Next we must assign each point in each table to the right second hash
-  // table.
-  size_t currentRow = 0;
-  for (size_t i = 0; i < numTables; ++i)
+  // Next we must place each point of each table in its bucket.  Points beyond
+  // the maximum bucket size are dropped.
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t c = 0; c < (omp_size_t) numChunks; ++c)
   {
-    // Insert the point in the corresponding row to its bucket in the
-    // 'secondHashTable'.
-    for (size_t j = 0; j < secondHashVectors.n_cols; ++j)
+    const size_t begin = (c * numEntries) / numChunks;
+    const size_t end = ((c + 1) * numEntries) / numChunks;
+    for (size_t e = begin; e < end; ++e)
     {
-      // This is the bucket number.
-      size_t hashInd = (size_t) secondHashVectors(i, j);
-      // The point ID is 'j'.
-
-      // If this is currently an empty bucket, start a new row keep track of
-      // which row corresponds to the bucket.
-      const size_t maxSize = secondHashBinCounts[hashInd];
-      if (bucketRowInHashTable[hashInd] == secondHashSize)
-      {
-        bucketRowInHashTable[hashInd] = currentRow;
-        secondHashTable[currentRow].set_size(maxSize);
-        currentRow++;
-      }
+      // This is the bucket number; the point ID is e % numPoints.
+      const size_t hashInd = secondHashVectors[e];
+      const size_t position = chunkPositions(hashInd, c)++;
+      if (position < secondHashBinCounts[hashInd])
+        bucketPoints[bucketOffsets[hashInd] + position] = e % numPoints;
+    }
+  }
 
-      // If this vector in the hash table is not full, add the point.
-      const size_t index = bucketRowInHashTable[hashInd];
-      if (bucketContentSize[index] < maxSize)
-        secondHashTable[index](bucketContentSize[index]++) = j;
-    } // Loop over all points in the reference set.
-  } // Loop over tables.
-
-  Log::Info << "Final hash table size: " << numRowsInTable << " rows, with a "
-            << "maximum length of " << arma::max(secondHashBinCounts) << ", "
-            << "totaling " << arma::accu(secondHashBinCounts) << " elements."
-            << std::endl;
+  const size_t numRowsInTable = arma::accu(secondHashBinCounts > 0);
+  Log::Info << "Final hash table size: " << numRowsInTable << " buckets, with "
+            << "a maximum length of " << arma::max(secondHashBinCounts) << ", "
+            << "totaling " << bucketPoints.n_elem << " elements." << std::endl;
 }
 
 // Base case where the query set is the reference set.  (So, we can't return
@@ -368,6 +400,10 @@ void LSHSearch<SortPolicy, MatType>::BaseCase(
   std::vector<Candidate> vect(k, def);
   CandidateList pqueue(CandidateCmp(), std::move(vect));
 
+  arma::vec candidateDistances;
+  CandidateDistances(referenceSet.col(queryIndex), referenceIndices,
+      candidateDistances);
+
   for (size_t j = 0; j < referenceIndices.n_elem; ++j)
   {
     const size_t referenceIndex = referenceIndices[j];
@@ -375,11 +411,7 @@ void LSHSearch<SortPolicy, MatType>::BaseCase(
     if (queryIndex == referenceIndex)
       continue;
 
-    const double distance = metric::EuclideanDistance::Evaluate(
-        referenceSet.col(queryIndex),
-        referenceSet.col(referenceIndex));
-
-    Candidate c = std::make_pair(distance, referenceIndex);
+    Candidate c = std::make_pair(candidateDistances[j], referenceIndex);
     // If this distance is better than the worst candidate, let's insert it.
     if (CandidateCmp()(c, pqueue.top()))
     {
@@ -415,14 +447,13 @@ void LSHSearch<SortPolicy, MatType>::BaseCase(
   std::vector<Candidate> vect(k, def);
   CandidateList pqueue(CandidateCmp(), std::move(vect));
 
+  arma::vec candidateDistances;
+  CandidateDistances(querySet.col(queryIndex), referenceIndices,
+      candidateDistances);
+
   for (size_t j = 0; j < referenceIndices.n_elem; ++j)
   {
-    const size_t referenceIndex = referenceIndices[j];
-    const double distance = metric::EuclideanDistance::Evaluate(
-        querySet.col(queryIndex),
-        referenceSet.col(referenceIndex));
-
-    Candidate c = std::make_pair(distance, referenceIndex);
+    Candidate c = std::make_pair(candidateDistances[j], referenceIndices[j]);
     // If this distance is better than the worst candidate, let's insert it.
     if (CandidateCmp()(c, pqueue.top()))
     {
@@ -439,6 +470,50 @@ void LSHSearch<SortPolicy, MatType>::BaseCase(
   }
 }
 
+// Compute the distances to a set of candidates, in blocks for dense data.
+template<typename SortPolicy, typename MatType>
+template<typename VecType, typename RefMatType>
+void LSHSearch<SortPolicy, MatType>::CandidateDistances(
+    const VecType& queryPoint,
+    const arma::uvec& referenceIndices,
+    arma::vec& candidateDistances,
+    const std::enable_if_t<!arma::is_SpMat<RefMatType>::value>*) const
+{
+  candidateDistances.set_size(referenceIndices.n_elem);
+
+  // The candidates are gathered into a contiguous block that is small enough
+  // to stay in cache, and the distances of the whole block are computed at
+  // once.
+  const size_t blockSize = 256;
+  arma::mat block;
+  for (size_t begin = 0; begin < referenceIndices.n_elem; begin += blockSize)
+  {
+    const size_t end = std::min(begin + blockSize,
+        (size_t) referenceIndices.n_elem);
+    block = referenceSet.cols(referenceIndices.subvec(begin, end - 1));
+    block.each_col() -= queryPoint;
+    candidateDistances.subvec(begin, end - 1) =
+        arma::sqrt(arma::sum(arma::square(block), 0)).t();
+  }
+}
+
+// Compute the distances to a set of candidates, one at a time for sparse data.
+template<typename SortPolicy, typename MatType>
+template<typename VecType, typename RefMatType>
+void LSHSearch<SortPolicy, MatType>::CandidateDistances(
+    const VecType& queryPoint,
+    const arma::uvec& referenceIndices,
+    arma::vec& candidateDistances,
+    const std::enable_if_t<arma::is_SpMat<RefMatType>::value>*) const
+{
+  candidateDistances.set_size(referenceIndices.n_elem);
+  for (size_t j = 0; j < referenceIndices.n_elem; ++j)
+  {
+    candidateDistances[j] = metric::EuclideanDistance::Evaluate(queryPoint,
+        referenceSet.col(referenceIndices[j]));
+  }
+}
+
 template<typename SortPolicy, typename MatType>
 inline force_inline
 double LSHSearch<SortPolicy, MatType>::PerturbationScore(
@@ -704,21 +779,12 @@ void LSHSearch<SortPolicy, MatType>::GetAdditionalProbingBins(
 
 template<typename SortPolicy, typename MatType>
 template<typename VecType>
-void LSHSearch<SortPolicy, MatType>::ReturnIndicesFromTable(
+void LSHSearch<SortPolicy, MatType>::ProbingBins(
     const VecType& queryPoint,
-    arma::uvec& referenceIndices,
-    size_t numTablesToSearch,
-    const size_t T) const
+    const size_t numTablesToSearch,
+    const size_t T,
+    arma::Mat<size_t>& hashMat) const
 {
-  // Decide on the number of tables to look into.
-  if (numTablesToSearch == 0) // If no user input is given, search all.
-    numTablesToSearch = numTables;
-
-  // Sanity check to make sure that the existing number of tables is not
-  // exceeded.
-  if (numTablesToSearch > numTables)
-    numTablesToSearch = numTables;
-
   // Hash the query in each of the 'numTablesToSearch' hash tables using the
   // 'numProj' projections for each table. This gives us 'numTablesToSearch'
   // keys for the query where each key is a 'numProj' dimensional integer
@@ -733,9 +799,6 @@ void LSHSearch<SortPolicy, MatType>::ReturnIndicesFromTable(
   queryCodesNotFloored += offsets.cols(0, numTablesToSearch - 1);
   allProjInTables = arma::floor(queryCodesNotFloored / hashWidth);
 
-  // Use hashMat to store the primary probing codes and any additional codes
-  // from multiprobe LSH.
-  arma::Mat<size_t> hashMat;
   hashMat.set_size(T + 1, numTablesToSearch);
 
   // Compute the primary hash value of each key of the query into a bucket of
@@ -767,6 +830,31 @@ void LSHSearch<SortPolicy, MatType>::ReturnIndicesFromTable(
         hashMat(p, i) = (hashMat(p, i) % secondHashSize);
     }
   }
+}
+
+template<typename SortPolicy, typename MatType>
+template<typename VecType>
+void LSHSearch<SortPolicy, MatType>::ReturnIndicesFromTable(
+    const VecType& queryPoint,
+    arma::uvec& referenceIndices,
+    size_t numTablesToSearch,
+    const size_t T,
+    std::vector<size_t>& candidateMarks,
+    const size_t generation) const
+{
+  // Decide on the number of tables to look into.
+  if (numTablesToSearch == 0) // If no user input is given, search all.
+    numTablesToSearch = numTables;
+
+  // Sanity check to make sure that the existing number of tables is not
+  // exceeded.
+  if (numTablesToSearch > numTables)
+    numTablesToSearch = numTables;
+
+  // Use hashMat to store the primary probing codes and any additional codes
+  // from multiprobe LSH.
+  arma::Mat<size_t> hashMat;
+  ProbingBins(queryPoint, numTablesToSearch, T, hashMat);
 
   // Count number of points hashed in the same bucket as the query.
   size_t maxNumPoints = 0;
@@ -775,83 +863,133 @@ void LSHSearch<SortPolicy, MatType>::ReturnIndicesFromTable(
     for (size_t p = 0; p < T + 1; ++p)
     {
       const size_t hashInd = hashMat(p, i); // find query's bucket
-      const size_t tableRow = bucketRowInHashTable[hashInd];
-      if (tableRow < secondHashSize)
-        maxNumPoints += bucketContentSize[tableRow]; // count bucket contents
+      // Count bucket contents.
+      maxNumPoints += bucketOffsets[hashInd + 1] - bucketOffsets[hashInd];
     }
   }
 
-  // There are two ways to proceed here:
-  // Either allocate a maxNumPoints-size vector, place all candidates, and run
-  // unique on the vector to discard duplicates.
-  // Or allocate a referenceSet.n_cols size vector (i.e. number of reference
-  // points) of zeros, and mark found indices as 1.
-  // Option 1 runs faster for small maxNumPoints but worse for larger values, so
-  // we choose based on a heuristic.
-  const float cutoff = 0.1;
-  const float selectivity = static_cast<float>(maxNumPoints) /
-      static_cast<float>(referenceSet.n_cols);
-
-  if (selectivity > cutoff)
+  // Collect the points of every bucket, and keep only the first copy of each
+  // point: a point is new if it has not been marked in this generation yet.
+  // This avoids sorting the candidates, and the marks never need to be reset.
+  referenceIndices.set_size(std::min(maxNumPoints,
+      (size_t) referenceSet.n_cols));
+  size_t numCandidates = 0;
+  for (size_t i = 0; i < numTablesToSearch; ++i) // For all tables.
   {
-    // Heuristic: larger maxNumPoints means we should use find() because it
-    // should be faster.
-    // Reference points hashed in the same bucket as the query are set to >0.
-    arma::Col<size_t> refPointsConsidered;
-    refPointsConsidered.zeros(referenceSet.n_cols);
-
-    for (size_t i = 0; i < numTablesToSearch; ++i) // for all tables
+    for (size_t p = 0; p < T + 1; ++p) // For entire probing sequence.
     {
-      for (size_t p = 0; p < T + 1; ++p) // For entire probing sequence.
+      const size_t hashInd = hashMat(p, i); // Find the query's bucket.
+      for (size_t j = bucketOffsets[hashInd]; j < bucketOffsets[hashInd + 1];
+           ++j)
       {
-        // get the sequence code
-        size_t hashInd = hashMat(p, i);
-        size_t tableRow = bucketRowInHashTable[hashInd];
-
-        if (tableRow < secondHashSize && bucketContentSize[tableRow] > 0)
+        const size_t index = bucketPoints[j];
+        if (candidateMarks[index] != generation)
         {
-          // Pick the indices in the bucket corresponding to hashInd.
-          for (size_t j = 0; j < bucketContentSize[tableRow]; ++j)
-            refPointsConsidered[ secondHashTable[tableRow](j) ]++;
+          candidateMarks[index] = generation;
+          referenceIndices[numCandidates++] = index;
         }
       }
     }
-
-    // Only keep reference points found in at least one bucket.
-    referenceIndices = arma::find(refPointsConsidered > 0);
-    return;
   }
-  else
-  {
-    // Heuristic: smaller maxNumPoints means we should use unique() because it
-    // should be faster.
-    // Allocate space for the query's potential neighbors.
-    arma::uvec refPointsConsideredSmall;
-    refPointsConsideredSmall.zeros(maxNumPoints);
 
-    // Retrieve candidates.
-    size_t start = 0;
+  referenceIndices.resize(numCandidates);
+}
+
+// Search for the neighbors of one query within a probing budget.
+template<typename SortPolicy, typename MatType>
+template<typename VecType>
+void LSHSearch<SortPolicy, MatType>::AdaptiveBaseCase(
+    const VecType& queryPoint,
+    const size_t queryIndex,
+    const size_t k,
+    const size_t candidateTarget,
+    const size_t T,
+    const double timeLimit,
+    std::vector<size_t>& candidateMarks,
+    const size_t generation,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances,
+    arma::Mat<size_t>& probeStatistics) const
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point deadline = Clock::now() +
+      std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(timeLimit));
+
+  arma::Mat<size_t> hashMat;
+  ProbingBins(queryPoint, numTables, T, hashMat);
+
+  const Candidate def = std::make_pair(SortPolicy::WorstDistance(),
+      referenceSet.n_cols);
+  std::vector<Candidate> vect(k, def);
+  CandidateList pqueue(CandidateCmp(), std::move(vect));
+
+  size_t probes = 0;
+  size_t scanned = 0;
+  size_t evaluations = 0;
+  arma::uvec newIndices;
+  arma::vec newDistances;
 
-    for (size_t i = 0; i < numTablesToSearch; ++i) // For all tables
+  // Probe the p'th bin of every table before the (p + 1)'th bin of any table,
+  // since the bins of each table are sorted by likelihood.
+  bool stop = false;
+  for (size_t p = 0; p < T + 1 && !stop; ++p)
+  {
+    for (size_t i = 0; i < numTables && !stop; ++i)
     {
-      for (size_t p = 0; p < T + 1; ++p)
+      ++probes;
+      const size_t hashInd = hashMat(p, i);
+      const size_t begin = bucketOffsets[hashInd];
+      const size_t contentSize = bucketOffsets[hashInd + 1] - begin;
+
+      // Only the candidates that have not been seen yet are evaluated.
+      newIndices.set_size(contentSize);
+      size_t numNew = 0;
+      for (size_t j = begin; j < begin + contentSize; ++j)
+      {
+        const size_t index = bucketPoints[j];
+        if (candidateMarks[index] != generation)
+        {
+          candidateMarks[index] = generation;
+          newIndices[numNew++] = index;
+        }
+      }
+      scanned += contentSize;
+
+      if (numNew > 0)
       {
-        const size_t hashInd =  hashMat(p, i); // Find the query's bucket.
-        const size_t tableRow = bucketRowInHashTable[hashInd];
+        newIndices.resize(numNew);
+        CandidateDistances(queryPoint, newIndices, newDistances);
+        evaluations += numNew;
 
-        if (tableRow < secondHashSize)
+        for (size_t j = 0; j < numNew; ++j)
         {
-          // Store all secondHashTable points in the candidates set.
-          for (size_t j = 0; j < bucketContentSize[tableRow]; ++j)
-            refPointsConsideredSmall(start++) = secondHashTable[tableRow](j);
-       }
+          Candidate c = std::make_pair(newDistances[j], newIndices[j]);
+          // If this distance is better than the worst candidate, let's insert
+          // it.
+          if (CandidateCmp()(c, pqueue.top()))
+          {
+            pqueue.pop();
+            pqueue.push(c);
+          }
+        }
       }
+
+      stop = (candidateTarget > 0 && evaluations >= candidateTarget) ||
+          (timeLimit > 0.0 && Clock::now() >= deadline);
     }
+  }
 
-    // Keep only one copy of each candidate.
-    referenceIndices = arma::unique(refPointsConsideredSmall);
-    return;
+  for (size_t j = 1; j <= k; ++j)
+  {
+    neighbors(k - j, queryIndex) = pqueue.top().second;
+    distances(k - j, queryIndex) = pqueue.top().first;
+    pqueue.pop();
   }
+
+  probeStatistics(0, queryIndex) = probes;
+  probeStatistics(1, queryIndex) = scanned;
+  probeStatistics(2, queryIndex) = evaluations;
 }
 
 // Search for nearest neighbors in a given query set.
@@ -912,28 +1050,31 @@ void LSHSearch<SortPolicy, MatType>::Search(
   Timer::Start("computing_neighbors");
 
   // Parallelization to process more than one query at a time.
-  #pragma omp parallel for \
-      shared(resultingNeighbors, distances) \
-      schedule(dynamic)\
+  #pragma omp parallel shared(resultingNeighbors, distances) \
       reduction(+:avgIndicesReturned)
-  for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
   {
-    // Go through every query point.
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(querySet.col(i), refIndices, numTablesToSearch,
-        Teffective);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    // Make atomic to avoid race conditions when multiple threads are running
-    // #pragma omp atomic
-    avgIndicesReturned = avgIndicesReturned + refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    BaseCase(i, refIndices, k, querySet, resultingNeighbors, distances);
+    // Each thread marks the candidates of its current query with a new
+    // generation, to discard duplicate candidates.
+    std::vector<size_t> candidateMarks(referenceSet.n_cols, 0);
+    size_t generation = 0;
+
+    #pragma omp for schedule(dynamic)
+    for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+    {
+      // Go through every query point.
+      // Hash every query into every hash table and eventually into the
+      // 'secondHashTable' to obtain the neighbor candidates.
+      arma::uvec refIndices;
+      ReturnIndicesFromTable(querySet.col(i), refIndices, numTablesToSearch,
+          Teffective, candidateMarks, ++generation);
+
+      // An informative book-keeping for the number of neighbor candidates
+      // returned on average.
+      avgIndicesReturned += refIndices.n_elem;
+
+      // Go through all the candidates and save the best 'k' candidates.
+      BaseCase(i, refIndices, k, querySet, resultingNeighbors, distances);
+    }
   }
 
   Timer::Stop("computing_neighbors");
@@ -978,28 +1119,31 @@ Search(const size_t k,
   Timer::Start("computing_neighbors");
 
   // Parallelization to process more than one query at a time.
-  #pragma omp parallel for \
-      shared(resultingNeighbors, distances) \
-      schedule(dynamic)\
+  #pragma omp parallel shared(resultingNeighbors, distances) \
       reduction(+:avgIndicesReturned)
-  for (omp_size_t i = 0; i < (omp_size_t) referenceSet.n_cols; ++i)
   {
-    // Go through every query point.
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(referenceSet.col(i), refIndices, numTablesToSearch,
-        Teffective);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    // Make atomic to avoid race conditions when multiple threads are running.
-    // #pragma omp atomic
-    avgIndicesReturned += refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    BaseCase(i, refIndices, k, resultingNeighbors, distances);
+    // Each thread marks the candidates of its current query with a new
+    // generation, to discard duplicate candidates.
+    std::vector<size_t> candidateMarks(referenceSet.n_cols, 0);
+    size_t generation = 0;
+
+    #pragma omp for schedule(dynamic)
+    for (omp_size_t i = 0; i < (omp_size_t) referenceSet.n_cols; ++i)
+    {
+      // Go through every query point.
+      // Hash every query into every hash table and eventually into the
+      // 'secondHashTable' to obtain the neighbor candidates.
+      arma::uvec refIndices;
+      ReturnIndicesFromTable(referenceSet.col(i), refIndices,
+          numTablesToSearch, Teffective, candidateMarks, ++generation);
+
+      // An informative book-keeping for the number of neighbor candidates
+      // returned on average.
+      avgIndicesReturned += refIndices.n_elem;
+
+      // Go through all the candidates and save the best 'k' candidates.
+      BaseCase(i, refIndices, k, resultingNeighbors, distances);
+    }
   }
 
   Timer::Stop("computing_neighbors");
@@ -1010,6 +1154,144 @@ Search(const size_t k,
       std::endl;
 }
 
+// Search for nearest neighbors in a given query set, with a probing budget.
+template<typename SortPolicy, typename MatType>
+void LSHSearch<SortPolicy, MatType>::AdaptiveSearch(
+    const MatType& querySet,
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    arma::Mat<size_t>& probeStatistics,
+    const size_t candidateTarget,
+    const size_t T,
+    const double timeLimit)
+{
+  // Ensure the dimensionality of the query set is correct.
+  if (querySet.n_rows != referenceSet.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::AdaptiveSearch(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality the model "
+        << "was trained on (" << referenceSet.n_rows << ")!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (k > referenceSet.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::AdaptiveSearch(): requested " << k << " approximate "
+        << "nearest neighbors, but reference set has " << referenceSet.n_cols
+        << " points!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (timeLimit < 0.0)
+  {
+    throw std::invalid_argument("LSHSearch::AdaptiveSearch(): the time limit "
+        "must not be negative");
+  }
+
+  resultingNeighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+  probeStatistics.zeros(3, querySet.n_cols);
+
+  // The probing sequence of a table holds at most 2^numProj - 1 additional
+  // bins.
+  size_t Teffective = T;
+  if (T > ((size_t) ((1 << numProj) - 1)))
+    Teffective = (1 << numProj) - 1;
+
+  size_t totalEvaluations = 0;
+
+  Timer::Start("computing_neighbors");
+
+  #pragma omp parallel shared(resultingNeighbors, distances, probeStatistics) \
+      reduction(+:totalEvaluations)
+  {
+    std::vector<size_t> candidateMarks(referenceSet.n_cols, 0);
+    size_t generation = 0;
+
+    #pragma omp for schedule(dynamic)
+    for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+    {
+      AdaptiveBaseCase(querySet.col(i), i, k, candidateTarget, Teffective,
+          timeLimit, candidateMarks, ++generation, resultingNeighbors,
+          distances, probeStatistics);
+      totalEvaluations += probeStatistics(2, i);
+    }
+  }
+
+  Timer::Stop("computing_neighbors");
+
+  distanceEvaluations += totalEvaluations;
+}
+
+// Search for approximate neighbors of the reference set, with a probing budget.
+template<typename SortPolicy, typename MatType>
+void LSHSearch<SortPolicy, MatType>::AdaptiveSearch(
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    arma::Mat<size_t>& probeStatistics,
+    const size_t candidateTarget,
+    const size_t T,
+    const double timeLimit)
+{
+  // Each point is not its own neighbor, so there are only n_cols - 1 other
+  // points to return.
+  if (k >= referenceSet.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::AdaptiveSearch(): requested " << k << " approximate "
+        << "nearest neighbors, but reference set has " << referenceSet.n_cols
+        << " points (including the query point itself)!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (timeLimit < 0.0)
+  {
+    throw std::invalid_argument("LSHSearch::AdaptiveSearch(): the time limit "
+        "must not be negative");
+  }
+
+  resultingNeighbors.set_size(k, referenceSet.n_cols);
+  distances.set_size(k, referenceSet.n_cols);
+  probeStatistics.zeros(3, referenceSet.n_cols);
+
+  // The probing sequence of a table holds at most 2^numProj - 1 additional
+  // bins.
+  size_t Teffective = T;
+  if (T > ((size_t) ((1 << numProj) - 1)))
+    Teffective = (1 << numProj) - 1;
+
+  size_t totalEvaluations = 0;
+
+  Timer::Start("computing_neighbors");
+
+  #pragma omp parallel shared(resultingNeighbors, distances, probeStatistics) \
+      reduction(+:totalEvaluations)
+  {
+    std::vector<size_t> candidateMarks(referenceSet.n_cols, 0);
+    size_t generation = 0;
+
+    #pragma omp for schedule(dynamic)
+    for (omp_size_t i = 0; i < (omp_size_t) referenceSet.n_cols; ++i)
+    {
+      // Mark the query itself, so that it is not returned as its own
+      // neighbor.
+      candidateMarks[i] = ++generation;
+      AdaptiveBaseCase(referenceSet.col(i), i, k, candidateTarget, Teffective,
+          timeLimit, candidateMarks, generation, resultingNeighbors,
+          distances, probeStatistics);
+      totalEvaluations += probeStatistics(2, i);
+    }
+  }
+
+  Timer::Stop("computing_neighbors");
+
+  distanceEvaluations += totalEvaluations;
+}
+
 template<typename SortPolicy, typename MatType>
 double LSHSearch<SortPolicy, MatType>::ComputeRecall(
     const arma::Mat<size_t>& foundNeighbors,
@@ -1040,8 +1322,12 @@ double LSHSearch<SortPolicy, MatType>::ComputeRecall(
 template<typename SortPolicy, typename MatType>
 template<typename Archive>
 void LSHSearch<SortPolicy, MatType>::serialize(Archive& ar,
-                                               const uint32_t /* version */)
+                                               const uint32_t version)
 {
+  // The loaded matrices must not alias a mapped file.
+  if (cereal::is_loading<Archive>())
+    ReleaseMapped();
+
   ar(CEREAL_NVP(referenceSet));
   ar(CEREAL_NVP(numProj));
   ar(CEREAL_NVP(numTables));
@@ -1056,12 +1342,249 @@ void LSHSearch<SortPolicy, MatType>::serialize(Archive& ar,
   ar(CEREAL_NVP(secondHashSize));
   ar(CEREAL_NVP(secondHashWeights));
   ar(CEREAL_NVP(bucketSize));
-  ar(CEREAL_NVP(secondHashTable));
-  ar(CEREAL_NVP(bucketContentSize));
-  ar(CEREAL_NVP(bucketRowInHashTable));
+
+  if (version == 0)
+  {
+    // Older models (only ever loaded) hold the buckets in a padded table: each
+    // used bucket has a row of secondHashTable, and bucketRowInHashTable maps
+    // each hash value to its row (or to secondHashSize if the bucket is empty).
+    std::vector<arma::Col<size_t>> secondHashTable;
+    arma::Col<size_t> bucketContentSize;
+    arma::Col<size_t> bucketRowInHashTable;
+    ar(CEREAL_NVP(secondHashTable));
+    ar(CEREAL_NVP(bucketContentSize));
+    ar(CEREAL_NVP(bucketRowInHashTable));
+
+    if (bucketRowInHashTable.n_elem != secondHashSize ||
+        bucketContentSize.n_elem != secondHashTable.size())
+    {
+      throw std::invalid_argument("LSHSearch::serialize(): the hash table of "
+          "the model is corrupt");
+    }
+
+    // Convert the table to the packed offsets and points.
+    bucketOffsets.zeros(secondHashSize + 1);
+    for (size_t h = 0; h < secondHashSize; ++h)
+    {
+      const size_t row = bucketRowInHashTable[h];
+      if (row < secondHashTable.size())
+      {
+        if (bucketContentSize[row] > secondHashTable[row].n_elem)
+        {
+          throw std::invalid_argument("LSHSearch::serialize(): the hash table "
+              "of the model is corrupt");
+        }
+        bucketOffsets[h + 1] = bucketContentSize[row];
+      }
+    }
+    bucketOffsets = arma::cumsum(bucketOffsets);
+
+    bucketPoints.set_size(bucketOffsets[secondHashSize]);
+    for (size_t h = 0; h < secondHashSize; ++h)
+    {
+      const size_t row = bucketRowInHashTable[h];
+      for (size_t j = bucketOffsets[h]; j < bucketOffsets[h + 1]; ++j)
+        bucketPoints[j] = secondHashTable[row][j - bucketOffsets[h]];
+    }
+  }
+  else
+  {
+    ar(CEREAL_NVP(bucketOffsets));
+    ar(CEREAL_NVP(bucketPoints));
+  }
+
   ar(CEREAL_NVP(distanceEvaluations));
 }
 
+template<typename SortPolicy, typename MatType>
+void LSHSearch<SortPolicy, MatType>::SaveMapped(
+    const std::string& filename) const
+{
+  const double* referenceMemory = MappedMemory(referenceSet);
+
+  MappedHeader header;
+  std::memset(&header, 0, sizeof(MappedHeader));
+  std::memcpy(header.magic, "MLPKLSH", 8);
+  header.version = 1;
+  header.dimensionality = referenceSet.n_rows;
+  header.points = referenceSet.n_cols;
+  header.numProj = numProj;
+  header.numTables = numTables;
+  header.hashWidth = hashWidth;
+  header.secondHashSize = secondHashSize;
+  header.bucketSize = bucketSize;
+  header.referenceOffset = data::MappedAlign(sizeof(MappedHeader));
+  header.projectionsOffset = data::MappedAlign(header.referenceOffset +
+      referenceSet.n_elem * sizeof(double));
+  header.offsetsOffset = data::MappedAlign(header.projectionsOffset +
+      projections.n_elem * sizeof(double));
+  header.weightsOffset = data::MappedAlign(header.offsetsOffset +
+      offsets.n_elem * sizeof(double));
+  header.bucketOffsetsOffset = data::MappedAlign(header.weightsOffset +
+      secondHashWeights.n_elem * sizeof(double));
+  header.bucketPointsSize = bucketPoints.n_elem;
+  header.bucketPointsOffset = data::MappedAlign(header.bucketOffsetsOffset +
+      bucketOffsets.n_elem * sizeof(uint64_t));
+  header.size = header.bucketPointsOffset +
+      bucketPoints.n_elem * sizeof(uint64_t);
+
+  if (projections.n_elem != referenceSet.n_rows * numProj * numTables ||
+      bucketOffsets.n_elem != secondHashSize + 1)
+  {
+    throw std::invalid_argument("LSHSearch::SaveMapped(): the model is not "
+        "trained");
+  }
+
+  std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
+  if (!ofs.is_open())
+    throw std::runtime_error("unable to open file '" + filename + "'");
+
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(MappedHeader));
+  size_t position = data::MappedPad(ofs, sizeof(MappedHeader));
+  ofs.write(reinterpret_cast<const char*>(referenceMemory),
+      referenceSet.n_elem * sizeof(double));
+  position = data::MappedPad(ofs, position +
+      referenceSet.n_elem * sizeof(double));
+  ofs.write(reinterpret_cast<const char*>(projections.memptr()),
+      projections.n_elem * sizeof(double));
+  position = data::MappedPad(ofs, position +
+      projections.n_elem * sizeof(double));
+  ofs.write(reinterpret_cast<const char*>(offsets.memptr()),
+      offsets.n_elem * sizeof(double));
+  position = data::MappedPad(ofs, position + offsets.n_elem * sizeof(double));
+  ofs.write(reinterpret_cast<const char*>(secondHashWeights.memptr()),
+      secondHashWeights.n_elem * sizeof(double));
+  position = data::MappedPad(ofs, position +
+      secondHashWeights.n_elem * sizeof(double));
+  // The buckets are written as 64-bit integers, whatever the width of size_t.
+  WriteMappedIndices(ofs, bucketOffsets);
+  data::MappedPad(ofs, position + bucketOffsets.n_elem * sizeof(uint64_t));
+  WriteMappedIndices(ofs, bucketPoints);
+}
+
+template<typename SortPolicy, typename MatType>
+void LSHSearch<SortPolicy, MatType>::LoadMapped(const std::string& filename)
+{
+  if (!std::is_same<MatType, arma::mat>::value)
+  {
+    throw std::invalid_argument("LSHSearch::LoadMapped(): only models with "
+        "dense reference sets can be memory-mapped");
+  }
+
+  std::shared_ptr<data::MappedFile> file(new data::MappedFile(filename));
+  const size_t size = file->Size();
+
+  MappedHeader header;
+  if (size < sizeof(MappedHeader))
+    throw std::invalid_argument("file is too small to hold a model");
+  std::memcpy(&header, file->Data(), sizeof(MappedHeader));
+
+  if (std::memcmp(header.magic, "MLPKLSH", 8) != 0 || header.version != 1)
+  {
+    throw std::invalid_argument("file does not hold a memory-mapped model of a "
+        "supported version");
+  }
+
+  // Check every section before anything is used, without overflowing.
+  auto product = [](const uint64_t x, const uint64_t y, uint64_t& result)
+  {
+    result = x * y;
+    return (x == 0 || result / x == y);
+  };
+  auto fits = [](const uint64_t begin, const uint64_t end,
+                 const uint64_t count, const uint64_t elemSize)
+  {
+    return (begin <= end && count <= (end - begin) / elemSize);
+  };
+
+  uint64_t referenceElements, offsetElements, projectionElements;
+  if (!product(header.dimensionality, header.points, referenceElements) ||
+      !product(header.numProj, header.numTables, offsetElements) ||
+      !product(header.dimensionality, offsetElements, projectionElements) ||
+      header.size > size || header.secondHashSize == 0 ||
+      header.secondHashSize == UINT64_MAX ||
+      header.referenceOffset % 64 != 0 ||
+      header.projectionsOffset % 64 != 0 ||
+      header.offsetsOffset % 64 != 0 ||
+      header.weightsOffset % 64 != 0 ||
+      header.bucketOffsetsOffset % 64 != 0 ||
+      header.bucketPointsOffset % 64 != 0 ||
+      header.referenceOffset < sizeof(MappedHeader) ||
+      !fits(header.referenceOffset, header.projectionsOffset,
+          referenceElements, sizeof(double)) ||
+      !fits(header.projectionsOffset, header.offsetsOffset, projectionElements,
+          sizeof(double)) ||
+      !fits(header.offsetsOffset, header.weightsOffset, offsetElements,
+          sizeof(double)) ||
+      !fits(header.weightsOffset, header.bucketOffsetsOffset, header.numProj,
+          sizeof(double)) ||
+      !fits(header.bucketOffsetsOffset, header.bucketPointsOffset,
+          header.secondHashSize + 1, sizeof(uint64_t)) ||
+      !fits(header.bucketPointsOffset, header.size, header.bucketPointsSize,
+          sizeof(uint64_t)))
+  {
+    throw std::invalid_argument("memory-mapped model is corrupt");
+  }
+
+  // Every bucket must lie within the packed points, and every point must be in
+  // the reference set.
+  uint64_t* newBucketOffsets = reinterpret_cast<uint64_t*>(file->Data() +
+      header.bucketOffsetsOffset);
+  uint64_t* newBucketPoints = reinterpret_cast<uint64_t*>(file->Data() +
+      header.bucketPointsOffset);
+  bool valid = (newBucketOffsets[0] == 0 &&
+      newBucketOffsets[header.secondHashSize] == header.bucketPointsSize);
+  for (size_t h = 0; h < header.secondHashSize && valid; ++h)
+    valid = (newBucketOffsets[h] <= newBucketOffsets[h + 1]);
+  for (size_t j = 0; j < header.bucketPointsSize && valid; ++j)
+    valid = (newBucketPoints[j] < header.points);
+  if (!valid)
+    throw std::invalid_argument("memory-mapped model is corrupt");
+
+  // The projections and the hash parameters are small, so they are copied.
+  const double* projectionMemory =
+      reinterpret_cast<const double*>(file->Data() + header.projectionsOffset);
+  const double* offsetMemory =
+      reinterpret_cast<const double*>(file->Data() + header.offsetsOffset);
+  const double* weightMemory =
+      reinterpret_cast<const double*>(file->Data() + header.weightsOffset);
+
+  // Now that everything has been checked, replace the current model.  The
+  // reference set and the buckets are used in place (the buckets are copied if
+  // size_t is not 64 bits wide).
+  ReleaseMapped();
+  MappedAlias(referenceSet, reinterpret_cast<double*>(file->Data() +
+      header.referenceOffset), header.dimensionality, header.points);
+  MappedIndices(bucketOffsets, newBucketOffsets, header.secondHashSize + 1);
+  MappedIndices(bucketPoints, newBucketPoints, header.bucketPointsSize);
+  mappedFile = std::move(file);
+
+  projections = arma::cube(projectionMemory, header.dimensionality,
+      header.numProj, header.numTables);
+  offsets = arma::mat(offsetMemory, header.numProj, header.numTables);
+  secondHashWeights = arma::vec(weightMemory, header.numProj);
+  numProj = header.numProj;
+  numTables = header.numTables;
+  hashWidth = header.hashWidth;
+  secondHashSize = header.secondHashSize;
+  bucketSize = header.bucketSize;
+  distanceEvaluations = 0;
+}
+
+template<typename SortPolicy, typename MatType>
+void LSHSearch<SortPolicy, MatType>::ReleaseMapped()
+{
+  if (!mappedFile)
+    return;
+
+  // The matrices may alias the mapped memory, so they are replaced before the
+  // file is unmapped.  (Armadillo never frees memory it does not own.)
+  Reconstruct(referenceSet);
+  Reconstruct(bucketOffsets);
+  Reconstruct(bucketPoints);
+  mappedFile.reset();
+}
+
 } // namespace neighbor
 } // namespace mlpack
 
@@ -40,6 +40,15 @@ namespace meanshift /** Mean shift clustering. */ {
  * meanShift.Cluster(dataset, assignments, centroids, forceConvergence);
  * @endcode
  *
+ * A single tree is built on the dataset, and in each iteration the neighbors
+ * of all of the centroids that have not converged yet are found with one
+ * dual-tree range search, which is done in parallel when OpenMP is available.
+ * The neighbors are not stored: the new centroids are accumulated as the
+ * neighbors are found.  A centroid stops moving as soon as it has converged.
+ * To use fewer seeds than points, the points can be binned into hypercubes
+ * whose side is the radius, and the bins with at least MinBinFrequency()
+ * points used as seeds.
+ *
  * @tparam UseKernel Use kernel or mean to calculate new centroid.
  *         If false, KernelType will be ignored.
  * @tparam KernelType The kernel to use.
@@ -102,6 +111,11 @@ class MeanShift
   //! Set the radius.
   void Radius(double radius);
 
+  //! Get the minimum number of points of a bin for it to be used as a seed.
+  size_t MinBinFrequency() const { return minBinFrequency; }
+  //! Modify the minimum number of points of a bin for it to be used as a seed.
+  size_t& MinBinFrequency() { return minBinFrequency; }
+
   //! Get the kernel.
   const KernelType& Kernel() const { return kernel; }
   //! Modify the kernel.
@@ -127,34 +141,22 @@ class MeanShift
                 MatType& seeds);
 
   /**
-   * Use kernel to calculate new centroid given dataset and valid neighbors.
+   * Get the weight of a neighbor at the given distance from the centroid with
+   * the kernel.  Neighbors at distance 0 have no weight.
    *
-   * @param data The whole dataset
-   * @param neighbors Valid neighbors
-   * @param distances Distances to neighbors
-   # @param centroid Store calculated centroid
+   * @param distance Distance of the neighbor to the centroid.
    */
   template<bool ApplyKernel = UseKernel>
-  typename std::enable_if<ApplyKernel, bool>::type
-  CalculateCentroid(const MatType& data,
-                    const std::vector<size_t>& neighbors,
-                    const std::vector<double>& distances,
-                    arma::colvec& centroid);
+  typename std::enable_if<ApplyKernel, double>::type
+  Weight(const double distance) const;
 
   /**
-   * Use mean to calculate new centroid given dataset and valid neighbors.
-   *
-   * @param data The whole dataset
-   * @param neighbors Valid neighbors
-   * @param distances Distances to neighbors
-   # @param centroid Store calculated centroid
+   * Get the weight of a neighbor when the new centroid is the mean of the
+   * neighbors; every neighbor has weight 1.
    */
   template<bool ApplyKernel = UseKernel>
-  typename std::enable_if<!ApplyKernel, bool>::type
-  CalculateCentroid(const MatType& data,
-                    const std::vector<size_t>& neighbors,
-                    const std::vector<double>&, /*unused*/
-                    arma::colvec& centroid);
+  typename std::enable_if<!ApplyKernel, double>::type
+  Weight(const double /* distance */) const;
 
   /**
    * If distance of two centroids is less than radius, one will be removed.
@@ -166,6 +168,9 @@ class MeanShift
   //! Maximum number of iterations before giving up.
   size_t maxIterations;
 
+  //! Minimum number of points of a bin for it to be used as a seed.
+  size_t minBinFrequency;
+
   //! Instantiated kernel.
   KernelType kernel;
 };
@@ -36,6 +36,7 @@ MeanShift(const double radius,
           const KernelType kernel) :
     radius(radius),
     maxIterations(maxIterations),
+    minBinFrequency(1),
     kernel(kernel)
 {
   // Nothing to do.
@@ -129,51 +130,27 @@ void MeanShift<UseKernel, KernelType, MatType>::GenSeeds(
   seeds *= binSize;
 }
 
-// Calculate new centroid with given kernel.
+// Get the weight of a neighbor with the given kernel.
 template<bool UseKernel, typename KernelType, typename MatType>
 template<bool ApplyKernel>
-typename std::enable_if<ApplyKernel, bool>::type
-MeanShift<UseKernel, KernelType, MatType>::
-CalculateCentroid(const MatType& data,
-                  const std::vector<size_t>& neighbors,
-                  const std::vector<double>& distances,
-                  arma::colvec& centroid)
+typename std::enable_if<ApplyKernel, double>::type
+MeanShift<UseKernel, KernelType, MatType>::Weight(const double distance) const
 {
-  double sumWeight = 0;
-  for (size_t i = 0; i < neighbors.size(); ++i)
-  {
-    if (distances[i] > 0)
-    {
-      double dist = distances[i] / radius;
-      double weight = kernel.Gradient(dist) / dist;
-      sumWeight += weight;
-      centroid += weight * data.unsafe_col(neighbors[i]);
-    }
-  }
+  if (distance <= 0)
+    return 0.0;
 
-  if (sumWeight != 0)
-  {
-    centroid /= sumWeight;
-    return true;
-  }
-  return false;
+  const double dist = distance / radius;
+  return kernel.Gradient(dist) / dist;
 }
 
-// Calculate new centroid by mean.
+// Every neighbor has the same weight for the mean.
 template<bool UseKernel, typename KernelType, typename MatType>
 template<bool ApplyKernel>
-typename std::enable_if<!ApplyKernel, bool>::type
-MeanShift<UseKernel, KernelType, MatType>::
-CalculateCentroid(const MatType& data,
-                  const std::vector<size_t>& neighbors,
-                  const std::vector<double>&, /*unused*/
-                  arma::colvec& centroid)
+typename std::enable_if<!ApplyKernel, double>::type
+MeanShift<UseKernel, KernelType, MatType>::Weight(
+    const double /* distance */) const
 {
-  for (size_t i = 0; i < neighbors.size(); ++i)
-    centroid += data.unsafe_col(neighbors[i]);
-
-  centroid /= neighbors.size();
-  return true;
+  return 1.0;
 }
 
 /**
@@ -198,67 +175,116 @@ inline void MeanShift<UseKernel, KernelType, MatType>::Cluster(
   const MatType* pSeeds = &data;
   if (useSeeds)
   {
-    GenSeeds(data, radius, 1, seeds);
-    pSeeds = &seeds;
+    GenSeeds(data, radius, (int) minBinFrequency, seeds);
+    if (seeds.n_cols > 0)
+    {
+      pSeeds = &seeds;
+    }
+    else
+    {
+      Log::Warn << "No bin holds at least " << minBinFrequency << " points; "
+          << "using every point as a seed." << std::endl;
+    }
   }
 
-  // Holds all centroids before removing duplicate ones.
-  arma::mat allCentroids(pSeeds->n_rows, pSeeds->n_cols);
+  // Holds all centroids before removing duplicate ones.  Initial centroids are
+  // the seeds themselves.
+  arma::mat allCentroids(*pSeeds);
 
   assignments.set_size(data.n_cols);
 
+  // The tree is built only once.  In each iteration, the neighbors of all of
+  // the centroids that are still moving are searched for at once.
   range::RangeSearch<> rangeSearcher(data);
   math::Range validRadius(0, radius);
-  std::vector<std::vector<size_t> > neighbors;
-  std::vector<std::vector<double> > distances;
 
-  // For each seed, perform mean shift algorithm.
-  for (size_t i = 0; i < pSeeds->n_cols; ++i)
+  // The seeds whose centroids are still moving, and whether the centroid of
+  // each seed has converged.
+  std::vector<size_t> movingSeeds(allCentroids.n_cols);
+  for (size_t i = 0; i < movingSeeds.size(); ++i)
+    movingSeeds[i] = i;
+  std::vector<bool> converged(allCentroids.n_cols, false);
+
+  arma::mat sums;
+  arma::vec sumWeights;
+  arma::Col<size_t> numNeighbors;
+  for (size_t completedIterations = 0; !movingSeeds.empty() &&
+      (completedIterations < maxIterations || forceConvergence);
+      completedIterations++)
   {
-    // Initial centroid is the seed itself.
-    allCentroids.col(i) = pSeeds->unsafe_col(i);
-    for (size_t completedIterations = 0; completedIterations < maxIterations
-        || forceConvergence; completedIterations++)
+    const arma::mat queries = allCentroids.cols(
+        arma::conv_to<arma::uvec>::from(movingSeeds));
+    sums.zeros(queries.n_rows, queries.n_cols);
+    sumWeights.zeros(queries.n_cols);
+    numNeighbors.zeros(queries.n_cols);
+
+    // Accumulate the new centroids as the neighbors are found.  All of the
+    // neighbors of one centroid are given by the same thread.
+    rangeSearcher.Search(queries, validRadius,
+        [&](const size_t query, const size_t reference, const double distance)
+        {
+          ++numNeighbors[query];
+          const double weight = Weight(distance);
+          if (weight != 0.0)
+          {
+            sums.col(query) += weight * data.col(reference);
+            sumWeights[query] += weight;
+          }
+        });
+
+    std::vector<size_t> stillMoving;
+    for (size_t j = 0; j < movingSeeds.size(); ++j)
     {
-      // Store new centroid in this.
-      arma::colvec newCentroid = arma::zeros<arma::colvec>(pSeeds->n_rows);
+      const size_t i = movingSeeds[j];
 
-      rangeSearcher.Search(allCentroids.unsafe_col(i), validRadius,
-          neighbors, distances);
-      if (neighbors[0].size() == 0) // There are no points in the cluster.
-        break;
+      // There are no points in the cluster.
+      if (numNeighbors[j] == 0)
+        continue;
 
-      // Calculate new centroid.
-      if (!CalculateCentroid(data, neighbors[0], distances[0], newCentroid))
-        newCentroid = allCentroids.unsafe_col(i);
+      // Calculate the new centroid; if no neighbor has any weight, it does not
+      // move.
+      arma::colvec newCentroid = allCentroids.col(i);
+      if (sumWeights[j] != 0.0)
+        newCentroid = sums.col(j) / sumWeights[j];
 
       // If the mean shift vector is small enough, it has converged.
       if (metric::EuclideanDistance::Evaluate(newCentroid,
           allCentroids.unsafe_col(i)) < 1e-3 * radius)
       {
-        // Determine if the new centroid is duplicate with old ones.
-        bool isDuplicated = false;
-        for (size_t k = 0; k < centroids.n_cols; ++k)
-        {
-          const double distance = metric::EuclideanDistance::Evaluate(
-              allCentroids.unsafe_col(i), centroids.unsafe_col(k));
-          if (distance < radius)
-          {
-            isDuplicated = true;
-            break;
-          }
-        }
-
-        if (!isDuplicated)
-          centroids.insert_cols(centroids.n_cols, allCentroids.unsafe_col(i));
-
-        // Get out of the loop.
-        break;
+        converged[i] = true;
+        continue;
       }
 
       // Update the centroid.
       allCentroids.col(i) = newCentroid;
+      stillMoving.push_back(i);
     }
+
+    movingSeeds.swap(stillMoving);
+  }
+
+  // Keep the converged centroids that are not duplicates of the centroids of
+  // earlier seeds.
+  for (size_t i = 0; i < allCentroids.n_cols; ++i)
+  {
+    if (!converged[i])
+      continue;
+
+    // Determine if the new centroid is duplicate with old ones.
+    bool isDuplicated = false;
+    for (size_t k = 0; k < centroids.n_cols; ++k)
+    {
+      const double distance = metric::EuclideanDistance::Evaluate(
+          allCentroids.unsafe_col(i), centroids.unsafe_col(k));
+      if (distance < radius)
+      {
+        isDuplicated = true;
+        break;
+      }
+    }
+
+    if (!isDuplicated)
+      centroids.insert_cols(centroids.n_cols, allCentroids.unsafe_col(i));
   }
 
   // If no centroid has converged due to too little iterations and without
@@ -44,6 +44,11 @@ BINDING_LONG_DESC(
     "is controlled with the " + PRINT_PARAM_STRING("max_iterations") + " "
     "parameter."
     "\n\n"
+    "The points are binned into hypercubes whose side is the radius, and the "
+    "bins with at least " + PRINT_PARAM_STRING("min_bin_frequency") + " "
+    "points are used as the initial centroids; increasing it gives fewer "
+    "seeds, which is faster on large datasets."
+    "\n\n"
     "The output labels may be saved with the " + PRINT_PARAM_STRING("output") +
     " output parameter and the centroids of each cluster may be saved with the"
     " " + PRINT_PARAM_STRING("centroid") + " output parameter.");
@@ -88,6 +93,9 @@ PARAM_MATRIX_OUT("centroid", "If specified, the centroids of each cluster will "
 PARAM_INT_IN("max_iterations", "Maximum number of iterations before mean shift "
     "terminates.", "m", 1000);
 
+PARAM_INT_IN("min_bin_frequency", "Minimum number of points in a bin for it "
+    "to be used as a seed.", "b", 1);
+
 PARAM_DOUBLE_IN("radius", "If the distance between two centroids is less than "
     "the given radius, one will be removed.  A radius of 0 or less means an "
     "estimate will be calculated and used for the radius.", "r", 0);
@@ -99,6 +107,8 @@ static void mlpackMain()
 
   RequireParamValue<int>("max_iterations", [](int x) { return x >= 0; }, true,
       "maximum iterations must be greater than or equal to 0");
+  RequireParamValue<int>("min_bin_frequency", [](int x) { return x >= 1; },
+      true, "minimum bin frequency must be at least 1");
 
   // Make sure we have an output file if we're not doing the work in-place.
   RequireAtLeastOnePassed({ "in_place", "output", "centroid" }, false,
@@ -112,6 +122,7 @@ static void mlpackMain()
   arma::Row<size_t> assignments;
 
   MeanShift<> meanShift(radius, maxIterations);
+  meanShift.MinBinFrequency() = (size_t) IO::GetParam<int>("min_bin_frequency");
 
   Timer::Start("clustering");
   Log::Info << "Performing mean shift clustering..." << endl;
@@ -47,7 +47,15 @@ BINDING_LONG_DESC(
     "This program will calculate the k-furthest-neighbors of a set of "
     "points. You may specify a separate set of reference points and query "
     "points, or just a reference set which will be used as both the reference "
-    "and query set.");
+    "and query set."
+    "\n\n"
+    "If " + PRINT_PARAM_STRING("single_precision") + " is specified, the "
+    "reference set and kd-tree are held in single precision, which halves the "
+    "memory used by the model and speeds up the search.  The distances that "
+    "are returned can then be recomputed in double precision by specifying " +
+    PRINT_PARAM_STRING("double_distances") + "; the reference points "
+    "themselves stay rounded to single precision, so the recomputed distances "
+    "are only accurate to about 1e-7 relative to the points' magnitude.");
 
 // Example.
 BINDING_EXAMPLE(
@@ -103,6 +111,11 @@ PARAM_INT_IN("leaf_size", "Leaf size for tree building (used for kd-trees, "
     "Hilbert R trees, R+ trees, R++ trees, and octrees).", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_FLAG("single_precision", "Hold the reference set and tree in single "
+    "precision (only valid for kd-trees).", "");
+PARAM_FLAG("double_distances", "If the model is held in single precision, "
+    "recompute the distances to the neighbors that are found in double "
+    "precision.", "");
 PARAM_INT_IN("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search settings.
@@ -127,6 +140,7 @@ static void mlpackMain()
 
   ReportIgnoredParam({{ "input_model", true }}, "tree_type");
   ReportIgnoredParam({{ "input_model", true }}, "random_basis");
+  ReportIgnoredParam({{ "input_model", true }}, "single_precision");
 
   // Notify the user of parameters that will be only be considered for query
   // tree.
@@ -177,6 +191,14 @@ static void mlpackMain()
   if (IO::HasParam("percentage"))
     epsilon = 1 - percentage;
 
+  // Single precision is only supported for kd-trees.
+  if (IO::HasParam("reference") && IO::HasParam("single_precision") &&
+      IO::GetParam<string>("tree_type") != "kd")
+  {
+    Log::Fatal << PRINT_PARAM_STRING("single_precision") << " is only "
+        << "supported with kd-trees!" << endl;
+  }
+
   // We either have to load the reference data, or we have to load the model.
   NSModel<FurthestNS>* kfn;
 
@@ -237,6 +259,7 @@ static void mlpackMain()
 
     kfn->TreeType() = tree;
     kfn->RandomBasis() = randomBasis;
+    kfn->SinglePrecision() = IO::HasParam("single_precision");
 
     Log::Info << "Using reference data from "
         << IO::GetPrintableParam<arma::mat>("reference") << "." << endl;
@@ -263,10 +286,25 @@ static void mlpackMain()
 
     Log::Info << "Using kFN model from '"
         << IO::GetPrintableParam<KFNModel*>("input_model") << "' (trained on "
-        << kfn->Dataset().n_rows << "x" << kfn->Dataset().n_cols
-        << " dataset)." << endl;
+        << (kfn->SinglePrecision() ? kfn->FloatDataset().n_rows :
+            kfn->Dataset().n_rows) << "x"
+        << (kfn->SinglePrecision() ? kfn->FloatDataset().n_cols :
+            kfn->Dataset().n_cols) << " dataset)." << endl;
   }
 
+  if (!kfn->SinglePrecision())
+  {
+    ReportIgnoredParam("double_distances",
+        "the model is not held in single precision");
+  }
+  kfn->DoubleDistances() = IO::HasParam("double_distances");
+
+  // The reference set may be held in either precision.
+  const size_t dimensions = kfn->SinglePrecision() ?
+      kfn->FloatDataset().n_rows : kfn->Dataset().n_rows;
+  const size_t referencePoints = kfn->SinglePrecision() ?
+      kfn->FloatDataset().n_cols : kfn->Dataset().n_cols;
+
   // Perform search, if desired.
   if (IO::HasParam("k"))
   {
@@ -278,10 +316,9 @@ static void mlpackMain()
       Log::Info << "Using query data from "
           << IO::GetPrintableParam<arma::mat>("query") << "." << endl;
       queryData = std::move(IO::GetParam<arma::mat>("query"));
-      if (queryData.n_rows != kfn->Dataset().n_rows)
+      if (queryData.n_rows != dimensions)
       {
         // Clean memory if needed.
-        const size_t dimensions = kfn->Dataset().n_rows;
         if (IO::HasParam("reference"))
           delete kfn;
         Log::Fatal << "Query has invalid dimensions (" << queryData.n_rows <<
@@ -292,10 +329,9 @@ static void mlpackMain()
     // Sanity check on k value: must be greater than 0, must be less than or
     // equal to the number of reference points.  Since it is unsigned,
     // we only test the upper bound.
-    if (k > kfn->Dataset().n_cols)
+    if (k > referencePoints)
     {
       // Clean memory if needed.
-      const size_t referencePoints = kfn->Dataset().n_cols;
       if (IO::HasParam("reference"))
         delete kfn;
       Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less "
@@ -305,10 +341,9 @@ static void mlpackMain()
 
     // Sanity check on k value: must not be equal to the number of reference
     // points when query data has not been provided.
-    if (!IO::HasParam("query") && k == kfn->Dataset().n_cols)
+    if (!IO::HasParam("query") && k == referencePoints)
     {
       // Clean memory if needed.
-      const size_t referencePoints = kfn->Dataset().n_cols;
       if (IO::HasParam("reference"))
         delete kfn;
       Log::Fatal << "Invalid k: " << k << "; must be less than the number of "
@@ -15,10 +15,12 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/util/mlpack_main.hpp>
+#include <mlpack/core/data/chunked_file.hpp>
 
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 #include "neighbor_search.hpp"
 #include "unmap.hpp"
@@ -50,7 +52,30 @@ BINDING_LONG_DESC(
     "points using kd-trees or cover trees (cover tree support is experimental "
     "and may be slow). You may specify a separate set of "
     "reference points and query points, or just a reference set which will be "
-    "used as both the reference and query set.");
+    "used as both the reference and query set."
+    "\n\n"
+    "Models that use kd-trees can also be saved to and loaded from files with "
+    "the '.mmap' extension.  These files hold the reference tree and reference "
+    "set in a flat layout that is memory-mapped when the model is loaded, so "
+    "that large models are used in place instead of being deserialized."
+    "\n\n"
+    "If " + PRINT_PARAM_STRING("single_precision") + " is specified, the "
+    "reference set and kd-tree are held in single precision, which halves the "
+    "memory used by the model and speeds up the search.  The distances that "
+    "are returned can then be recomputed in double precision by specifying " +
+    PRINT_PARAM_STRING("double_distances") + "; the reference points "
+    "themselves stay rounded to single precision, so the recomputed distances "
+    "are only accurate to about 1e-7 relative to the points' magnitude."
+    "\n\n"
+    "Query sets that are too large to be held in memory can be searched by "
+    "giving the name of a text file (with one point per line) as " +
+    PRINT_PARAM_STRING("query_stream_file") + ".  The points are then read and "
+    "searched " + PRINT_PARAM_STRING("chunk_size") + " at a time, and the "
+    "results for each chunk are appended to the text files given as " +
+    PRINT_PARAM_STRING("neighbors_stream_file") + " and " +
+    PRINT_PARAM_STRING("distances_stream_file") + " (one query point per "
+    "line), so the memory used does not depend on the number of query "
+    "points.");
 
 // Example.
 BINDING_EXAMPLE(
@@ -99,6 +124,17 @@ PARAM_MODEL_OUT(KNNModel, "output_model", "If specified, the kNN model will be "
 PARAM_MATRIX_IN("query", "Matrix containing query points (optional).", "q");
 PARAM_INT_IN("k", "Number of nearest neighbors to find.", "k", 0);
 
+// Alternately, the query points may be read and searched in chunks.
+PARAM_STRING_IN("query_stream_file", "Text file containing query points (one "
+    "per line) to read and search in chunks instead of all at once.", "", "");
+PARAM_INT_IN("chunk_size", "Number of query points to read and search at a "
+    "time when --query_stream_file is given.", "", 100000);
+PARAM_STRING_IN("neighbors_stream_file", "Text file to write the neighbors of "
+    "each point of --query_stream_file into, one line per point.", "", "");
+PARAM_STRING_IN("distances_stream_file", "Text file to write the distances to "
+    "the neighbors of each point of --query_stream_file into, one line per "
+    "point.", "", "");
+
 // The user may specify the type of tree to use, and a few parameters for tree
 // building.
 PARAM_STRING_IN("tree_type", "Type of tree to use: 'kd', 'vp', 'rp', 'max-rp', "
@@ -115,11 +151,19 @@ PARAM_DOUBLE_IN("rho", "Balance threshold (only valid for spill trees).", "b",
 
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_FLAG("single_precision", "Hold the reference set and tree in single "
+    "precision (only valid for kd-trees).", "");
+PARAM_FLAG("double_distances", "If the model is held in single precision, "
+    "recompute the distances to the neighbors that are found in double "
+    "precision.", "");
 PARAM_INT_IN("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search settings.
 PARAM_STRING_IN("algorithm", "Type of neighbor search: 'naive', 'single_tree', "
-    "'dual_tree', 'greedy'.", "a", "dual_tree");
+    "'dual_tree', 'greedy', 'parallel_dual_tree'.", "a", "dual_tree");
+PARAM_INT_IN("num_threads", "Number of threads to use for the "
+    "'parallel_dual_tree' algorithm (if 0, the OpenMP default is used).", "N",
+    0);
 PARAM_DOUBLE_IN("epsilon", "If specified, will do approximate nearest neighbor "
     "search with given relative error.", "e", 0);
 
@@ -135,6 +179,7 @@ static void mlpackMain()
 
   ReportIgnoredParam({{ "input_model", true }}, "tree_type");
   ReportIgnoredParam({{ "input_model", true }}, "random_basis");
+  ReportIgnoredParam({{ "input_model", true }}, "single_precision");
   ReportIgnoredParam({{ "input_model", true }}, "tau");
   ReportIgnoredParam({{ "input_model", true }}, "rho");
   if (IO::HasParam("input_model") && IO::HasParam("leaf_size"))
@@ -148,8 +193,22 @@ static void mlpackMain()
   RequireAtLeastOnePassed({ "k", "output_model" }, false,
       "no results will be saved");
 
+  // Query points can be given in memory or streamed from a file, but not both.
+  if (IO::HasParam("query") && IO::HasParam("query_stream_file"))
+  {
+    Log::Fatal << "Can only pass one of " << PRINT_PARAM_STRING("query")
+        << " or " << PRINT_PARAM_STRING("query_stream_file") << "!" << endl;
+  }
+  const bool streaming = IO::HasParam("query_stream_file");
+
   // If the user specifies k but no output files, they should be warned.
-  if (IO::HasParam("k"))
+  if (IO::HasParam("k") && streaming)
+  {
+    RequireAtLeastOnePassed({ "neighbors_stream_file",
+        "distances_stream_file" }, false,
+        "nearest neighbor search results will not be saved");
+  }
+  else if (IO::HasParam("k"))
   {
     RequireAtLeastOnePassed({ "neighbors", "distances" }, false,
         "nearest neighbor search results will not be saved");
@@ -161,6 +220,21 @@ static void mlpackMain()
   ReportIgnoredParam({{ "k", false }}, "true_neighbors");
   ReportIgnoredParam({{ "k", false }}, "true_distances");
   ReportIgnoredParam({{ "k", false }}, "query");
+  ReportIgnoredParam({{ "k", false }}, "query_stream_file");
+
+  // The streamed results are only written to the streamed output files, and
+  // they are never held in memory all at once.
+  ReportIgnoredParam({{ "query_stream_file", false }}, "chunk_size");
+  ReportIgnoredParam({{ "query_stream_file", false }}, "neighbors_stream_file");
+  ReportIgnoredParam({{ "query_stream_file", false }}, "distances_stream_file");
+  ReportIgnoredParam({{ "query_stream_file", true }}, "neighbors");
+  ReportIgnoredParam({{ "query_stream_file", true }}, "distances");
+  ReportIgnoredParam({{ "query_stream_file", true }}, "true_neighbors");
+  ReportIgnoredParam({{ "query_stream_file", true }}, "true_distances");
+
+  // Sanity check on chunk size.
+  RequireParamValue<int>("chunk_size", [](int x) { return x > 0; },
+      true, "chunk size must be positive");
 
   // Sanity check on leaf size.
   RequireParamValue<int>("leaf_size", [](int x) { return x > 0; },
@@ -184,6 +258,14 @@ static void mlpackMain()
     ReportIgnoredParam("rho", "spill trees are not being used");
   }
 
+  // Single precision is only supported for kd-trees.
+  if (IO::HasParam("reference") && IO::HasParam("single_precision") &&
+      IO::GetParam<string>("tree_type") != "kd")
+  {
+    Log::Fatal << PRINT_PARAM_STRING("single_precision") << " is only "
+        << "supported with kd-trees!" << endl;
+  }
+
   // Sanity check on epsilon.
   const double epsilon = IO::GetParam<double>("epsilon");
   RequireParamValue<double>("epsilon", [](double x) { return x >= 0.0; }, true,
@@ -194,7 +276,8 @@ static void mlpackMain()
 
   const string algorithm = IO::GetParam<string>("algorithm");
   RequireParamInSet<string>("algorithm", { "naive", "single_tree", "dual_tree",
-      "greedy" }, true, "unknown neighbor search algorithm");
+      "greedy", "parallel_dual_tree" }, true,
+      "unknown neighbor search algorithm");
   NeighborSearchMode searchMode = DUAL_TREE_MODE;
 
   if (algorithm == "naive")
@@ -205,6 +288,26 @@ static void mlpackMain()
     searchMode = DUAL_TREE_MODE;
   else if (algorithm == "greedy")
     searchMode = GREEDY_SINGLE_TREE_MODE;
+  else if (algorithm == "parallel_dual_tree")
+    searchMode = PARALLEL_DUAL_TREE_MODE;
+
+  // Sanity check on the number of threads.
+  RequireParamValue<int>("num_threads", [](int x) { return x >= 0; }, true,
+      "number of threads must be non-negative");
+  if (algorithm != "parallel_dual_tree")
+  {
+    ReportIgnoredParam("num_threads",
+        "the 'parallel_dual_tree' algorithm is not being used");
+  }
+  else if (IO::GetParam<int>("num_threads") > 0)
+  {
+    #ifdef HAS_OPENMP
+    omp_set_num_threads(IO::GetParam<int>("num_threads"));
+    #else
+    Log::Warn << "Using the 'parallel_dual_tree' algorithm, but OpenMP "
+        << "support is not available; only one thread will be used!" << endl;
+    #endif
+  }
 
   if (IO::HasParam("reference"))
   {
@@ -252,6 +355,7 @@ static void mlpackMain()
 
     knn->TreeType() = tree;
     knn->RandomBasis() = randomBasis;
+    knn->SinglePrecision() = IO::HasParam("single_precision");
     knn->LeafSize() = size_t(lsInt);
     knn->Tau() = tau;
     knn->Rho() = rho;
@@ -281,9 +385,24 @@ static void mlpackMain()
 
     Log::Info << "Loaded kNN model from '"
         << IO::GetPrintableParam<KNNModel*>("input_model") << "' (trained on "
-        << knn->Dataset().n_rows << "x" << knn->Dataset().n_cols
-        << " dataset)." << endl;
+        << (knn->SinglePrecision() ? knn->FloatDataset().n_rows :
+            knn->Dataset().n_rows) << "x"
+        << (knn->SinglePrecision() ? knn->FloatDataset().n_cols :
+            knn->Dataset().n_cols) << " dataset)." << endl;
+  }
+
+  if (!knn->SinglePrecision())
+  {
+    ReportIgnoredParam("double_distances",
+        "the model is not held in single precision");
   }
+  knn->DoubleDistances() = IO::HasParam("double_distances");
+
+  // The reference set may be held in either precision.
+  const size_t dimensions = knn->SinglePrecision() ?
+      knn->FloatDataset().n_rows : knn->Dataset().n_rows;
+  const size_t referencePoints = knn->SinglePrecision() ?
+      knn->FloatDataset().n_cols : knn->Dataset().n_cols;
 
   // Perform search, if desired.
   if (IO::HasParam("k"))
@@ -296,10 +415,9 @@ static void mlpackMain()
       Log::Info << "Using query data from "
           << IO::GetPrintableParam<arma::mat>("query") << "." << endl;
       queryData = std::move(IO::GetParam<arma::mat>("query"));
-      if (queryData.n_rows != knn->Dataset().n_rows)
+      if (queryData.n_rows != dimensions)
       {
         // Clean memory if needed before crashing.
-        const size_t dimensions = knn->Dataset().n_rows;
         if (IO::HasParam("reference"))
           delete knn;
         Log::Fatal << "Query has invalid dimensions(" << queryData.n_rows <<
@@ -310,10 +428,9 @@ static void mlpackMain()
     // Sanity check on k value: must be greater than 0, must be less than or
     // equal to the number of reference points.  Since it is unsigned,
     // we only test the upper bound.
-    if (k > knn->Dataset().n_cols)
+    if (k > referencePoints)
     {
       // Clean memory if needed before crashing.
-      const size_t referencePoints = knn->Dataset().n_cols;
       if (IO::HasParam("reference"))
         delete knn;
       Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less "
@@ -323,10 +440,9 @@ static void mlpackMain()
 
     // Sanity check on k value: must not be equal to the number of reference
     // points when query data has not been provided.
-    if (!IO::HasParam("query") && k == knn->Dataset().n_cols)
+    if (!IO::HasParam("query") && !streaming && k == referencePoints)
     {
       // Clean memory if needed before crashing.
-      const size_t referencePoints = knn->Dataset().n_cols;
       if (IO::HasParam("reference"))
         delete knn;
       Log::Fatal << "Invalid k: " << k << "; must be less than the number of "
@@ -338,6 +454,64 @@ static void mlpackMain()
     arma::Mat<size_t> neighbors;
     arma::mat distances;
 
+    if (streaming)
+    {
+      const string queryFile = IO::GetParam<string>("query_stream_file");
+      const size_t chunkSize = (size_t) IO::GetParam<int>("chunk_size");
+      Log::Info << "Searching query points from '" << queryFile << "' in "
+          << "chunks of " << chunkSize << " points." << endl;
+
+      size_t numQueries = 0;
+      try
+      {
+        data::ChunkedReader reader(queryFile);
+        std::unique_ptr<data::ChunkedWriter> neighborsWriter,
+            distancesWriter;
+        if (IO::HasParam("neighbors_stream_file"))
+        {
+          neighborsWriter.reset(new data::ChunkedWriter(
+              IO::GetParam<string>("neighbors_stream_file")));
+        }
+        if (IO::HasParam("distances_stream_file"))
+        {
+          distancesWriter.reset(new data::ChunkedWriter(
+              IO::GetParam<string>("distances_stream_file")));
+        }
+
+        arma::mat chunk;
+        while (reader.Read(chunk, chunkSize) > 0)
+        {
+          if (chunk.n_rows != dimensions)
+          {
+            throw std::runtime_error("Query has invalid dimensions(" +
+                std::to_string(chunk.n_rows) + "); should be " +
+                std::to_string(dimensions) + "!");
+          }
+
+          // A query tree is built for each chunk, if one is needed.
+          numQueries += chunk.n_cols;
+          knn->Search(std::move(chunk), k, neighbors, distances);
+
+          if (neighborsWriter)
+            neighborsWriter->Write(neighbors);
+          if (distancesWriter)
+            distancesWriter->Write(distances);
+        }
+      }
+      catch (std::exception& e)
+      {
+        // Clean memory if needed before crashing.
+        if (IO::HasParam("reference"))
+          delete knn;
+        Log::Fatal << e.what() << endl;
+      }
+
+      Log::Info << "Search complete (" << numQueries << " query points)."
+          << endl;
+      IO::GetParam<KNNModel*>("output_model") = knn;
+      return;
+    }
+
     if (IO::HasParam("query"))
       knn->Search(std::move(queryData), k, neighbors, distances);
     else
@@ -14,6 +14,8 @@
 #define MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <atomic>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -34,13 +36,20 @@ namespace neighbor  {
 template<typename SortPolicy>
 class TrainVisitor;
 
-//! NeighborSearchMode represents the different neighbor search modes available.
+/**
+ * NeighborSearchMode represents the different neighbor search modes available.
+ * PARALLEL_DUAL_TREE_MODE is the same as DUAL_TREE_MODE, except that the query
+ * tree is split into independent subtrees that are traversed in parallel with
+ * OpenMP (if mlpack was compiled without OpenMP support, it is equivalent to
+ * DUAL_TREE_MODE).
+ */
 enum NeighborSearchMode
 {
   NAIVE_MODE,
   SINGLE_TREE_MODE,
   DUAL_TREE_MODE,
-  GREEDY_SINGLE_TREE_MODE
+  GREEDY_SINGLE_TREE_MODE,
+  PARALLEL_DUAL_TREE_MODE
 };
 
 /**
@@ -57,6 +66,14 @@ enum NeighborSearchMode
  * can be found in the NearestNeighborSort class and the kernel::ExampleKernel
  * class.
  *
+ * Search() may be called from several threads at once on the same object:
+ * the state of each search (the candidate lists, the query tree and its
+ * statistics, and the counts of base cases and scores) is local to that
+ * search, and the reference tree is only read.  The one exception is the
+ * dual-tree search without a query set, which uses the statistics of the
+ * reference tree; such searches are run one at a time.  Train(), Insert() and
+ * Remove() must not run concurrently with anything else.
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
  * @tparam MetricType The metric to use for computation.
  * @tparam MatType The type of data matrix.
@@ -206,6 +223,32 @@ class NeighborSearch
    */
   void Train(Tree referenceTree);
 
+  /**
+   * Add the given points to the reference set without building the reference
+   * tree again.  The points are given the indices that follow the existing
+   * reference points, so later searches report them as if they had been
+   * appended to the original reference set.  The tree is modified in place
+   * (see BinarySpaceTree::Insert()), so this is only available for trees based
+   * on BinarySpaceTree, and frozen trees are refused.  The model can be used
+   * for searches before and after the call.
+   *
+   * @param points Points to add to the reference set.
+   * @param leafSize Maximum number of points held in a leaf of the tree.
+   */
+  void Insert(const MatType& points, const size_t leafSize = 20);
+
+  /**
+   * Remove the points with the given indices from the reference set without
+   * building the reference tree again.  The remaining points are renumbered as
+   * if the removed points had been deleted from the original reference set.
+   * As with Insert(), this is only available for trees based on
+   * BinarySpaceTree, and frozen trees are refused.
+   *
+   * @param indices Indices of the points to remove from the reference set.
+   * @param leafSize Maximum number of points held in a leaf of the tree.
+   */
+  void Remove(const std::vector<size_t>& indices, const size_t leafSize = 20);
+
   /**
    * For each point in the query set, compute the nearest neighbors and store
    * the output in the given matrices.  The matrices will be set to the size of
@@ -305,10 +348,11 @@ class NeighborSearch
                        arma::Mat<size_t>& realNeighbors);
 
   //! Return the total number of base case evaluations performed during the last
-  //! search.
+  //! search (the last one to finish, if several ran at once).
   size_t BaseCases() const { return baseCases; }
 
-  //! Return the number of node combination scores during the last search.
+  //! Return the number of node combination scores during the last search (the
+  //! last one to finish, if several ran at once).
   size_t Scores() const { return scores; }
 
   //! Access the search mode.
@@ -329,6 +373,15 @@ class NeighborSearch
   //! Modify the reference tree.
   Tree& ReferenceTree() { return *referenceTree; }
 
+  //! Access the mapping from the indices of points in the reference tree to
+  //! their indices in the original reference set (this is empty if the points
+  //! were not rearranged, or if the tree was given by the user).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+  //! Modify the mapping from the indices of points in the reference tree to
+  //! their indices in the original reference set.
+  std::vector<size_t>& OldFromNewReferences() { return oldFromNewReferences; }
+
   //! Serialize the NeighborSearch model.
   template<typename Archive>
   void serialize(Archive& ar, const uint32_t version);
@@ -350,13 +403,31 @@ class NeighborSearch
   MetricType metric;
 
   //! The total number of base cases.
-  size_t baseCases;
+  std::atomic<size_t> baseCases;
   //! The total number of scores (applicable for non-naive search).
-  size_t scores;
+  std::atomic<size_t> scores;
 
   //! If this is true, the reference tree bounds need to be reset on a call to
   //! Search() without a query set.
   bool treeNeedsReset;
+  //! Serializes dual-tree searches without a query set, which use the
+  //! statistics of the reference tree.
+  std::mutex monochromaticMutex;
+
+  /**
+   * Perform the dual-tree traversal of the given query tree against the
+   * reference tree in parallel.  The query tree is split into subtrees (each
+   * query point belongs to exactly one of them), and each subtree is traversed
+   * by a separate task with its own copy of the traversal state; the candidate
+   * lists are shared between tasks, since no two tasks hold the same query
+   * point.  The numbers of base cases and scores of all tasks are added to the
+   * given rules object.
+   *
+   * @param queryTree Tree built on the query points.
+   * @param rules Rules object holding the candidate lists.
+   */
+  template<typename RuleType>
+  void ParallelDualTreeTraversal(Tree& queryTree, RuleType& rules);
 
   //! The NSModel class should have access to internal members.
   template<typename SortPol>
@@ -18,6 +18,11 @@
 #include "neighbor_search_rules.hpp"
 #include <mlpack/core/tree/spill_tree/is_spill_tree.hpp>
 
+// Use OpenMP for the parallel dual-tree traversal, if available.
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace neighbor {
 
@@ -129,7 +134,7 @@ SingleTreeTraversalType>::NeighborSearch(const NeighborSearchMode mode,
   // Build the tree on the empty dataset, if necessary.
   if (mode != NAIVE_MODE)
   {
-    referenceTree = BuildTree<Tree>(std::move(arma::mat()),
+    referenceTree = BuildTree<Tree>(std::move(MatType()),
         oldFromNewReferences);
     referenceSet = &referenceTree->Dataset();
   }
@@ -153,8 +158,8 @@ SingleTreeTraversalType>::NeighborSearch(const NeighborSearch& other) :
     searchMode(other.searchMode),
     epsilon(other.epsilon),
     metric(other.metric),
-    baseCases(other.baseCases),
-    scores(other.scores),
+    baseCases(other.baseCases.load()),
+    scores(other.scores.load()),
     treeNeedsReset(false)
 {
   // Nothing else to do.
@@ -177,8 +182,8 @@ SingleTreeTraversalType>::NeighborSearch(NeighborSearch&& other) :
     searchMode(other.searchMode),
     epsilon(other.epsilon),
     metric(std::move(other.metric)),
-    baseCases(other.baseCases),
-    scores(other.scores),
+    baseCases(other.baseCases.load()),
+    scores(other.scores.load()),
     treeNeedsReset(other.treeNeedsReset)
 {
   // Clear the other model.
@@ -230,8 +235,8 @@ NeighborSearch<SortPolicy,
   searchMode = other.searchMode;
   epsilon = other.epsilon;
   metric = other.metric;
-  baseCases = other.baseCases;
-  scores = other.scores;
+  baseCases = other.baseCases.load();
+  scores = other.scores.load();
   treeNeedsReset = false;
 }
 
@@ -272,15 +277,15 @@ NeighborSearch<SortPolicy,
   searchMode = other.searchMode;
   epsilon = other.epsilon;
   metric = other.metric;
-  baseCases = other.baseCases;
-  scores = other.scores;
+  baseCases = other.baseCases.load();
+  scores = other.scores.load();
   treeNeedsReset = other.treeNeedsReset;
 
   // Reset the other object.  Clean memory if needed.
   if (!other.referenceTree)
     delete other.referenceSet;
 
-  other.referenceTree = BuildTree<Tree>(std::move(arma::mat()),
+  other.referenceTree = BuildTree<Tree>(std::move(MatType()),
       other.oldFromNewReferences);
   other.referenceSet = &other.referenceTree->Dataset();
   other.searchMode = DUAL_TREE_MODE,
@@ -373,6 +378,109 @@ DualTreeTraversalType, SingleTreeTraversalType>::Train(Tree referenceTree)
   this->referenceSet = &this->referenceTree->Dataset();
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+DualTreeTraversalType, SingleTreeTraversalType>::Insert(
+    const MatType& points,
+    const size_t leafSize)
+{
+  if (points.n_rows != referenceSet->n_rows)
+  {
+    throw std::invalid_argument("NeighborSearch::Insert(): the points must "
+        "have the same dimensionality as the reference set");
+  }
+
+  // Without a tree, we own the reference set.
+  if (!referenceTree)
+  {
+    MatType* set = const_cast<MatType*>(referenceSet);
+    set->insert_cols(set->n_cols, points);
+    return;
+  }
+
+  // If the tree was given by the user, its order is the original order.
+  if (oldFromNewReferences.empty())
+  {
+    oldFromNewReferences.resize(referenceSet->n_cols);
+    for (size_t i = 0; i < referenceSet->n_cols; ++i)
+      oldFromNewReferences[i] = i;
+  }
+
+  referenceTree->Insert(points, oldFromNewReferences, leafSize);
+
+  // The nodes that were not modified may still hold bounds from an earlier
+  // monochromatic search.
+  treeNeedsReset = true;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+DualTreeTraversalType, SingleTreeTraversalType>::Remove(
+    const std::vector<size_t>& indices,
+    const size_t leafSize)
+{
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    if (indices[i] >= referenceSet->n_cols)
+    {
+      throw std::invalid_argument("NeighborSearch::Remove(): index " +
+          std::to_string(indices[i]) + " is out of range");
+    }
+  }
+
+  // Without a tree, we own the reference set; the columns are removed from
+  // the last one down, so that the other indices stay valid.
+  if (!referenceTree)
+  {
+    std::vector<size_t> sortedIndices(indices);
+    std::sort(sortedIndices.begin(), sortedIndices.end());
+    sortedIndices.erase(std::unique(sortedIndices.begin(),
+        sortedIndices.end()), sortedIndices.end());
+
+    MatType* set = const_cast<MatType*>(referenceSet);
+    for (size_t i = sortedIndices.size(); i > 0; --i)
+      set->shed_col(sortedIndices[i - 1]);
+    return;
+  }
+
+  // If the tree was given by the user, its order is the original order.
+  if (oldFromNewReferences.empty())
+  {
+    oldFromNewReferences.resize(referenceSet->n_cols);
+    for (size_t i = 0; i < referenceSet->n_cols; ++i)
+      oldFromNewReferences[i] = i;
+  }
+
+  // Find the points in the tree.
+  std::vector<size_t> newFromOld(oldFromNewReferences.size());
+  for (size_t i = 0; i < oldFromNewReferences.size(); ++i)
+    newFromOld[oldFromNewReferences[i]] = i;
+
+  std::vector<size_t> treeIndices(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+    treeIndices[i] = newFromOld[indices[i]];
+
+  referenceTree->Remove(treeIndices, oldFromNewReferences, leafSize);
+
+  // The nodes that were not modified may still hold bounds from an earlier
+  // monochromatic search.
+  treeNeedsReset = true;
+}
+
 /**
  * Computes the best neighbors and stores them in resultingNeighbors and
  * distances.
@@ -402,12 +510,18 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
 
   Timer::Start("computing_neighbors");
 
-  baseCases = 0;
-  scores = 0;
+  // The counts are kept locally, since several searches may run at once.
+  size_t searchBaseCases = 0;
+  size_t searchScores = 0;
 
   // This will hold mappings for query points, if necessary.
   std::vector<size_t> oldFromNewQueries;
 
+  // The parallel dual-tree search builds a query tree just like the regular
+  // dual-tree search.
+  const bool dualTreeSearch = (searchMode == DUAL_TREE_MODE ||
+      searchMode == PARALLEL_DUAL_TREE_MODE);
+
   // If we have built the trees ourselves, then we will have to map all the
   // indices back to their original indices when this computation is finished.
   // To avoid an extra copy, we will store the neighbors and distances in a
@@ -418,7 +532,7 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   // Mapping is only necessary if the tree rearranges points.
   if (tree::TreeTraits<Tree>::RearrangesDataset)
   {
-    if (searchMode == DUAL_TREE_MODE)
+    if (dualTreeSearch)
     {
       distancePtr = new arma::mat; // Query indices need to be mapped.
       neighborPtr = new arma::Mat<size_t>;
@@ -445,7 +559,7 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
         for (size_t j = 0; j < referenceSet->n_cols; ++j)
           rules.BaseCase(i, j);
 
-      baseCases += querySet.n_cols * referenceSet->n_cols;
+      searchBaseCases += querySet.n_cols * referenceSet->n_cols;
 
       rules.GetResults(*neighborPtr, *distancePtr);
       break;
@@ -462,8 +576,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       for (size_t i = 0; i < querySet.n_cols; ++i)
         traverser.Traverse(i, *referenceTree);
 
-      scores += rules.Scores();
-      baseCases += rules.BaseCases();
+      searchScores += rules.Scores();
+      searchBaseCases += rules.BaseCases();
 
       Log::Info << rules.Scores() << " node combinations were scored."
           << std::endl;
@@ -474,6 +588,7 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       break;
     }
     case DUAL_TREE_MODE:
+    case PARALLEL_DUAL_TREE_MODE:
     {
       // Build the query tree.
       Timer::Stop("computing_neighbors");
@@ -485,13 +600,20 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       // Create the helper object for the tree traversal.
       RuleType rules(*referenceSet, queryTree->Dataset(), k, metric, epsilon);
 
-      // Create the traverser.
-      DualTreeTraversalType<RuleType> traverser(rules);
+      if (searchMode == PARALLEL_DUAL_TREE_MODE)
+      {
+        ParallelDualTreeTraversal(*queryTree, rules);
+      }
+      else
+      {
+        // Create the traverser.
+        DualTreeTraversalType<RuleType> traverser(rules);
 
-      traverser.Traverse(*queryTree, *referenceTree);
+        traverser.Traverse(*queryTree, *referenceTree);
+      }
 
-      scores += rules.Scores();
-      baseCases += rules.BaseCases();
+      searchScores += rules.Scores();
+      searchBaseCases += rules.BaseCases();
 
       Log::Info << rules.Scores() << " node combinations were scored."
           << std::endl;
@@ -515,8 +637,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       for (size_t i = 0; i < querySet.n_cols; ++i)
         traverser.Traverse(i, *referenceTree);
 
-      scores += rules.Scores();
-      baseCases += rules.BaseCases();
+      searchScores += rules.Scores();
+      searchBaseCases += rules.BaseCases();
 
       Log::Info << rules.Scores() << " node combinations were scored."
           << std::endl;
@@ -528,12 +650,14 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
     }
   }
 
+  baseCases = searchBaseCases;
+  scores = searchScores;
   Timer::Stop("computing_neighbors");
 
   // Map points back to original indices, if necessary.
   if (tree::TreeTraits<Tree>::RearrangesDataset)
   {
-    if (searchMode == DUAL_TREE_MODE && !oldFromNewReferences.empty())
+    if (dualTreeSearch && !oldFromNewReferences.empty())
     {
       // We must map both query and reference indices.
       neighbors.set_size(k, querySet.n_cols);
@@ -556,7 +680,7 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       delete neighborPtr;
       delete distancePtr;
     }
-    else if (searchMode == DUAL_TREE_MODE)
+    else if (dualTreeSearch)
     {
       // We must map query indices only.
       neighbors.set_size(k, querySet.n_cols);
@@ -615,14 +739,15 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   }
 
   // Make sure we are in dual-tree mode.
-  if (searchMode != DUAL_TREE_MODE)
+  if (searchMode != DUAL_TREE_MODE && searchMode != PARALLEL_DUAL_TREE_MODE)
     throw std::invalid_argument("cannot call NeighborSearch::Search() with a "
         "query tree when naive or singleMode are set to true");
 
   Timer::Start("computing_neighbors");
 
-  baseCases = 0;
-  scores = 0;
+  // The counts are kept locally, since several searches may run at once.
+  size_t searchBaseCases = 0;
+  size_t searchScores = 0;
 
   // Get a reference to the query set.
   const MatType& querySet = queryTree.Dataset();
@@ -641,12 +766,19 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
   RuleType rules(*referenceSet, querySet, k, metric, epsilon, sameSet);
 
-  // Create the traverser.
-  DualTreeTraversalType<RuleType> traverser(rules);
-  traverser.Traverse(queryTree, *referenceTree);
+  if (searchMode == PARALLEL_DUAL_TREE_MODE)
+  {
+    ParallelDualTreeTraversal(queryTree, rules);
+  }
+  else
+  {
+    // Create the traverser.
+    DualTreeTraversalType<RuleType> traverser(rules);
+    traverser.Traverse(queryTree, *referenceTree);
+  }
 
-  scores += rules.Scores();
-  baseCases += rules.BaseCases();
+  searchScores += rules.Scores();
+  searchBaseCases += rules.BaseCases();
 
   Log::Info << rules.Scores() << " node combinations were scored." << std::endl;
   Log::Info << rules.BaseCases() << " base cases were calculated." << std::endl;
@@ -656,6 +788,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   Log::Info << rules.Scores() << " node combinations were scored.\n";
   Log::Info << rules.BaseCases() << " base cases were calculated.\n";
 
+  baseCases = searchBaseCases;
+  scores = searchScores;
   Timer::Stop("computing_neighbors");
 
   // Do we need to map indices?
@@ -707,8 +841,9 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
 
   Timer::Start("computing_neighbors");
 
-  baseCases = 0;
-  scores = 0;
+  // The counts are kept locally, since several searches may run at once.
+  size_t searchBaseCases = 0;
+  size_t searchScores = 0;
 
   arma::Mat<size_t>* neighborPtr = &neighbors;
   arma::mat* distancePtr = &distances;
@@ -739,7 +874,7 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
         for (size_t j = 0; j < referenceSet->n_cols; ++j)
           rules.BaseCase(i, j);
 
-      baseCases += referenceSet->n_cols * referenceSet->n_cols;
+      searchBaseCases += referenceSet->n_cols * referenceSet->n_cols;
       break;
     }
     case SINGLE_TREE_MODE:
@@ -751,8 +886,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       for (size_t i = 0; i < referenceSet->n_cols; ++i)
         traverser.Traverse(i, *referenceTree);
 
-      scores += rules.Scores();
-      baseCases += rules.BaseCases();
+      searchScores += rules.Scores();
+      searchBaseCases += rules.BaseCases();
 
       Log::Info << rules.Scores() << " node combinations were scored."
           << std::endl;
@@ -761,7 +896,12 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       break;
     }
     case DUAL_TREE_MODE:
+    case PARALLEL_DUAL_TREE_MODE:
     {
+      // The reference tree is also the query tree here, so its statistics hold
+      // the bounds of this search; only one such search may run at a time.
+      std::lock_guard<std::mutex> lock(monochromaticMutex);
+
       // The dual-tree monochromatic search case may require resetting the
       // bounds in the tree.
       if (treeNeedsReset)
@@ -790,17 +930,23 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
         // For Dual Tree Search on SpillTree, the queryTree must be built with
         // non overlapping (tau = 0).
         Tree queryTree(*referenceSet);
-        traverser.Traverse(queryTree, *referenceTree);
+        if (searchMode == PARALLEL_DUAL_TREE_MODE)
+          ParallelDualTreeTraversal(queryTree, rules);
+        else
+          traverser.Traverse(queryTree, *referenceTree);
       }
       else
       {
-        traverser.Traverse(*referenceTree, *referenceTree);
+        if (searchMode == PARALLEL_DUAL_TREE_MODE)
+          ParallelDualTreeTraversal(*referenceTree, rules);
+        else
+          traverser.Traverse(*referenceTree, *referenceTree);
         // Next time we perform this search, we'll need to reset the tree.
         treeNeedsReset = true;
       }
 
-      scores += rules.Scores();
-      baseCases += rules.BaseCases();
+      searchScores += rules.Scores();
+      searchBaseCases += rules.BaseCases();
 
       Log::Info << rules.Scores() << " node combinations were scored."
           << std::endl;
@@ -820,8 +966,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       for (size_t i = 0; i < referenceSet->n_cols; ++i)
         traverser.Traverse(i, *referenceTree);
 
-      scores += rules.Scores();
-      baseCases += rules.BaseCases();
+      searchScores += rules.Scores();
+      searchBaseCases += rules.BaseCases();
 
       Log::Info << rules.Scores() << " node combinations were scored."
           << std::endl;
@@ -833,6 +979,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
 
   rules.GetResults(*neighborPtr, *distancePtr);
 
+  baseCases = searchBaseCases;
+  scores = searchScores;
   Timer::Stop("computing_neighbors");
 
   // Do we need to map the reference indices?
@@ -928,6 +1076,88 @@ DualTreeTraversalType, SingleTreeTraversalType>::Recall(
   return ((double) found) / realNeighbors.n_elem;
 }
 
+//! Traverse independent query subtrees in parallel.
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+template<typename RuleType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+DualTreeTraversalType, SingleTreeTraversalType>::ParallelDualTreeTraversal(
+    Tree& queryTree,
+    RuleType& rules)
+{
+  #ifdef HAS_OPENMP
+  const size_t numThreads = omp_get_max_threads();
+  #else
+  const size_t numThreads = 1;
+  #endif
+
+  // With only one thread there is nothing to gain by splitting the query tree.
+  if (numThreads == 1)
+  {
+    DualTreeTraversalType<RuleType> traverser(rules);
+    traverser.Traverse(queryTree, *referenceTree);
+    return;
+  }
+
+  // Split the query tree into subtrees.  We descend one level at a time until
+  // there are enough subtrees to keep every thread busy even when some
+  // subtrees are pruned quickly, or until every subtree is a leaf.  Each query
+  // point is a descendant of exactly one subtree, so the subtrees can be
+  // traversed independently.  Note that we never score the query nodes above
+  // the split; their statistics are only read (as parent bounds) during the
+  // parallel traversal.
+  std::vector<Tree*> subtrees(1, &queryTree);
+  bool expanded = true;
+  while (expanded && subtrees.size() < 4 * numThreads)
+  {
+    expanded = false;
+    std::vector<Tree*> nextSubtrees;
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      if (subtrees[i]->NumChildren() == 0)
+      {
+        nextSubtrees.push_back(subtrees[i]);
+        continue;
+      }
+
+      for (size_t j = 0; j < subtrees[i]->NumChildren(); ++j)
+        nextSubtrees.push_back(&subtrees[i]->Child(j));
+      expanded = true;
+    }
+
+    subtrees.swap(nextSubtrees);
+  }
+
+  Log::Info << "Traversing " << subtrees.size() << " query subtrees with "
+      << numThreads << " threads." << std::endl;
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  #pragma omp parallel for \
+      schedule(dynamic) \
+      reduction(+:totalBaseCases, totalScores)
+  for (omp_size_t i = 0; i < (omp_size_t) subtrees.size(); ++i)
+  {
+    // Each task has its own traversal state, but shares the candidate lists.
+    RuleType taskRules(&rules);
+    DualTreeTraversalType<RuleType> traverser(taskRules);
+    traverser.Traverse(*subtrees[i], *referenceTree);
+
+    totalBaseCases += taskRules.BaseCases();
+    totalScores += taskRules.Scores();
+  }
+
+  rules.BaseCases() += totalBaseCases;
+  rules.Scores() += totalScores;
+}
+
 //! Serialize the NeighborSearch model.
 template<typename SortPolicy,
          typename MetricType,
@@ -16,6 +16,7 @@
 #include <mlpack/core/tree/traversal_info.hpp>
 
 #include <queue>
+#include <unordered_map>
 
 namespace mlpack {
 namespace neighbor {
@@ -54,6 +55,21 @@ class NeighborSearchRules
                       const double epsilon = 0,
                       const bool sameSet = false);
 
+  /**
+   * Construct a NeighborSearchRules object that uses the same datasets,
+   * parameters, and candidate lists as the given NeighborSearchRules object,
+   * but that keeps its own traversal state (the last base case, the traversal
+   * info, and the number of base cases and scores).  This is used by the
+   * parallel dual-tree search: each thread traverses a different query subtree,
+   * and since those subtrees hold disjoint sets of query points, no two threads
+   * ever modify the same candidate list.
+   *
+   * The given object must outlive the object being constructed.
+   *
+   * @param other NeighborSearchRules object whose candidate lists are shared.
+   */
+  explicit NeighborSearchRules(NeighborSearchRules* other);
+
   /**
    * Store the list of candidates for each query point in the given matrices.
    *
@@ -73,6 +89,20 @@ class NeighborSearchRules
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Evaluate the base cases between each of the given query points and every
+   * point held by the given reference node.  This gives the same results as
+   * calling BaseCase() for each pair.  When the metric is the (squared)
+   * Euclidean distance, all of the distances are first computed in one batch
+   * (see metric::LMetric::BatchEvaluate()), and only the pairs that could enter
+   * the candidate lists are evaluated exactly.
+   *
+   * @param queryIndices Indices of query points.
+   * @param referenceNode Node holding the reference points.
+   */
+  void BatchBaseCase(const std::vector<size_t>& queryIndices,
+                     TreeType& referenceNode);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -183,8 +213,14 @@ class NeighborSearchRules
   typedef std::priority_queue<Candidate, std::vector<Candidate>, CandidateCmp>
       CandidateList;
 
-  //! Set of candidate neighbors for each point.
-  std::vector<CandidateList> candidates;
+  //! Storage for the candidate lists, if they are not shared with another
+  //! NeighborSearchRules object.
+  std::vector<CandidateList> candidateStorage;
+
+  //! Set of candidate neighbors for each point.  This points either to
+  //! candidateStorage or to the candidate lists of another NeighborSearchRules
+  //! object.
+  std::vector<CandidateList>* candidates;
 
   //! Number of neighbors to search for.
   const size_t k;
@@ -205,6 +241,12 @@ class NeighborSearchRules
   //! The last base case result.
   double lastBaseCase;
 
+  //! The distance between the current query point and the first point of each
+  //! reference node that has been scored, for trees with self-children.  This
+  //! is kept here rather than in the statistics of the reference tree, so that
+  //! several searches can use the same reference tree at once.
+  std::unordered_map<const TreeType*, double> lastDistances;
+
   //! The number of base cases that have been performed.
   size_t baseCases;
   //! The number of scores that have been performed.
@@ -219,6 +261,23 @@ class NeighborSearchRules
    */
   double CalculateBound(TreeType& queryNode) const;
 
+  /**
+   * Evaluate the batched base cases with BaseCase(), for metrics that have no
+   * batched kernel.
+   */
+  template<typename MetricType2>
+  void BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                         TreeType& referenceNode,
+                         MetricType2& metric);
+
+  /**
+   * Evaluate the batched base cases with the batched L2 kernel.
+   */
+  template<bool TakeRoot>
+  void BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                         TreeType& referenceNode,
+                         metric::LMetric<2, TakeRoot>& metric);
+
   /**
    * Helper function to insert a point into the list of candidate points.
    *
@@ -29,6 +29,7 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
     const bool sameSet) :
     referenceSet(referenceSet),
     querySet(querySet),
+    candidates(&candidateStorage),
     k(k),
     metric(metric),
     sameSet(sameSet),
@@ -54,9 +55,30 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
   std::vector<Candidate> vect(k, def);
   CandidateList pqueue(CandidateCmp(), std::move(vect));
 
-  candidates.reserve(querySet.n_cols);
+  candidateStorage.reserve(querySet.n_cols);
   for (size_t i = 0; i < querySet.n_cols; ++i)
-    candidates.push_back(pqueue);
+    candidateStorage.push_back(pqueue);
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
+    NeighborSearchRules* other) :
+    referenceSet(other->referenceSet),
+    querySet(other->querySet),
+    candidates(other->candidates),
+    k(other->k),
+    metric(other->metric),
+    sameSet(other->sameSet),
+    epsilon(other->epsilon),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // The traversal info must point to something invalid but not NULL, just like
+  // in the regular constructor.
+  traversalInfo.LastQueryNode() = (TreeType*) this;
+  traversalInfo.LastReferenceNode() = (TreeType*) this;
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -69,7 +91,7 @@ void NeighborSearchRules<SortPolicy, MetricType, TreeType>::GetResults(
 
   for (size_t i = 0; i < querySet.n_cols; ++i)
   {
-    CandidateList& pqueue = candidates[i];
+    CandidateList& pqueue = (*candidates)[i];
     for (size_t j = 1; j <= k; ++j)
     {
       neighbors(k - j, i) = pqueue.top().second;
@@ -107,6 +129,68 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   return distance;
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline void NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+BatchBaseCase(const std::vector<size_t>& queryIndices, TreeType& referenceNode)
+{
+  BatchBaseCaseImpl(queryIndices, referenceNode, metric);
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+template<typename MetricType2>
+inline void NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                  TreeType& referenceNode,
+                  MetricType2& /* metric */)
+{
+  for (size_t i = 0; i < queryIndices.size(); ++i)
+    for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+      BaseCase(queryIndices[i], referenceNode.Point(j));
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+template<bool TakeRoot>
+inline void NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                  TreeType& referenceNode,
+                  metric::LMetric<2, TakeRoot>& /* metric */)
+{
+  typedef typename TreeType::ElemType ElemType;
+
+  arma::uvec queries(queryIndices.size());
+  for (size_t i = 0; i < queryIndices.size(); ++i)
+    queries[i] = queryIndices[i];
+  arma::uvec references(referenceNode.NumPoints());
+  for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+    references[j] = referenceNode.Point(j);
+
+  arma::Mat<ElemType> distances;
+  const double tolerance = metric::LMetric<2, TakeRoot>::BatchEvaluate(
+      arma::Mat<ElemType>(querySet.cols(queries)),
+      arma::Mat<ElemType>(referenceSet.cols(references)), distances);
+
+  for (size_t i = 0; i < queries.n_elem; ++i)
+  {
+    const size_t queryIndex = queries[i];
+    for (size_t j = 0; j < references.n_elem; ++j)
+    {
+      // Only a pair whose distance could be at least as good as the current
+      // k'th best candidate can change the results, so only these pairs need
+      // the exact distance; the others are not inserted by BaseCase() anyway.
+      const double bestDistance = (*candidates)[queryIndex].top().first;
+      if (SortPolicy::IsBetter(distances(i, j),
+          SortPolicy::CombineWorst(bestDistance, tolerance)))
+      {
+        BaseCase(queryIndex, references[j]);
+      }
+      else if (!sameSet || queryIndex != references[j])
+      {
+        ++baseCases;
+      }
+    }
+  }
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
     const size_t queryIndex,
@@ -125,12 +209,12 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
       // base case.
       if ((referenceNode.Parent() != NULL) &&
           (referenceNode.Point(0) == referenceNode.Parent()->Point(0)))
-        baseCase = referenceNode.Parent()->Stat().LastDistance();
+        baseCase = lastDistances[referenceNode.Parent()];
       else
         baseCase = BaseCase(queryIndex, referenceNode.Point(0));
 
       // Save this evaluation.
-      referenceNode.Stat().LastDistance() = baseCase;
+      lastDistances[&referenceNode] = baseCase;
     }
 
     distance = SortPolicy::CombineBest(baseCase,
@@ -143,7 +227,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
   }
 
   // Compare against the best k'th distance for this query point so far.
-  double bestDistance = candidates[queryIndex].top().first;
+  double bestDistance = (*candidates)[queryIndex].top().first;
   bestDistance = SortPolicy::Relax(bestDistance, epsilon);
 
   return (SortPolicy::IsBetter(distance, bestDistance)) ?
@@ -179,7 +263,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
   const double distance = SortPolicy::ConvertToDistance(oldScore);
 
   // Just check the score again against the distances.
-  double bestDistance = candidates[queryIndex].top().first;
+  double bestDistance = (*candidates)[queryIndex].top().first;
   bestDistance = SortPolicy::Relax(bestDistance, epsilon);
 
   return (SortPolicy::IsBetter(distance, bestDistance)) ? oldScore : DBL_MAX;
@@ -404,7 +488,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   // Loop over points held in the node.
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const double distance = candidates[queryNode.Point(i)].top().first;
+    const double distance = (*candidates)[queryNode.Point(i)].top().first;
     if (SortPolicy::IsBetter(worstDistance, distance))
       worstDistance = distance;
     if (SortPolicy::IsBetter(distance, bestPointDistance))
@@ -499,7 +583,7 @@ InsertNeighbor(
     const size_t neighbor,
     const double distance)
 {
-  CandidateList& pqueue = candidates[queryIndex];
+  CandidateList& pqueue = (*candidates)[queryIndex];
   Candidate c = std::make_pair(distance, neighbor);
 
   if (CandidateCmp()(c, pqueue.top()))
@@ -20,6 +20,7 @@
 #include <mlpack/core/tree/rectangle_tree.hpp>
 #include <mlpack/core/tree/spill_tree.hpp>
 #include <mlpack/core/tree/octree.hpp>
+#include <mlpack/core/data/mapped_file.hpp>
 #include <boost/variant.hpp>
 #include "neighbor_search.hpp"
 
@@ -27,19 +28,41 @@ namespace mlpack {
 namespace neighbor {
 
 /**
- * Alias template for euclidean neighbor search.
+ * Alias template for euclidean neighbor search.  The data is held as double
+ * precision unless MatType is given.
  */
 template<typename SortPolicy,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
+                  typename TreeMatType> class TreeType,
+         typename MatType = arma::mat>
 using NSType = NeighborSearch<SortPolicy,
                               metric::EuclideanDistance,
-                              arma::mat,
+                              MatType,
                               TreeType,
                               TreeType<metric::EuclideanDistance,
                                   NeighborSearchStat<SortPolicy>,
-                                  arma::mat>::template DualTreeTraverser>;
+                                  MatType>::template DualTreeTraverser>;
+
+/**
+ * Recompute the distances between each query point and its neighbors in double
+ * precision.  This is used for models that hold their data in single precision,
+ * to avoid accumulating the distances in single precision; the reference
+ * points themselves are still rounded to single precision, so the distances
+ * are accurate to about 1e-7 relative to the magnitude of the points.  The
+ * neighbors index the reference set of the given NSType in its original order.
+ *
+ * @param ns The NSType that found the neighbors.
+ * @param querySet The query points, or NULL if the query points are the
+ *      reference points themselves (monochromatic search).
+ * @param neighbors The neighbors found for each query point.
+ * @param distances The distances to recompute.
+ */
+template<typename NSType>
+void RecomputeDistances(const NSType& ns,
+                        const arma::mat* querySet,
+                        const arma::Mat<size_t>& neighbors,
+                        arma::mat& distances);
 
 /**
  * MonoSearchVisitor executes a monochromatic neighbor search on the given
@@ -54,6 +77,8 @@ class MonoSearchVisitor : public boost::static_visitor<void>
   arma::Mat<size_t>& neighbors;
   //! Result matrix for distances.
   arma::mat& distances;
+  //! If true, recompute the distances in double precision.
+  const bool doubleDistances;
 
  public:
   //! Perform monochromatic nearest neighbor search.
@@ -63,10 +88,12 @@ class MonoSearchVisitor : public boost::static_visitor<void>
   //! Construct the MonoSearchVisitor object with the given parameters.
   MonoSearchVisitor(const size_t k,
                     arma::Mat<size_t>& neighbors,
-                    arma::mat& distances) :
+                    arma::mat& distances,
+                    const bool doubleDistances = false) :
       k(k),
       neighbors(neighbors),
-      distances(distances)
+      distances(distances),
+      doubleDistances(doubleDistances)
   {};
 };
 
@@ -94,10 +121,13 @@ class BiSearchVisitor : public boost::static_visitor<void>
   const double tau;
   //! Balance threshold (for spill trees).
   const double rho;
+  //! If true, recompute the distances of single-precision models in double
+  //! precision.
+  const bool doubleDistances;
 
   //! Bichromatic neighbor search on the given NSType considering the leafSize.
-  template<typename NSType>
-  void SearchLeaf(NSType* ns) const;
+  template<typename NSType, typename MatType>
+  void SearchLeaf(NSType* ns, const MatType& querySet) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -124,6 +154,9 @@ class BiSearchVisitor : public boost::static_visitor<void>
   //! Bichromatic neighbor search specialized for octrees.
   void operator()(NSTypeT<tree::Octree>* ns) const;
 
+  //! Bichromatic neighbor search specialized for single-precision KDTrees.
+  void operator()(NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const;
+
   //! Construct the BiSearchVisitor.
   BiSearchVisitor(const arma::mat& querySet,
                   const size_t k,
@@ -131,7 +164,8 @@ class BiSearchVisitor : public boost::static_visitor<void>
                   arma::mat& distances,
                   const size_t leafSize,
                   const double tau,
-                  const double rho);
+                  const double rho,
+                  const bool doubleDistances = false);
 };
 
 /**
@@ -154,8 +188,8 @@ class TrainVisitor : public boost::static_visitor<void>
   const double rho;
 
   //! Train on the given NSType considering the leafSize.
-  template<typename NSType>
-  void TrainLeaf(NSType* ns) const;
+  template<typename NSType, typename MatType>
+  void TrainLeaf(NSType* ns, MatType&& dataset) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -182,6 +216,9 @@ class TrainVisitor : public boost::static_visitor<void>
   //! Train specialized for octrees.
   void operator()(NSTypeT<tree::Octree>* ns) const;
 
+  //! Train specialized for single-precision KDTrees.
+  void operator()(NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const;
+
   //! Construct the TrainVisitor object with the given reference set, leafSize
   //! for BinarySpaceTrees, and tau and rho for spill trees.
   TrainVisitor(arma::mat&& referenceSet,
@@ -213,14 +250,25 @@ class EpsilonVisitor : public boost::static_visitor<double&>
 };
 
 /**
- * ReferenceSetVisitor exposes the referenceSet of the given NSType.
+ * ReferenceSetVisitor exposes the referenceSet of the given NSType.  A
+ * std::invalid_argument is thrown if the reference set of the NSType is not of
+ * type MatType.
  */
-class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
+template<typename MatType = arma::mat>
+class ReferenceSetVisitor : public boost::static_visitor<const MatType&>
 {
  public:
   //! Return the reference set.
   template<typename NSType>
-  const arma::mat& operator()(NSType *ns) const;
+  const MatType& operator()(NSType *ns) const;
+
+ private:
+  //! Return the given reference set, which has the right type.
+  const MatType& Get(const MatType& referenceSet) const { return referenceSet; }
+
+  //! Throw, since the reference set does not have the right type.
+  template<typename OtherMatType>
+  const MatType& Get(const OtherMatType& referenceSet) const;
 };
 
 /**
@@ -285,6 +333,13 @@ class NSModel
   //! This is the random projection matrix; only used if randomBasis is true.
   arma::mat q;
 
+  //! If true, the reference set is held in single precision.
+  bool singlePrecision;
+  //! If true, the distances returned by searches of a single-precision model
+  //! are recomputed in double precision (from the rounded reference points).
+  //! This is not serialized.
+  bool doubleDistances;
+
   /**
    * nSearch holds an instance of the NeigborSearch class for the current
    * treeType. It is initialized every time BuildModel is executed.
@@ -304,18 +359,55 @@ class NSModel
                  NSType<SortPolicy, tree::MaxRPTree>*,
                  SpillKNN*,
                  NSType<SortPolicy, tree::UBTree>*,
-                 NSType<SortPolicy, tree::Octree>*> nSearch;
+                 NSType<SortPolicy, tree::Octree>*,
+                 NSType<SortPolicy, tree::KDTree, arma::fmat>*> nSearch;
+
+  //! The memory-mapped file holding the reference tree, if the model was
+  //! loaded with LoadMapped().  It is shared by copies of the model, since
+  //! copies share nSearch.
+  std::shared_ptr<data::MappedFile> mappedFile;
+
+  /**
+   * The header of a memory-mapped model file.  It is followed by the random
+   * basis q (if any), the mapping from tree indices to original indices, and
+   * the image of the reference tree (see tree::MappedTreeHeader).  Each
+   * section is aligned to 64 bytes, and all offsets are from the start of the
+   * file.
+   */
+  struct MappedHeader
+  {
+    char magic[8];
+    uint64_t version;
+    uint64_t treeType;
+    uint64_t leafSize;
+    double tau;
+    double rho;
+    uint64_t randomBasis;
+    uint64_t searchMode;
+    double epsilon;
+    uint64_t qRows;
+    uint64_t qCols;
+    uint64_t qOffset;
+    uint64_t mappingSize;
+    uint64_t mappingOffset;
+    uint64_t treeOffset;
+  };
 
  public:
   /**
    * Initialize the NSModel with the given type and whether or not a random
-   * basis should be used.
+   * basis should be used.  If singlePrecision is true, the reference set is
+   * converted to single precision when the model is built, which halves its
+   * size and speeds up the search; this is only supported for kd-trees.
    *
    * @param treeType Type of tree to use.
    * @param randomBasis Whether or not to project the points onto a random basis
    *      before searching.
+   * @param singlePrecision Whether or not to hold the data in single precision.
    */
-  NSModel(TreeTypes treeType = TreeTypes::KD_TREE, bool randomBasis = false);
+  NSModel(TreeTypes treeType = TreeTypes::KD_TREE,
+          bool randomBasis = false,
+          bool singlePrecision = false);
 
   /**
    * Copy the given NSModel.
@@ -352,8 +444,35 @@ class NSModel
   template<typename Archive>
   void serialize(Archive& ar, const uint32_t /* version */);
 
-  //! Expose the dataset.
+  /**
+   * Save the model to the given file in a flat binary format that can be
+   * memory-mapped by LoadMapped(), so that the reference tree and reference
+   * set are used in place instead of being deserialized.  This is only
+   * available for double-precision kd-tree models that are not in naive mode;
+   * otherwise a std::invalid_argument is thrown.  data::Save() calls this for
+   * files with the extension ".mmap".
+   *
+   * @param filename File to save the model to.
+   */
+  void SaveMapped(const std::string& filename) const;
+
+  /**
+   * Load a model saved with SaveMapped() by memory-mapping the given file.
+   * Nothing but the tree nodes and their statistics is allocated; the file
+   * stays mapped until the model is rebuilt, reloaded or destroyed.  A
+   * std::runtime_error is thrown if the file cannot be mapped, and a
+   * std::invalid_argument if it does not hold a valid model.  data::Load()
+   * calls this for files with the extension ".mmap".
+   *
+   * @param filename File to load the model from.
+   */
+  void LoadMapped(const std::string& filename);
+
+  //! Expose the dataset.  This throws if the model is single-precision.
   const arma::mat& Dataset() const;
+  //! Expose the dataset of a single-precision model.  This throws if the model
+  //! is double-precision.
+  const arma::fmat& FloatDataset() const;
 
   //! Expose SearchMode.
   NeighborSearchMode SearchMode() const;
@@ -383,6 +502,19 @@ class NSModel
   bool RandomBasis() const { return randomBasis; }
   bool& RandomBasis() { return randomBasis; }
 
+  //! Get whether the data is held in single precision.  This is set when the
+  //! model is loaded; change it before calling BuildModel() to convert.
+  bool SinglePrecision() const { return singlePrecision; }
+  //! Modify whether the data is held in single precision.
+  bool& SinglePrecision() { return singlePrecision; }
+
+  //! Get whether the distances found by a single-precision model are
+  //! recomputed in double precision.
+  bool DoubleDistances() const { return doubleDistances; }
+  //! Modify whether the distances found by a single-precision model are
+  //! recomputed in double precision.
+  bool& DoubleDistances() { return doubleDistances; }
+
   //! Build the reference tree.
   void BuildModel(arma::mat&& referenceSet,
                   const size_t leafSize,
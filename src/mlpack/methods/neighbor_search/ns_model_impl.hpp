@@ -21,12 +21,53 @@
 namespace mlpack {
 namespace neighbor {
 
+//! Recompute the distances to the neighbors in double precision, from the
+//! single-precision reference points.
+template<typename NSType>
+void RecomputeDistances(const NSType& ns,
+                        const arma::mat* querySet,
+                        const arma::Mat<size_t>& neighbors,
+                        arma::mat& distances)
+{
+  // The reference set may have been reordered when the tree was built.
+  const std::vector<size_t>& oldFromNew = ns.OldFromNewReferences();
+  std::vector<size_t> newFromOld(oldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    newFromOld[oldFromNew[i]] = i;
+
+  const size_t numReferences = ns.ReferenceSet().n_cols;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    const arma::vec queryPoint = (querySet != NULL) ?
+        arma::vec(querySet->col(i)) :
+        arma::conv_to<arma::vec>::from(ns.ReferenceSet().col(
+            newFromOld.empty() ? i : newFromOld[i]));
+
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      // Skip neighbors that were not found.
+      if (neighbors(j, i) >= numReferences)
+        continue;
+
+      const size_t index = newFromOld.empty() ? neighbors(j, i) :
+          newFromOld[neighbors(j, i)];
+      distances(j, i) = metric::EuclideanDistance::Evaluate(queryPoint,
+          arma::conv_to<arma::vec>::from(ns.ReferenceSet().col(index)));
+    }
+  }
+}
+
 //! Monochromatic neighbor search on the given NSType instance.
 template<typename NSType>
 void MonoSearchVisitor::operator()(NSType *ns) const
 {
   if (ns)
-    return ns->Search(k, neighbors, distances);
+  {
+    ns->Search(k, neighbors, distances);
+    if (doubleDistances)
+      RecomputeDistances(*ns, NULL, neighbors, distances);
+    return;
+  }
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -38,14 +79,16 @@ BiSearchVisitor<SortPolicy>::BiSearchVisitor(const arma::mat& querySet,
                                              arma::mat& distances,
                                              const size_t leafSize,
                                              const double tau,
-                                             const double rho) :
+                                             const double rho,
+                                             const bool doubleDistances) :
     querySet(querySet),
     k(k),
     neighbors(neighbors),
     distances(distances),
     leafSize(leafSize),
     tau(tau),
-    rho(rho)
+    rho(rho),
+    doubleDistances(doubleDistances)
 {}
 
 //! Default Bichromatic neighbor search on the given NSType instance.
@@ -65,7 +108,7 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::KDTree>* ns) const
 {
   if (ns)
-    return SearchLeaf(ns);
+    return SearchLeaf(ns, querySet);
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -74,7 +117,7 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::BallTree>* ns) const
 {
   if (ns)
-    return SearchLeaf(ns);
+    return SearchLeaf(ns, querySet);
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -84,7 +127,8 @@ void BiSearchVisitor<SortPolicy>::operator()(SpillKNN* ns) const
 {
   if (ns)
   {
-    if (ns->SearchMode() == DUAL_TREE_MODE)
+    if (ns->SearchMode() == DUAL_TREE_MODE ||
+        ns->SearchMode() == PARALLEL_DUAL_TREE_MODE)
     {
       // For Dual Tree Search on SpillTrees, the queryTree must be built with
       // non overlapping (tau = 0).
@@ -104,16 +148,33 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::Octree>* ns) const
 {
   if (ns)
-    return SearchLeaf(ns);
+    return SearchLeaf(ns, querySet);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Bichromatic neighbor search specialized for single-precision KDTrees.
+template<typename SortPolicy>
+void BiSearchVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const
+{
+  if (ns)
+  {
+    SearchLeaf(ns, arma::conv_to<arma::fmat>::from(querySet));
+    if (doubleDistances)
+      RecomputeDistances(*ns, &querySet, neighbors, distances);
+    return;
+  }
   throw std::runtime_error("no neighbor search model initialized");
 }
 
 //! Bichromatic neighbor search on the given NSType considering the leafSize.
 template<typename SortPolicy>
-template<typename NSType>
-void BiSearchVisitor<SortPolicy>::SearchLeaf(NSType* ns) const
+template<typename NSType, typename MatType>
+void BiSearchVisitor<SortPolicy>::SearchLeaf(NSType* ns,
+                                             const MatType& querySet) const
 {
-  if (ns->SearchMode() == DUAL_TREE_MODE)
+  if (ns->SearchMode() == DUAL_TREE_MODE ||
+      ns->SearchMode() == PARALLEL_DUAL_TREE_MODE)
   {
     std::vector<size_t> oldFromNewQueries;
     typename NSType::Tree queryTree(std::move(querySet), oldFromNewQueries,
@@ -165,7 +226,7 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(NSTypeT<tree::KDTree>* ns) const
 {
   if (ns)
-    return TrainLeaf(ns);
+    return TrainLeaf(ns, std::move(referenceSet));
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -174,7 +235,7 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(NSTypeT<tree::BallTree>* ns) const
 {
   if (ns)
-    return TrainLeaf(ns);
+    return TrainLeaf(ns, std::move(referenceSet));
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -201,21 +262,37 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(NSTypeT<tree::Octree>* ns) const
 {
   if (ns)
-    return TrainLeaf(ns);
+    return TrainLeaf(ns, std::move(referenceSet));
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Train specialized for single-precision KDTrees.
+template<typename SortPolicy>
+void TrainVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const
+{
+  if (ns)
+  {
+    arma::fmat floatReferenceSet = arma::conv_to<arma::fmat>::from(
+        referenceSet);
+    // The double-precision copy is no longer needed.
+    referenceSet.reset();
+    return TrainLeaf(ns, std::move(floatReferenceSet));
+  }
   throw std::runtime_error("no neighbor search model initialized");
 }
 
 //! Train on the given NSType considering the leafSize.
 template<typename SortPolicy>
-template<typename NSType>
-void TrainVisitor<SortPolicy>::TrainLeaf(NSType* ns) const
+template<typename NSType, typename MatType>
+void TrainVisitor<SortPolicy>::TrainLeaf(NSType* ns, MatType&& dataset) const
 {
   if (ns->SearchMode() == NAIVE_MODE)
-    ns->Train(std::move(referenceSet));
+    ns->Train(std::move(dataset));
   else
   {
     std::vector<size_t> oldFromNewReferences;
-    typename NSType::Tree referenceTree(std::move(referenceSet),
+    typename NSType::Tree referenceTree(std::move(dataset),
         oldFromNewReferences, leafSize);
     ns->Train(std::move(referenceTree));
     // Set the mappings.
@@ -242,14 +319,25 @@ double& EpsilonVisitor::operator()(NSType* ns) const
 }
 
 //! Expose the referenceSet of the given NSType.
+template<typename MatType>
 template<typename NSType>
-const arma::mat& ReferenceSetVisitor::operator()(NSType* ns) const
+const MatType& ReferenceSetVisitor<MatType>::operator()(NSType* ns) const
 {
   if (ns)
-    return ns->ReferenceSet();
+    return Get(ns->ReferenceSet());
   throw std::runtime_error("no neighbor search model initialized");
 }
 
+//! Throw, since the reference set does not have the requested type.
+template<typename MatType>
+template<typename OtherMatType>
+const MatType& ReferenceSetVisitor<MatType>::Get(
+    const OtherMatType& /* referenceSet */) const
+{
+  throw std::invalid_argument("the reference set of the model does not have "
+      "the requested precision");
+}
+
 //! Clean memory, if necessary.
 template<typename NSType>
 void DeleteVisitor::operator()(NSType* ns) const
@@ -263,12 +351,16 @@ void DeleteVisitor::operator()(NSType* ns) const
  * basis should be used.
  */
 template<typename SortPolicy>
-NSModel<SortPolicy>::NSModel(TreeTypes treeType, bool randomBasis) :
+NSModel<SortPolicy>::NSModel(TreeTypes treeType,
+                             bool randomBasis,
+                             bool singlePrecision) :
     treeType(treeType),
     leafSize(20),
     tau(0),
     rho(0.7),
-    randomBasis(randomBasis)
+    randomBasis(randomBasis),
+    singlePrecision(singlePrecision),
+    doubleDistances(false)
 {
   // Nothing to do.
 }
@@ -281,7 +373,10 @@ NSModel<SortPolicy>::NSModel(const NSModel& other) :
     rho(other.rho),
     randomBasis(other.randomBasis),
     q(other.q),
-    nSearch(other.nSearch)
+    singlePrecision(other.singlePrecision),
+    doubleDistances(other.doubleDistances),
+    nSearch(other.nSearch),
+    mappedFile(other.mappedFile)
 {
   // Nothing to do.
 }
@@ -294,7 +389,10 @@ NSModel<SortPolicy>::NSModel(NSModel&& other) :
     rho(other.rho),
     randomBasis(other.randomBasis),
     q(std::move(other.q)),
-    nSearch(other.nSearch)
+    singlePrecision(other.singlePrecision),
+    doubleDistances(other.doubleDistances),
+    nSearch(other.nSearch),
+    mappedFile(std::move(other.mappedFile))
 {
   // Reset parameters of the other model.
   other.treeType = TreeTypes::KD_TREE;
@@ -302,6 +400,8 @@ NSModel<SortPolicy>::NSModel(NSModel&& other) :
   other.tau = 0;
   other.rho = 0.7;
   other.randomBasis = false;
+  other.singlePrecision = false;
+  other.doubleDistances = false;
   other.nSearch = decltype(other.nSearch)();
 }
 
@@ -316,7 +416,10 @@ NSModel<SortPolicy>& NSModel<SortPolicy>::operator=(const NSModel& other)
   rho = other.rho;
   randomBasis = other.randomBasis;
   q = other.q;
+  singlePrecision = other.singlePrecision;
+  doubleDistances = other.doubleDistances;
   nSearch = other.nSearch;
+  mappedFile = other.mappedFile;
 
   return *this;
 }
@@ -332,8 +435,11 @@ NSModel<SortPolicy>& NSModel<SortPolicy>::operator=(NSModel&& other)
   rho = other.rho;
   randomBasis = other.randomBasis;
   q = std::move(other.q);
+  singlePrecision = other.singlePrecision;
+  doubleDistances = other.doubleDistances;
   // Copy the pointer and type.
   nSearch = other.nSearch;
+  mappedFile = std::move(other.mappedFile);
 
   // Reset parameters of the other model.
   other.treeType = TreeTypes::KD_TREE;
@@ -341,6 +447,8 @@ NSModel<SortPolicy>& NSModel<SortPolicy>::operator=(NSModel&& other)
   other.tau = 0;
   other.rho = 0.7;
   other.randomBasis = false;
+  other.singlePrecision = false;
+  other.doubleDistances = false;
   other.nSearch = decltype(other.nSearch)();
 
   return *this;
@@ -367,16 +475,151 @@ void NSModel<SortPolicy>::serialize(Archive& ar, const uint32_t /* version */)
 
   // This should never happen, but just in case, be clean with memory.
   if (cereal::is_loading<Archive>())
+  {
     boost::apply_visitor(DeleteVisitor(), nSearch);
+    mappedFile.reset();
+  }
 
   ar(CEREAL_VARIANT_POINTER(nSearch));
+
+  // The precision is implied by the type of the model.
+  if (cereal::is_loading<Archive>())
+  {
+    typedef NSType<SortPolicy, tree::KDTree, arma::fmat> FloatKDTreeNSType;
+    singlePrecision = (boost::get<FloatKDTreeNSType*>(&nSearch) != NULL);
+  }
+}
+
+//! Save the model to a memory-mappable file.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::SaveMapped(const std::string& filename) const
+{
+  typedef NSType<SortPolicy, tree::KDTree> KDTreeNSType;
+  KDTreeNSType* const* ns = boost::get<KDTreeNSType*>(&nSearch);
+  if (treeType != KD_TREE || !ns || !(*ns) ||
+      (*ns)->SearchMode() == NAIVE_MODE)
+  {
+    throw std::invalid_argument("only double-precision kd-tree models that do "
+        "not use naive search can be saved in the memory-mapped format");
+  }
+
+  const std::vector<size_t>& oldFromNew = (*ns)->OldFromNewReferences();
+  std::vector<uint64_t> mapping(oldFromNew.begin(), oldFromNew.end());
+
+  MappedHeader header;
+  std::memset(&header, 0, sizeof(MappedHeader));
+  std::memcpy(header.magic, "MLPKNSM", 8);
+  header.version = 1;
+  header.treeType = treeType;
+  header.leafSize = leafSize;
+  header.tau = tau;
+  header.rho = rho;
+  header.randomBasis = randomBasis;
+  header.searchMode = (*ns)->SearchMode();
+  header.epsilon = (*ns)->Epsilon();
+  header.qRows = q.n_rows;
+  header.qCols = q.n_cols;
+  header.qOffset = data::MappedAlign(sizeof(MappedHeader));
+  header.mappingSize = mapping.size();
+  header.mappingOffset = data::MappedAlign(header.qOffset +
+      q.n_elem * sizeof(double));
+  header.treeOffset = data::MappedAlign(header.mappingOffset +
+      mapping.size() * sizeof(uint64_t));
+
+  std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
+  if (!ofs.is_open())
+    throw std::runtime_error("unable to open file '" + filename + "'");
+
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(MappedHeader));
+  size_t position = data::MappedPad(ofs, sizeof(MappedHeader));
+  ofs.write(reinterpret_cast<const char*>(q.memptr()),
+      q.n_elem * sizeof(double));
+  position = data::MappedPad(ofs, position + q.n_elem * sizeof(double));
+  ofs.write(reinterpret_cast<const char*>(mapping.data()),
+      mapping.size() * sizeof(uint64_t));
+  data::MappedPad(ofs, position + mapping.size() * sizeof(uint64_t));
+
+  (*ns)->ReferenceTree().SaveMapped(ofs);
+}
+
+//! Load the model from a memory-mapped file.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::LoadMapped(const std::string& filename)
+{
+  typedef NSType<SortPolicy, tree::KDTree> KDTreeNSType;
+  typedef typename KDTreeNSType::Tree KDTreeType;
+
+  std::shared_ptr<data::MappedFile> file(new data::MappedFile(filename));
+  const size_t size = file->Size();
+
+  MappedHeader header;
+  if (size < sizeof(MappedHeader))
+    throw std::invalid_argument("file is too small to hold a model");
+  std::memcpy(&header, file->Data(), sizeof(MappedHeader));
+
+  if (std::memcmp(header.magic, "MLPKNSM", 8) != 0 || header.version != 1)
+  {
+    throw std::invalid_argument("file does not hold a memory-mapped model of a "
+        "supported version");
+  }
+  if (header.treeType != (uint64_t) KD_TREE ||
+      header.searchMode == (uint64_t) NAIVE_MODE ||
+      header.searchMode > (uint64_t) PARALLEL_DUAL_TREE_MODE ||
+      header.qOffset + header.qRows * header.qCols * sizeof(double) >
+          header.mappingOffset ||
+      header.mappingOffset + header.mappingSize * sizeof(uint64_t) >
+          header.treeOffset ||
+      header.treeOffset > size || header.treeOffset % 64 != 0)
+  {
+    throw std::invalid_argument("memory-mapped model is corrupt");
+  }
+
+  // The random basis and the mapping are small, so they are copied.
+  const double* qMemory =
+      reinterpret_cast<const double*>(file->Data() + header.qOffset);
+  arma::mat newQ(qMemory, header.qRows, header.qCols);
+  const uint64_t* mapping =
+      reinterpret_cast<const uint64_t*>(file->Data() + header.mappingOffset);
+  std::vector<size_t> oldFromNew(mapping, mapping + header.mappingSize);
+
+  // The tree and its dataset are used in place.
+  KDTreeType tree(file->Data() + header.treeOffset, size - header.treeOffset);
+  if (!oldFromNew.empty() && (oldFromNew.size() != tree.Dataset().n_cols ||
+      *std::max_element(oldFromNew.begin(), oldFromNew.end()) >=
+      tree.Dataset().n_cols))
+  {
+    throw std::invalid_argument("memory-mapped model is corrupt");
+  }
+
+  KDTreeNSType* ns = new KDTreeNSType(std::move(tree),
+      (NeighborSearchMode) header.searchMode, header.epsilon);
+  ns->OldFromNewReferences() = std::move(oldFromNew);
+
+  // Now that everything has been loaded, replace the current model.
+  boost::apply_visitor(DeleteVisitor(), nSearch);
+  nSearch = ns;
+  mappedFile = std::move(file);
+  treeType = KD_TREE;
+  singlePrecision = false;
+  leafSize = header.leafSize;
+  tau = header.tau;
+  rho = header.rho;
+  randomBasis = (header.randomBasis != 0);
+  q = std::move(newQ);
 }
 
 //! Expose the dataset.
 template<typename SortPolicy>
 const arma::mat& NSModel<SortPolicy>::Dataset() const
 {
-  return boost::apply_visitor(ReferenceSetVisitor(), nSearch);
+  return boost::apply_visitor(ReferenceSetVisitor<arma::mat>(), nSearch);
+}
+
+//! Expose the dataset of a single-precision model.
+template<typename SortPolicy>
+const arma::fmat& NSModel<SortPolicy>::FloatDataset() const
+{
+  return boost::apply_visitor(ReferenceSetVisitor<arma::fmat>(), nSearch);
 }
 
 //! Access the search mode.
@@ -412,6 +655,12 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
                                      const NeighborSearchMode searchMode,
                                      const double epsilon)
 {
+  if (singlePrecision && treeType != KD_TREE)
+  {
+    throw std::invalid_argument("single-precision models are only supported "
+        "with kd-trees");
+  }
+
   this->leafSize = leafSize;
   // Initialize random basis if necessary.
   if (randomBasis)
@@ -447,6 +696,7 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
 
   // Clean memory, if necessary.
   boost::apply_visitor(DeleteVisitor(), nSearch);
+  mappedFile.reset();
 
   // Do we need to modify the reference set?
   if (randomBasis)
@@ -461,7 +711,15 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
   switch (treeType)
   {
     case KD_TREE:
-      nSearch = new NSType<SortPolicy, tree::KDTree>(searchMode, epsilon);
+      if (singlePrecision)
+      {
+        nSearch = new NSType<SortPolicy, tree::KDTree, arma::fmat>(searchMode,
+            epsilon);
+      }
+      else
+      {
+        nSearch = new NSType<SortPolicy, tree::KDTree>(searchMode, epsilon);
+      }
       break;
     case COVER_TREE:
       nSearch = new NSType<SortPolicy, tree::StandardCoverTree>(searchMode,
@@ -547,10 +805,14 @@ void NSModel<SortPolicy>::Search(arma::mat&& querySet,
       Log::Info << "greedy single-tree " << TreeName() << " search..."
           << std::endl;
       break;
+    case PARALLEL_DUAL_TREE_MODE:
+      Log::Info << "parallel dual-tree " << TreeName() << " search..."
+          << std::endl;
+      break;
   }
 
   BiSearchVisitor<SortPolicy> search(querySet, k, neighbors, distances,
-      leafSize, tau, rho);
+      leafSize, tau, rho, singlePrecision && doubleDistances);
   boost::apply_visitor(search, nSearch);
 }
 
@@ -577,13 +839,18 @@ void NSModel<SortPolicy>::Search(const size_t k,
       Log::Info << "greedy single-tree " << TreeName() << " search..."
           << std::endl;
       break;
+    case PARALLEL_DUAL_TREE_MODE:
+      Log::Info << "parallel dual-tree " << TreeName() << " search..."
+          << std::endl;
+      break;
   }
 
   if (Epsilon() != 0 && SearchMode() != NAIVE_MODE)
     Log::Info << "Maximum of " << Epsilon() * 100 << "% relative error."
         << std::endl;
 
-  MonoSearchVisitor search(k, neighbors, distances);
+  MonoSearchVisitor search(k, neighbors, distances,
+      singlePrecision && doubleDistances);
   boost::apply_visitor(search, nSearch);
 }
 
@@ -0,0 +1,271 @@
+/**
+ * @file methods/neighbor_search/quantized_search.hpp
+ *
+ * Defines the QuantizedSearch class, which performs approximate nearest
+ * neighbor search over a compressed (quantized) reference set.
+ *
+ * The method is the inverted file with asymmetric distance computation
+ * (IVFADC) of the following paper:
+ *
+ * @code
+ * @article{jegou2011product,
+ *  title={Product quantization for nearest neighbor search},
+ *  author={J{\'e}gou, H. and Douze, M. and Schmid, C.},
+ *  journal={IEEE Transactions on Pattern Analysis and Machine Intelligence},
+ *  volume={33},
+ *  number={1},
+ *  pages={117--128},
+ *  year={2011}
+ * }
+ * @endcode
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_SEARCH_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_SEARCH_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include <mlpack/methods/lsh/lsh_search.hpp>
+#include "neighbor_search.hpp"
+#include "quantizers/product_quantizer.hpp"
+#include "quantizers/scalar_quantizer.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The QuantizedSearch class computes approximate nearest neighbors (with the
+ * Euclidean distance) without holding the reference set in memory.  The
+ * reference points are split into cells with k-means, and every point is
+ * stored as the quantized code of its offset from the centroid of its cell;
+ * with a ProductQuantizer this typically takes 8 to 64 bytes per point.
+ *
+ * To answer a query, the closest cells are found by searching the cell
+ * centroids with CoarseSearchType, and the points of those cells are ranked by
+ * their asymmetric distance to the query (the exact query against the
+ * quantized points), which is computed from a small table of precomputed
+ * distances.  The search may then re-rank the best candidates with their exact
+ * distances, if the caller can provide the reference set (for instance, memory
+ * mapped from disk).
+ *
+ * CoarseSearchType may be NeighborSearch (in any mode; for instance,
+ * `KNN(SINGLE_TREE_MODE)` or `KNN(NAIVE_MODE)`) or LSHSearch.  With a single
+ * cell, no coarse search is done and every point is scanned.
+ *
+ * Since points may be added in chunks with Add(), the quantizer can be trained
+ * on a sample of the data and the reference set never needs to be loaded at
+ * once:
+ *
+ * @code
+ * QuantizedSearch<> search(ProductQuantizer(16), KNN(SINGLE_TREE_MODE));
+ * search.Train(sample, 1024);
+ * while (reader.Read(chunk, 100000) > 0)
+ *   search.Add(chunk);
+ * search.Probes() = 8;
+ * search.Search(queries, 10, neighbors, distances);
+ * @endcode
+ *
+ * @tparam QuantizerType Type of quantizer; see ProductQuantizer and
+ *     ScalarQuantizer.
+ * @tparam CoarseSearchType Type of search used to find the closest cells.
+ */
+template<
+    typename QuantizerType = ProductQuantizer,
+    typename CoarseSearchType = NeighborSearch<NearestNeighborSort,
+                                               metric::EuclideanDistance>
+>
+class QuantizedSearch
+{
+ public:
+  /**
+   * Create an empty model with the given (untrained) quantizer and coarse
+   * search.  Call Train() and Add() before calling Search().
+   *
+   * @param quantizer Quantizer to encode points with.
+   * @param coarseSearch Search used to find the closest cells; its settings
+   *     (such as the search mode) are kept when it is trained on the cell
+   *     centroids.
+   */
+  QuantizedSearch(QuantizerType quantizer = QuantizerType(),
+                  CoarseSearchType coarseSearch = CoarseSearchType());
+
+  /**
+   * Train the model on the given reference set and add all of its points.
+   *
+   * @param referenceSet Set of reference points.
+   * @param numCells Number of cells to split the points into.
+   * @param quantizer Quantizer to encode points with.
+   * @param coarseSearch Search used to find the closest cells.
+   */
+  QuantizedSearch(const arma::mat& referenceSet,
+                  const size_t numCells = 1,
+                  QuantizerType quantizer = QuantizerType(),
+                  CoarseSearchType coarseSearch = CoarseSearchType());
+
+  /**
+   * Compute the cells and train the quantizer on the given points, and remove
+   * any points from the model.  The training set may be a sample of the
+   * reference set; the reference points are added with Add().
+   *
+   * @param trainingSet Points to train on.
+   * @param numCells Number of cells to split the points into.
+   * @param maxIterations Maximum number of k-means iterations used to find the
+   *     cells.
+   */
+  void Train(const arma::mat& trainingSet,
+             const size_t numCells = 1,
+             const size_t maxIterations = 25);
+
+  /**
+   * Encode the given points and add them to the model.  The points are given
+   * the indices Size(), Size() + 1, and so on.
+   *
+   * @param points Points to add.
+   */
+  void Add(const arma::mat& points);
+
+  /**
+   * Compute the approximate nearest neighbors of the points in the given query
+   * set, using the asymmetric distances to the quantized points.  The
+   * distances returned are these approximate distances.  Queries are answered
+   * in parallel when OpenMP is available.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Compute the approximate nearest neighbors of the points in the given query
+   * set, and re-rank the best Shortlist() candidates of each query with their
+   * exact distances, which are computed from the given reference set.  The
+   * reference set must hold the points in the order they were added; it is
+   * only read at the indices of the candidates, so it may be memory mapped.
+   *
+   * @param querySet Set of query points.
+   * @param referenceSet Set of reference points, in the order they were added.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const arma::mat& querySet,
+              const arma::mat& referenceSet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Serialize the model.
+   *
+   * @param ar Archive to serialize to.
+   * @param version serialize class version to provide backward compatibility
+   */
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t version);
+
+  //! Get the number of points in the model.
+  size_t Size() const { return numPoints; }
+  //! Get the number of cells.
+  size_t NumCells() const { return centroids.n_cols; }
+  //! Get the centroids of the cells.
+  const arma::mat& Centroids() const { return centroids; }
+  //! Get the indices of the points of the given cell.
+  const std::vector<size_t>& CellIndices(const size_t cell) const
+  { return cellIndices[cell]; }
+
+  //! Get the number of cells scanned for each query.
+  size_t Probes() const { return probes; }
+  //! Modify the number of cells scanned for each query.
+  size_t& Probes() { return probes; }
+
+  //! Get the number of candidates re-ranked with their exact distances (if
+  //! fewer than k, k candidates are re-ranked).
+  size_t Shortlist() const { return shortlist; }
+  //! Modify the number of candidates re-ranked with their exact distances.
+  size_t& Shortlist() { return shortlist; }
+
+  //! Get the quantizer.
+  const QuantizerType& Quantizer() const { return quantizer; }
+  //! Get the coarse search.
+  const CoarseSearchType& CoarseSearch() const { return coarseSearch; }
+
+ private:
+  /**
+   * Find the given number of candidates with the smallest asymmetric distances
+   * for every query.  Missing candidates are set to SIZE_MAX.
+   *
+   * @param querySet Set of query points.
+   * @param numCandidates Number of candidates to find.
+   * @param candidates Matrix storing the candidates of each query.
+   * @param distances Matrix storing the squared asymmetric distances.
+   */
+  void Candidates(const arma::mat& querySet,
+                  const size_t numCandidates,
+                  arma::Mat<size_t>& candidates,
+                  arma::mat& distances);
+
+  /**
+   * Find the given number of closest cells for every point.
+   *
+   * @param points Points to find the cells of.
+   * @param numProbes Number of cells to find.
+   * @param cells Matrix storing the cells of each point; cells that could not
+   *     be found are set to NumCells().
+   */
+  void ClosestCells(const arma::mat& points,
+                    const size_t numProbes,
+                    arma::Mat<size_t>& cells);
+
+  //! Train a NeighborSearch (or any search with Train(MatType)) on the cell
+  //! centroids.
+  template<typename SearchType>
+  static void TrainCoarseSearch(SearchType& search, arma::mat cellCentroids);
+
+  //! Train an LSHSearch on the cell centroids, keeping its number of
+  //! projections and tables (the defaults of the lsh binding are used for an
+  //! untrained model).
+  template<typename SortPolicy>
+  static void TrainCoarseSearch(LSHSearch<SortPolicy, arma::mat>& search,
+                                arma::mat cellCentroids);
+
+  //! The quantizer.
+  QuantizerType quantizer;
+  //! The search over the cell centroids.
+  CoarseSearchType coarseSearch;
+
+  //! The centroids of the cells.
+  arma::mat centroids;
+  //! The codes of the points of each cell, one after the other.
+  std::vector<std::vector<unsigned char>> cellCodes;
+  //! The indices of the points of each cell.
+  std::vector<std::vector<size_t>> cellIndices;
+  //! The number of points.
+  size_t numPoints;
+
+  //! The number of cells scanned for each query.
+  size_t probes;
+  //! The number of candidates re-ranked with their exact distances.
+  size_t shortlist;
+
+  //! Candidate represents a possible neighbor (distance, index).
+  typedef std::pair<double, size_t> Candidate;
+}; // class QuantizedSearch
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "quantized_search_impl.hpp"
+
+#endif
@@ -0,0 +1,353 @@
+/**
+ * @file methods/neighbor_search/quantized_search_impl.hpp
+ *
+ * Implementation of the QuantizedSearch class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_SEARCH_IMPL_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "quantized_search.hpp"
+
+#include <mlpack/methods/kmeans/kmeans.hpp>
+
+#include <queue>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename QuantizerType, typename CoarseSearchType>
+QuantizedSearch<QuantizerType, CoarseSearchType>::QuantizedSearch(
+    QuantizerType quantizer,
+    CoarseSearchType coarseSearch) :
+    quantizer(std::move(quantizer)),
+    coarseSearch(std::move(coarseSearch)),
+    numPoints(0),
+    probes(1),
+    shortlist(100)
+{
+  // Nothing to do.
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+QuantizedSearch<QuantizerType, CoarseSearchType>::QuantizedSearch(
+    const arma::mat& referenceSet,
+    const size_t numCells,
+    QuantizerType quantizer,
+    CoarseSearchType coarseSearch) :
+    quantizer(std::move(quantizer)),
+    coarseSearch(std::move(coarseSearch)),
+    numPoints(0),
+    probes(1),
+    shortlist(100)
+{
+  Train(referenceSet, numCells);
+  Add(referenceSet);
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::Train(
+    const arma::mat& trainingSet,
+    const size_t numCells,
+    const size_t maxIterations)
+{
+  if (numCells == 0 || numCells > trainingSet.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "QuantizedSearch::Train(): the number of cells (" << numCells
+        << ") must be between 1 and the number of training points ("
+        << trainingSet.n_cols << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  arma::Row<size_t> assignments;
+  if (numCells == 1)
+  {
+    centroids = arma::mean(trainingSet, 1);
+    assignments.zeros(trainingSet.n_cols);
+  }
+  else
+  {
+    kmeans::KMeans<> kmeans(maxIterations);
+    kmeans.Cluster(trainingSet, numCells, assignments, centroids);
+  }
+
+  // The quantizer encodes the offsets of the points from their cell centroid.
+  arma::mat residuals = trainingSet -
+      centroids.cols(arma::conv_to<arma::uvec>::from(assignments));
+  quantizer.Train(residuals);
+
+  if (numCells > 1)
+    TrainCoarseSearch(coarseSearch, centroids);
+
+  cellCodes.clear();
+  cellCodes.resize(numCells);
+  cellIndices.clear();
+  cellIndices.resize(numCells);
+  numPoints = 0;
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::Add(
+    const arma::mat& points)
+{
+  if (centroids.n_cols == 0)
+  {
+    throw std::invalid_argument("QuantizedSearch::Add(): the model must be "
+        "trained before points are added");
+  }
+  if (points.n_rows != centroids.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "QuantizedSearch::Add(): dimensionality of points ("
+        << points.n_rows << ") is not equal to the dimensionality the model "
+        << "was trained on (" << centroids.n_rows << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  arma::Mat<size_t> cells;
+  ClosestCells(points, 1, cells);
+
+  const arma::mat residuals = points -
+      centroids.cols(arma::conv_to<arma::uvec>::from(cells.row(0)));
+  arma::Mat<unsigned char> codes;
+  quantizer.Encode(residuals, codes);
+
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    const size_t cell = cells(0, i);
+    cellCodes[cell].insert(cellCodes[cell].end(), codes.colptr(i),
+        codes.colptr(i) + codes.n_rows);
+    cellIndices[cell].push_back(numPoints + i);
+  }
+
+  numPoints += points.n_cols;
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::Search(
+    const arma::mat& querySet,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  Candidates(querySet, k, neighbors, distances);
+
+  // The asymmetric distances are squared.
+  distances.transform([](const double d)
+      { return (d == DBL_MAX) ? d : std::sqrt(d); });
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::Search(
+    const arma::mat& querySet,
+    const arma::mat& referenceSet,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  if (referenceSet.n_cols != numPoints ||
+      referenceSet.n_rows != centroids.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "QuantizedSearch::Search(): the reference set has "
+        << referenceSet.n_cols << " points of dimensionality "
+        << referenceSet.n_rows << ", but the model holds " << numPoints
+        << " points of dimensionality " << centroids.n_rows << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  arma::Mat<size_t> candidates;
+  arma::mat candidateDistances;
+  Candidates(querySet, std::max(k, std::min(shortlist, numPoints)),
+      candidates, candidateDistances);
+
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(SIZE_MAX);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(DBL_MAX);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+  {
+    std::vector<Candidate> exact;
+    exact.reserve(candidates.n_rows);
+    for (size_t j = 0; j < candidates.n_rows; ++j)
+    {
+      const size_t index = candidates(j, i);
+      if (index == SIZE_MAX)
+        break;
+
+      exact.emplace_back(metric::EuclideanDistance::Evaluate(querySet.col(i),
+          referenceSet.col(index)), index);
+    }
+
+    const size_t found = std::min(k, exact.size());
+    std::partial_sort(exact.begin(), exact.begin() + found, exact.end());
+    for (size_t j = 0; j < found; ++j)
+    {
+      neighbors(j, i) = exact[j].second;
+      distances(j, i) = exact[j].first;
+    }
+  }
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+template<typename Archive>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::serialize(
+    Archive& ar,
+    const uint32_t /* version */)
+{
+  ar(CEREAL_NVP(quantizer));
+  ar(CEREAL_NVP(coarseSearch));
+  ar(CEREAL_NVP(centroids));
+  ar(CEREAL_NVP(cellCodes));
+  ar(CEREAL_NVP(cellIndices));
+  ar(CEREAL_NVP(numPoints));
+  ar(CEREAL_NVP(probes));
+  ar(CEREAL_NVP(shortlist));
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::Candidates(
+    const arma::mat& querySet,
+    const size_t numCandidates,
+    arma::Mat<size_t>& candidates,
+    arma::mat& distances)
+{
+  if (querySet.n_rows != centroids.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "QuantizedSearch::Search(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality the model "
+        << "was trained on (" << centroids.n_rows << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (numCandidates > numPoints)
+  {
+    std::ostringstream oss;
+    oss << "QuantizedSearch::Search(): requested " << numCandidates
+        << " approximate nearest neighbors, but the model holds " << numPoints
+        << " points!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  candidates.set_size(numCandidates, querySet.n_cols);
+  candidates.fill(SIZE_MAX);
+  distances.set_size(numCandidates, querySet.n_cols);
+  distances.fill(DBL_MAX);
+
+  if (numCandidates == 0)
+    return;
+
+  arma::Mat<size_t> cells;
+  ClosestCells(querySet, std::min(std::max(probes, (size_t) 1),
+      (size_t) centroids.n_cols), cells);
+
+  const size_t codeSize = quantizer.CodeSize();
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+  {
+    // The worst of the best candidates so far is on top.
+    std::priority_queue<Candidate> best;
+    arma::mat table;
+    arma::vec residual;
+
+    for (size_t p = 0; p < cells.n_rows; ++p)
+    {
+      const size_t cell = cells(p, i);
+      if (cell >= centroids.n_cols || cellIndices[cell].empty())
+        continue;
+
+      residual = querySet.col(i) - centroids.col(cell);
+      quantizer.DistanceTable(residual, table);
+
+      const std::vector<size_t>& indices = cellIndices[cell];
+      const unsigned char* code = cellCodes[cell].data();
+      for (size_t j = 0; j < indices.size(); ++j, code += codeSize)
+      {
+        const double distance = quantizer.Distance(table, code);
+        if (best.size() < numCandidates)
+        {
+          best.emplace(distance, indices[j]);
+        }
+        else if (distance < best.top().first)
+        {
+          best.pop();
+          best.emplace(distance, indices[j]);
+        }
+      }
+    }
+
+    for (size_t j = best.size(); j > 0; --j)
+    {
+      candidates(j - 1, i) = best.top().second;
+      distances(j - 1, i) = best.top().first;
+      best.pop();
+    }
+  }
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::ClosestCells(
+    const arma::mat& points,
+    const size_t numProbes,
+    arma::Mat<size_t>& cells)
+{
+  // With a single cell there is nothing to search.
+  if (centroids.n_cols == 1)
+  {
+    cells.zeros(1, points.n_cols);
+    return;
+  }
+
+  arma::mat cellDistances;
+  coarseSearch.Search(points, numProbes, cells, cellDistances);
+
+  // An approximate coarse search may not find any cell for a point; then, the
+  // closest centroid is found by brute force.
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    if (cells(0, i) < centroids.n_cols)
+      continue;
+
+    arma::mat differences = centroids;
+    differences.each_col() -= points.col(i);
+    cells(0, i) = arma::index_min(arma::sum(arma::square(differences), 0));
+  }
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+template<typename SearchType>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::TrainCoarseSearch(
+    SearchType& search,
+    arma::mat cellCentroids)
+{
+  search.Train(std::move(cellCentroids));
+}
+
+template<typename QuantizerType, typename CoarseSearchType>
+template<typename SortPolicy>
+void QuantizedSearch<QuantizerType, CoarseSearchType>::TrainCoarseSearch(
+    LSHSearch<SortPolicy, arma::mat>& search,
+    arma::mat cellCentroids)
+{
+  // The offsets hold one row per projection and one column per table.
+  const bool trained = (search.Offsets().n_elem > 0);
+  const size_t numProj = trained ? search.Offsets().n_rows : 10;
+  const size_t numTables = trained ? search.Offsets().n_cols : 30;
+  search.Train(std::move(cellCentroids), numProj, numTables, 0.0, 99901,
+      search.BucketSize());
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
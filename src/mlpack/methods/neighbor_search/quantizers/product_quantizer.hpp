@@ -0,0 +1,162 @@
+/**
+ * @file methods/neighbor_search/quantizers/product_quantizer.hpp
+ *
+ * Definition of the ProductQuantizer class, which compresses a point to one
+ * byte per subspace.
+ *
+ * The details of this method can be found in the following paper:
+ *
+ * @code
+ * @article{jegou2011product,
+ *  title={Product quantization for nearest neighbor search},
+ *  author={J{\'e}gou, H. and Douze, M. and Schmid, C.},
+ *  journal={IEEE Transactions on Pattern Analysis and Machine Intelligence},
+ *  volume={33},
+ *  number={1},
+ *  pages={117--128},
+ *  year={2011}
+ * }
+ * @endcode
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_PRODUCT_QUANTIZER_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_PRODUCT_QUANTIZER_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The ProductQuantizer splits the dimensions of the data into a number of
+ * contiguous subspaces and clusters each subspace independently with k-means
+ * into (at most) 256 centroids.  A point is encoded as the index of the closest
+ * centroid in every subspace, so a point is stored in one byte per subspace;
+ * for instance, 128-dimensional points with 16 subspaces are stored in 16
+ * bytes instead of the 1024 bytes of an arma::mat column.
+ *
+ * The squared Euclidean distance between a query and an encoded point is
+ * computed with an asymmetric distance table, which holds the squared distance
+ * between each subvector of the query and every centroid of its subspace; the
+ * distance to a point is then the sum of one table entry per subspace.
+ *
+ * This class implements the same interface as ScalarQuantizer, and can be used
+ * with QuantizedSearch.
+ */
+class ProductQuantizer
+{
+ public:
+  /**
+   * Create an untrained quantizer.
+   *
+   * @param subspaces Number of subspaces (and bytes per encoded point).
+   * @param maxIterations Maximum number of k-means iterations used to find the
+   *     centroids of each subspace.
+   */
+  ProductQuantizer(const size_t subspaces = 8,
+                   const size_t maxIterations = 25) :
+      subspaces(subspaces),
+      maxIterations(maxIterations)
+  { }
+
+  /**
+   * Compute the centroids of every subspace of the given data.  The data must
+   * have at least as many dimensions as there are subspaces.
+   *
+   * @param data Training points.
+   */
+  void Train(const arma::mat& data);
+
+  /**
+   * Encode the given points; each column of codes holds CodeSize() bytes.
+   *
+   * @param data Points to encode.
+   * @param codes Matrix to store the codes in.
+   */
+  void Encode(const arma::mat& data, arma::Mat<unsigned char>& codes) const;
+
+  /**
+   * Compute the approximation of the given encoded points.
+   *
+   * @param codes Codes to decode.
+   * @param data Matrix to store the decoded points in.
+   */
+  void Decode(const arma::Mat<unsigned char>& codes, arma::mat& data) const;
+
+  /**
+   * Compute the asymmetric distance table of the given query: the entry (c, s)
+   * is the squared distance between subspace s of the query and centroid c of
+   * that subspace.
+   *
+   * @param query Query point.
+   * @param table Matrix to store the table in.
+   */
+  template<typename VecType>
+  void DistanceTable(const VecType& query, arma::mat& table) const;
+
+  /**
+   * Return the squared Euclidean distance between the query whose distance
+   * table is given and the encoded point.
+   *
+   * @param table Distance table of the query, as given by DistanceTable().
+   * @param code Code of the point (CodeSize() bytes).
+   */
+  double Distance(const arma::mat& table, const unsigned char* code) const
+  {
+    double distance = 0.0;
+    const double* column = table.memptr();
+    for (size_t s = 0; s < table.n_cols; ++s, column += table.n_rows)
+      distance += column[code[s]];
+    return distance;
+  }
+
+  //! Return the number of bytes used to encode a point.
+  size_t CodeSize() const { return codebooks.size(); }
+
+  //! Get the number of subspaces.
+  size_t Subspaces() const { return subspaces; }
+  //! Modify the number of subspaces (this takes effect at the next Train()).
+  size_t& Subspaces() { return subspaces; }
+
+  //! Get the maximum number of k-means iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of k-means iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the centroids of the given subspace (one per column).
+  const arma::mat& Codebook(const size_t subspace) const
+  { return codebooks[subspace]; }
+
+  //! Serialize the quantizer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */)
+  {
+    ar(CEREAL_NVP(subspaces));
+    ar(CEREAL_NVP(maxIterations));
+    ar(CEREAL_NVP(codebooks));
+    ar(CEREAL_NVP(boundaries));
+  }
+
+ private:
+  //! The number of subspaces.
+  size_t subspaces;
+  //! The maximum number of k-means iterations.
+  size_t maxIterations;
+
+  //! The centroids of every subspace.
+  std::vector<arma::mat> codebooks;
+  //! The first dimension of every subspace, followed by the dimensionality.
+  std::vector<size_t> boundaries;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "product_quantizer_impl.hpp"
+
+#endif
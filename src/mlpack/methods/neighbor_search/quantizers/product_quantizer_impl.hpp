@@ -0,0 +1,118 @@
+/**
+ * @file methods/neighbor_search/quantizers/product_quantizer_impl.hpp
+ *
+ * Implementation of the ProductQuantizer class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_PRODUCT_QUANTIZER_IMPL_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_PRODUCT_QUANTIZER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "product_quantizer.hpp"
+
+#include <mlpack/methods/kmeans/kmeans.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+inline void ProductQuantizer::Train(const arma::mat& data)
+{
+  if (subspaces == 0 || subspaces > data.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "ProductQuantizer::Train(): the number of subspaces (" << subspaces
+        << ") must be between 1 and the dimensionality of the data ("
+        << data.n_rows << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+  if (data.n_cols == 0)
+  {
+    throw std::invalid_argument("ProductQuantizer::Train(): cannot train on an "
+        "empty dataset");
+  }
+
+  // Spread the dimensions as evenly as possible over the subspaces.
+  boundaries.resize(subspaces + 1);
+  for (size_t s = 0; s <= subspaces; ++s)
+    boundaries[s] = (s * data.n_rows) / subspaces;
+
+  const size_t centroids = std::min(data.n_cols, (arma::uword) 256);
+  codebooks.resize(subspaces);
+  kmeans::KMeans<> kmeans(maxIterations);
+  for (size_t s = 0; s < subspaces; ++s)
+  {
+    const arma::mat subspaceData = data.rows(boundaries[s],
+        boundaries[s + 1] - 1);
+    kmeans.Cluster(subspaceData, centroids, codebooks[s]);
+  }
+}
+
+inline void ProductQuantizer::Encode(const arma::mat& data,
+                                     arma::Mat<unsigned char>& codes) const
+{
+  if (boundaries.empty() || data.n_rows != boundaries.back())
+  {
+    std::ostringstream oss;
+    oss << "ProductQuantizer::Encode(): dimensionality of data ("
+        << data.n_rows << ") is not equal to the dimensionality the quantizer "
+        << "was trained on (" << (boundaries.empty() ? 0 : boundaries.back())
+        << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  codes.set_size(codebooks.size(), data.n_cols);
+  for (size_t s = 0; s < codebooks.size(); ++s)
+  {
+    // The closest centroid minimizes ||c||^2 - 2 c^T x, which is computed for
+    // all points with one matrix product.
+    const arma::mat& codebook = codebooks[s];
+    arma::mat scores = -2.0 * codebook.t() *
+        data.rows(boundaries[s], boundaries[s + 1] - 1);
+    scores.each_col() += arma::sum(arma::square(codebook), 0).t();
+
+    const arma::urowvec closest = arma::index_min(scores, 0);
+    for (size_t i = 0; i < data.n_cols; ++i)
+      codes(s, i) = (unsigned char) closest[i];
+  }
+}
+
+inline void ProductQuantizer::Decode(const arma::Mat<unsigned char>& codes,
+                                     arma::mat& data) const
+{
+  data.set_size(boundaries.back(), codes.n_cols);
+  for (size_t i = 0; i < codes.n_cols; ++i)
+  {
+    for (size_t s = 0; s < codebooks.size(); ++s)
+    {
+      data.submat(boundaries[s], i, boundaries[s + 1] - 1, i) =
+          codebooks[s].col(codes(s, i));
+    }
+  }
+}
+
+template<typename VecType>
+void ProductQuantizer::DistanceTable(const VecType& query,
+                                     arma::mat& table) const
+{
+  // Subspaces with fewer than 256 centroids leave the rest of their column
+  // unused.
+  table.zeros(256, codebooks.size());
+  for (size_t s = 0; s < codebooks.size(); ++s)
+  {
+    const arma::vec subquery = query.subvec(boundaries[s],
+        boundaries[s + 1] - 1);
+    arma::mat differences = codebooks[s];
+    differences.each_col() -= subquery;
+    table.col(s).head(codebooks[s].n_cols) =
+        arma::sum(arma::square(differences), 0).t();
+  }
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file methods/neighbor_search/quantizers/scalar_quantizer.hpp
+ *
+ * Definition of the ScalarQuantizer class, which compresses each dimension of a
+ * point to a single byte.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_SCALAR_QUANTIZER_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_SCALAR_QUANTIZER_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The ScalarQuantizer splits the range of every dimension of the training data
+ * into 256 levels of equal width, and encodes each value of a point as the
+ * level it falls in; a point of d dimensions is thus stored in d bytes (8 times
+ * less than an arma::mat).  Values outside of the training range are clamped.
+ *
+ * The squared Euclidean distance between a query and an encoded point is
+ * computed with an asymmetric distance table, which holds the squared distance
+ * between the query and every level of every dimension; see DistanceTable().
+ *
+ * Every quantizer used with QuantizedSearch must implement the same methods:
+ * Train(), Encode(), Decode(), DistanceTable(), Distance(), CodeSize() and
+ * serialize().
+ */
+class ScalarQuantizer
+{
+ public:
+  //! Create an untrained quantizer.
+  ScalarQuantizer() { }
+
+  /**
+   * Compute the range of every dimension of the given data.
+   *
+   * @param data Training points.
+   */
+  void Train(const arma::mat& data);
+
+  /**
+   * Encode the given points; each column of codes holds CodeSize() bytes.
+   *
+   * @param data Points to encode.
+   * @param codes Matrix to store the codes in.
+   */
+  void Encode(const arma::mat& data, arma::Mat<unsigned char>& codes) const;
+
+  /**
+   * Compute the approximation of the given encoded points.
+   *
+   * @param codes Codes to decode.
+   * @param data Matrix to store the decoded points in.
+   */
+  void Decode(const arma::Mat<unsigned char>& codes, arma::mat& data) const;
+
+  /**
+   * Compute the asymmetric distance table of the given query: the entry (l, j)
+   * is the squared distance between dimension j of the query and level l.
+   *
+   * @param query Query point.
+   * @param table Matrix to store the table in.
+   */
+  template<typename VecType>
+  void DistanceTable(const VecType& query, arma::mat& table) const;
+
+  /**
+   * Return the squared Euclidean distance between the query whose distance
+   * table is given and the encoded point.
+   *
+   * @param table Distance table of the query, as given by DistanceTable().
+   * @param code Code of the point (CodeSize() bytes).
+   */
+  double Distance(const arma::mat& table, const unsigned char* code) const
+  {
+    double distance = 0.0;
+    const double* column = table.memptr();
+    for (size_t j = 0; j < table.n_cols; ++j, column += table.n_rows)
+      distance += column[code[j]];
+    return distance;
+  }
+
+  //! Return the number of bytes used to encode a point.
+  size_t CodeSize() const { return minimums.n_elem; }
+
+  //! Get the lowest value of every dimension.
+  const arma::vec& Minimums() const { return minimums; }
+  //! Get the width of the levels of every dimension.
+  const arma::vec& Widths() const { return widths; }
+
+  //! Serialize the quantizer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */)
+  {
+    ar(CEREAL_NVP(minimums));
+    ar(CEREAL_NVP(widths));
+  }
+
+ private:
+  //! The lowest value of every dimension.
+  arma::vec minimums;
+  //! The width of the levels of every dimension.
+  arma::vec widths;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "scalar_quantizer_impl.hpp"
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * @file methods/neighbor_search/quantizers/scalar_quantizer_impl.hpp
+ *
+ * Implementation of the ScalarQuantizer class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_SCALAR_QUANTIZER_IMPL_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZERS_SCALAR_QUANTIZER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "scalar_quantizer.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+inline void ScalarQuantizer::Train(const arma::mat& data)
+{
+  if (data.n_cols == 0)
+  {
+    throw std::invalid_argument("ScalarQuantizer::Train(): cannot train on an "
+        "empty dataset");
+  }
+
+  minimums = arma::min(data, 1);
+  widths = (arma::max(data, 1) - minimums) / 256.0;
+}
+
+inline void ScalarQuantizer::Encode(const arma::mat& data,
+                                    arma::Mat<unsigned char>& codes) const
+{
+  if (data.n_rows != minimums.n_elem)
+  {
+    std::ostringstream oss;
+    oss << "ScalarQuantizer::Encode(): dimensionality of data ("
+        << data.n_rows << ") is not equal to the dimensionality the quantizer "
+        << "was trained on (" << minimums.n_elem << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  codes.set_size(data.n_rows, data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t j = 0; j < data.n_rows; ++j)
+    {
+      // A dimension with a single value only has one level.
+      const double level = (widths[j] == 0.0) ? 0.0 :
+          std::floor((data(j, i) - minimums[j]) / widths[j]);
+      codes(j, i) = (unsigned char) std::min(std::max(level, 0.0), 255.0);
+    }
+  }
+}
+
+inline void ScalarQuantizer::Decode(const arma::Mat<unsigned char>& codes,
+                                    arma::mat& data) const
+{
+  // Each value is approximated by the middle of its level.
+  data = arma::conv_to<arma::mat>::from(codes) + 0.5;
+  data.each_col() %= widths;
+  data.each_col() += minimums;
+}
+
+template<typename VecType>
+void ScalarQuantizer::DistanceTable(const VecType& query,
+                                    arma::mat& table) const
+{
+  table.set_size(256, minimums.n_elem);
+  for (size_t j = 0; j < minimums.n_elem; ++j)
+  {
+    for (size_t l = 0; l < 256; ++l)
+    {
+      const double difference = query[j] -
+          (minimums[j] + (l + 0.5) * widths[j]);
+      table(l, j) = difference * difference;
+    }
+  }
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -17,6 +17,7 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include "range_search_stat.hpp"
+#include "range_search_results.hpp"
 
 namespace mlpack {
 namespace range /** Range-search routines. */ {
@@ -30,6 +31,14 @@ class TrainVisitor;
  * algorithm; for more details on the actual algorithm, see the RangeSearchRules
  * class.
  *
+ * Searches are done in parallel when OpenMP is available: naive and
+ * single-tree searches split the query points over the threads, and dual-tree
+ * searches traverse independent subtrees of the query tree concurrently.
+ * Besides one list of neighbors per query point, the results may be returned
+ * in a compact layout (one offset per query point into flat arrays of
+ * neighbors and distances), only counted with Count(), or given to a callback
+ * as they are found, so that they are never stored.
+ *
  * @tparam MetricType Metric to use for range search calculations.
  * @tparam MatType Type of data to use.
  * @tparam TreeType Type of tree to use; must satisfy the TreeType policy API.
@@ -259,6 +268,122 @@ class RangeSearch
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
 
+  /**
+   * Search for all reference points in the given range for each point in the
+   * query set, returning the results in a compact layout: the neighbors of
+   * query point i are neighbors[offsets[i]] to neighbors[offsets[i + 1] - 1],
+   * and their distances are stored at the same positions of distances.  That
+   * is, offsets holds one more element than there are query points, and the
+   * last element is the total number of results.  The neighbors of each query
+   * point are not sorted in any particular order.
+   *
+   * This avoids the allocation of one vector per query point.  To only find
+   * the number of results of each query point, use Count() instead.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param offsets Object which will hold the offset of the results of each
+   *      query point.
+   * @param neighbors Object which will hold the neighbors of every query point.
+   * @param distances Object which will hold the distances of every query
+   *      point.
+   */
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              arma::Col<size_t>& offsets,
+              arma::Col<size_t>& neighbors,
+              arma::vec& distances);
+
+  /**
+   * Search for all points in the given range for each point in the reference
+   * set, returning the results in the compact layout described above.  A
+   * point is not returned in its own results.
+   *
+   * @param range Range of distances in which to search.
+   * @param offsets Object which will hold the offset of the results of each
+   *      point.
+   * @param neighbors Object which will hold the neighbors of every point.
+   * @param distances Object which will hold the distances of every point.
+   */
+  void Search(const math::Range& range,
+              arma::Col<size_t>& offsets,
+              arma::Col<size_t>& neighbors,
+              arma::vec& distances);
+
+  /**
+   * Count the reference points in the given range of each point in the query
+   * set, without storing the neighbors.  The distances to the points of tree
+   * nodes that are entirely in the range are never computed.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param counts Object which will hold the number of reference points in the
+   *      range of each query point.
+   */
+  void Count(const MatType& querySet,
+             const math::Range& range,
+             arma::Col<size_t>& counts);
+
+  /**
+   * Count the other points in the given range of each point in the reference
+   * set, without storing the neighbors.
+   *
+   * @param range Range of distances in which to search.
+   * @param counts Object which will hold the number of other points in the
+   *      range of each point.
+   */
+  void Count(const math::Range& range, arma::Col<size_t>& counts);
+
+  /**
+   * Search for all reference points in the given range for each point in the
+   * query set, and give every result to the given callback as soon as it is
+   * found, instead of storing the results.  The callback is called as
+   *
+   * @code
+   * callback(queryIndex, referenceIndex, distance);
+   * @endcode
+   *
+   * with the original indices of the points.  When OpenMP is available, the
+   * callback is called by several threads at once (but all of the results of
+   * one query point are given by the same thread), so it must be thread-safe.
+   * The results are given in no particular order.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param callback Callback to give the results to.
+   */
+  template<typename CallbackType>
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              CallbackType&& callback);
+
+  /**
+   * Given a pre-built query tree, search for all reference points in the given
+   * range for each point in the query set, and give every result to the given
+   * callback (see above).  The query indices given to the callback are those of
+   * the dataset of the query tree.  If either naive or singleMode are set to
+   * true, this will throw an invalid_argument exception.
+   *
+   * @param queryTree Tree built on query points.
+   * @param range Range of distances in which to search.
+   * @param callback Callback to give the results to.
+   */
+  template<typename CallbackType>
+  void Search(Tree* queryTree,
+              const math::Range& range,
+              CallbackType&& callback);
+
+  /**
+   * Search for all points in the given range for each point in the reference
+   * set, and give every result to the given callback (see above).  A point is
+   * not returned in its own results.
+   *
+   * @param range Range of distances in which to search.
+   * @param callback Callback to give the results to.
+   */
+  template<typename CallbackType>
+  void Search(const math::Range& range, CallbackType&& callback);
+
   //! Get whether single-tree search is being used.
   bool SingleMode() const { return singleMode; }
   //! Modify whether single-tree search is being used.
@@ -284,7 +409,56 @@ class RangeSearch
   //! Return the reference tree (or NULL if in naive mode).
   Tree* ReferenceTree() { return referenceTree; }
 
+  //! Access the mapping from the indices of points in the reference tree to
+  //! their indices in the original reference set (this is empty if the points
+  //! were not rearranged, or if the tree was given by the user).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+
  private:
+  /**
+   * Search for the points in the given range of each query point with the
+   * current search mode (in parallel, if possible), and give the results to
+   * the given object.  The indices given to the results are those of the
+   * query set and of the reference set, which may have been rearranged by
+   * tree building.
+   *
+   * @param querySet Set of query points; if a query tree is given, this must
+   *      be its dataset.
+   * @param queryTree Tree built on the query points, for dual-tree search.
+   * @param range Range of distances in which to search.
+   * @param results Object that receives the results.
+   * @param sameSet If true, the query set is the reference set, and a point is
+   *      not returned in its own results.
+   */
+  template<typename ResultType>
+  void Traverse(const MatType& querySet,
+                Tree* queryTree,
+                const math::Range& range,
+                ResultType results,
+                const bool sameSet);
+
+  /**
+   * Gather the results stored by every thread into the compact layout, mapping
+   * the query and reference indices back to their original indices if the
+   * given mappings are not NULL.
+   *
+   * @param buffers Results of every thread; they are emptied.
+   * @param numQueries Number of query points.
+   * @param queryMapping Original index of every query point, or NULL.
+   * @param referenceMapping Original index of every reference point, or NULL.
+   * @param offsets Offset of the results of each query point.
+   * @param neighbors Neighbors of every query point.
+   * @param distances Distances of every query point.
+   */
+  static void GatherResults(FlatResults::BufferList& buffers,
+                            const size_t numQueries,
+                            const std::vector<size_t>* queryMapping,
+                            const std::vector<size_t>* referenceMapping,
+                            arma::Col<size_t>& offsets,
+                            arma::Col<size_t>& neighbors,
+                            arma::vec& distances);
+
   //! Mappings to old reference indices (used when this object builds trees).
   std::vector<size_t> oldFromNewReferences;
   //! Reference tree.
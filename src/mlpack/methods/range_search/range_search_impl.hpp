@@ -18,6 +18,10 @@
 // The rules for traversal.
 #include "range_search_rules.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace range {
 
@@ -108,7 +112,7 @@ RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
   // Build the tree on the empty dataset, if necessary.
   if (!naive)
   {
-    referenceTree = BuildTree<Tree>(std::move(arma::mat()),
+    referenceTree = BuildTree<Tree>(std::move(MatType()),
         oldFromNewReferences);
     referenceSet = &referenceTree->Dataset();
     treeOwner = true;
@@ -154,7 +158,7 @@ RangeSearch<MetricType, MatType, TreeType>::RangeSearch(RangeSearch&& other) :
 {
   // Clear other object.
   other.referenceTree =
-      BuildTree<Tree>(std::move(arma::mat()), other.oldFromNewReferences);
+      BuildTree<Tree>(std::move(MatType()), other.oldFromNewReferences);
   other.referenceSet = &other.referenceTree->Dataset();
   other.treeOwner = true;
   other.naive = false;
@@ -321,38 +325,10 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   distancePtr->clear();
   distancePtr->resize(querySet.n_cols);
 
-  // Create the helper object for the traversal.
-  typedef RangeSearchRules<MetricType, Tree> RuleType;
-
-  // Reset counts.
-  baseCases = 0;
-  scores = 0;
-
-  if (naive)
-  {
-    RuleType rules(*referenceSet, querySet, range, *neighborPtr, *distancePtr,
-        metric);
-
-    // The naive brute-force solution.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
-
-    baseCases += (querySet.n_cols * referenceSet->n_cols);
-  }
-  else if (singleMode)
+  if (naive || singleMode)
   {
-    // Create the traverser.
-    RuleType rules(*referenceSet, querySet, range, *neighborPtr, *distancePtr,
-        metric);
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    baseCases += rules.BaseCases();
-    scores += rules.Scores();
+    Traverse(querySet, NULL, range, ListResults(*neighborPtr, *distancePtr),
+        false);
   }
   else // Dual-tree recursion.
   {
@@ -363,15 +339,8 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
     Timer::Stop("range_search/tree_building");
     Timer::Start("range_search/computing_neighbors");
 
-    // Create the traverser.
-    RuleType rules(*referenceSet, queryTree->Dataset(), range, *neighborPtr,
-        *distancePtr, metric);
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*queryTree, *referenceTree);
-
-    baseCases += rules.BaseCases();
-    scores += rules.Scores();
+    Traverse(queryTree->Dataset(), queryTree, range,
+        ListResults(*neighborPtr, *distancePtr), false);
 
     // Clean up tree memory.
     delete queryTree;
@@ -483,21 +452,11 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   distances.clear();
   distances.resize(querySet.n_cols);
 
-  // Create the helper object for the traversal.
-  typedef RangeSearchRules<MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, queryTree->Dataset(), range, *neighborPtr,
-      distances, metric);
-
-  // Create the traverser.
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-  traverser.Traverse(*queryTree, *referenceTree);
+  Traverse(querySet, queryTree, range, ListResults(*neighborPtr, distances),
+      false);
 
   Timer::Stop("range_search/computing_neighbors");
 
-  baseCases = rules.BaseCases();
-  scores = rules.Scores();
-
   // Do we need to map indices?
   if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
   {
@@ -550,43 +509,10 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   distancePtr->clear();
   distancePtr->resize(referenceSet->n_cols);
 
-  // Create the helper object for the traversal.
-  typedef RangeSearchRules<MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, *referenceSet, range, *neighborPtr,
-      *distancePtr, metric, true /* don't return the query in the results */);
-
-  if (naive)
-  {
-    // The naive brute-force solution.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
-
-    baseCases = (referenceSet->n_cols * referenceSet->n_cols);
-    scores = 0;
-  }
-  else if (singleMode)
-  {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    baseCases = rules.BaseCases();
-    scores = rules.Scores();
-  }
-  else // Dual-tree recursion.
-  {
-    // Create the traverser.
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*referenceTree, *referenceTree);
-
-    baseCases = rules.BaseCases();
-    scores = rules.Scores();
-  }
+  // The reference tree is also the query tree for dual-tree search.
+  Traverse(*referenceSet, (naive || singleMode) ? NULL : referenceTree, range,
+      ListResults(*neighborPtr, *distancePtr),
+      true /* don't return the query in the results */);
 
   Timer::Stop("range_search/computing_neighbors");
 
@@ -618,6 +544,508 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   }
 }
 
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& offsets,
+    arma::Col<size_t>& neighbors,
+    arma::vec& distances)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  offsets.zeros(querySet.n_cols + 1);
+  neighbors.reset();
+  distances.reset();
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  #ifdef HAS_OPENMP
+  FlatResults::BufferList buffers(omp_get_max_threads());
+  #else
+  FlatResults::BufferList buffers(1);
+  #endif
+
+  // Reference indices only need to be mapped if we built the reference tree
+  // ourselves.
+  const std::vector<size_t>* referenceMapping =
+      (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset) ?
+      &oldFromNewReferences : NULL;
+
+  if (naive || singleMode)
+  {
+    Traverse(querySet, NULL, range, FlatResults(buffers), false);
+    GatherResults(buffers, querySet.n_cols, NULL, referenceMapping, offsets,
+        neighbors, distances);
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    std::vector<size_t> oldFromNewQueries;
+    Tree* queryTree = BuildTree<Tree>(querySet, oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    Traverse(queryTree->Dataset(), queryTree, range, FlatResults(buffers),
+        false);
+    delete queryTree;
+
+    GatherResults(buffers, querySet.n_cols,
+        tree::TreeTraits<Tree>::RearrangesDataset ? &oldFromNewQueries : NULL,
+        referenceMapping, offsets, neighbors, distances);
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const math::Range& range,
+    arma::Col<size_t>& offsets,
+    arma::Col<size_t>& neighbors,
+    arma::vec& distances)
+{
+  offsets.zeros(referenceSet->n_cols + 1);
+  neighbors.reset();
+  distances.reset();
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  #ifdef HAS_OPENMP
+  FlatResults::BufferList buffers(omp_get_max_threads());
+  #else
+  FlatResults::BufferList buffers(1);
+  #endif
+
+  // The reference tree is also the query tree for dual-tree search.
+  Traverse(*referenceSet, (naive || singleMode) ? NULL : referenceTree, range,
+      FlatResults(buffers), true /* don't return the query in the results */);
+
+  // Both the query and reference indices need to be mapped if we built the
+  // tree ourselves.
+  const std::vector<size_t>* mapping =
+      (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset) ?
+      &oldFromNewReferences : NULL;
+  GatherResults(buffers, referenceSet->n_cols, mapping, mapping, offsets,
+      neighbors, distances);
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Count(
+    const MatType& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Count(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  counts.zeros(querySet.n_cols);
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  if (naive || singleMode)
+  {
+    Traverse(querySet, NULL, range, CountResults(counts), false);
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    std::vector<size_t> oldFromNewQueries;
+    Tree* queryTree = BuildTree<Tree>(querySet, oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    arma::Col<size_t> treeCounts(querySet.n_cols, arma::fill::zeros);
+    Traverse(queryTree->Dataset(), queryTree, range, CountResults(treeCounts),
+        false);
+    delete queryTree;
+
+    // Map the counts back to the original query indices, if necessary.
+    if (tree::TreeTraits<Tree>::RearrangesDataset)
+    {
+      for (size_t i = 0; i < treeCounts.n_elem; ++i)
+        counts[oldFromNewQueries[i]] = treeCounts[i];
+    }
+    else
+    {
+      counts = std::move(treeCounts);
+    }
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Count(
+    const math::Range& range,
+    arma::Col<size_t>& counts)
+{
+  counts.zeros(referenceSet->n_cols);
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  arma::Col<size_t> treeCounts(referenceSet->n_cols, arma::fill::zeros);
+  Traverse(*referenceSet, (naive || singleMode) ? NULL : referenceTree, range,
+      CountResults(treeCounts), true /* don't count the query itself */);
+
+  // Map the counts back to the original indices, if necessary.
+  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    for (size_t i = 0; i < treeCounts.n_elem; ++i)
+      counts[oldFromNewReferences[i]] = treeCounts[i];
+  }
+  else
+  {
+    counts = std::move(treeCounts);
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename CallbackType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    CallbackType&& callback)
+{
+  typedef CallbackResults<typename std::remove_reference<CallbackType>::type>
+      ResultType;
+
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  // Reference indices only need to be mapped if we built the reference tree
+  // ourselves.
+  const std::vector<size_t>* referenceMapping =
+      (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset) ?
+      &oldFromNewReferences : NULL;
+
+  if (naive || singleMode)
+  {
+    Traverse(querySet, NULL, range,
+        ResultType(callback, NULL, referenceMapping), false);
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    std::vector<size_t> oldFromNewQueries;
+    Tree* queryTree = BuildTree<Tree>(querySet, oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    Traverse(queryTree->Dataset(), queryTree, range, ResultType(callback,
+        tree::TreeTraits<Tree>::RearrangesDataset ? &oldFromNewQueries : NULL,
+        referenceMapping), false);
+    delete queryTree;
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename CallbackType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    Tree* queryTree,
+    const math::Range& range,
+    CallbackType&& callback)
+{
+  typedef CallbackResults<typename std::remove_reference<CallbackType>::type>
+      ResultType;
+
+  // Make sure we are in dual-tree mode.
+  if (singleMode || naive)
+    throw std::invalid_argument("cannot call RangeSearch::Search() with a "
+        "query tree when naive or singleMode are set to true");
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  // We must map reference indices only.
+  Traverse(queryTree->Dataset(), queryTree, range, ResultType(callback, NULL,
+      (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset) ?
+      &oldFromNewReferences : NULL), false);
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename CallbackType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const math::Range& range,
+    CallbackType&& callback)
+{
+  typedef CallbackResults<typename std::remove_reference<CallbackType>::type>
+      ResultType;
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  // Both the query and reference indices need to be mapped if we built the
+  // tree ourselves.
+  const std::vector<size_t>* mapping =
+      (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset) ?
+      &oldFromNewReferences : NULL;
+
+  // The reference tree is also the query tree for dual-tree search.
+  Traverse(*referenceSet, (naive || singleMode) ? NULL : referenceTree, range,
+      ResultType(callback, mapping, mapping),
+      true /* don't return the query in the results */);
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+//! Search in parallel with the current search mode.
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename ResultType>
+void RangeSearch<MetricType, MatType, TreeType>::Traverse(
+    const MatType& querySet,
+    Tree* queryTree,
+    const math::Range& range,
+    ResultType results,
+    const bool sameSet)
+{
+  typedef RangeSearchRules<MetricType, Tree, ResultType> RuleType;
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  if (naive)
+  {
+    // The naive brute-force solution.  Each thread has its own rules, because
+    // the rules remember the last base case.
+    #pragma omp parallel
+    {
+      RuleType rules(*referenceSet, querySet, range, results.Task(), metric,
+          sameSet);
+
+      #pragma omp for schedule(dynamic)
+      for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+        for (size_t j = 0; j < referenceSet->n_cols; ++j)
+          rules.BaseCase(i, j);
+    }
+
+    totalBaseCases = querySet.n_cols * referenceSet->n_cols;
+  }
+  else if (singleMode)
+  {
+    // Trees whose first point is the centroid cache the last base case in the
+    // statistics of the reference nodes, so only one thread may traverse them.
+    #pragma omp parallel \
+        if (!tree::TreeTraits<Tree>::FirstPointIsCentroid) \
+        reduction(+:totalBaseCases, totalScores)
+    {
+      RuleType rules(*referenceSet, querySet, range, results.Task(), metric,
+          sameSet);
+      typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+      // Now have it traverse for each point.
+      #pragma omp for schedule(dynamic)
+      for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+        traverser.Traverse(i, *referenceTree);
+
+      totalBaseCases += rules.BaseCases();
+      totalScores += rules.Scores();
+    }
+  }
+  else // Dual-tree recursion.
+  {
+    #ifdef HAS_OPENMP
+    const size_t numThreads = omp_get_max_threads();
+    #else
+    const size_t numThreads = 1;
+    #endif
+
+    // Split the query tree into subtrees, descending one level at a time until
+    // there are enough subtrees to keep every thread busy, or until every
+    // subtree is a leaf.  Each query point is a descendant of exactly one
+    // subtree (unless a point may be held by several nodes), so the subtrees
+    // can be traversed independently and never give results for the same
+    // query point.  The query nodes above the split are never scored.
+    std::vector<Tree*> subtrees(1, queryTree);
+    bool expanded = (numThreads > 1 &&
+        tree::TreeTraits<Tree>::UniqueNumDescendants);
+    while (expanded && subtrees.size() < 4 * numThreads)
+    {
+      expanded = false;
+      std::vector<Tree*> nextSubtrees;
+      for (size_t i = 0; i < subtrees.size(); ++i)
+      {
+        if (subtrees[i]->NumChildren() == 0)
+        {
+          nextSubtrees.push_back(subtrees[i]);
+          continue;
+        }
+
+        for (size_t j = 0; j < subtrees[i]->NumChildren(); ++j)
+          nextSubtrees.push_back(&subtrees[i]->Child(j));
+        expanded = true;
+      }
+
+      subtrees.swap(nextSubtrees);
+    }
+
+    #pragma omp parallel for \
+        schedule(dynamic) \
+        reduction(+:totalBaseCases, totalScores)
+    for (omp_size_t i = 0; i < (omp_size_t) subtrees.size(); ++i)
+    {
+      // Each task has its own traversal state.
+      RuleType rules(*referenceSet, querySet, range, results.Task(), metric,
+          sameSet);
+      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+      traverser.Traverse(*subtrees[i], *referenceTree);
+
+      totalBaseCases += rules.BaseCases();
+      totalScores += rules.Scores();
+    }
+  }
+
+  baseCases = totalBaseCases;
+  scores = totalScores;
+}
+
+//! Gather the results of every thread into the compact layout.
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::GatherResults(
+    FlatResults::BufferList& buffers,
+    const size_t numQueries,
+    const std::vector<size_t>* queryMapping,
+    const std::vector<size_t>* referenceMapping,
+    arma::Col<size_t>& offsets,
+    arma::Col<size_t>& neighbors,
+    arma::vec& distances)
+{
+  // Count the results of each query point, and turn the counts into offsets.
+  offsets.zeros(numQueries + 1);
+  for (size_t b = 0; b < buffers.size(); ++b)
+  {
+    for (size_t j = 0; j < buffers[b].size(); ++j)
+    {
+      const size_t query = queryMapping ?
+          (*queryMapping)[buffers[b][j].query] : buffers[b][j].query;
+      ++offsets[query + 1];
+    }
+  }
+  for (size_t i = 1; i <= numQueries; ++i)
+    offsets[i] += offsets[i - 1];
+
+  neighbors.set_size(offsets[numQueries]);
+  distances.set_size(offsets[numQueries]);
+
+  // The results of each query point were all stored by the same thread, so
+  // every buffer can be scattered by a different thread.
+  arma::Col<size_t> positions(offsets.memptr(), numQueries);
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) buffers.size(); ++b)
+  {
+    for (size_t j = 0; j < buffers[b].size(); ++j)
+    {
+      const FlatResults::Result& result = buffers[b][j];
+      const size_t query = queryMapping ?
+          (*queryMapping)[result.query] : result.query;
+      const size_t position = positions[query]++;
+      neighbors[position] = referenceMapping ?
+          (*referenceMapping)[result.reference] : result.reference;
+      distances[position] = result.distance;
+    }
+
+    // Release the memory of the buffer as soon as possible.
+    std::vector<FlatResults::Result>().swap(buffers[b]);
+  }
+}
+
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
@@ -20,6 +20,10 @@
 #include "range_search.hpp"
 #include "rs_model.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::range;
@@ -48,7 +52,25 @@ BINDING_LONG_DESC(
     " points, or only a reference set -- which is then used as both the "
     "reference and query set.  The given range is taken to be inclusive (that "
     "is, points with a distance exactly equal to the minimum and maximum of the"
-    " range are included in the results).");
+    " range are included in the results)."
+    "\n\n"
+    "If " + PRINT_PARAM_STRING("single_precision") + " is specified, the "
+    "reference set and kd-tree are held in single precision, which halves the "
+    "memory used by the model and speeds up the search.  The distances that "
+    "are returned can then be recomputed in double precision by specifying " +
+    PRINT_PARAM_STRING("double_distances") + "; the reference points "
+    "themselves stay rounded to single precision, so the recomputed distances "
+    "are only accurate to about 1e-7 relative to the points' magnitude.  "
+    "Neighbors whose recomputed distance is outside of the range are then "
+    "dropped."
+    "\n\n"
+    "If the number of results is too large to hold in memory, they can instead "
+    "be written to a file as they are found by specifying " +
+    PRINT_PARAM_STRING("results_file") + ".  Each line of this file holds one "
+    "result as 'query, reference, distance', and the results are written in "
+    "no particular order.  In this case, " +
+    PRINT_PARAM_STRING("neighbors_file") + " and " +
+    PRINT_PARAM_STRING("distances_file") + " are ignored.");
 
 // Example.
 BINDING_EXAMPLE(
@@ -84,6 +106,8 @@ BINDING_SEE_ALSO("mlpack::range::RangeSearch C++ class documentation",
 PARAM_MATRIX_IN("reference", "Matrix containing the reference dataset.", "r");
 PARAM_STRING_OUT("distances_file", "File to output distances into.", "d");
 PARAM_STRING_OUT("neighbors_file", "File to output neighbors into.", "n");
+PARAM_STRING_OUT("results_file", "File to write each result into as it is "
+    "found, one 'query, reference, distance' line per result.", "o");
 
 // The option exists to load or save models.
 PARAM_MODEL_IN(RSModel, "input_model", "File containing pre-trained range "
@@ -107,6 +131,11 @@ PARAM_INT_IN("leaf_size", "Leaf size for tree building (used for kd-trees, "
     "Hilbert R trees, R+ trees, R++ trees, and octrees).", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_FLAG("single_precision", "Hold the reference set and tree in single "
+    "precision (only valid for kd-trees).", "");
+PARAM_FLAG("double_distances", "If the model is held in single precision, "
+    "recompute the distances to the neighbors that are found in double "
+    "precision.", "");
 PARAM_INT_IN("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search settings.
@@ -126,6 +155,7 @@ static void mlpackMain()
 
   ReportIgnoredParam({{ "input_model", true }}, "tree_type");
   ReportIgnoredParam({{ "input_model", true }}, "random_basis");
+  ReportIgnoredParam({{ "input_model", true }}, "single_precision");
   ReportIgnoredParam({{ "input_model", true }}, "leaf_size");
   ReportIgnoredParam({{ "input_model", true }}, "naive");
 
@@ -136,16 +166,21 @@ static void mlpackMain()
   // If the user specifies a range but not output files, they should be warned.
   if (IO::HasParam("min") || IO::HasParam("max"))
   {
-    RequireAtLeastOnePassed({ "neighbors_file", "distances_file" }, false,
-        "no range search results will be saved");
+    RequireAtLeastOnePassed({ "neighbors_file", "distances_file",
+        "results_file" }, false, "no range search results will be saved");
   }
 
   if (!IO::HasParam("min") && !IO::HasParam("max"))
   {
     ReportIgnoredParam("neighbors_file", "no range is specified for searching");
     ReportIgnoredParam("distances_file", "no range is specified for searching");
+    ReportIgnoredParam("results_file", "no range is specified for searching");
   }
 
+  // The results are not stored if they are written as they are found.
+  ReportIgnoredParam({{ "results_file", true }}, "neighbors_file");
+  ReportIgnoredParam({{ "results_file", true }}, "distances_file");
+
   if (IO::HasParam("input_model") &&
       (IO::HasParam("min") || IO::HasParam("max")))
   {
@@ -158,6 +193,14 @@ static void mlpackMain()
   RequireParamValue<int>("leaf_size", [](int x) { return x > 0; }, true,
       "leaf size must be greater than 0");
 
+  // Single precision is only supported for kd-trees.
+  if (IO::HasParam("reference") && IO::HasParam("single_precision") &&
+      IO::GetParam<string>("tree_type") != "kd")
+  {
+    Log::Fatal << PRINT_PARAM_STRING("single_precision") << " is only "
+        << "supported with kd-trees!" << endl;
+  }
+
   // We either have to load the reference data, or we have to load the model.
   RSModel* rs;
   const bool naive = IO::HasParam("naive");
@@ -205,6 +248,7 @@ static void mlpackMain()
 
     rs->TreeType() = tree;
     rs->RandomBasis() = randomBasis;
+    rs->SinglePrecision() = IO::HasParam("single_precision");
 
     Log::Info << "Using reference data from "
         << IO::GetPrintableParam<arma::mat>("reference") << "." << endl;
@@ -222,8 +266,10 @@ static void mlpackMain()
 
     Log::Info << "Using range search model from '"
         << IO::GetPrintableParam<RSModel*>("input_model") << "' ("
-        << "trained on " << rs->Dataset().n_rows << "x" << rs->Dataset().n_cols
-        << " dataset)." << endl;
+        << "trained on " << (rs->SinglePrecision() ?
+            rs->FloatDataset().n_rows : rs->Dataset().n_rows) << "x"
+        << (rs->SinglePrecision() ? rs->FloatDataset().n_cols :
+            rs->Dataset().n_cols) << " dataset)." << endl;
 
     // Adjust singleMode and naive if necessary.
     rs->SingleMode() = IO::HasParam("single_mode");
@@ -231,6 +277,13 @@ static void mlpackMain()
     rs->LeafSize() = size_t(lsInt);
   }
 
+  if (!rs->SinglePrecision())
+  {
+    ReportIgnoredParam("double_distances",
+        "the model is not held in single precision");
+  }
+  rs->DoubleDistances() = IO::HasParam("double_distances");
+
   // Perform search, if desired.
   if (IO::HasParam("min") || IO::HasParam("max"))
   {
@@ -253,73 +306,127 @@ static void mlpackMain()
       Log::Warn << PRINT_PARAM_STRING("single_mode") << " ignored because "
           << PRINT_PARAM_STRING("naive") << " is present." << endl;
 
-    // Now run the search.
-    vector<vector<size_t>> neighbors;
-    vector<vector<double>> distances;
-
-    if (IO::HasParam("query"))
-      rs->Search(std::move(queryData), r, neighbors, distances);
-    else
-      rs->Search(r, neighbors, distances);
-
-    Log::Info << "Search complete." << endl;
-
-    // Save output, if desired.  We have to do this by hand.
-    if (IO::HasParam("distances_file"))
+    if (IO::HasParam("results_file"))
     {
-      const string distancesFile = IO::GetParam<string>("distances_file");
-      fstream distancesStr(distancesFile.c_str(), fstream::out);
-      if (!distancesStr.is_open())
+      const string resultsFile = IO::GetParam<string>("results_file");
+      fstream resultsStr(resultsFile.c_str(), fstream::out);
+      if (!resultsStr.is_open())
       {
-        Log::Warn << "Cannot open file '" << distancesFile << "' to save output"
-            << " distances to!" << endl;
+        Log::Warn << "Cannot open file '" << resultsFile << "' to save results "
+            << "to!" << endl;
       }
       else
       {
-        // Loop over each point.
-        for (size_t i = 0; i < distances.size(); ++i)
+        // Each thread writes its results to its own buffer, which is written
+        // to the file whenever it gets large.
+        #ifdef HAS_OPENMP
+        vector<ostringstream> buffers(omp_get_max_threads());
+        #else
+        vector<ostringstream> buffers(1);
+        #endif
+
+        RSCallback writeResult = [&](const size_t query,
+            const size_t reference, const double distance)
         {
-          // Store the distances of each point.  We may have 0 points to store,
-          // so we must account for that possibility.
-          for (size_t j = 0; j + 1 < distances[i].size(); ++j)
-            distancesStr << distances[i][j] << ", ";
+          #ifdef HAS_OPENMP
+          ostringstream& buffer = buffers[omp_get_thread_num()];
+          #else
+          ostringstream& buffer = buffers[0];
+          #endif
+          buffer << query << ", " << reference << ", " << distance << "\n";
+
+          if (buffer.tellp() > (1 << 20))
+          {
+            #pragma omp critical
+            {
+              resultsStr << buffer.str();
+            }
+            buffer.str("");
+          }
+        };
+
+        if (IO::HasParam("query"))
+          rs->Search(std::move(queryData), r, writeResult);
+        else
+          rs->Search(r, writeResult);
+
+        for (size_t i = 0; i < buffers.size(); ++i)
+          resultsStr << buffers[i].str();
+        resultsStr.close();
+
+        Log::Info << "Search complete." << endl;
+      }
+    }
+    else
+    {
+      // Now run the search.
+      vector<vector<size_t>> neighbors;
+      vector<vector<double>> distances;
+
+      if (IO::HasParam("query"))
+        rs->Search(std::move(queryData), r, neighbors, distances);
+      else
+        rs->Search(r, neighbors, distances);
 
-          if (distances[i].size() > 0)
-            distancesStr << distances[i][distances[i].size() - 1];
+      Log::Info << "Search complete." << endl;
 
-          distancesStr << endl;
+      // Save output, if desired.  We have to do this by hand.
+      if (IO::HasParam("distances_file"))
+      {
+        const string distancesFile = IO::GetParam<string>("distances_file");
+        fstream distancesStr(distancesFile.c_str(), fstream::out);
+        if (!distancesStr.is_open())
+        {
+          Log::Warn << "Cannot open file '" << distancesFile << "' to save "
+              << "output distances to!" << endl;
         }
+        else
+        {
+          // Loop over each point.
+          for (size_t i = 0; i < distances.size(); ++i)
+          {
+            // Store the distances of each point.  We may have 0 points to
+            // store, so we must account for that possibility.
+            for (size_t j = 0; j + 1 < distances[i].size(); ++j)
+              distancesStr << distances[i][j] << ", ";
 
-        distancesStr.close();
-      }
-    }
+            if (distances[i].size() > 0)
+              distancesStr << distances[i][distances[i].size() - 1];
 
-    if (IO::HasParam("neighbors_file"))
-    {
-      const string neighborsFile = IO::GetParam<string>("neighbors_file");
-      fstream neighborsStr(neighborsFile.c_str(), fstream::out);
-      if (!neighborsStr.is_open())
-      {
-        Log::Warn << "Cannot open file '" << neighborsFile << "' to save output"
-            << " neighbor indices to!" << endl;
+            distancesStr << endl;
+          }
+
+          distancesStr.close();
+        }
       }
-      else
+
+      if (IO::HasParam("neighbors_file"))
       {
-        // Loop over each point.
-        for (size_t i = 0; i < neighbors.size(); ++i)
+        const string neighborsFile = IO::GetParam<string>("neighbors_file");
+        fstream neighborsStr(neighborsFile.c_str(), fstream::out);
+        if (!neighborsStr.is_open())
         {
-          // Store the neighbors of each point.  We may have 0 points to store,
-          // so we must account for that possibility.
-          for (size_t j = 0; j + 1 < neighbors[i].size(); ++j)
-            neighborsStr << neighbors[i][j] << ", ";
+          Log::Warn << "Cannot open file '" << neighborsFile << "' to save "
+              << "output neighbor indices to!" << endl;
+        }
+        else
+        {
+          // Loop over each point.
+          for (size_t i = 0; i < neighbors.size(); ++i)
+          {
+            // Store the neighbors of each point.  We may have 0 points to
+            // store, so we must account for that possibility.
+            for (size_t j = 0; j + 1 < neighbors[i].size(); ++j)
+              neighborsStr << neighbors[i][j] << ", ";
 
-          if (neighbors[i].size() > 0)
-            neighborsStr << neighbors[i][neighbors[i].size() - 1];
+            if (neighbors[i].size() > 0)
+              neighborsStr << neighbors[i][neighbors[i].size() - 1];
 
-          neighborsStr << endl;
-        }
+            neighborsStr << endl;
+          }
 
-        neighborsStr.close();
+          neighborsStr.close();
+        }
       }
     }
   }
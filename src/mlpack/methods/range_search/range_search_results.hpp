@@ -0,0 +1,255 @@
+/**
+ * @file methods/range_search/range_search_results.hpp
+ *
+ * Classes that receive the results found by RangeSearchRules.  Each class
+ * stores the results in a different way: as one list per query point, as a
+ * flat list of (query, reference, distance) tuples, or only as the number of
+ * results of each query point; or gives them to a callback without storing
+ * them.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RESULTS_HPP
+#define MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RESULTS_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace range {
+
+/**
+ * ListResults stores the neighbors and distances of each query point in a
+ * separate vector; this is the output of RangeSearch::Search() with
+ * std::vector<std::vector<size_t>> and std::vector<std::vector<double>>.
+ *
+ * Every class that receives results from RangeSearchRules has the same
+ * interface:
+ *
+ *  - NeedsDistances: if false, the distances given to Add() are not used, so
+ *    they do not need to be computed when a whole node is in the range.
+ *  - Reserve(queryIndex, count): a hint that count more results of the given
+ *    query point will follow.
+ *  - Add(queryIndex, referenceIndex, distance): store a result.
+ *  - Task(): return the object that one task of a parallel search should
+ *    store its results in.  Tasks never share query points, so the results of
+ *    one query point are always given to the same object.
+ */
+class ListResults
+{
+ public:
+  //! The distances are stored.
+  static const bool NeedsDistances = true;
+
+  /**
+   * Store the results in the given vectors, which must hold one (empty) vector
+   * for each query point.
+   *
+   * @param neighbors Vector to store the neighbors of each query point in.
+   * @param distances Vector to store the distances of each query point in.
+   */
+  ListResults(std::vector<std::vector<size_t>>& neighbors,
+              std::vector<std::vector<double>>& distances) :
+      neighbors(&neighbors),
+      distances(&distances)
+  { }
+
+  //! Make room for the given number of results of the given query point.
+  void Reserve(const size_t queryIndex, const size_t count)
+  {
+    (*neighbors)[queryIndex].reserve((*neighbors)[queryIndex].size() + count);
+    (*distances)[queryIndex].reserve((*distances)[queryIndex].size() + count);
+  }
+
+  //! Store a result.
+  void Add(const size_t queryIndex,
+           const size_t referenceIndex,
+           const double distance)
+  {
+    (*neighbors)[queryIndex].push_back(referenceIndex);
+    (*distances)[queryIndex].push_back(distance);
+  }
+
+  //! Every task writes to the lists of its own query points.
+  ListResults Task() const { return *this; }
+
+ private:
+  //! The neighbors of each query point.
+  std::vector<std::vector<size_t>>* neighbors;
+  //! The distances of each query point.
+  std::vector<std::vector<double>>* distances;
+};
+
+/**
+ * FlatResults appends every result to a buffer of (query, reference, distance)
+ * tuples, without any allocation per query point.  Each thread of a parallel
+ * search has its own buffer.
+ */
+class FlatResults
+{
+ public:
+  //! The distances are stored.
+  static const bool NeedsDistances = true;
+
+  //! A single result.
+  struct Result
+  {
+    //! The index of the query point.
+    size_t query;
+    //! The index of the reference point.
+    size_t reference;
+    //! The distance between the two points.
+    double distance;
+  };
+
+  //! The buffers of every thread.
+  typedef std::vector<std::vector<Result>> BufferList;
+
+  /**
+   * Store the results in the given buffers; there must be one buffer for each
+   * thread.  The results of a serial search are stored in the first buffer.
+   *
+   * @param buffers Buffers to store the results in.
+   */
+  FlatResults(BufferList& buffers) :
+      buffers(&buffers),
+      buffer(&buffers[0])
+  { }
+
+  //! Nothing needs to be reserved.
+  void Reserve(const size_t /* queryIndex */, const size_t /* count */) { }
+
+  //! Store a result.
+  void Add(const size_t queryIndex,
+           const size_t referenceIndex,
+           const double distance)
+  {
+    buffer->push_back(Result { queryIndex, referenceIndex, distance });
+  }
+
+  //! Return an object that stores results in the buffer of the calling thread.
+  FlatResults Task() const
+  {
+    FlatResults results(*this);
+    #ifdef HAS_OPENMP
+    results.buffer = &(*buffers)[omp_get_thread_num()];
+    #endif
+    return results;
+  }
+
+ private:
+  //! The buffers of every thread.
+  BufferList* buffers;
+  //! The buffer that results are stored in.
+  std::vector<Result>* buffer;
+};
+
+/**
+ * CountResults only counts the results of each query point; neither the
+ * neighbors nor the distances are stored.
+ */
+class CountResults
+{
+ public:
+  //! The distances are not needed.
+  static const bool NeedsDistances = false;
+
+  /**
+   * Count the results in the given vector, which must hold one (zero) count
+   * for each query point.
+   *
+   * @param counts Vector to count the results of each query point in.
+   */
+  CountResults(arma::Col<size_t>& counts) : counts(&counts) { }
+
+  //! Nothing needs to be reserved.
+  void Reserve(const size_t /* queryIndex */, const size_t /* count */) { }
+
+  //! Count a result.
+  void Add(const size_t queryIndex,
+           const size_t /* referenceIndex */,
+           const double /* distance */)
+  {
+    ++(*counts)[queryIndex];
+  }
+
+  //! Every task counts the results of its own query points.
+  CountResults Task() const { return *this; }
+
+ private:
+  //! The number of results of each query point.
+  arma::Col<size_t>* counts;
+};
+
+/**
+ * CallbackResults gives every result to a callback as soon as it is found, so
+ * that the results are never stored.  The callback is called as
+ * callback(queryIndex, referenceIndex, distance).  In a parallel search the
+ * callback is called by several threads at once, but all of the results of one
+ * query point are given by the same thread.
+ *
+ * Since the indices given by RangeSearchRules are those of the (possibly
+ * rearranged) datasets of the trees, they can be mapped back to the original
+ * indices before they are given to the callback.
+ *
+ * @tparam CallbackType Type of the callback.
+ */
+template<typename CallbackType>
+class CallbackResults
+{
+ public:
+  //! The distances are given to the callback.
+  static const bool NeedsDistances = true;
+
+  /**
+   * Give the results to the given callback.
+   *
+   * @param callback Callback to call for every result.
+   * @param queryMapping Original index of every query point, or NULL if the
+   *      query points were not rearranged.
+   * @param referenceMapping Original index of every reference point, or NULL
+   *      if the reference points were not rearranged.
+   */
+  CallbackResults(CallbackType& callback,
+                  const std::vector<size_t>* queryMapping = NULL,
+                  const std::vector<size_t>* referenceMapping = NULL) :
+      callback(&callback),
+      queryMapping(queryMapping),
+      referenceMapping(referenceMapping)
+  { }
+
+  //! Nothing needs to be reserved.
+  void Reserve(const size_t /* queryIndex */, const size_t /* count */) { }
+
+  //! Give a result to the callback.
+  void Add(const size_t queryIndex,
+           const size_t referenceIndex,
+           const double distance)
+  {
+    (*callback)(queryMapping ? (*queryMapping)[queryIndex] : queryIndex,
+        referenceMapping ? (*referenceMapping)[referenceIndex] : referenceIndex,
+        distance);
+  }
+
+  //! Every task calls the same callback.
+  CallbackResults Task() const { return *this; }
+
+ private:
+  //! The callback.
+  CallbackType* callback;
+  //! The original index of every query point, or NULL.
+  const std::vector<size_t>* queryMapping;
+  //! The original index of every reference point, or NULL.
+  const std::vector<size_t>* referenceMapping;
+};
+
+} // namespace range
+} // namespace mlpack
+
+#endif
@@ -14,6 +14,8 @@
 
 #include <mlpack/core/tree/traversal_info.hpp>
 
+#include "range_search_results.hpp"
+
 namespace mlpack {
 namespace range {
 
@@ -23,8 +25,11 @@ namespace range {
  *
  * @tparam MetricType The metric to use for computation.
  * @tparam TreeType The tree type to use; must adhere to the TreeType API.
+ * @tparam ResultType The class that receives the results; see ListResults.
  */
-template<typename MetricType, typename TreeType>
+template<typename MetricType,
+         typename TreeType,
+         typename ResultType = ListResults>
 class RangeSearchRules
 {
  public:
@@ -41,14 +46,33 @@ class RangeSearchRules
    * @param sameSet If true, the query and reference set are taken to be the
    *      same, and a query point will not return itself in the results.
    */
-  RangeSearchRules(const arma::mat& referenceSet,
-                   const arma::mat& querySet,
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
                    const math::Range& range,
                    std::vector<std::vector<size_t> >& neighbors,
                    std::vector<std::vector<double> >& distances,
                    MetricType& metric,
                    const bool sameSet = false);
 
+  /**
+   * Construct the RangeSearchRules object, giving the results to the given
+   * object instead of storing them in vectors.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param results Object that receives the results.
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference set are taken to be the
+   *      same, and a query point will not return itself in the results.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   ResultType results,
+                   MetricType& metric,
+                   const bool sameSet = false);
+
   /**
    * Compute the base case between the given query point and reference point.
    *
@@ -57,6 +81,20 @@ class RangeSearchRules
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Compute the base cases between each of the given query points and every
+   * point held by the given reference node.  This gives the same results as
+   * calling BaseCase() for each pair.  When the metric is the (squared)
+   * Euclidean distance, all of the distances are first computed in one batch
+   * (see metric::LMetric::BatchEvaluate()), and only the pairs whose distance
+   * could be in the range are evaluated exactly.
+   *
+   * @param queryIndices Indices of query points.
+   * @param referenceNode Node holding the reference points.
+   */
+  void BatchBaseCase(const std::vector<size_t>& queryIndices,
+                     TreeType& referenceNode);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -123,19 +161,16 @@ class RangeSearchRules
 
  private:
   //! The reference set.
-  const arma::mat& referenceSet;
+  const typename TreeType::Mat& referenceSet;
 
   //! The query set.
-  const arma::mat& querySet;
+  const typename TreeType::Mat& querySet;
 
   //! The range of distances for which we are searching.
   const math::Range& range;
 
-  //! The vector the resultant neighbor indices should be stored in.
-  std::vector<std::vector<size_t> >& neighbors;
-
-  //! The vector the resultant neighbor distances should be stored in.
-  std::vector<std::vector<double> >& distances;
+  //! The object that receives the results.
+  ResultType results;
 
   //! The instantiated metric.
   MetricType& metric;
@@ -154,6 +189,19 @@ class RangeSearchRules
   void AddResult(const size_t queryIndex,
                  TreeType& referenceNode);
 
+  //! Compute the batched base cases with BaseCase(), for metrics that have no
+  //! batched kernel.
+  template<typename MetricType2>
+  void BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                         TreeType& referenceNode,
+                         MetricType2& metric);
+
+  //! Compute the batched base cases with the batched L2 kernel.
+  template<bool TakeRoot>
+  void BatchBaseCaseImpl(const std::vector<size_t>& queryIndices,
+                         TreeType& referenceNode,
+                         metric::LMetric<2, TakeRoot>& metric);
+
   TraversalInfoType traversalInfo;
 
   //! The number of base cases.
@@ -18,10 +18,10 @@
 namespace mlpack {
 namespace range {
 
-template<typename MetricType, typename TreeType>
-RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
-    const arma::mat& referenceSet,
-    const arma::mat& querySet,
+template<typename MetricType, typename TreeType, typename ResultType>
+RangeSearchRules<MetricType, TreeType, ResultType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
     const math::Range& range,
     std::vector<std::vector<size_t> >& neighbors,
     std::vector<std::vector<double> >& distances,
@@ -30,8 +30,29 @@ RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
     referenceSet(referenceSet),
     querySet(querySet),
     range(range),
-    neighbors(neighbors),
-    distances(distances),
+    results(neighbors, distances),
+    metric(metric),
+    sameSet(sameSet),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType, typename ResultType>
+RangeSearchRules<MetricType, TreeType, ResultType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    ResultType results,
+    MetricType& metric,
+    const bool sameSet) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    results(std::move(results)),
     metric(metric),
     sameSet(sameSet),
     lastQueryIndex(querySet.n_cols),
@@ -44,9 +65,9 @@ RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
 
 //! The base case.  Evaluate the distance between the two points and add to the
 //! results if necessary.
-template<typename MetricType, typename TreeType>
+template<typename MetricType, typename TreeType, typename ResultType>
 inline force_inline
-double RangeSearchRules<MetricType, TreeType>::BaseCase(
+double RangeSearchRules<MetricType, TreeType, ResultType>::BaseCase(
     const size_t queryIndex,
     const size_t referenceIndex)
 {
@@ -67,18 +88,73 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
   lastReferenceIndex = referenceIndex;
 
   if (range.Contains(distance))
-  {
-    neighbors[queryIndex].push_back(referenceIndex);
-    distances[queryIndex].push_back(distance);
-  }
+    results.Add(queryIndex, referenceIndex, distance);
 
   return distance;
 }
 
+template<typename MetricType, typename TreeType, typename ResultType>
+void RangeSearchRules<MetricType, TreeType, ResultType>::BatchBaseCase(
+    const std::vector<size_t>& queryIndices,
+    TreeType& referenceNode)
+{
+  BatchBaseCaseImpl(queryIndices, referenceNode, metric);
+}
+
+template<typename MetricType, typename TreeType, typename ResultType>
+template<typename MetricType2>
+void RangeSearchRules<MetricType, TreeType, ResultType>::BatchBaseCaseImpl(
+    const std::vector<size_t>& queryIndices,
+    TreeType& referenceNode,
+    MetricType2& /* metric */)
+{
+  for (size_t i = 0; i < queryIndices.size(); ++i)
+    for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+      BaseCase(queryIndices[i], referenceNode.Point(j));
+}
+
+template<typename MetricType, typename TreeType, typename ResultType>
+template<bool TakeRoot>
+void RangeSearchRules<MetricType, TreeType, ResultType>::BatchBaseCaseImpl(
+    const std::vector<size_t>& queryIndices,
+    TreeType& referenceNode,
+    metric::LMetric<2, TakeRoot>& /* metric */)
+{
+  typedef typename TreeType::ElemType ElemType;
+
+  arma::uvec queries(queryIndices.size());
+  for (size_t i = 0; i < queryIndices.size(); ++i)
+    queries[i] = queryIndices[i];
+  arma::uvec references(referenceNode.NumPoints());
+  for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+    references[j] = referenceNode.Point(j);
+
+  arma::Mat<ElemType> batchDistances;
+  const double tolerance = metric::LMetric<2, TakeRoot>::BatchEvaluate(
+      arma::Mat<ElemType>(querySet.cols(queries)),
+      arma::Mat<ElemType>(referenceSet.cols(references)), batchDistances);
+
+  // Only the pairs whose distance could be in the range need to be evaluated
+  // exactly.
+  const math::Range widenedRange(range.Lo() - tolerance,
+      range.Hi() + tolerance);
+  for (size_t i = 0; i < queries.n_elem; ++i)
+  {
+    for (size_t j = 0; j < references.n_elem; ++j)
+    {
+      if (widenedRange.Contains(batchDistances(i, j)))
+        BaseCase(queries[i], references[j]);
+      else if (!sameSet || queries[i] != references[j])
+        ++baseCases;
+    }
+  }
+}
+
 //! Single-tree scoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
-                                                     TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename ResultType>
+double RangeSearchRules<MetricType, TreeType, ResultType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
 {
   // We must get the minimum and maximum distances and store them in this
   // object.
@@ -136,8 +212,8 @@ double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
 }
 
 //! Single-tree rescoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Rescore(
+template<typename MetricType, typename TreeType, typename ResultType>
+double RangeSearchRules<MetricType, TreeType, ResultType>::Rescore(
     const size_t /* queryIndex */,
     TreeType& /* referenceNode */,
     const double oldScore) const
@@ -147,9 +223,10 @@ double RangeSearchRules<MetricType, TreeType>::Rescore(
 }
 
 //! Dual-tree scoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
-                                                     TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename ResultType>
+double RangeSearchRules<MetricType, TreeType, ResultType>::Score(
+    TreeType& queryNode,
+    TreeType& referenceNode)
 {
   math::Range distances;
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
@@ -209,8 +286,8 @@ double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
 }
 
 //! Dual-tree rescoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Rescore(
+template<typename MetricType, typename TreeType, typename ResultType>
+double RangeSearchRules<MetricType, TreeType, ResultType>::Rescore(
     TreeType& /* queryNode */,
     TreeType& /* referenceNode */,
     const double oldScore) const
@@ -221,9 +298,10 @@ double RangeSearchRules<MetricType, TreeType>::Rescore(
 
 //! Add all the points in the given node to the results for the given query
 //! point.
-template<typename MetricType, typename TreeType>
-void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
-                                                       TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename ResultType>
+void RangeSearchRules<MetricType, TreeType, ResultType>::AddResult(
+    const size_t queryIndex,
+    TreeType& referenceNode)
 {
   // Some types of trees calculate the base case evaluation before Score() is
   // called, so if the base case has already been calculated, then we must avoid
@@ -236,14 +314,10 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     baseCaseMod = 1;
   }
 
-  // Resize distances and neighbors vectors appropriately.  We have to use
-  // reserve() and not resize(), because we don't know if we will encounter the
-  // case where the datasets and points are the same (and we skip in that case).
-  const size_t oldSize = neighbors[queryIndex].size();
-  neighbors[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
-  distances[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
+  // Make room for the results.  This may be one too many, because we don't
+  // know if we will encounter the case where the datasets and points are the
+  // same (and we skip in that case).
+  results.Reserve(queryIndex, referenceNode.NumDescendants() - baseCaseMod);
 
   for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
   {
@@ -251,11 +325,14 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
         (queryIndex == referenceNode.Descendant(i)))
       continue;
 
-    const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-        referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i)));
+    // Every point of the node is in the range, so the distance is only
+    // computed if it is stored.
+    const double distance = ResultType::NeedsDistances ?
+        metric.Evaluate(querySet.unsafe_col(queryIndex),
+            referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i))) :
+        0.0;
 
-    neighbors[queryIndex].push_back(referenceNode.Descendant(i));
-    distances[queryIndex].push_back(distance);
+    results.Add(queryIndex, referenceNode.Descendant(i), distance);
   }
 }
 
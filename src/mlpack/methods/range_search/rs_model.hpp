@@ -20,6 +20,7 @@
 #include <mlpack/core/tree/rectangle_tree.hpp>
 #include <mlpack/core/tree/octree.hpp>
 #include <boost/variant.hpp>
+#include <functional>
 
 #include "range_search.hpp"
 
@@ -27,12 +28,65 @@ namespace mlpack {
 namespace range {
 
 /**
- * Alias template for Range Search.
+ * Alias template for Range Search.  The data is held as double precision unless
+ * MatType is given.
  */
 template<template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-using RSType = RangeSearch<metric::EuclideanDistance, arma::mat, TreeType>;
+                  typename TreeMatType> class TreeType,
+         typename MatType = arma::mat>
+using RSType = RangeSearch<metric::EuclideanDistance, MatType, TreeType>;
+
+/**
+ * Recompute the distances between each query point and the neighbors found for
+ * it in double precision, and remove the neighbors whose distance is then
+ * outside of the given range.  This is used for models that hold their data in
+ * single precision, to avoid accumulating the distances in single precision;
+ * the reference points themselves are still rounded to single precision, so
+ * the distances are accurate to about 1e-7 relative to the magnitude of the
+ * points.  The neighbors index the reference set of the given RSType in its
+ * original order.
+ *
+ * @param rs The RSType that found the neighbors.
+ * @param querySet The query points, or NULL if the query points are the
+ *      reference points themselves (monochromatic search).
+ * @param range The range that was searched for.
+ * @param neighbors The neighbors found for each query point.
+ * @param distances The distances to recompute.
+ */
+template<typename RSType>
+void RecomputeDistances(const RSType& rs,
+                        const arma::mat* querySet,
+                        const math::Range& range,
+                        std::vector<std::vector<size_t>>& neighbors,
+                        std::vector<std::vector<double>>& distances);
+
+/**
+ * The type of callback that the results of a search can be given to instead of
+ * being stored; it is called as callback(queryIndex, referenceIndex, distance)
+ * for every result.  See RangeSearch<>::Search() for details.
+ */
+typedef std::function<void(size_t, size_t, double)> RSCallback;
+
+/**
+ * Wrap the given callback so that the distance of every result is recomputed
+ * in double precision before it is given to the callback, and results whose
+ * distance is then outside of the given range are dropped.  This is the
+ * counterpart of RecomputeDistances() for searches with a callback.
+ *
+ * @param rs The RSType that will find the results.
+ * @param querySet The query points, or NULL for monochromatic search.
+ * @param range The range that will be searched for.
+ * @param callback The callback to give the results to.
+ * @param newFromOld Storage for the mapping from the original reference indices
+ *      to those of the reference set of rs; it must outlive the search.
+ */
+template<typename RSType>
+RSCallback DoubleDistanceCallback(const RSType& rs,
+                                  const arma::mat* querySet,
+                                  const math::Range& range,
+                                  const RSCallback& callback,
+                                  std::vector<size_t>& newFromOld);
 
 /**
  * MonoSearchVisitor executes a monochromatic range search on the given
@@ -43,10 +97,14 @@ class MonoSearchVisitor : public  boost::static_visitor<void>
  private:
   //! The range to search for.
   const math::Range& range;
-  //! Output neighbors.
-  std::vector<std::vector<size_t>>& neighbors;
-  //! Output distances.
-  std::vector<std::vector<double>>& distances;
+  //! Output neighbors (NULL if the results are given to a callback).
+  std::vector<std::vector<size_t>>* neighbors;
+  //! Output distances (NULL if the results are given to a callback).
+  std::vector<std::vector<double>>* distances;
+  //! The callback to give the results to, or NULL.
+  const RSCallback* callback;
+  //! If true, recompute the distances in double precision.
+  const bool doubleDistances;
 
  public:
   //! Perform monochromatic search with the given RangeSearch object.
@@ -56,10 +114,24 @@ class MonoSearchVisitor : public  boost::static_visitor<void>
   //! Construct the MonoSearchVisitor with the given parameters.
   MonoSearchVisitor(const math::Range& range,
                     std::vector<std::vector<size_t>>& neighbors,
-                    std::vector<std::vector<double>>& distances):
+                    std::vector<std::vector<double>>& distances,
+                    const bool doubleDistances = false):
+      range(range),
+      neighbors(&neighbors),
+      distances(&distances),
+      callback(NULL),
+      doubleDistances(doubleDistances)
+  {};
+
+  //! Construct the MonoSearchVisitor to give the results to a callback.
+  MonoSearchVisitor(const math::Range& range,
+                    const RSCallback& callback,
+                    const bool doubleDistances = false):
       range(range),
-      neighbors(neighbors),
-      distances(distances)
+      neighbors(NULL),
+      distances(NULL),
+      callback(&callback),
+      doubleDistances(doubleDistances)
   {};
 };
 
@@ -76,16 +148,26 @@ class BiSearchVisitor : public boost::static_visitor<void>
   const arma::mat& querySet;
   //! Range to search neighbours for.
   const math::Range& range;
-  //! The result vector for neighbors.
-  std::vector<std::vector<size_t>>& neighbors;
-  //! The result vector for distances.
-  std::vector<std::vector<double>>& distances;
+  //! The result vector for neighbors (NULL if the results are given to a
+  //! callback).
+  std::vector<std::vector<size_t>>* neighbors;
+  //! The result vector for distances (NULL if the results are given to a
+  //! callback).
+  std::vector<std::vector<double>>* distances;
+  //! The callback to give the results to, or NULL.
+  const RSCallback* callback;
   //! The number of points in a leaf (for BinarySpaceTrees).
   const size_t leafSize;
+  //! If true, recompute the distances of single-precision models in double
+  //! precision.
+  const bool doubleDistances;
 
   //! Bichromatic range search on the given RSType considering the leafSize.
-  template<typename RSType>
-  void SearchLeaf(RSType* rs) const;
+  //! If searchCallback is not NULL, the results are given to it.
+  template<typename RSType, typename MatType>
+  void SearchLeaf(RSType* rs,
+                  const MatType& querySet,
+                  const RSCallback* searchCallback) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -109,12 +191,23 @@ class BiSearchVisitor : public boost::static_visitor<void>
   //! Bichromatic range search specialized for octrees.
   void operator()(RSTypeT<tree::Octree>* rs) const;
 
+  //! Bichromatic range search specialized for single-precision KDTrees.
+  void operator()(RSType<tree::KDTree, arma::fmat>* rs) const;
+
   //! Construct the BiSearchVisitor.
   BiSearchVisitor(const arma::mat& querySet,
                   const math::Range& range,
                   std::vector<std::vector<size_t>>& neighbors,
                   std::vector<std::vector<double>>& distances,
-                  const size_t leafSize);
+                  const size_t leafSize,
+                  const bool doubleDistances = false);
+
+  //! Construct the BiSearchVisitor to give the results to a callback.
+  BiSearchVisitor(const arma::mat& querySet,
+                  const math::Range& range,
+                  const RSCallback& callback,
+                  const size_t leafSize,
+                  const bool doubleDistances = false);
 };
 
 /**
@@ -131,8 +224,8 @@ class TrainVisitor : public boost::static_visitor<void>
   //! The leaf size, used only by BinarySpaceTree.
   size_t leafSize;
   //! Train on the given RsType considering the leafSize.
-  template<typename RSType>
-  void TrainLeaf(RSType* rs) const;
+  template<typename RSType, typename MatType>
+  void TrainLeaf(RSType* rs, MatType&& dataset) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -156,20 +249,34 @@ class TrainVisitor : public boost::static_visitor<void>
   //! Train specialized for octrees.
   void operator()(RSTypeT<tree::Octree>* rs) const;
 
+  //! Train specialized for single-precision KDTrees.
+  void operator()(RSType<tree::KDTree, arma::fmat>* rs) const;
+
   //! Construct the TrainVisitor object with the given reference set, leafSize
   TrainVisitor(arma::mat&& referenceSet,
                const size_t leafSize);
 };
 
 /**
- * ReferenceSetVisitor exposes the referenceSet of the given RSType.
+ * ReferenceSetVisitor exposes the referenceSet of the given RSType.  A
+ * std::invalid_argument is thrown if the reference set of the RSType is not of
+ * type MatType.
  */
-class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
+template<typename MatType = arma::mat>
+class ReferenceSetVisitor : public boost::static_visitor<const MatType&>
 {
  public:
   //! Return the reference set.
   template<typename RSType>
-  const arma::mat& operator()(RSType* rs) const;
+  const MatType& operator()(RSType* rs) const;
+
+ private:
+  //! Return the given reference set, which has the right type.
+  const MatType& Get(const MatType& referenceSet) const { return referenceSet; }
+
+  //! Throw, since the reference set does not have the right type.
+  template<typename OtherMatType>
+  const MatType& Get(const OtherMatType& referenceSet) const;
 };
 
 /**
@@ -240,6 +347,12 @@ class RSModel
   //! Random projection matrix.
   arma::mat q;
 
+  //! If true, the reference set is held in single precision.
+  bool singlePrecision;
+  //! If true, the distances returned by searches of a single-precision model
+  //! are recomputed in double precision.  This is not serialized.
+  bool doubleDistances;
+
   /**
    * rSearch holds an instance of the RangeSearch class for the current
    * treeType. It is initialized every time BuildModel is executed.
@@ -258,18 +371,23 @@ class RSModel
                  RSType<tree::RPTree>*,
                  RSType<tree::MaxRPTree>*,
                  RSType<tree::UBTree>*,
-                 RSType<tree::Octree>*> rSearch;
+                 RSType<tree::Octree>*,
+                 RSType<tree::KDTree, arma::fmat>*> rSearch;
 
  public:
   /**
    * Initialize the RSModel with the given type and whether or not a random
-   * basis should be used.
+   * basis should be used.  If singlePrecision is true, the reference set is
+   * converted to single precision when the model is built; this is only
+   * supported for kd-trees.
    *
    * @param treeType Type of tree to use.
    * @param randomBasis Whether or not to use a random basis.
+   * @param singlePrecision Whether or not to hold the data in single precision.
    */
   RSModel(const TreeTypes treeType = TreeTypes::KD_TREE,
-          const bool randomBasis = false);
+          const bool randomBasis = false,
+          const bool singlePrecision = false);
 
   /**
    * Copy the given RSModel.
@@ -303,8 +421,11 @@ class RSModel
   template<typename Archive>
   void serialize(Archive& ar, const uint32_t /* version */);
 
-  //! Expose the dataset.
+  //! Expose the dataset.  This throws if the model is single-precision.
   const arma::mat& Dataset() const;
+  //! Expose the dataset of a single-precision model.  This throws if the model
+  //! is double-precision.
+  const arma::fmat& FloatDataset() const;
 
   //! Get whether the model is in single-tree search mode.
   bool SingleMode() const;
@@ -332,6 +453,19 @@ class RSModel
   //! been built).
   bool& RandomBasis() { return randomBasis; }
 
+  //! Get whether the data is held in single precision.
+  bool SinglePrecision() const { return singlePrecision; }
+  //! Modify whether the data is held in single precision (don't do this after
+  //! the model has been built).
+  bool& SinglePrecision() { return singlePrecision; }
+
+  //! Get whether the distances found by a single-precision model are
+  //! recomputed in double precision.
+  bool DoubleDistances() const { return doubleDistances; }
+  //! Modify whether the distances found by a single-precision model are
+  //! recomputed in double precision.
+  bool& DoubleDistances() { return doubleDistances; }
+
   /**
    * Build the reference tree on the given dataset with the given parameters.
    * This takes possession of the reference set to avoid a copy.
@@ -374,6 +508,29 @@ class RSModel
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
 
+  /**
+   * Perform range search, and give every result to the given callback as soon
+   * as it is found instead of storing it.  This takes possession of the query
+   * set, so the query set will not be usable after the search.  The callback
+   * may be called by several threads at once; see RangeSearch<>::Search().
+   *
+   * @param querySet Set of query points.
+   * @param range Range to search for.
+   * @param callback Callback to give the results to.
+   */
+  void Search(arma::mat&& querySet,
+              const math::Range& range,
+              const RSCallback& callback);
+
+  /**
+   * Perform monochromatic range search, with the reference set as the query
+   * set, and give every result to the given callback instead of storing it.
+   *
+   * @param range Range to search for.
+   * @param callback Callback to give the results to.
+   */
+  void Search(const math::Range& range, const RSCallback& callback);
+
  private:
   /**
    * Return a string representing the name of the tree.  This is used for
@@ -381,6 +538,11 @@ class RSModel
    */
   std::string TreeName() const;
 
+  /**
+   * Print the range and the type of search that is about to be done.
+   */
+  void LogSearch(const math::Range& range) const;
+
   /**
    * Clean up memory.
    */
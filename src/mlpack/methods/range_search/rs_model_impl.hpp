@@ -24,10 +24,14 @@ namespace range {
  * Initialize the RSModel with the given tree type and whether or not a random
  * basis should be used.
  */
-inline RSModel::RSModel(TreeTypes treeType, bool randomBasis) :
+inline RSModel::RSModel(TreeTypes treeType,
+                        bool randomBasis,
+                        bool singlePrecision) :
     treeType(treeType),
     leafSize(0),
-    randomBasis(randomBasis)
+    randomBasis(randomBasis),
+    singlePrecision(singlePrecision),
+    doubleDistances(false)
 {
   // Nothing to do.
 }
@@ -38,6 +42,8 @@ inline RSModel::RSModel(const RSModel& other) :
     leafSize(other.leafSize),
     randomBasis(other.randomBasis),
     q(other.q),
+    singlePrecision(other.singlePrecision),
+    doubleDistances(other.doubleDistances),
     rSearch(other.rSearch)
 {
   // Nothing to do.
@@ -49,12 +55,16 @@ inline RSModel::RSModel(RSModel&& other) :
     leafSize(other.leafSize),
     randomBasis(other.randomBasis),
     q(std::move(other.q)),
+    singlePrecision(other.singlePrecision),
+    doubleDistances(other.doubleDistances),
     rSearch(std::move(other.rSearch))
 {
   // Reset other model.
   other.treeType = TreeTypes::KD_TREE;
   other.leafSize = 0;
   other.randomBasis = false;
+  other.singlePrecision = false;
+  other.doubleDistances = false;
   other.rSearch = decltype(other.rSearch)();
 }
 
@@ -66,6 +76,8 @@ inline RSModel& RSModel::operator=(RSModel other)
   leafSize = other.leafSize;
   randomBasis = other.randomBasis;
   q = std::move(other.q);
+  singlePrecision = other.singlePrecision;
+  doubleDistances = other.doubleDistances;
   rSearch = std::move(other.rSearch);
 
   return *this;
@@ -82,6 +94,12 @@ inline void RSModel::BuildModel(arma::mat&& referenceSet,
                                 const bool naive,
                                 const bool singleMode)
 {
+  if (singlePrecision && treeType != KD_TREE)
+  {
+    throw std::invalid_argument("single-precision models are only supported "
+        "with kd-trees");
+  }
+
   // Initialize random basis if necessary.
   if (randomBasis)
   {
@@ -107,7 +125,10 @@ inline void RSModel::BuildModel(arma::mat&& referenceSet,
   switch (treeType)
   {
     case KD_TREE:
-      rSearch = new RSType<tree::KDTree> (naive, singleMode);
+      if (singlePrecision)
+        rSearch = new RSType<tree::KDTree, arma::fmat>(naive, singleMode);
+      else
+        rSearch = new RSType<tree::KDTree>(naive, singleMode);
       break;
 
     case COVER_TREE:
@@ -183,18 +204,10 @@ inline void RSModel::Search(arma::mat&& querySet,
   if (randomBasis)
     querySet = q * querySet;
 
-  Log::Info << "Search for points in the range [" << range.Lo() << ", "
-      << range.Hi() << "] with ";
-  if (!Naive() && !SingleMode())
-    Log::Info << "dual-tree " << TreeName() << " search..." << std::endl;
-  else if (!Naive())
-    Log::Info << "single-tree " << TreeName() << " search..." << std::endl;
-  else
-    Log::Info << "brute-force (naive) search..." << std::endl;
-
+  LogSearch(range);
 
   BiSearchVisitor search(querySet, range, neighbors, distances,
-      leafSize);
+      leafSize, singlePrecision && doubleDistances);
   boost::apply_visitor(search, rSearch);
 }
 
@@ -202,6 +215,43 @@ inline void RSModel::Search(arma::mat&& querySet,
 inline void RSModel::Search(const math::Range& range,
                             std::vector<std::vector<size_t>>& neighbors,
                             std::vector<std::vector<double>>& distances)
+{
+  LogSearch(range);
+
+  MonoSearchVisitor search(range, neighbors, distances,
+      singlePrecision && doubleDistances);
+  boost::apply_visitor(search, rSearch);
+}
+
+// Perform range search with a callback.
+inline void RSModel::Search(arma::mat&& querySet,
+                            const math::Range& range,
+                            const RSCallback& callback)
+{
+  // We may need to map the query set randomly.
+  if (randomBasis)
+    querySet = q * querySet;
+
+  LogSearch(range);
+
+  BiSearchVisitor search(querySet, range, callback, leafSize,
+      singlePrecision && doubleDistances);
+  boost::apply_visitor(search, rSearch);
+}
+
+// Perform range search with a callback (monochromatic case).
+inline void RSModel::Search(const math::Range& range,
+                            const RSCallback& callback)
+{
+  LogSearch(range);
+
+  MonoSearchVisitor search(range, callback,
+      singlePrecision && doubleDistances);
+  boost::apply_visitor(search, rSearch);
+}
+
+// Print the type of search.
+inline void RSModel::LogSearch(const math::Range& range) const
 {
   Log::Info << "Search for points in the range [" << range.Lo() << ", "
       << range.Hi() << "] with ";
@@ -211,9 +261,6 @@ inline void RSModel::Search(const math::Range& range,
     Log::Info << "single-tree " << TreeName() << " search..." << std::endl;
   else
     Log::Info << "brute-force (naive) search..." << std::endl;
-
-  MonoSearchVisitor search(range, neighbors, distances);
-  boost::apply_visitor(search, rSearch);
 }
 
 // Get the name of the tree type.
@@ -260,12 +307,107 @@ inline void RSModel::CleanMemory()
   boost::apply_visitor(DeleteVisitor(), rSearch);
 }
 
+//! Recompute the distances to the neighbors in double precision, from the
+//! single-precision reference points.
+template<typename RSType>
+void RecomputeDistances(const RSType& rs,
+                        const arma::mat* querySet,
+                        const math::Range& range,
+                        std::vector<std::vector<size_t>>& neighbors,
+                        std::vector<std::vector<double>>& distances)
+{
+  // The reference set may have been reordered when the tree was built.
+  const std::vector<size_t>& oldFromNew = rs.OldFromNewReferences();
+  std::vector<size_t> newFromOld(oldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    newFromOld[oldFromNew[i]] = i;
+
+  for (size_t i = 0; i < neighbors.size(); ++i)
+  {
+    const arma::vec queryPoint = (querySet != NULL) ?
+        arma::vec(querySet->col(i)) :
+        arma::conv_to<arma::vec>::from(rs.ReferenceSet().col(
+            newFromOld.empty() ? i : newFromOld[i]));
+
+    // Only keep the neighbors that are still in the range.
+    size_t kept = 0;
+    for (size_t j = 0; j < neighbors[i].size(); ++j)
+    {
+      const size_t index = newFromOld.empty() ? neighbors[i][j] :
+          newFromOld[neighbors[i][j]];
+      const double distance = metric::EuclideanDistance::Evaluate(queryPoint,
+          arma::conv_to<arma::vec>::from(rs.ReferenceSet().col(index)));
+      if (range.Contains(distance))
+      {
+        neighbors[i][kept] = neighbors[i][j];
+        distances[i][kept] = distance;
+        ++kept;
+      }
+    }
+
+    neighbors[i].resize(kept);
+    distances[i].resize(kept);
+  }
+}
+
+//! Recompute the distances given to a callback in double precision.
+template<typename RSType>
+RSCallback DoubleDistanceCallback(const RSType& rs,
+                                  const arma::mat* querySet,
+                                  const math::Range& range,
+                                  const RSCallback& callback,
+                                  std::vector<size_t>& newFromOld)
+{
+  // The reference set may have been reordered when the tree was built.
+  const std::vector<size_t>& oldFromNew = rs.OldFromNewReferences();
+  newFromOld.resize(oldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    newFromOld[oldFromNew[i]] = i;
+
+  return [&rs, querySet, range, &callback, &newFromOld](const size_t query,
+      const size_t reference, const double /* distance */)
+  {
+    const size_t index = newFromOld.empty() ? reference :
+        newFromOld[reference];
+    const arma::vec referencePoint =
+        arma::conv_to<arma::vec>::from(rs.ReferenceSet().col(index));
+    const arma::vec queryPoint = (querySet != NULL) ?
+        arma::vec(querySet->col(query)) :
+        arma::conv_to<arma::vec>::from(rs.ReferenceSet().col(
+            newFromOld.empty() ? query : newFromOld[query]));
+
+    // Only keep the results that are still in the range.
+    const double distance = metric::EuclideanDistance::Evaluate(queryPoint,
+        referencePoint);
+    if (range.Contains(distance))
+      callback(query, reference, distance);
+  };
+}
+
 //! Monochromatic range search on the given RSType instance.
 template<typename RSType>
 void MonoSearchVisitor::operator()(RSType* rs) const
 {
   if (rs)
-    return rs->Search(range, neighbors, distances);
+  {
+    if (callback && doubleDistances)
+    {
+      std::vector<size_t> newFromOld;
+      rs->Search(range, DoubleDistanceCallback(*rs, NULL, range, *callback,
+          newFromOld));
+    }
+    else if (callback)
+    {
+      rs->Search(range, *callback);
+    }
+    else
+    {
+      rs->Search(range, *neighbors, *distances);
+      if (doubleDistances)
+        RecomputeDistances(*rs, NULL, range, *neighbors, *distances);
+    }
+    return;
+  }
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -275,12 +417,31 @@ inline BiSearchVisitor::BiSearchVisitor(
     const math::Range& range,
     std::vector<std::vector<size_t>>& neighbors,
     std::vector<std::vector<double>>& distances,
-    const size_t leafSize) :
+    const size_t leafSize,
+    const bool doubleDistances) :
     querySet(querySet),
     range(range),
-    neighbors(neighbors),
-    distances(distances),
-    leafSize(leafSize)
+    neighbors(&neighbors),
+    distances(&distances),
+    callback(NULL),
+    leafSize(leafSize),
+    doubleDistances(doubleDistances)
+{}
+
+//! Save parameters for bichromatic range search with a callback.
+inline BiSearchVisitor::BiSearchVisitor(
+    const arma::mat& querySet,
+    const math::Range& range,
+    const RSCallback& callback,
+    const size_t leafSize,
+    const bool doubleDistances) :
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    callback(&callback),
+    leafSize(leafSize),
+    doubleDistances(doubleDistances)
 {}
 
 //! Default Bichromatic range search on the given RSType instance.
@@ -290,7 +451,11 @@ template<template<typename TreeMetricType,
 void BiSearchVisitor::operator()(RSTypeT<TreeType>* rs) const
 {
   if (rs)
-    return rs->Search(querySet, range, neighbors, distances);
+  {
+    if (callback)
+      return rs->Search(querySet, range, *callback);
+    return rs->Search(querySet, range, *neighbors, *distances);
+  }
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -298,7 +463,7 @@ void BiSearchVisitor::operator()(RSTypeT<TreeType>* rs) const
 inline void BiSearchVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 {
   if (rs)
-    return SearchLeaf(rs);
+    return SearchLeaf(rs, querySet, callback);
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -306,7 +471,7 @@ inline void BiSearchVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 inline void BiSearchVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 {
   if (rs)
-    return SearchLeaf(rs);
+    return SearchLeaf(rs, querySet, callback);
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -314,13 +479,39 @@ inline void BiSearchVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 inline void BiSearchVisitor::operator()(RSTypeT<tree::Octree>* rs) const
 {
   if (rs)
-    return SearchLeaf(rs);
+    return SearchLeaf(rs, querySet, callback);
+  throw std::runtime_error("no range search model initialized");
+}
+
+//! Bichromatic range search specialized for single-precision KDTrees.
+inline void BiSearchVisitor::operator()(
+    RSType<tree::KDTree, arma::fmat>* rs) const
+{
+  if (rs)
+  {
+    if (callback && doubleDistances)
+    {
+      std::vector<size_t> newFromOld;
+      const RSCallback exactCallback = DoubleDistanceCallback(*rs, &querySet,
+          range, *callback, newFromOld);
+      SearchLeaf(rs, arma::conv_to<arma::fmat>::from(querySet),
+          &exactCallback);
+      return;
+    }
+
+    SearchLeaf(rs, arma::conv_to<arma::fmat>::from(querySet), callback);
+    if (doubleDistances && !callback)
+      RecomputeDistances(*rs, &querySet, range, *neighbors, *distances);
+    return;
+  }
   throw std::runtime_error("no range search model initialized");
 }
 
 //! Bichromatic range search on the given RSType considering the leafSize.
-template<typename RSType>
-void BiSearchVisitor::SearchLeaf(RSType* rs) const
+template<typename RSType, typename MatType>
+void BiSearchVisitor::SearchLeaf(RSType* rs,
+                                 const MatType& querySet,
+                                 const RSCallback* searchCallback) const
 {
   if (!rs->Naive() && !rs->SingleMode())
   {
@@ -333,21 +524,34 @@ void BiSearchVisitor::SearchLeaf(RSType* rs) const
     Log::Info << "Tree built." << std::endl;
     Timer::Stop("tree_building");
 
+    if (searchCallback)
+    {
+      // Remap the query points before they are given to the callback.
+      rs->Search(&queryTree, range, [&](const size_t query,
+          const size_t reference, const double distance)
+      {
+        (*searchCallback)(oldFromNewQueries[query], reference, distance);
+      });
+      return;
+    }
+
     std::vector<std::vector<size_t>> neighborsOut;
     std::vector<std::vector<double>> distancesOut;
     rs->Search(&queryTree, range, neighborsOut, distancesOut);
 
     // Remap the query points.
-    neighbors.resize(queryTree.Dataset().n_cols);
-    distances.resize(queryTree.Dataset().n_cols);
+    neighbors->resize(queryTree.Dataset().n_cols);
+    distances->resize(queryTree.Dataset().n_cols);
     for (size_t i = 0; i < queryTree.Dataset().n_cols; ++i)
     {
-      neighbors[oldFromNewQueries[i]] = neighborsOut[i];
-      distances[oldFromNewQueries[i]] = distancesOut[i];
+      (*neighbors)[oldFromNewQueries[i]] = neighborsOut[i];
+      (*distances)[oldFromNewQueries[i]] = distancesOut[i];
     }
   }
+  else if (searchCallback)
+    rs->Search(querySet, range, *searchCallback);
   else
-    rs->Search(querySet, range, neighbors, distances);
+    rs->Search(querySet, range, *neighbors, *distances);
 }
 
 //! Save parameters for Train.
@@ -372,7 +576,7 @@ void TrainVisitor::operator()(RSTypeT<TreeType>* rs) const
 inline void TrainVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 {
   if (rs)
-    return TrainLeaf(rs);
+    return TrainLeaf(rs, std::move(referenceSet));
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -380,7 +584,7 @@ inline void TrainVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 inline void TrainVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 {
   if (rs)
-    return TrainLeaf(rs);
+    return TrainLeaf(rs, std::move(referenceSet));
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -388,21 +592,35 @@ inline void TrainVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 inline void TrainVisitor::operator()(RSTypeT<tree::Octree>* rs) const
 {
   if (rs)
-    return TrainLeaf(rs);
+    return TrainLeaf(rs, std::move(referenceSet));
+  throw std::runtime_error("no range search model initialized");
+}
+
+//! Train specialized for single-precision KDTrees.
+inline void TrainVisitor::operator()(RSType<tree::KDTree, arma::fmat>* rs) const
+{
+  if (rs)
+  {
+    arma::fmat floatReferenceSet = arma::conv_to<arma::fmat>::from(
+        referenceSet);
+    // The double-precision copy is no longer needed.
+    referenceSet.reset();
+    return TrainLeaf(rs, std::move(floatReferenceSet));
+  }
   throw std::runtime_error("no range search model initialized");
 }
 
 //! Train on the given RSType considering the leafSize.
-template<typename RSType>
-void TrainVisitor::TrainLeaf(RSType* rs) const
+template<typename RSType, typename MatType>
+void TrainVisitor::TrainLeaf(RSType* rs, MatType&& dataset) const
 {
   if (rs->Naive())
-    rs->Train(std::move(referenceSet));
+    rs->Train(std::move(dataset));
   else
   {
     std::vector<size_t> oldFromNewReferences;
     typename RSType::Tree* tree =
-        new typename RSType::Tree(std::move(referenceSet), oldFromNewReferences,
+        new typename RSType::Tree(std::move(dataset), oldFromNewReferences,
         leafSize);
     rs->Train(tree);
 
@@ -413,14 +631,25 @@ void TrainVisitor::TrainLeaf(RSType* rs) const
 }
 
 //! Expose the referenceSet of the given RSType.
+template<typename MatType>
 template<typename RSType>
-const arma::mat& ReferenceSetVisitor::operator()(RSType* rs) const
+const MatType& ReferenceSetVisitor<MatType>::operator()(RSType* rs) const
 {
   if (rs)
-    return rs->ReferenceSet();
+    return Get(rs->ReferenceSet());
   throw std::runtime_error("no range search model initialized");
 }
 
+//! Throw, since the reference set does not have the requested type.
+template<typename MatType>
+template<typename OtherMatType>
+const MatType& ReferenceSetVisitor<MatType>::Get(
+    const OtherMatType& /* referenceSet */) const
+{
+  throw std::invalid_argument("the reference set of the model does not have "
+      "the requested precision");
+}
+
 //! For cleaning memory
 template<typename RSType>
 void DeleteVisitor::operator()(RSType* rs) const
@@ -461,11 +690,23 @@ void RSModel::serialize(Archive& ar, const uint32_t /* version */)
 
   // We'll only need to serialize one of the model objects, based on the type.
   ar(CEREAL_VARIANT_POINTER(rSearch));
+
+  // The precision is implied by the type of the model.
+  if (cereal::is_loading<Archive>())
+  {
+    singlePrecision =
+        (boost::get<RSType<tree::KDTree, arma::fmat>*>(&rSearch) != NULL);
+  }
 }
 
 inline const arma::mat& RSModel::Dataset() const
 {
-  return boost::apply_visitor(ReferenceSetVisitor(), rSearch);
+  return boost::apply_visitor(ReferenceSetVisitor<arma::mat>(), rSearch);
+}
+
+inline const arma::fmat& RSModel::FloatDataset() const
+{
+  return boost::apply_visitor(ReferenceSetVisitor<arma::fmat>(), rSearch);
 }
 
 inline bool RSModel::SingleMode() const
@@ -45,7 +45,15 @@ BINDING_LONG_DESC(
     "set of points. You may specify a separate set of reference points and "
     "query points, or just a reference set which will be used as both the "
     "reference and query set. You must specify the rank approximation (in %) "
-    "(and optionally the success probability).");
+    "(and optionally the success probability)."
+    "\n\n"
+    "If " + PRINT_PARAM_STRING("single_precision") + " is specified, the "
+    "reference set and kd-tree are held in single precision, which halves the "
+    "memory used by the model and speeds up the search.  The distances that "
+    "are returned can then be recomputed in double precision by specifying " +
+    PRINT_PARAM_STRING("double_distances") + "; the reference points "
+    "themselves stay rounded to single precision, so the recomputed distances "
+    "are only accurate to about 1e-7 relative to the points' magnitude.");
 
 // Example.
 BINDING_EXAMPLE(
@@ -105,6 +113,11 @@ PARAM_INT_IN("leaf_size", "Leaf size for tree building (used for kd-trees, "
     "R++ trees, and octrees).", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_FLAG("single_precision", "Hold the reference set and tree in single "
+    "precision (only valid for kd-trees).", "");
+PARAM_FLAG("double_distances", "If the model is held in single precision, "
+    "recompute the distances to the neighbors that are found in double "
+    "precision.", "");
 PARAM_INT_IN("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search options.
@@ -134,6 +147,7 @@ static void mlpackMain()
   ReportIgnoredParam({{ "input_model", true }}, "tree_type");
   ReportIgnoredParam({{ "input_model", true }}, "leaf_size");
   ReportIgnoredParam({{ "input_model", true }}, "random_basis");
+  ReportIgnoredParam({{ "input_model", true }}, "single_precision");
   ReportIgnoredParam({{ "input_model", true }}, "naive");
 
   // The user should give something to do...
@@ -169,6 +183,14 @@ static void mlpackMain()
       return (x >= 0.0 && x <=1.0); }, true,
       "alpha must be in range [0.0, 1.0]");
 
+  // Single precision is only supported for kd-trees.
+  if (IO::HasParam("reference") && IO::HasParam("single_precision") &&
+      IO::GetParam<string>("tree_type") != "kd")
+  {
+    Log::Fatal << PRINT_PARAM_STRING("single_precision") << " is only "
+        << "supported with kd-trees!" << endl;
+  }
+
   // We either have to load the reference data, or we have to load the model.
   RANNModel* rann;
   const bool naive = IO::HasParam("naive");
@@ -208,6 +230,7 @@ static void mlpackMain()
 
     rann->TreeType() = tree;
     rann->RandomBasis() = randomBasis;
+    rann->SinglePrecision() = IO::HasParam("single_precision");
 
     Log::Info << "Using reference data from "
         << IO::GetPrintableParam<arma::mat>("reference") << "." << endl;
@@ -222,8 +245,10 @@ static void mlpackMain()
 
     Log::Info << "Using rank-approximate kNN model from '"
         << IO::GetPrintableParam<RANNModel*>("input_model") << "' (trained on "
-        << rann->Dataset().n_rows << "x" << rann->Dataset().n_cols
-        << " dataset)." << endl;
+        << (rann->SinglePrecision() ? rann->FloatDataset().n_rows :
+            rann->Dataset().n_rows) << "x"
+        << (rann->SinglePrecision() ? rann->FloatDataset().n_cols :
+            rann->Dataset().n_cols) << " dataset)." << endl;
 
     // Adjust singleMode and naive if necessary.
     rann->SingleMode() = IO::HasParam("single_mode");
@@ -241,6 +266,19 @@ static void mlpackMain()
   rann->SampleAtLeaves() = IO::HasParam("sample_at_leaves");
   rann->FirstLeafExact() = IO::HasParam("sample_at_leaves");
 
+  if (!rann->SinglePrecision())
+  {
+    ReportIgnoredParam("double_distances",
+        "the model is not held in single precision");
+  }
+  rann->DoubleDistances() = IO::HasParam("double_distances");
+
+  // The reference set may be held in either precision.
+  const size_t dimensions = rann->SinglePrecision() ?
+      rann->FloatDataset().n_rows : rann->Dataset().n_rows;
+  const size_t referencePoints = rann->SinglePrecision() ?
+      rann->FloatDataset().n_cols : rann->Dataset().n_cols;
+
   // Perform search, if desired.
   if (IO::HasParam("k"))
   {
@@ -253,9 +291,8 @@ static void mlpackMain()
       Log::Info << "Using query data from '"
           << IO::GetPrintableParam<arma::mat>("query") << "' ("
           << queryData.n_rows << "x" << queryData.n_cols << ")." << endl;
-      if (queryData.n_rows != rann->Dataset().n_rows)
+      if (queryData.n_rows != dimensions)
       {
-        const size_t dimensions = rann->Dataset().n_rows;
         Log::Fatal << "Query has invalid dimensions(" << queryData.n_rows <<
             "); should be " << dimensions << "!" << endl;
       }
@@ -264,11 +301,11 @@ static void mlpackMain()
     // Sanity check on k value: must be greater than 0, must be less than the
     // number of reference points.  Since it is unsigned, we only test the upper
     // bound.
-    if (k > rann->Dataset().n_cols)
+    if (k > referencePoints)
     {
       Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
       Log::Fatal << "than or equal to the number of reference points (";
-      Log::Fatal << rann->Dataset().n_cols << ")." << endl;
+      Log::Fatal << referencePoints << ")." << endl;
     }
 
     arma::Mat<size_t> neighbors;
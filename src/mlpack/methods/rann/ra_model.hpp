@@ -25,17 +25,39 @@ namespace mlpack {
 namespace neighbor {
 
 /**
- * Alias template for RASearch
+ * Alias template for RASearch.  The data is held as double precision unless
+ * MatType is given.
  */
 template<typename SortPolicy,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
+                  typename TreeMatType> class TreeType,
+         typename MatType = arma::mat>
 using RAType = RASearch<SortPolicy,
                         metric::EuclideanDistance,
-                        arma::mat,
+                        MatType,
                         TreeType>;
 
+/**
+ * Recompute the distances between each query point and its neighbors in double
+ * precision.  This is used for models that hold their data in single precision,
+ * to avoid accumulating the distances in single precision; the reference
+ * points themselves are still rounded to single precision, so the distances
+ * are accurate to about 1e-7 relative to the magnitude of the points.  The
+ * neighbors index the reference set of the given RAType in its original order.
+ *
+ * @param ra The RAType that found the neighbors.
+ * @param querySet The query points, or NULL if the query points are the
+ *      reference points themselves (monochromatic search).
+ * @param neighbors The neighbors found for each query point.
+ * @param distances The distances to recompute.
+ */
+template<typename RAType>
+void RecomputeDistances(const RAType& ra,
+                        const arma::mat* querySet,
+                        const arma::Mat<size_t>& neighbors,
+                        arma::mat& distances);
+
 /**
  * MonoSearchVisitor executes a monochromatic neighbor search on the given
  * RAType. We don't make any difference for different instantiation of RAType.
@@ -49,6 +71,8 @@ class MonoSearchVisitor : public boost::static_visitor<void>
   arma::Mat<size_t>& neighbors;
   //! Result matrix for distances.
   arma::mat& distances;
+  //! If true, recompute the distances in double precision.
+  const bool doubleDistances;
 
  public:
   //! Perform monochromatic nearest neighbor search.
@@ -58,10 +82,12 @@ class MonoSearchVisitor : public boost::static_visitor<void>
   //! Construct the MonoSearchVisitor object with the given parameters.
   MonoSearchVisitor(const size_t k,
                     arma::Mat<size_t>& neighbors,
-                    arma::mat& distances) :
+                    arma::mat& distances,
+                    const bool doubleDistances = false) :
       k(k),
       neighbors(neighbors),
-      distances(distances)
+      distances(distances),
+      doubleDistances(doubleDistances)
   {};
 };
 
@@ -85,10 +111,13 @@ class BiSearchVisitor : public boost::static_visitor<void>
   arma::mat& distances;
   //! The number of points in a leaf (for BinarySpaceTrees).
   const size_t leafSize;
+  //! If true, recompute the distances of single-precision models in double
+  //! precision.
+  const bool doubleDistances;
 
   //! Bichromatic neighbor search on the given RAType considering leafSize.
-  template<typename RAType>
-  void SearchLeaf(RAType* ra) const;
+  template<typename RAType, typename MatType>
+  void SearchLeaf(RAType* ra, const MatType& querySet) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -109,12 +138,16 @@ class BiSearchVisitor : public boost::static_visitor<void>
   //! Bichromatic search on the given RAType specialized for octrees.
   void operator()(RATypeT<tree::Octree>* ra) const;
 
+  //! Bichromatic search specialized for single-precision KDTrees.
+  void operator()(RAType<SortPolicy, tree::KDTree, arma::fmat>* ra) const;
+
   //! Construct the BiSearchVisitor.
   BiSearchVisitor(const arma::mat& querySet,
                   const size_t k,
                   arma::Mat<size_t>& neighbors,
                   arma::mat& distances,
-                  const size_t leafSize);
+                  const size_t leafSize,
+                  const bool doubleDistances = false);
 };
 
 /**
@@ -133,8 +166,8 @@ class TrainVisitor : public boost::static_visitor<void>
   size_t leafSize;
 
   //! Train on the given RAType considering the leafSize.
-  template<typename RAType>
-  void TrainLeaf(RAType* ra) const;
+  template<typename RAType, typename MatType>
+  void TrainLeaf(RAType* ra, MatType&& dataset) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -155,6 +188,9 @@ class TrainVisitor : public boost::static_visitor<void>
   //! Train on the given RAType specialized for Octrees.
   void operator()(RATypeT<tree::Octree>* ra) const;
 
+  //! Train on the given RAType specialized for single-precision KDTrees.
+  void operator()(RAType<SortPolicy, tree::KDTree, arma::fmat>* ra) const;
+
   //! Construct the TrainVisitor object with the given reference set, leafSize
   //! for BinarySpaceTrees.
   TrainVisitor(arma::mat&& referenceSet,
@@ -226,14 +262,24 @@ class SingleModeVisitor : public boost::static_visitor<bool&>
 };
 
 /**
- * Exposes the referenceSet of the given RAType.
+ * Exposes the referenceSet of the given RAType.  A std::invalid_argument is
+ * thrown if the reference set of the RAType is not of type MatType.
  */
-class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
+template<typename MatType = arma::mat>
+class ReferenceSetVisitor : public boost::static_visitor<const MatType&>
 {
  public:
   //! Return the reference set.
   template<typename RAType>
-  const arma::mat& operator()(RAType* ra) const;
+  const MatType& operator()(RAType* ra) const;
+
+ private:
+  //! Return the given reference set, which has the right type.
+  const MatType& Get(const MatType& referenceSet) const { return referenceSet; }
+
+  //! Throw, since the reference set does not have the right type.
+  template<typename OtherMatType>
+  const MatType& Get(const OtherMatType& referenceSet) const;
 };
 
 /**
@@ -300,6 +346,12 @@ class RAModel
   //! The basis to project into.
   arma::mat q;
 
+  //! If true, the reference set is held in single precision.
+  bool singlePrecision;
+  //! If true, the distances returned by searches of a single-precision model
+  //! are recomputed in double precision.  This is not serialized.
+  bool doubleDistances;
+
   //! The rank-approximate model.
   boost::variant<RAType<SortPolicy, tree::KDTree>*,
                  RAType<SortPolicy, tree::StandardCoverTree>*,
@@ -310,14 +362,19 @@ class RAModel
                  RAType<SortPolicy, tree::RPlusTree>*,
                  RAType<SortPolicy, tree::RPlusPlusTree>*,
                  RAType<SortPolicy, tree::UBTree>*,
-                 RAType<SortPolicy, tree::Octree>*> raSearch;
+                 RAType<SortPolicy, tree::Octree>*,
+                 RAType<SortPolicy, tree::KDTree, arma::fmat>*> raSearch;
 
  public:
   /**
    * Initialize the RAModel with the given type and whether or not a random
-   * basis should be used.
+   * basis should be used.  If singlePrecision is true, the reference set is
+   * converted to single precision when the model is built; this is only
+   * supported for kd-trees.
    */
-  RAModel(TreeTypes treeType = TreeTypes::KD_TREE, bool randomBasis = false);
+  RAModel(TreeTypes treeType = TreeTypes::KD_TREE,
+          bool randomBasis = false,
+          bool singlePrecision = false);
 
   /**
    * Copy the given RAModel.
@@ -354,8 +411,11 @@ class RAModel
   template<typename Archive>
   void serialize(Archive& ar, const uint32_t /* version */);
 
-  //! Expose the dataset.
+  //! Expose the dataset.  This throws if the model is single-precision.
   const arma::mat& Dataset() const;
+  //! Expose the dataset of a single-precision model.  This throws if the model
+  //! is double-precision.
+  const arma::fmat& FloatDataset() const;
 
   //! Get whether or not single-tree search is being used.
   bool SingleMode() const;
@@ -408,6 +468,19 @@ class RAModel
   //! the model using BuildModel().
   bool& RandomBasis();
 
+  //! Get whether or not the data is held in single precision.
+  bool SinglePrecision() const;
+  //! Modify whether or not the data is held in single precision.  Be sure to
+  //! rebuild the model using BuildModel().
+  bool& SinglePrecision();
+
+  //! Get whether or not the distances found by a single-precision model are
+  //! recomputed in double precision.
+  bool DoubleDistances() const;
+  //! Modify whether or not the distances found by a single-precision model are
+  //! recomputed in double precision.
+  bool& DoubleDistances();
+
   //! Build the reference tree.
   void BuildModel(arma::mat&& referenceSet,
                   const size_t leafSize,
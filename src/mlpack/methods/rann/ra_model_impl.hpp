@@ -19,12 +19,53 @@
 namespace mlpack {
 namespace neighbor {
 
+//! Recompute the distances to the neighbors in double precision, from the
+//! single-precision reference points.
+template<typename RAType>
+void RecomputeDistances(const RAType& ra,
+                        const arma::mat* querySet,
+                        const arma::Mat<size_t>& neighbors,
+                        arma::mat& distances)
+{
+  // The reference set may have been reordered when the tree was built.
+  const std::vector<size_t>& oldFromNew = ra.OldFromNewReferences();
+  std::vector<size_t> newFromOld(oldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    newFromOld[oldFromNew[i]] = i;
+
+  const size_t numReferences = ra.ReferenceSet().n_cols;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    const arma::vec queryPoint = (querySet != NULL) ?
+        arma::vec(querySet->col(i)) :
+        arma::conv_to<arma::vec>::from(ra.ReferenceSet().col(
+            newFromOld.empty() ? i : newFromOld[i]));
+
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      // Skip neighbors that were not found.
+      if (neighbors(j, i) >= numReferences)
+        continue;
+
+      const size_t index = newFromOld.empty() ? neighbors(j, i) :
+          newFromOld[neighbors(j, i)];
+      distances(j, i) = metric::EuclideanDistance::Evaluate(queryPoint,
+          arma::conv_to<arma::vec>::from(ra.ReferenceSet().col(index)));
+    }
+  }
+}
+
 //! Monochromatic search for the given RAType instance.
 template<typename RAType>
 void MonoSearchVisitor::operator()(RAType* ra) const
 {
   if (ra)
-    return ra->Search(k, neighbors, distances);
+  {
+    ra->Search(k, neighbors, distances);
+    if (doubleDistances)
+      RecomputeDistances(*ra, NULL, neighbors, distances);
+    return;
+  }
   throw std::runtime_error("no rank-approximate model initialized");
 }
 
@@ -34,12 +75,14 @@ BiSearchVisitor<SortPolicy>::BiSearchVisitor(const arma::mat& querySet,
                                  const size_t k,
                                  arma::Mat<size_t>& neighbors,
                                  arma::mat& distances,
-                                 const size_t leafSize) :
+                                 const size_t leafSize,
+                                 const bool doubleDistances) :
     querySet(querySet),
     k(k),
     neighbors(neighbors),
     distances(distances),
-    leafSize(leafSize)
+    leafSize(leafSize),
+    doubleDistances(doubleDistances)
 {};
 
 //! Default Bichromatic search on the given RAType instance.
@@ -59,7 +102,7 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(RATypeT<tree::KDTree>* ra) const
 {
   if (ra)
-    return SearchLeaf(ra);
+    return SearchLeaf(ra, querySet);
   throw std::runtime_error("no rank-approximate search model initialized");
 }
 
@@ -68,14 +111,30 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(RATypeT<tree::Octree>* ra) const
 {
   if (ra)
-    return SearchLeaf(ra);
+    return SearchLeaf(ra, querySet);
+  throw std::runtime_error("no rank-approximate search model initialized");
+}
+
+//! Bichromatic search specialized for single-precision KDTrees.
+template<typename SortPolicy>
+void BiSearchVisitor<SortPolicy>::operator()(
+    RAType<SortPolicy, tree::KDTree, arma::fmat>* ra) const
+{
+  if (ra)
+  {
+    SearchLeaf(ra, arma::conv_to<arma::fmat>::from(querySet));
+    if (doubleDistances)
+      RecomputeDistances(*ra, &querySet, neighbors, distances);
+    return;
+  }
   throw std::runtime_error("no rank-approximate search model initialized");
 }
 
 //! Bichromatic search on the given RAType considering the leafSize.
 template<typename SortPolicy>
-template<typename RAType>
-void BiSearchVisitor<SortPolicy>::SearchLeaf(RAType* ra) const
+template<typename RAType, typename MatType>
+void BiSearchVisitor<SortPolicy>::SearchLeaf(RAType* ra,
+                                             const MatType& querySet) const
 {
   if (!ra->Naive() && !ra->SingleMode())
   {
@@ -133,7 +192,7 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(RATypeT<tree::KDTree>* ra) const
 {
   if (ra)
-    return TrainLeaf(ra);
+    return TrainLeaf(ra, std::move(referenceSet));
   throw std::runtime_error("no rank-approximate search model initialized");
 }
 
@@ -142,25 +201,41 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(RATypeT<tree::Octree>* ra) const
 {
   if (ra)
-    return TrainLeaf(ra);
+    return TrainLeaf(ra, std::move(referenceSet));
+  throw std::runtime_error("no rank-approximate search model is initialized");
+}
+
+//! Train on the given RAType specialized for single-precision KDTrees.
+template<typename SortPolicy>
+void TrainVisitor<SortPolicy>::operator()(
+    RAType<SortPolicy, tree::KDTree, arma::fmat>* ra) const
+{
+  if (ra)
+  {
+    arma::fmat floatReferenceSet = arma::conv_to<arma::fmat>::from(
+        referenceSet);
+    // The double-precision copy is no longer needed.
+    referenceSet.reset();
+    return TrainLeaf(ra, std::move(floatReferenceSet));
+  }
   throw std::runtime_error("no rank-approximate search model is initialized");
 }
 
 //! Train on the given RAType considering the leafSize.
 template<typename SortPolicy>
-template<typename RAType>
-void TrainVisitor<SortPolicy>::TrainLeaf(RAType* ra) const
+template<typename RAType, typename MatType>
+void TrainVisitor<SortPolicy>::TrainLeaf(RAType* ra, MatType&& dataset) const
 {
   // Build tree, if necessary
   if (ra->Naive())
   {
-    ra->Train(std::move(referenceSet));
+    ra->Train(std::move(dataset));
   }
   else
   {
     std::vector<size_t> oldFromNewReferences;
     typename RAType::Tree* tree =
-        new typename RAType::Tree(std::move(referenceSet), oldFromNewReferences,
+        new typename RAType::Tree(std::move(dataset), oldFromNewReferences,
         leafSize);
     ra->Train(tree);
 
@@ -225,14 +300,25 @@ bool& SingleModeVisitor::operator()(RAType* ra) const
 }
 
 //! Exposes the referenceSet of the given RAType.
+template<typename MatType>
 template<typename RAType>
-const arma::mat& ReferenceSetVisitor::operator()(RAType* ra) const
+const MatType& ReferenceSetVisitor<MatType>::operator()(RAType* ra) const
 {
   if (ra)
-    return ra->ReferenceSet();
+    return Get(ra->ReferenceSet());
   throw std::runtime_error("no rank-approximate model is initialized");
 }
 
+//! Throw, since the reference set does not have the requested type.
+template<typename MatType>
+template<typename OtherMatType>
+const MatType& ReferenceSetVisitor<MatType>::Get(
+    const OtherMatType& /* referenceSet */) const
+{
+  throw std::invalid_argument("the reference set of the model does not have "
+      "the requested precision");
+}
+
 //! Exposes the Naive() method of the given RAType instance.
 template<typename RAType>
 bool& NaiveVisitor::operator()(RAType* ra) const
@@ -251,10 +337,14 @@ void DeleteVisitor::operator()(RSType* rs) const
 }
 
 template<typename SortPolicy>
-RAModel<SortPolicy>::RAModel(const TreeTypes treeType, const bool randomBasis) :
+RAModel<SortPolicy>::RAModel(const TreeTypes treeType,
+                             const bool randomBasis,
+                             const bool singlePrecision) :
     treeType(treeType),
     leafSize(20),
-    randomBasis(randomBasis)
+    randomBasis(randomBasis),
+    singlePrecision(singlePrecision),
+    doubleDistances(false)
 {
   // Nothing to do.
 }
@@ -266,6 +356,8 @@ RAModel<SortPolicy>::RAModel(const RAModel& other) :
     leafSize(other.leafSize),
     randomBasis(other.randomBasis),
     q(other.q),
+    singlePrecision(other.singlePrecision),
+    doubleDistances(other.doubleDistances),
     raSearch(other.raSearch)
 {
   // Nothing to do.
@@ -278,12 +370,16 @@ RAModel<SortPolicy>::RAModel(RAModel&& other) :
     leafSize(other.leafSize),
     randomBasis(other.randomBasis),
     q(std::move(other.q)),
+    singlePrecision(other.singlePrecision),
+    doubleDistances(other.doubleDistances),
     raSearch(std::move(other.raSearch))
 {
   // Clear other model.
   other.treeType = TreeTypes::KD_TREE;
   other.leafSize = 20;
   other.randomBasis = false;
+  other.singlePrecision = false;
+  other.doubleDistances = false;
   other.raSearch = decltype(other.raSearch)();
 }
 
@@ -298,6 +394,8 @@ RAModel<SortPolicy>& RAModel<SortPolicy>::operator=(const RAModel& other)
   leafSize = other.leafSize;
   randomBasis = other.randomBasis;
   q = other.q;
+  singlePrecision = other.singlePrecision;
+  doubleDistances = other.doubleDistances;
   raSearch = other.raSearch;
 
   return *this;
@@ -312,12 +410,16 @@ RAModel<SortPolicy>& RAModel<SortPolicy>::operator=(RAModel&& other)
   leafSize = other.leafSize;
   randomBasis = other.randomBasis;
   q = std::move(other.q);
+  singlePrecision = other.singlePrecision;
+  doubleDistances = other.doubleDistances;
   raSearch = std::move(other.raSearch);
 
   // Reset other model.
   other.treeType = TreeTypes::KD_TREE;
   other.leafSize = 20;
   other.randomBasis = false;
+  other.singlePrecision = false;
+  other.doubleDistances = false;
   other.raSearch = decltype(other.raSearch)();
 
   return *this;
@@ -347,12 +449,25 @@ void RAModel<SortPolicy>::serialize(Archive& ar,
 
   // We only need to serialize one of the kRANN objects.
   ar(CEREAL_VARIANT_POINTER(raSearch));
+
+  // The precision is implied by the type of the model.
+  if (cereal::is_loading<Archive>())
+  {
+    typedef RAType<SortPolicy, tree::KDTree, arma::fmat> FloatKDTreeRAType;
+    singlePrecision = (boost::get<FloatKDTreeRAType*>(&raSearch) != NULL);
+  }
 }
 
 template<typename SortPolicy>
 const arma::mat& RAModel<SortPolicy>::Dataset() const
 {
-  return boost::apply_visitor(ReferenceSetVisitor(), raSearch);
+  return boost::apply_visitor(ReferenceSetVisitor<arma::mat>(), raSearch);
+}
+
+template<typename SortPolicy>
+const arma::fmat& RAModel<SortPolicy>::FloatDataset() const
+{
+  return boost::apply_visitor(ReferenceSetVisitor<arma::fmat>(), raSearch);
 }
 
 template<typename SortPolicy>
@@ -475,12 +590,42 @@ bool& RAModel<SortPolicy>::RandomBasis()
   return randomBasis;
 }
 
+template<typename SortPolicy>
+bool RAModel<SortPolicy>::SinglePrecision() const
+{
+  return singlePrecision;
+}
+
+template<typename SortPolicy>
+bool& RAModel<SortPolicy>::SinglePrecision()
+{
+  return singlePrecision;
+}
+
+template<typename SortPolicy>
+bool RAModel<SortPolicy>::DoubleDistances() const
+{
+  return doubleDistances;
+}
+
+template<typename SortPolicy>
+bool& RAModel<SortPolicy>::DoubleDistances()
+{
+  return doubleDistances;
+}
+
 template<typename SortPolicy>
 void RAModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
                                      const size_t leafSize,
                                      const bool naive,
                                      const bool singleMode)
 {
+  if (singlePrecision && treeType != KD_TREE)
+  {
+    throw std::invalid_argument("single-precision models are only supported "
+        "with kd-trees");
+  }
+
   // Initialize random basis, if necessary.
   if (randomBasis)
   {
@@ -505,7 +650,15 @@ void RAModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
   switch (treeType)
   {
     case KD_TREE:
-      raSearch = new RAType<SortPolicy, tree::KDTree>(naive, singleMode);
+      if (singlePrecision)
+      {
+        raSearch = new RAType<SortPolicy, tree::KDTree, arma::fmat>(naive,
+            singleMode);
+      }
+      else
+      {
+        raSearch = new RAType<SortPolicy, tree::KDTree>(naive, singleMode);
+      }
       break;
     case COVER_TREE:
       raSearch = new RAType<SortPolicy, tree::StandardCoverTree>(naive,
@@ -568,7 +721,7 @@ void RAModel<SortPolicy>::Search(arma::mat&& querySet,
   Log::Info << std::endl;
 
   BiSearchVisitor<SortPolicy> search(querySet, k, neighbors, distances,
-      leafSize);
+      leafSize, singlePrecision && doubleDistances);
   boost::apply_visitor(search, raSearch);
 }
 
@@ -586,7 +739,8 @@ void RAModel<SortPolicy>::Search(const size_t k,
     Log::Info << "brute-force (naive) rank-approximate search...";
   Log::Info << std::endl;
 
-  MonoSearchVisitor search(k, neighbors, distances);
+  MonoSearchVisitor search(k, neighbors, distances,
+      singlePrecision && doubleDistances);
   boost::apply_visitor(search, raSearch);
 }
 
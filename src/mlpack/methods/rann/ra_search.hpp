@@ -321,6 +321,12 @@ class RASearch
   //! Access the reference set.
   const MatType& ReferenceSet() const { return *referenceSet; }
 
+  //! Access the mapping from the indices of points in the reference tree to
+  //! their indices in the original reference set (this is empty if the points
+  //! were not rearranged, or if the tree was given by the user).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+
   //! Get whether or not naive (brute-force) search is used.
   bool Naive() const { return naive; }
   //! Modify whether or not naive (brute-force) search is used.
@@ -54,8 +54,8 @@ class RASearchRules
    * @param sameSet If true, the query and reference set are taken to be the
    *      same, and a query point will not return itself in the results.
    */
-  RASearchRules(const arma::mat& referenceSet,
-                const arma::mat& querySet,
+  RASearchRules(const typename TreeType::Mat& referenceSet,
+                const typename TreeType::Mat& querySet,
                 const size_t k,
                 MetricType& metric,
                 const double tau = 5,
@@ -248,10 +248,10 @@ class RASearchRules
 
  private:
   //! The reference set.
-  const arma::mat& referenceSet;
+  const typename TreeType::Mat& referenceSet;
 
   //! The query set.
-  const arma::mat& querySet;
+  const typename TreeType::Mat& querySet;
 
   //! Candidate represents a possible candidate neighbor (distance, index).
   typedef std::pair<double, size_t> Candidate;
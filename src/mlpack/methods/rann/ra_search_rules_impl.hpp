@@ -20,8 +20,8 @@ namespace neighbor {
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
 RASearchRules<SortPolicy, MetricType, TreeType>::
-RASearchRules(const arma::mat& referenceSet,
-              const arma::mat& querySet,
+RASearchRules(const typename TreeType::Mat& referenceSet,
+              const typename TreeType::Mat& querySet,
               const size_t k,
               MetricType& metric,
               const double tau,
@@ -145,7 +145,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
     const size_t queryIndex,
     TreeType& referenceNode)
 {
-  const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
+  const arma::Col<typename TreeType::ElemType> queryPoint =
+      querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode);
   const double bestDistance = candidates[queryIndex].top().first;
@@ -159,7 +160,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
     TreeType& referenceNode,
     const double baseCaseResult)
 {
-  const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
+  const arma::Col<typename TreeType::ElemType> queryPoint =
+      querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode, baseCaseResult);
   const double bestDistance = candidates[queryIndex].top().first;
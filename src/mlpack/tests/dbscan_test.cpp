@@ -12,6 +12,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/dbscan/dbscan.hpp>
 #include <mlpack/methods/dbscan/random_point_selection.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
 
 #include "test_catch_tools.hpp"
 #include "catch.hpp"
@@ -306,3 +307,118 @@ TEST_CASE("RandomPointSelectionTest", "[DBSCANTest]")
   // The number of assignments returned should be the same as points.
   REQUIRE(assignments.n_elem == points.n_cols);
 }
+
+/**
+ * Cluster the given points with core points by brute force, numbering the
+ * clusters in the order of their first point, as the parallel mode does.
+ */
+size_t NaiveCoreCluster(const arma::mat& points,
+                        const double epsilon,
+                        const size_t minPoints,
+                        arma::Row<size_t>& assignments)
+{
+  const size_t n = points.n_cols;
+  arma::mat distances(n, n);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j < n; ++j)
+      distances(i, j) = metric::EuclideanDistance::Evaluate(points.col(i),
+          points.col(j));
+
+  std::vector<bool> core(n);
+  for (size_t i = 0; i < n; ++i)
+    core[i] = (arma::accu(distances.col(i) <= epsilon) >= minPoints);
+
+  emst::UnionFind uf(n);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j < n; ++j)
+      if (core[i] && core[j] && distances(i, j) <= epsilon)
+        uf.Union(i, j);
+
+  std::map<size_t, size_t> labels;
+  assignments.set_size(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t point = core[i] ? i : SIZE_MAX;
+    for (size_t j = 0; j < n && point == SIZE_MAX; ++j)
+      if (core[j] && distances(i, j) <= epsilon)
+        point = j;
+
+    if (point == SIZE_MAX)
+    {
+      assignments[i] = SIZE_MAX;
+      continue;
+    }
+
+    const size_t root = uf.Find(point);
+    if (labels.count(root) == 0)
+    {
+      const size_t label = labels.size();
+      labels[root] = label;
+    }
+    assignments[i] = labels[root];
+  }
+
+  return labels.size();
+}
+
+/**
+ * Make sure that the parallel mode gives the same clusters as a brute-force
+ * clustering with core points, with every kind of range search.
+ */
+TEST_CASE("ParallelCorePointTest", "[DBSCANTest]")
+{
+  arma::mat points(2, 400, arma::fill::randu);
+  points.cols(200, 399) += 1.5;
+
+  arma::Row<size_t> naiveAssignments;
+  const size_t naiveClusters = NaiveCoreCluster(points, 0.08, 5,
+      naiveAssignments);
+
+  DBSCAN<> dualTree(0.08, 5);
+  dualTree.Parallel() = true;
+  DBSCAN<> singleTree(0.08, 5, false, RangeSearch<>(false, true));
+  singleTree.Parallel() = true;
+  DBSCAN<> naive(0.08, 5, true, RangeSearch<>(true));
+  naive.Parallel() = true;
+  DBSCAN<RangeSearch<metric::EuclideanDistance, arma::mat,
+      tree::StandardCoverTree>> coverTree(0.08, 5);
+  coverTree.Parallel() = true;
+
+  arma::Row<size_t> assignments;
+  REQUIRE(dualTree.Cluster(points, assignments) == naiveClusters);
+  CheckMatrices(assignments, naiveAssignments);
+  REQUIRE(singleTree.Cluster(points, assignments) == naiveClusters);
+  CheckMatrices(assignments, naiveAssignments);
+  REQUIRE(naive.Cluster(points, assignments) == naiveClusters);
+  CheckMatrices(assignments, naiveAssignments);
+  REQUIRE(coverTree.Cluster(points, assignments) == naiveClusters);
+  CheckMatrices(assignments, naiveAssignments);
+}
+
+/**
+ * A point that is not a core point does not link the clusters of its
+ * neighbors.
+ */
+TEST_CASE("ParallelBorderPointTest", "[DBSCANTest]")
+{
+  // Two groups of four points, with a point between them that is within
+  // epsilon of one point of each group.
+  arma::mat points("0.0 0.03 0.06 0.09 0.19 0.29 0.32 0.35 0.38");
+
+  DBSCAN<> d(0.105, 4);
+  d.Parallel() = true;
+
+  arma::Row<size_t> assignments;
+  REQUIRE(d.Cluster(points, assignments) == 2);
+  for (size_t i = 0; i < 4; ++i)
+    REQUIRE(assignments[i] == 0);
+  for (size_t i = 5; i < 9; ++i)
+    REQUIRE(assignments[i] == 1);
+  // The point in the middle joins the cluster of its core neighbor with the
+  // smallest index.
+  REQUIRE(assignments[4] == 0);
+
+  // The pairwise modes link every pair of points within epsilon.
+  DBSCAN<> pairwise(0.105, 4);
+  REQUIRE(pairwise.Cluster(points, assignments) == 1);
+}
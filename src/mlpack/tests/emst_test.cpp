@@ -274,3 +274,113 @@ TEST_CASE("EMSTBallTreeTest", "[EMSTTest]")
     REQUIRE(bstResults(2, i) == Approx(ballResults(2, i)).epsilon(1e-7));
   }
 }
+
+/**
+ * Make sure that the (parallel) dual-tree computation finds a minimum spanning
+ * tree when many edges have the same length, as on a grid.
+ */
+TEST_CASE("EMSTGridTest", "[EMSTTest]")
+{
+  arma::mat inputData(2, 400);
+  for (size_t i = 0; i < inputData.n_cols; ++i)
+  {
+    inputData(0, i) = (double) (i % 20);
+    inputData(1, i) = (double) (i / 20);
+  }
+
+  DualTreeBoruvka<> dtb(inputData);
+  DualTreeBoruvka<> dtbNaive(inputData, true);
+
+  arma::mat dualResults, naiveResults;
+  dtb.ComputeMST(dualResults);
+  dtbNaive.ComputeMST(naiveResults);
+
+  // Every edge of a minimum spanning tree of the grid has length 1, and the
+  // edges must connect all of the points.
+  REQUIRE(dualResults.n_cols == inputData.n_cols - 1);
+  REQUIRE(naiveResults.n_cols == inputData.n_cols - 1);
+  UnionFind connections(inputData.n_cols);
+  for (size_t i = 0; i < dualResults.n_cols; ++i)
+  {
+    REQUIRE(dualResults(2, i) == Approx(1.0).epsilon(1e-7));
+    REQUIRE(naiveResults(2, i) == Approx(1.0).epsilon(1e-7));
+    connections.Union((size_t) dualResults(0, i), (size_t) dualResults(1, i));
+  }
+
+  for (size_t i = 0; i < inputData.n_cols; ++i)
+    REQUIRE(connections.Find(i) == connections.Find(0));
+}
+
+/**
+ * Make sure that the spanning tree of the mutual reachability distance is
+ * minimal, by comparing its length with that found by Prim's algorithm on all
+ * of the pairwise distances, with every tree type.
+ */
+TEST_CASE("EMSTCoreDistanceTest", "[EMSTTest]")
+{
+  arma::mat inputData(3, 300, arma::fill::randu);
+  arma::vec coreDistances = 0.3 * arma::randu<arma::vec>(inputData.n_cols);
+
+  // Prim's algorithm on the dense mutual reachability distances.
+  const size_t n = inputData.n_cols;
+  arma::vec bestDistances(n);
+  bestDistances.fill(DBL_MAX);
+  std::vector<bool> inTree(n, false);
+  double primLength = 0.0;
+  size_t next = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    inTree[next] = true;
+    primLength += (i == 0) ? 0.0 : bestDistances[next];
+
+    size_t closest = 0;
+    double closestDistance = DBL_MAX;
+    for (size_t j = 0; j < n; ++j)
+    {
+      if (inTree[j])
+        continue;
+
+      const double distance = std::max(EuclideanDistance::Evaluate(
+          inputData.col(next), inputData.col(j)), std::max(
+          coreDistances[next], coreDistances[j]));
+      bestDistances[j] = std::min(bestDistances[j], distance);
+      if (bestDistances[j] < closestDistance)
+      {
+        closestDistance = bestDistances[j];
+        closest = j;
+      }
+    }
+    next = closest;
+  }
+
+  DualTreeBoruvka<> dtb(inputData);
+  DualTreeBoruvka<> dtbNaive(inputData, true);
+  DualTreeBoruvka<EuclideanDistance, arma::mat, StandardCoverTree>
+      dtbCover(inputData);
+
+  arma::mat dualResults, naiveResults, coverResults;
+  dtb.ComputeMST(dualResults, coreDistances);
+  dtbNaive.ComputeMST(naiveResults, coreDistances);
+  dtbCover.ComputeMST(coverResults, coreDistances);
+
+  REQUIRE(dualResults.n_cols == n - 1);
+  REQUIRE(arma::accu(dualResults.row(2)) == Approx(primLength).epsilon(1e-7));
+  REQUIRE(arma::accu(naiveResults.row(2)) == Approx(primLength).epsilon(1e-7));
+  REQUIRE(arma::accu(coverResults.row(2)) == Approx(primLength).epsilon(1e-7));
+
+  // The distance of each edge is the mutual reachability distance of its
+  // endpoints, which are given with their original indices.
+  for (size_t i = 0; i < dualResults.n_cols; ++i)
+  {
+    const size_t a = (size_t) dualResults(0, i);
+    const size_t b = (size_t) dualResults(1, i);
+    const double distance = std::max(EuclideanDistance::Evaluate(
+        inputData.col(a), inputData.col(b)), std::max(coreDistances[a],
+        coreDistances[b]));
+    REQUIRE(dualResults(2, i) == Approx(distance).epsilon(1e-7));
+  }
+
+  DualTreeBoruvka<> dtbWrongSize(inputData);
+  REQUIRE_THROWS_AS(dtbWrongSize.ComputeMST(dualResults,
+      arma::vec(n - 1, arma::fill::zeros)), std::invalid_argument);
+}
@@ -218,6 +218,288 @@ TEST_CASE("SparsePolynomialFastMKSTest", "[FastMKSTest]")
   }
 }
 
+/**
+ * Compare parallel single-tree search with naive search, with and without a
+ * query set.
+ */
+TEST_CASE("FastMKSParallelSingleTreeVsNaive", "[FastMKSTest]")
+{
+  arma::mat data;
+  data.randn(5, 1000);
+  arma::mat queries;
+  queries.randn(5, 300);
+  LinearKernel lk;
+
+  FastMKS<LinearKernel> naive(data, lk, false, true);
+  FastMKS<LinearKernel> single(data, lk, true);
+  single.Parallel() = true;
+
+  arma::Mat<size_t> naiveIndices, singleIndices;
+  arma::mat naiveProducts, singleProducts;
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    if (pass == 0)
+    {
+      naive.Search(10, naiveIndices, naiveProducts);
+      single.Search(10, singleIndices, singleProducts);
+    }
+    else
+    {
+      naive.Search(queries, 10, naiveIndices, naiveProducts);
+      single.Search(queries, 10, singleIndices, singleProducts);
+    }
+
+    REQUIRE(singleIndices.n_cols == naiveIndices.n_cols);
+    for (size_t q = 0; q < singleIndices.n_cols; ++q)
+    {
+      for (size_t r = 0; r < singleIndices.n_rows; ++r)
+      {
+        REQUIRE(singleIndices(r, q) == naiveIndices(r, q));
+        REQUIRE(singleProducts(r, q) ==
+            Approx(naiveProducts(r, q)).epsilon(1e-7));
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that the batched naive search of the polynomial kernel, which
+ * evaluates blocks of points at once, returns the true maximum kernels, in
+ * serial and in parallel.
+ */
+TEST_CASE("FastMKSBatchedNaiveTest", "[FastMKSTest]")
+{
+  // Use more points than fit in one block.
+  arma::mat data;
+  data.randn(4, 700);
+  PolynomialKernel pk(3.0, 1.0);
+
+  FastMKS<PolynomialKernel> naive(data, pk, false, true);
+
+  // Compute the maximum kernels of each point by hand.
+  const size_t k = 5;
+  arma::Mat<size_t> trueIndices(k, data.n_cols);
+  arma::mat trueKernels(k, data.n_cols);
+  for (size_t q = 0; q < data.n_cols; ++q)
+  {
+    arma::vec evals(data.n_cols);
+    for (size_t r = 0; r < data.n_cols; ++r)
+      evals[r] = (q == r) ? -DBL_MAX : pk.Evaluate(data.col(q), data.col(r));
+
+    const arma::uvec order = arma::sort_index(evals, "descend");
+    for (size_t j = 0; j < k; ++j)
+    {
+      trueIndices(j, q) = order[j];
+      trueKernels(j, q) = evals[order[j]];
+    }
+  }
+
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    naive.Parallel() = (pass == 1);
+
+    arma::Mat<size_t> indices;
+    arma::mat kernels;
+    naive.Search(k, indices, kernels);
+
+    REQUIRE(indices.n_rows == k);
+    REQUIRE(indices.n_cols == data.n_cols);
+    for (size_t q = 0; q < data.n_cols; ++q)
+    {
+      for (size_t j = 0; j < k; ++j)
+      {
+        REQUIRE(indices(j, q) == trueIndices(j, q));
+        REQUIRE(kernels(j, q) == Approx(trueKernels(j, q)).epsilon(1e-7));
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that search with the norm bucket index gives the same results as
+ * naive search, for points with very different norms and a kernel with batched
+ * evaluation.
+ */
+TEST_CASE("FastMKSNormBucketsLinearTest", "[FastMKSTest]")
+{
+  arma::mat referenceData;
+  referenceData.randn(5, 1000);
+  referenceData.each_row() %= arma::exp(arma::randn<arma::rowvec>(1000));
+  arma::mat queryData;
+  queryData.randn(5, 300);
+
+  FastMKS<LinearKernel> naive(referenceData, false, true);
+  FastMKS<LinearKernel> buckets(referenceData);
+  buckets.NormBuckets() = true;
+  buckets.BucketSize() = 64;
+
+  arma::Mat<size_t> naiveIndices, naiveMonoIndices;
+  arma::mat naiveKernels, naiveMonoKernels;
+  naive.Search(queryData, 10, naiveIndices, naiveKernels);
+  naive.Search(10, naiveMonoIndices, naiveMonoKernels);
+
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    buckets.Parallel() = (pass == 1);
+
+    arma::Mat<size_t> indices;
+    arma::mat kernels;
+    buckets.Search(queryData, 10, indices, kernels);
+
+    CheckMatrices(indices, naiveIndices);
+    CheckMatrices(kernels, naiveKernels);
+
+    buckets.Search(10, indices, kernels);
+
+    CheckMatrices(indices, naiveMonoIndices);
+    CheckMatrices(kernels, naiveMonoKernels);
+  }
+}
+
+/**
+ * Make sure that search with the norm bucket index gives the same results as
+ * naive search for a kernel without batched evaluation, and after the bucket
+ * size is changed.
+ */
+TEST_CASE("FastMKSNormBucketsGaussianTest", "[FastMKSTest]")
+{
+  arma::mat referenceData;
+  referenceData.randu(4, 500);
+  arma::mat queryData;
+  queryData.randu(4, 100);
+  GaussianKernel gk(0.5);
+
+  FastMKS<GaussianKernel> naive(referenceData, gk, false, true);
+  FastMKS<GaussianKernel> buckets(referenceData, gk);
+  buckets.NormBuckets() = true;
+
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveKernels;
+  naive.Search(queryData, 5, naiveIndices, naiveKernels);
+
+  const size_t bucketSizes[] = { 256, 7, 1000 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    buckets.BucketSize() = bucketSizes[i];
+
+    arma::Mat<size_t> indices;
+    arma::mat kernels;
+    buckets.Search(queryData, 5, indices, kernels);
+
+    CheckMatrices(indices, naiveIndices);
+    CheckMatrices(kernels, naiveKernels);
+  }
+
+  // A query tree can't be used with the norm bucket index.
+  typename FastMKS<GaussianKernel>::Tree queryTree(queryData);
+  arma::Mat<size_t> indices;
+  arma::mat kernels;
+  REQUIRE_THROWS_AS(buckets.Search(&queryTree, 5, indices, kernels),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that the norm bucket index is rebuilt after retraining.
+ */
+TEST_CASE("FastMKSNormBucketsRetrainTest", "[FastMKSTest]")
+{
+  arma::mat referenceData1 = arma::randn<arma::mat>(3, 200);
+  arma::mat referenceData2 = 3 * arma::randn<arma::mat>(3, 300);
+  arma::mat queryData = arma::randn<arma::mat>(3, 50);
+
+  FastMKS<LinearKernel> buckets(referenceData1);
+  buckets.NormBuckets() = true;
+
+  arma::Mat<size_t> indices;
+  arma::mat kernels;
+  buckets.Search(queryData, 3, indices, kernels);
+
+  buckets.Train(referenceData2);
+  buckets.Search(queryData, 3, indices, kernels);
+
+  FastMKS<LinearKernel> naive(referenceData2, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveKernels;
+  naive.Search(queryData, 3, naiveIndices, naiveKernels);
+
+  CheckMatrices(indices, naiveIndices);
+  CheckMatrices(kernels, naiveKernels);
+}
+
+/**
+ * Make sure that no tree is built when the norm bucket index is used before
+ * training, and that such a model can be serialized.
+ */
+TEST_CASE("FastMKSNormBucketsNoTreeTest", "[FastMKSTest]")
+{
+  arma::mat referenceData = arma::randn<arma::mat>(4, 300);
+  arma::mat queryData = arma::randn<arma::mat>(4, 50);
+
+  FastMKS<LinearKernel> buckets;
+  buckets.NormBuckets() = true;
+  buckets.Train(referenceData);
+
+  FastMKS<LinearKernel> naive(referenceData, false, true);
+  arma::Mat<size_t> naiveIndices, indices;
+  arma::mat naiveKernels, kernels;
+  naive.Search(queryData, 5, naiveIndices, naiveKernels);
+  buckets.Search(queryData, 5, indices, kernels);
+
+  CheckMatrices(indices, naiveIndices);
+  CheckMatrices(kernels, naiveKernels);
+
+  // Tree search is not possible without the tree.
+  buckets.NormBuckets() = false;
+  REQUIRE_THROWS_AS(buckets.Search(queryData, 5, indices, kernels),
+      std::invalid_argument);
+  buckets.SingleMode() = true;
+  REQUIRE_THROWS_AS(buckets.Search(5, indices, kernels),
+      std::invalid_argument);
+
+  // Only the dataset is serialized.
+  FastMKS<LinearKernel> fXml, fText, fBinary;
+  SerializeObjectAll(buckets, fXml, fText, fBinary);
+
+  arma::Mat<size_t> xmlIndices, jsonIndices, binaryIndices;
+  arma::mat xmlKernels, jsonKernels, binaryKernels;
+  fXml.NormBuckets() = true;
+  fText.NormBuckets() = true;
+  fBinary.NormBuckets() = true;
+  fXml.Search(queryData, 5, xmlIndices, xmlKernels);
+  fText.Search(queryData, 5, jsonIndices, jsonKernels);
+  fBinary.Search(queryData, 5, binaryIndices, binaryKernels);
+
+  CheckMatrices(naiveIndices, xmlIndices, jsonIndices, binaryIndices);
+  CheckMatrices(naiveKernels, xmlKernels, jsonKernels, binaryKernels);
+}
+
+/**
+ * Make sure that the norm bucket index rejects points with a negative kernel
+ * value with themselves.
+ */
+TEST_CASE("FastMKSNormBucketsNegativeSelfKernelTest", "[FastMKSTest]")
+{
+  // With a negative offset, the self-kernels of points with small norm are
+  // negative.
+  HyperbolicTangentKernel kernel(1.0, -10.0);
+  arma::mat smallData = 0.1 * arma::randu<arma::mat>(3, 50);
+  arma::mat largeData = 10.0 + arma::randu<arma::mat>(3, 50);
+
+  FastMKS<HyperbolicTangentKernel> f;
+  f.NormBuckets() = true;
+  f.Train(smallData, kernel);
+
+  arma::Mat<size_t> indices;
+  arma::mat kernels;
+  REQUIRE_THROWS_AS(f.Search(largeData, 3, indices, kernels),
+      std::invalid_argument);
+
+  // The query points are checked too.
+  NormBucketIndex<HyperbolicTangentKernel> index(largeData, kernel);
+  REQUIRE_THROWS_AS(index.Search(smallData, kernel, 3, indices, kernels),
+      std::invalid_argument);
+}
+
 // Make sure the empty constructor works.
 TEST_CASE("FastMKSEmptyConstructorTest", "[FastMKSTest]")
 {
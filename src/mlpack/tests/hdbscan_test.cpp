@@ -0,0 +1,191 @@
+/**
+ * @file tests/hdbscan_test.cpp
+ *
+ * Test the HDBSCAN implementation.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/methods/hdbscan/hdbscan.hpp>
+
+#include "test_catch_tools.hpp"
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::hdbscan;
+using namespace mlpack::metric;
+using namespace mlpack::tree;
+
+/**
+ * Generate three well-separated blobs of 100 points each, with different
+ * spreads, so that no single DBSCAN radius suits all of them.
+ */
+void BlobDataset(arma::mat& points)
+{
+  points.set_size(2, 300);
+  const double spreads[3] = { 0.05, 0.3, 0.6 };
+  for (size_t c = 0; c < 3; ++c)
+  {
+    points.cols(100 * c, 100 * c + 99) = spreads[c] *
+        arma::randn<arma::mat>(2, 100);
+    points.row(0).subvec(100 * c, 100 * c + 99) += 10.0 * c;
+  }
+}
+
+/**
+ * Make sure that the three blobs are found as three clusters, with most points
+ * of each blob in its own cluster.
+ */
+TEST_CASE("HDBSCANBlobTest", "[HDBSCANTest]")
+{
+  arma::mat points;
+  BlobDataset(points);
+
+  HDBSCAN<> h(20, 5);
+  arma::Row<size_t> assignments;
+  const size_t clusters = h.Cluster(points, assignments);
+
+  REQUIRE(clusters == 3);
+  REQUIRE(assignments.n_elem == points.n_cols);
+
+  std::set<size_t> labels;
+  for (size_t c = 0; c < 3; ++c)
+  {
+    // The label of the blob is the most common label of its points.
+    const arma::Row<size_t> blob = assignments.subvec(100 * c, 100 * c + 99);
+    arma::uvec counts(clusters + 1, arma::fill::zeros);
+    for (size_t i = 0; i < blob.n_elem; ++i)
+      ++counts[std::min((size_t) blob[i], clusters)];
+
+    // Every point of the blob is in the same cluster, or noise.
+    const size_t label = counts.subvec(0, clusters - 1).index_max();
+    REQUIRE(counts[label] + counts[clusters] == 100);
+    REQUIRE(counts[label] >= 80);
+    labels.insert(label);
+  }
+
+  REQUIRE(labels.size() == 3);
+}
+
+/**
+ * Make sure that the tree-based computations give the same clusters as the
+ * naive computation.  The spanning trees may differ when distances are equal,
+ * so the clusters may be numbered differently, but the same points must be
+ * clustered together, and leave their clusters at the same lambda values.
+ */
+template<typename HDBSCANType>
+void CheckSameClusters(HDBSCANType& h,
+                       const arma::mat& points,
+                       const arma::Row<size_t>& naiveAssignments,
+                       const arma::mat& naiveTree)
+{
+  arma::Row<size_t> assignments;
+  arma::mat condensedTree;
+  h.Cluster(points, assignments, condensedTree);
+
+  REQUIRE(assignments.n_elem == naiveAssignments.n_elem);
+  std::map<size_t, size_t> labels;
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+  {
+    if (labels.count(assignments[i]) == 0)
+      labels[assignments[i]] = naiveAssignments[i];
+    REQUIRE(labels[assignments[i]] == naiveAssignments[i]);
+  }
+
+  REQUIRE(condensedTree.n_cols == naiveTree.n_cols);
+  const arma::mat lambdas = arma::sort(condensedTree.row(2));
+  const arma::mat naiveLambdas = arma::sort(naiveTree.row(2));
+  CheckMatrices(lambdas, naiveLambdas);
+}
+
+TEST_CASE("HDBSCANTreeVsNaiveTest", "[HDBSCANTest]")
+{
+  arma::mat points;
+  BlobDataset(points);
+
+  HDBSCAN<> naive(10, 5, true);
+  arma::Row<size_t> naiveAssignments;
+  arma::mat naiveTree;
+  const size_t naiveClusters = naive.Cluster(points, naiveAssignments,
+      naiveTree);
+  REQUIRE(naiveClusters >= 3);
+
+  HDBSCAN<> kd(10, 5);
+  CheckSameClusters(kd, points, naiveAssignments, naiveTree);
+
+  HDBSCAN<EuclideanDistance, arma::mat, BallTree> ball(10, 5);
+  CheckSameClusters(ball, points, naiveAssignments, naiveTree);
+
+  HDBSCAN<EuclideanDistance, arma::mat, StandardCoverTree> cover(10, 5);
+  CheckSameClusters(cover, points, naiveAssignments, naiveTree);
+}
+
+/**
+ * Check that the condensed tree holds every point once, that clusters only
+ * split into parts of at least the minimum cluster size, and that points far
+ * from everything else are noise.
+ */
+TEST_CASE("HDBSCANCondensedTreeTest", "[HDBSCANTest]")
+{
+  arma::mat points;
+  BlobDataset(points);
+  points.resize(2, 302);
+  points.col(300) = arma::vec({ 100.0, 100.0 });
+  points.col(301) = arma::vec({ -100.0, 100.0 });
+
+  HDBSCAN<> h(20, 5);
+  arma::Row<size_t> assignments;
+  arma::mat condensedTree;
+  h.Cluster(points, assignments, condensedTree);
+
+  REQUIRE(condensedTree.n_rows == 4);
+  REQUIRE(assignments[300] == SIZE_MAX);
+  REQUIRE(assignments[301] == SIZE_MAX);
+
+  arma::uvec pointCounts(points.n_cols, arma::fill::zeros);
+  for (size_t i = 0; i < condensedTree.n_cols; ++i)
+  {
+    REQUIRE(condensedTree(0, i) >= points.n_cols);
+    REQUIRE(condensedTree(2, i) >= 0.0);
+    if (condensedTree(1, i) < points.n_cols)
+    {
+      REQUIRE(condensedTree(3, i) == 1.0);
+      ++pointCounts[(size_t) condensedTree(1, i)];
+    }
+    else
+    {
+      REQUIRE(condensedTree(1, i) > condensedTree(0, i));
+      REQUIRE(condensedTree(3, i) >= 20.0);
+    }
+  }
+
+  for (size_t i = 0; i < pointCounts.n_elem; ++i)
+    REQUIRE(pointCounts[i] == 1);
+}
+
+/**
+ * When there are fewer than two clusters' worth of points, everything is
+ * noise; invalid parameters throw.
+ */
+TEST_CASE("HDBSCANSmallDatasetTest", "[HDBSCANTest]")
+{
+  arma::mat points(3, 15, arma::fill::randu);
+
+  HDBSCAN<> h(10, 3);
+  arma::Row<size_t> assignments;
+  REQUIRE(h.Cluster(points, assignments) == 0);
+  REQUIRE(assignments.n_elem == points.n_cols);
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+    REQUIRE(assignments[i] == SIZE_MAX);
+
+  HDBSCAN<> tooSmall(1, 3);
+  REQUIRE_THROWS_AS(tooSmall.Cluster(points, assignments),
+      std::invalid_argument);
+  HDBSCAN<> tooManyPoints(5, 16);
+  REQUIRE_THROWS_AS(tooManyPoints.Cluster(points, assignments),
+      std::invalid_argument);
+}
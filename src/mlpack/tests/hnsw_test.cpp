@@ -0,0 +1,216 @@
+/**
+ * @file tests/hnsw_test.cpp
+ *
+ * Unit tests for the 'HNSWSearch' class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include "catch.hpp"
+#include "serialization_catch.hpp"
+#include "test_catch_tools.hpp"
+
+#include <mlpack/methods/hnsw/hnsw_search.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+using namespace mlpack::metric;
+
+/**
+ * Make sure that the approximate neighbors found on a high-dimensional dataset
+ * are mostly the true neighbors.
+ */
+TEST_CASE("HNSWRecallTest", "[HNSWTest]")
+{
+  const size_t k = 10;
+  arma::mat referenceData = arma::randu<arma::mat>(20, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(20, 200);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(queryData, k, trueNeighbors, trueDistances);
+
+  HNSWSearch<> hnsw(referenceData, 16, 100, 100);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  hnsw.Search(queryData, k, neighbors, distances);
+
+  REQUIRE(neighbors.n_rows == k);
+  REQUIRE(neighbors.n_cols == queryData.n_cols);
+  REQUIRE(HNSWSearch<>::ComputeRecall(neighbors, trueNeighbors) >= 0.85);
+
+  // The search should be much cheaper than brute force.
+  REQUIRE(hnsw.DistanceEvaluations() > 0);
+  REQUIRE(hnsw.DistanceEvaluations() <
+      queryData.n_cols * referenceData.n_cols / 2);
+  REQUIRE(hnsw.VisitedNodes() > 0);
+}
+
+/**
+ * Make sure that the returned distances are correct and sorted, and that every
+ * link of the graph respects the limits set by M.
+ */
+TEST_CASE("HNSWDistancesAndLinksTest", "[HNSWTest]")
+{
+  const size_t m = 8;
+  arma::mat referenceData = arma::randu<arma::mat>(5, 500);
+  arma::mat queryData = arma::randu<arma::mat>(5, 50);
+
+  HNSWSearch<> hnsw(referenceData, m, 50);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  hnsw.Search(queryData, 5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      REQUIRE(neighbors(j, i) < referenceData.n_cols);
+      REQUIRE(distances(j, i) == Approx(EuclideanDistance::Evaluate(
+          queryData.col(i), referenceData.col(neighbors(j, i)))).epsilon(1e-7));
+      if (j > 0)
+        REQUIRE(distances(j - 1, i) <= distances(j, i));
+    }
+  }
+
+  REQUIRE(hnsw.Level(hnsw.EntryPoint()) == hnsw.MaxLevel());
+  for (size_t p = 0; p < referenceData.n_cols; ++p)
+  {
+    for (size_t layer = 0; layer <= hnsw.Level(p); ++layer)
+    {
+      const std::vector<size_t>& links = hnsw.Links(p, layer);
+      REQUIRE(links.size() <= ((layer == 0) ? 2 * m : m));
+      for (size_t l = 0; l < links.size(); ++l)
+      {
+        REQUIRE(links[l] != p);
+        REQUIRE(hnsw.Level(links[l]) >= layer);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that the monochromatic search does not return the query point
+ * itself, and finds most of the true neighbors.
+ */
+TEST_CASE("HNSWMonochromaticTest", "[HNSWTest]")
+{
+  const size_t k = 5;
+  arma::mat referenceData = arma::randu<arma::mat>(10, 1000);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(k, trueNeighbors, trueDistances);
+
+  HNSWSearch<> hnsw(referenceData);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  hnsw.Search(k, neighbors, distances);
+
+  REQUIRE(neighbors.n_rows == k);
+  REQUIRE(neighbors.n_cols == referenceData.n_cols);
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+      REQUIRE(neighbors(j, i) != i);
+
+  REQUIRE(HNSWSearch<>::ComputeRecall(neighbors, trueNeighbors) >= 0.9);
+}
+
+/**
+ * Make sure that single-precision data can be used.
+ */
+TEST_CASE("HNSWFloatTest", "[HNSWTest]")
+{
+  const size_t k = 3;
+  arma::fmat referenceData = arma::randu<arma::fmat>(4, 300);
+  arma::fmat queryData = arma::randu<arma::fmat>(4, 30);
+
+  KNN knn(arma::conv_to<arma::mat>::from(referenceData));
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(arma::conv_to<arma::mat>::from(queryData), k, trueNeighbors,
+      trueDistances);
+
+  HNSWSearch<EuclideanDistance, arma::fmat> hnsw(referenceData);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  hnsw.Search(queryData, k, neighbors, distances);
+
+  REQUIRE(HNSWSearch<>::ComputeRecall(neighbors, trueNeighbors) >= 0.9);
+}
+
+/**
+ * Make sure that invalid parameters are rejected.
+ */
+TEST_CASE("HNSWInvalidParametersTest", "[HNSWTest]")
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 20);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  HNSWSearch<> hnsw;
+  REQUIRE_THROWS_AS(hnsw.Train(referenceData, 1), std::invalid_argument);
+  REQUIRE_THROWS_AS(hnsw.Train(referenceData, 4, 0), std::invalid_argument);
+
+  hnsw.Train(referenceData, 4, 10);
+  REQUIRE_THROWS_AS(hnsw.Search(arma::mat(4, 5, arma::fill::randu), 1,
+      neighbors, distances), std::invalid_argument);
+  REQUIRE_THROWS_AS(hnsw.Search(referenceData, 21, neighbors, distances),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(hnsw.Search(20, neighbors, distances),
+      std::invalid_argument);
+
+  REQUIRE_THROWS_AS(HNSWSearch<>::ComputeRecall(arma::Mat<size_t>(2, 3),
+      arma::Mat<size_t>(3, 3)), std::invalid_argument);
+}
+
+/**
+ * Make sure that a serialized model gives the same results as the original.
+ */
+TEST_CASE("HNSWSerializationTest", "[HNSWTest]")
+{
+  arma::mat referenceData = arma::randu<arma::mat>(8, 300);
+  arma::mat queryData = arma::randu<arma::mat>(8, 40);
+
+  HNSWSearch<> hnsw(referenceData, 6, 40, 30);
+  HNSWSearch<> xmlHnsw;
+  HNSWSearch<> jsonHnsw(arma::randu<arma::mat>(3, 30), 4, 10);
+  HNSWSearch<> binaryHnsw(arma::randu<arma::mat>(8, 100), 12, 20);
+
+  SerializeObjectAll(hnsw, xmlHnsw, jsonHnsw, binaryHnsw);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  hnsw.Search(queryData, 4, neighbors, distances);
+
+  for (HNSWSearch<>* model : { &xmlHnsw, &jsonHnsw, &binaryHnsw })
+  {
+    REQUIRE(model->M() == hnsw.M());
+    REQUIRE(model->EfConstruction() == hnsw.EfConstruction());
+    REQUIRE(model->Ef() == hnsw.Ef());
+    REQUIRE(model->EntryPoint() == hnsw.EntryPoint());
+    REQUIRE(model->MaxLevel() == hnsw.MaxLevel());
+    CheckMatrices(model->ReferenceSet(), hnsw.ReferenceSet());
+
+    for (size_t p = 0; p < referenceData.n_cols; ++p)
+    {
+      REQUIRE(model->Level(p) == hnsw.Level(p));
+      for (size_t layer = 0; layer <= hnsw.Level(p); ++layer)
+        REQUIRE(model->Links(p, layer) == hnsw.Links(p, layer));
+    }
+
+    arma::Mat<size_t> modelNeighbors;
+    arma::mat modelDistances;
+    model->Search(queryData, 4, modelNeighbors, modelDistances);
+    CheckMatrices(modelNeighbors, neighbors);
+    CheckMatrices(modelDistances, distances);
+  }
+}
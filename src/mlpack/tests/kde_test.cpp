@@ -1297,3 +1297,331 @@ TEST_CASE("GaussianBreadthDualKDTreeMonteCarloKDE", "[KDETest]")
 
   REQUIRE(correctResults > 70);
 }
+
+/**
+ * Test dual-tree or single-tree evaluations against brute force results, for
+ * bichromatic and monochromatic evaluations, either in parallel or with series
+ * expansions.  With series expansions, the evaluations must also need fewer
+ * base cases than without them, so that the expansions are known to be used.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckTreeKDE(const KDEMode mode,
+                  const size_t dimensionality,
+                  const double kernelBandwidth,
+                  const double relError,
+                  const bool parallel,
+                  const bool seriesExpansion)
+{
+  arma::mat reference = arma::randu(dimensionality, 1000);
+  arma::mat query = arma::randu(dimensionality, 300);
+  arma::vec bfEstimations = arma::vec(query.n_cols, arma::fill::zeros);
+  arma::vec bfMonoEstimations = arma::vec(reference.n_cols, arma::fill::zeros);
+  arma::vec treeEstimations, monoEstimations;
+
+  // Brute force KDE.
+  GaussianKernel kernel(kernelBandwidth);
+  BruteForceKDE<GaussianKernel>(reference,
+                                query,
+                                bfEstimations,
+                                kernel);
+  BruteForceKDE<GaussianKernel>(reference,
+                                reference,
+                                bfMonoEstimations,
+                                kernel);
+  // The estimation of a point with itself is not computed.
+  bfMonoEstimations -= kernel.Evaluate(0.0) / reference.n_cols;
+
+  // Optimized KDE.
+  metric::EuclideanDistance metric;
+  KDE<GaussianKernel, metric::EuclideanDistance, arma::mat, TreeType>
+      kde(relError, 0.0, kernel, mode, metric);
+  kde.Parallel() = parallel;
+  kde.SeriesExpansion() = seriesExpansion;
+  kde.SeriesOrder(4);
+  kde.Train(reference);
+  kde.Evaluate(query, treeEstimations);
+  const size_t baseCases = kde.BaseCases();
+  kde.Evaluate(monoEstimations);
+  const size_t monoBaseCases = kde.BaseCases();
+
+  // Check whether results are equal.
+  REQUIRE(treeEstimations.n_elem == query.n_cols);
+  for (size_t i = 0; i < query.n_cols; ++i)
+    REQUIRE(bfEstimations[i] == Approx(treeEstimations[i]).epsilon(relError));
+
+  REQUIRE(monoEstimations.n_elem == reference.n_cols);
+  for (size_t i = 0; i < reference.n_cols; ++i)
+  {
+    REQUIRE(bfMonoEstimations[i] ==
+        Approx(monoEstimations[i]).epsilon(relError));
+  }
+
+  if (seriesExpansion)
+  {
+    kde.SeriesExpansion() = false;
+    kde.Evaluate(query, treeEstimations);
+    REQUIRE(baseCases < kde.BaseCases());
+    kde.Evaluate(monoEstimations);
+    REQUIRE(monoBaseCases < kde.BaseCases());
+  }
+}
+
+TEST_CASE("ParallelDualKDEBruteForceTest", "[KDETest]")
+{
+  CheckTreeKDE<KDTree>(KDEMode::DUAL_TREE_MODE, 2, 0.15, 0.05, true, false);
+  CheckTreeKDE<BallTree>(KDEMode::DUAL_TREE_MODE, 2, 0.15, 0.05, true, false);
+  CheckTreeKDE<Octree>(KDEMode::DUAL_TREE_MODE, 2, 0.15, 0.05, true, false);
+  CheckTreeKDE<StandardCoverTree>(KDEMode::DUAL_TREE_MODE, 2, 0.15, 0.05, true,
+      false);
+}
+
+TEST_CASE("ParallelSingleKDEBruteForceTest", "[KDETest]")
+{
+  CheckTreeKDE<KDTree>(KDEMode::SINGLE_TREE_MODE, 2, 0.15, 0.05, true, false);
+  CheckTreeKDE<BallTree>(KDEMode::SINGLE_TREE_MODE, 2, 0.15, 0.05, true,
+      false);
+}
+
+/**
+ * Make sure that the parallel setting is kept by copies and moves.
+ */
+TEST_CASE("ParallelKDECopyTest", "[KDETest]")
+{
+  KDE<> kde;
+  REQUIRE(kde.Parallel() == false);
+  kde.Parallel() = true;
+
+  KDE<> copy(kde);
+  REQUIRE(copy.Parallel() == true);
+
+  KDE<> moved(std::move(copy));
+  REQUIRE(moved.Parallel() == true);
+  REQUIRE(copy.Parallel() == false);
+}
+
+/**
+ * Make sure that the error bound holds for data that is far from the origin,
+ * where the batched Euclidean base cases have a large rounding error.
+ */
+TEST_CASE("OffsetDataKDEErrorBoundTest", "[KDETest]")
+{
+  arma::mat reference = arma::randu(3, 500) + 1e4;
+  arma::mat query = arma::randu(3, 100) + 1e4;
+  const double relError = 0.01;
+
+  GaussianKernel kernel(0.05);
+  arma::vec bfEstimations(query.n_cols, arma::fill::zeros);
+  BruteForceKDE<GaussianKernel>(reference, query, bfEstimations, kernel);
+
+  for (const KDEMode mode : { KDEMode::DUAL_TREE_MODE,
+                              KDEMode::SINGLE_TREE_MODE })
+  {
+    KDE<GaussianKernel, metric::EuclideanDistance, arma::mat, KDTree>
+        kde(relError, 0.0, kernel, mode);
+    kde.Train(reference);
+
+    arma::vec estimations;
+    kde.Evaluate(query, estimations);
+
+    REQUIRE(estimations.n_elem == query.n_cols);
+    for (size_t i = 0; i < query.n_cols; ++i)
+    {
+      REQUIRE(std::abs(estimations[i] - bfEstimations[i]) <=
+          relError * bfEstimations[i]);
+    }
+  }
+}
+
+/**
+ * Make sure that the series expansion of a node has the expected number of
+ * terms, and that its error is within the bound.
+ */
+TEST_CASE("GaussianSeriesExpansionTest", "[KDETest]")
+{
+  arma::mat reference = 0.2 * arma::randu(3, 200);
+  const double bandwidth = 0.5;
+  KDTree<EuclideanDistance, KDEStat, arma::mat> tree(reference);
+  GaussianKernel kernel(bandwidth);
+  EuclideanDistance metric;
+
+  for (size_t order = 1; order < 9; ++order)
+  {
+    GaussianSeriesExpansion series(3, order, bandwidth);
+
+    // There are (order - 1 + D) choose D monomials of degree less than the
+    // order in D dimensions.
+    const size_t terms = (order + 2) * (order + 1) * order / 6;
+    REQUIRE(series.NumTerms() == terms);
+
+    series.ComputeCoefficients(tree);
+    REQUIRE(series.IsComputed(tree.Stat()));
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+      const arma::vec query = 0.1 + arma::randu(3);
+
+      double density = 0.0;
+      for (size_t j = 0; j < tree.Dataset().n_cols; ++j)
+      {
+        density += kernel.Evaluate(metric.Evaluate(query,
+            tree.Dataset().col(j)));
+      }
+
+      arma::vec monomials;
+      const double estimation = series.Evaluate(tree.Stat(), query,
+          monomials);
+      const double distance = metric.Evaluate(query,
+          tree.Stat().SeriesCenter());
+      const double maxError = tree.NumDescendants() *
+          series.MaxError(distance, distance, tree.Stat().SeriesRadius());
+
+      REQUIRE(std::abs(estimation - density) <= maxError + 1e-10);
+    }
+  }
+
+  // An expansion with another bandwidth doesn't hold these coefficients.
+  GaussianSeriesExpansion other(3, 4, 2 * bandwidth);
+  REQUIRE(!other.IsComputed(tree.Stat()));
+}
+
+TEST_CASE("SeriesDualKDEBruteForceTest", "[KDETest]")
+{
+  CheckTreeKDE<KDTree>(KDEMode::DUAL_TREE_MODE, 2, 0.6, 0.02, false, true);
+  CheckTreeKDE<BallTree>(KDEMode::DUAL_TREE_MODE, 2, 0.6, 0.02, false, true);
+  CheckTreeKDE<KDTree>(KDEMode::DUAL_TREE_MODE, 4, 0.6, 0.02, false, true);
+  CheckTreeKDE<StandardCoverTree>(KDEMode::DUAL_TREE_MODE, 2, 0.6, 0.02, false,
+      true);
+}
+
+TEST_CASE("SeriesSingleKDEBruteForceTest", "[KDETest]")
+{
+  CheckTreeKDE<KDTree>(KDEMode::SINGLE_TREE_MODE, 2, 0.6, 0.02, false, true);
+  CheckTreeKDE<BallTree>(KDEMode::SINGLE_TREE_MODE, 4, 0.6, 0.02, false, true);
+}
+
+/**
+ * Make sure that the order of series expansions is checked, and that the
+ * series settings are kept by copies.
+ */
+TEST_CASE("SeriesKDESettingsTest", "[KDETest]")
+{
+  KDE<> kde;
+  REQUIRE(kde.SeriesExpansion() == false);
+  REQUIRE(kde.SeriesOrder() == KDEDefaultParams::seriesOrder);
+  REQUIRE_THROWS_AS(kde.SeriesOrder(0), std::invalid_argument);
+
+  kde.SeriesExpansion() = true;
+  kde.SeriesOrder(3);
+
+  KDE<> copy(kde);
+  REQUIRE(copy.SeriesExpansion() == true);
+  REQUIRE(copy.SeriesOrder() == 3);
+}
+
+/**
+ * Slide a window over a dataset with InsertReferencePoints() and
+ * ExpireReferencePoints(), and check the estimations of each window against
+ * brute force results.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckSlidingWindowKDE(const KDEMode mode)
+{
+  arma::mat data = arma::randu(2, 1000);
+  arma::mat query = arma::randu(2, 100);
+  const double kernelBandwidth = 0.2;
+  const double relError = 0.05;
+  GaussianKernel kernel(kernelBandwidth);
+
+  metric::EuclideanDistance metric;
+  KDE<GaussianKernel, metric::EuclideanDistance, arma::mat, TreeType>
+      kde(relError, 0.0, kernel, mode, metric);
+  kde.Train(data.cols(0, 399));
+
+  for (size_t first = 0; first <= 600; first += 200)
+  {
+    if (first > 0)
+    {
+      kde.InsertReferencePoints(data.cols(first + 200, first + 399));
+      kde.ExpireReferencePoints(200);
+    }
+
+    const arma::mat window = data.cols(first, first + 399);
+    REQUIRE(kde.ReferenceTree()->Dataset().n_cols == window.n_cols);
+    REQUIRE(kde.ReferenceTree()->NumDescendants() == window.n_cols);
+
+    // Brute force KDE.
+    arma::vec bfEstimations(query.n_cols, arma::fill::zeros);
+    arma::vec bfMonoEstimations(window.n_cols, arma::fill::zeros);
+    BruteForceKDE<GaussianKernel>(window, query, bfEstimations, kernel);
+    BruteForceKDE<GaussianKernel>(window, window, bfMonoEstimations, kernel);
+    // The estimation of a point with itself is not computed.
+    bfMonoEstimations -= kernel.Evaluate(0.0) / window.n_cols;
+
+    // Optimized KDE.
+    arma::vec treeEstimations, monoEstimations;
+    kde.Evaluate(query, treeEstimations);
+    kde.Evaluate(monoEstimations);
+
+    // Check whether results are equal.
+    REQUIRE(treeEstimations.n_elem == query.n_cols);
+    for (size_t i = 0; i < query.n_cols; ++i)
+    {
+      REQUIRE(bfEstimations[i] ==
+          Approx(treeEstimations[i]).epsilon(relError));
+    }
+
+    // The monochromatic estimations are in the order of the window.
+    REQUIRE(monoEstimations.n_elem == window.n_cols);
+    for (size_t i = 0; i < window.n_cols; ++i)
+    {
+      REQUIRE(bfMonoEstimations[i] ==
+          Approx(monoEstimations[i]).epsilon(relError));
+    }
+  }
+}
+
+TEST_CASE("SlidingWindowRTreeKDETest", "[KDETest]")
+{
+  CheckSlidingWindowKDE<RTree>(KDEMode::DUAL_TREE_MODE);
+  CheckSlidingWindowKDE<RTree>(KDEMode::SINGLE_TREE_MODE);
+  CheckSlidingWindowKDE<RStarTree>(KDEMode::DUAL_TREE_MODE);
+}
+
+TEST_CASE("SlidingWindowBinarySpaceTreeKDETest", "[KDETest]")
+{
+  CheckSlidingWindowKDE<KDTree>(KDEMode::DUAL_TREE_MODE);
+  CheckSlidingWindowKDE<KDTree>(KDEMode::SINGLE_TREE_MODE);
+  CheckSlidingWindowKDE<BallTree>(KDEMode::DUAL_TREE_MODE);
+}
+
+TEST_CASE("SlidingWindowRebuildKDETest", "[KDETest]")
+{
+  CheckSlidingWindowKDE<StandardCoverTree>(KDEMode::DUAL_TREE_MODE);
+  CheckSlidingWindowKDE<StandardCoverTree>(KDEMode::SINGLE_TREE_MODE);
+  CheckSlidingWindowKDE<Octree>(KDEMode::DUAL_TREE_MODE);
+}
+
+/**
+ * Make sure that invalid reference updates throw.
+ */
+TEST_CASE("InvalidReferenceUpdateKDETest", "[KDETest]")
+{
+  KDE<> kde;
+  REQUIRE_THROWS_AS(kde.InsertReferencePoints(arma::randu(2, 10)),
+      std::runtime_error);
+  REQUIRE_THROWS_AS(kde.ExpireReferencePoints(1), std::runtime_error);
+
+  kde.Train(arma::randu(2, 10));
+  REQUIRE_THROWS_AS(kde.InsertReferencePoints(arma::randu(3, 10)),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(kde.ExpireReferencePoints(10), std::invalid_argument);
+
+  // Nothing happens with empty updates.
+  kde.InsertReferencePoints(arma::mat(2, 0));
+  kde.ExpireReferencePoints(0);
+  REQUIRE(kde.ReferenceTree()->Dataset().n_cols == 10);
+}
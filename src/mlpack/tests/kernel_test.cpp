@@ -632,3 +632,36 @@ TEST_CASE("CauchyKernelTest", "[KernelTest]")
   REQUIRE(ck.Evaluate(a, b) == Approx(0.92592588).epsilon(1e-7));
   REQUIRE(ck.Evaluate(b, a) == Approx(0.92592588).epsilon(1e-7));
 }
+
+/**
+ * Make sure that the batched evaluations of the linear and polynomial kernels
+ * match the evaluation of each pair.
+ */
+TEST_CASE("LinearPolynomialBatchEvaluateTest", "[KernelTest]")
+{
+  arma::mat a(5, 30, arma::fill::randn);
+  arma::mat b(5, 40, arma::fill::randn);
+
+  LinearKernel lk;
+  PolynomialKernel pk(3.0, 1.5);
+
+  arma::mat linearKernels, polynomialKernels;
+  lk.BatchEvaluate(a, b, linearKernels);
+  pk.BatchEvaluate(a, b, polynomialKernels);
+
+  REQUIRE(linearKernels.n_rows == a.n_cols);
+  REQUIRE(linearKernels.n_cols == b.n_cols);
+  REQUIRE(polynomialKernels.n_rows == a.n_cols);
+  REQUIRE(polynomialKernels.n_cols == b.n_cols);
+
+  for (size_t j = 0; j < b.n_cols; ++j)
+  {
+    for (size_t i = 0; i < a.n_cols; ++i)
+    {
+      REQUIRE(linearKernels(i, j) ==
+          Approx(lk.Evaluate(a.col(i), b.col(j))).margin(1e-10));
+      REQUIRE(polynomialKernels(i, j) ==
+          Approx(pk.Evaluate(a.col(i), b.col(j))).epsilon(1e-7).margin(1e-8));
+    }
+  }
+}
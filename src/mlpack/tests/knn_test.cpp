@@ -718,6 +718,316 @@ TEST_CASE("KNNDualTreeVsNaive2", "[KNNTest]")
   }
 }
 
+/**
+ * Test the parallel dual-tree nearest-neighbors method with the naive method,
+ * both with a query set and in the monochromatic setting.
+ */
+TEST_CASE("KNNParallelDualTreeVsNaive", "[KNNTest]")
+{
+  arma::mat dataset;
+  if (!data::Load("test_data_3_1000.csv", dataset))
+    FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::mat querySet = arma::randu<arma::mat>(3, 500);
+
+  KNN knn(dataset, PARALLEL_DUAL_TREE_MODE);
+  KNN naive(dataset, NAIVE_MODE);
+
+  arma::Mat<size_t> neighborsTree, neighborsNaive;
+  arma::mat distancesTree, distancesNaive;
+  knn.Search(querySet, 10, neighborsTree, distancesTree);
+  naive.Search(querySet, 10, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    REQUIRE(neighborsTree[i] == neighborsNaive[i]);
+    REQUIRE(distancesTree[i] == Approx(distancesNaive[i]).epsilon(1e-7));
+  }
+
+  // Run the monochromatic search twice, to make sure the tree is reset
+  // correctly between searches.
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    knn.Search(10, neighborsTree, distancesTree);
+    naive.Search(10, neighborsNaive, distancesNaive);
+
+    for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+    {
+      REQUIRE(neighborsTree[i] == neighborsNaive[i]);
+      REQUIRE(distancesTree[i] == Approx(distancesNaive[i]).epsilon(1e-7));
+    }
+  }
+}
+
+/**
+ * Make sure that searches with a frozen kd-tree give the same results as the
+ * naive method.
+ */
+TEST_CASE("KNNFrozenTreeVsNaive", "[KNNTest]")
+{
+  arma::mat dataset;
+  if (!data::Load("test_data_3_1000.csv", dataset))
+    FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  KNN::Tree tree(dataset);
+  tree.Freeze();
+
+  KNN knn(std::move(tree));
+  REQUIRE(knn.ReferenceTree().IsFrozen());
+
+  // The tree has reordered the reference set, so use the same order for the
+  // naive search.
+  KNN naive(knn.ReferenceSet(), NAIVE_MODE);
+
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(10, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    knn.SearchMode() = (i == 0) ? DUAL_TREE_MODE : SINGLE_TREE_MODE;
+
+    arma::Mat<size_t> neighborsTree;
+    arma::mat distancesTree;
+    knn.Search(10, neighborsTree, distancesTree);
+
+    for (size_t j = 0; j < neighborsTree.n_elem; ++j)
+    {
+      REQUIRE(neighborsTree[j] == neighborsNaive[j]);
+      REQUIRE(distancesTree[j] == Approx(distancesNaive[j]).epsilon(1e-7));
+    }
+  }
+}
+
+/**
+ * Make sure that a kd-tree model saved in the memory-mapped format gives the
+ * same results as the original model when it is loaded, and that other models
+ * are refused.
+ */
+TEST_CASE("KNNMappedModelTest", "[KNNTest]")
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat dataset = arma::randu<arma::mat>(5, 2000);
+  arma::mat queryset = arma::randu<arma::mat>(5, 300);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    // Try both with and without a random basis.
+    KNNModel model(KNNModel::TreeTypes::KD_TREE, (i == 1));
+    model.BuildModel(arma::mat(dataset), 15, DUAL_TREE_MODE);
+    REQUIRE(data::Save("knn_model.mmap", "model", model, false));
+
+    KNNModel mapped;
+    REQUIRE(data::Load("knn_model.mmap", "model", mapped, false));
+
+    REQUIRE(mapped.TreeType() == KNNModel::TreeTypes::KD_TREE);
+    REQUIRE(mapped.LeafSize() == 15);
+    REQUIRE(mapped.RandomBasis() == (i == 1));
+    REQUIRE(mapped.SearchMode() == DUAL_TREE_MODE);
+    CheckMatrices(model.Dataset(), mapped.Dataset());
+
+    arma::Mat<size_t> neighbors, mappedNeighbors;
+    arma::mat distances, mappedDistances;
+    model.Search(arma::mat(queryset), 5, neighbors, distances);
+    mapped.Search(arma::mat(queryset), 5, mappedNeighbors, mappedDistances);
+    CheckMatrices(neighbors, mappedNeighbors);
+    CheckMatrices(distances, mappedDistances);
+
+    model.Search(5, neighbors, distances);
+    mapped.SearchMode() = SINGLE_TREE_MODE;
+    mapped.Search(5, mappedNeighbors, mappedDistances);
+    CheckMatrices(neighbors, mappedNeighbors);
+    CheckMatrices(distances, mappedDistances);
+  }
+
+  // Other tree types can't be saved in the memory-mapped format.
+  KNNModel coverModel(KNNModel::TreeTypes::COVER_TREE);
+  coverModel.BuildModel(arma::mat(dataset), 20, DUAL_TREE_MODE);
+  REQUIRE(!data::Save("knn_cover_model.mmap", "model", coverModel, false));
+
+  remove("knn_model.mmap");
+  remove("knn_cover_model.mmap");
+}
+
+/**
+ * Make sure that a single-precision kd-tree model finds the same neighbors as
+ * a double-precision model, that recomputing the distances in double precision
+ * gives the exact distances, and that the precision survives serialization.
+ */
+TEST_CASE("KNNSinglePrecisionModelTest", "[KNNTest]")
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat dataset = arma::randu<arma::mat>(5, 1000);
+  arma::mat queryset = arma::randu<arma::mat>(5, 200);
+
+  KNNModel model(KNNModel::TreeTypes::KD_TREE);
+  model.BuildModel(arma::mat(dataset), 20, DUAL_TREE_MODE);
+  KNNModel floatModel(KNNModel::TreeTypes::KD_TREE, false, true);
+  floatModel.BuildModel(arma::mat(dataset), 20, DUAL_TREE_MODE);
+
+  REQUIRE(floatModel.SinglePrecision());
+  REQUIRE(floatModel.FloatDataset().n_cols == 1000);
+  REQUIRE_THROWS_AS(floatModel.Dataset(), std::invalid_argument);
+  REQUIRE_THROWS_AS(model.FloatDataset(), std::invalid_argument);
+
+  arma::Mat<size_t> neighbors, floatNeighbors;
+  arma::mat distances, floatDistances;
+  model.Search(arma::mat(queryset), 5, neighbors, distances);
+
+  // The recomputed distances are computed from the reference points rounded to
+  // single precision.
+  const arma::mat roundedDataset = arma::conv_to<arma::mat>::from(
+      arma::conv_to<arma::fmat>::from(dataset));
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    floatModel.DoubleDistances() = (i == 1);
+    floatModel.Search(arma::mat(queryset), 5, floatNeighbors, floatDistances);
+
+    REQUIRE(floatNeighbors.n_rows == neighbors.n_rows);
+    REQUIRE(floatNeighbors.n_cols == neighbors.n_cols);
+    if (i == 0)
+    {
+      for (size_t j = 0; j < distances.n_elem; ++j)
+        REQUIRE(floatDistances[j] == Approx(distances[j]).epsilon(1e-5));
+      continue;
+    }
+
+    for (size_t c = 0; c < floatNeighbors.n_cols; ++c)
+    {
+      for (size_t r = 0; r < floatNeighbors.n_rows; ++r)
+      {
+        const double trueDistance = metric::EuclideanDistance::Evaluate(
+            queryset.col(c), roundedDataset.col(floatNeighbors(r, c)));
+        REQUIRE(floatDistances(r, c) ==
+            Approx(trueDistance).epsilon(1e-10));
+        REQUIRE(floatDistances(r, c) ==
+            Approx(distances(r, c)).epsilon(0).margin(1e-6));
+      }
+    }
+  }
+
+  // Monochromatic search should also work; there the query points are rounded
+  // too.
+  model.Search(5, neighbors, distances);
+  floatModel.Search(5, floatNeighbors, floatDistances);
+  for (size_t c = 0; c < floatNeighbors.n_cols; ++c)
+  {
+    for (size_t r = 0; r < floatNeighbors.n_rows; ++r)
+    {
+      const double trueDistance = metric::EuclideanDistance::Evaluate(
+          roundedDataset.col(c), roundedDataset.col(floatNeighbors(r, c)));
+      REQUIRE(floatDistances(r, c) == Approx(trueDistance).epsilon(1e-10));
+      REQUIRE(floatDistances(r, c) ==
+          Approx(distances(r, c)).epsilon(0).margin(1e-6));
+    }
+  }
+
+  // The precision is restored when the model is loaded.
+  REQUIRE(data::Save("knn_float_model.bin", "model", floatModel, false));
+  KNNModel loaded;
+  REQUIRE(data::Load("knn_float_model.bin", "model", loaded, false));
+  REQUIRE(loaded.SinglePrecision());
+  CheckMatrices(floatModel.FloatDataset(), loaded.FloatDataset());
+
+  // Single precision is only available for kd-trees.
+  KNNModel coverModel(KNNModel::TreeTypes::COVER_TREE, false, true);
+  REQUIRE_THROWS_AS(coverModel.BuildModel(arma::mat(dataset), 20,
+      DUAL_TREE_MODE), std::invalid_argument);
+
+  remove("knn_float_model.bin");
+}
+
+/**
+ * Insert points into and remove points from the reference set of a model, and
+ * make sure that the results are the same as those of a model built on the
+ * modified reference set.
+ */
+TEST_CASE("KNNInsertRemoveTest", "[KNNTest]")
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 1000);
+  arma::mat points = arma::randu<arma::mat>(4, 600);
+  arma::mat queryset = arma::randu<arma::mat>(4, 100);
+
+  KNN knn(dataset);
+  KNN naive(dataset, NAIVE_MODE);
+
+  // Search once, so that the bounds in the tree have to be reset.
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(5, neighbors, distances);
+
+  knn.Insert(points);
+  naive.Insert(points);
+  arma::mat modified = arma::join_rows(dataset, points);
+
+  std::vector<size_t> removed;
+  for (size_t i = 0; i < modified.n_cols; i += 4)
+    removed.push_back(i);
+  knn.Remove(removed);
+  naive.Remove(removed);
+  for (size_t i = removed.size(); i > 0; --i)
+    modified.shed_col(removed[i - 1]);
+
+  REQUIRE(knn.ReferenceSet().n_cols == modified.n_cols);
+  REQUIRE(naive.ReferenceSet().n_cols == modified.n_cols);
+
+  KNN baseline(modified, NAIVE_MODE);
+  arma::Mat<size_t> baselineNeighbors;
+  arma::mat baselineDistances;
+  baseline.Search(queryset, 5, baselineNeighbors, baselineDistances);
+
+  knn.Search(queryset, 5, neighbors, distances);
+  CheckMatrices(neighbors, baselineNeighbors);
+  CheckMatrices(distances, baselineDistances);
+
+  knn.SearchMode() = SINGLE_TREE_MODE;
+  knn.Search(queryset, 5, neighbors, distances);
+  CheckMatrices(neighbors, baselineNeighbors);
+  CheckMatrices(distances, baselineDistances);
+
+  naive.Search(queryset, 5, neighbors, distances);
+  CheckMatrices(neighbors, baselineNeighbors);
+  CheckMatrices(distances, baselineDistances);
+
+  // Monochromatic search.
+  knn.SearchMode() = DUAL_TREE_MODE;
+  baseline.Search(5, baselineNeighbors, baselineDistances);
+  knn.Search(5, neighbors, distances);
+  CheckMatrices(neighbors, baselineNeighbors);
+  CheckMatrices(distances, baselineDistances);
+
+  REQUIRE_THROWS_AS(knn.Remove(std::vector<size_t>(1, modified.n_cols)),
+      std::invalid_argument);
+}
+
+/**
+ * Test the parallel dual-tree nearest-neighbors method with cover trees, which
+ * hold points in non-leaf nodes, against the naive method.
+ */
+TEST_CASE("KNNParallelDualCoverTreeTest", "[KNNTest]")
+{
+  arma::mat dataset;
+  data::Load("test_data_3_1000.csv", dataset);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      StandardCoverTree> coverTreeSearch(dataset, PARALLEL_DUAL_TREE_MODE);
+  KNN naive(dataset, NAIVE_MODE);
+
+  arma::Mat<size_t> coverNeighbors, naiveNeighbors;
+  arma::mat coverDistances, naiveDistances;
+  coverTreeSearch.Search(dataset, 5, coverNeighbors, coverDistances);
+  naive.Search(dataset, 5, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < coverNeighbors.n_elem; ++i)
+  {
+    REQUIRE(coverNeighbors(i) == naiveNeighbors(i));
+    REQUIRE(coverDistances(i) == Approx(naiveDistances(i)).epsilon(1e-7));
+  }
+}
+
 /**
  * Test the single-tree nearest-neighbors method with the naive method.  This
  * uses only a reference dataset.
@@ -1814,3 +2124,53 @@ TEST_CASE("KNNSpillTreeSearchEnoughResults", "[KNNTest]")
   REQUIRE(arma::accu(distancesGreedy < 0.0 || distancesGreedy > std::sqrt(3.0))
       == 0);
 }
+
+/**
+ * Run many searches on one model at once (if OpenMP is available), and make
+ * sure that each gives the same results as when the searches are run one at a
+ * time.
+ */
+TEST_CASE("KNNConcurrentModelSearchTest", "[KNNTest]")
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat dataset = arma::randu<arma::mat>(4, 2000);
+  arma::mat queryset = arma::randu<arma::mat>(4, 800);
+
+  // The cover tree also caches distances during single-tree search.
+  KNNModel::TreeTypes treeTypes[] = { KNNModel::KD_TREE,
+      KNNModel::COVER_TREE };
+  NeighborSearchMode modes[] = { DUAL_TREE_MODE, SINGLE_TREE_MODE };
+  const size_t numSearches = 16;
+  const size_t chunkSize = queryset.n_cols / numSearches;
+
+  for (size_t t = 0; t < 2; ++t)
+  {
+    for (size_t m = 0; m < 2; ++m)
+    {
+      KNNModel model(treeTypes[t]);
+      model.BuildModel(arma::mat(dataset), 20, modes[m]);
+
+      std::vector<arma::Mat<size_t>> neighbors(numSearches);
+      std::vector<arma::mat> distances(numSearches);
+
+      #pragma omp parallel for
+      for (omp_size_t i = 0; i < (omp_size_t) numSearches; ++i)
+      {
+        model.Search(queryset.cols(i * chunkSize, (i + 1) * chunkSize - 1), 5,
+            neighbors[i], distances[i]);
+      }
+
+      for (size_t i = 0; i < numSearches; ++i)
+      {
+        arma::Mat<size_t> sequentialNeighbors;
+        arma::mat sequentialDistances;
+        model.Search(queryset.cols(i * chunkSize, (i + 1) * chunkSize - 1), 5,
+            sequentialNeighbors, sequentialDistances);
+
+        CheckMatrices(neighbors[i], sequentialNeighbors);
+        CheckMatrices(distances[i], sequentialDistances);
+      }
+    }
+  }
+}
@@ -644,6 +644,275 @@ TEST_CASE("LSHTrainTest", "[LSHTest]")
   REQUIRE(distances.n_rows == 3);
 }
 
+/**
+ * Test: when every point falls in the same bucket of every table, each point is
+ * returned once per table, so the search is exact only if the duplicate
+ * candidates are discarded.
+ */
+TEST_CASE("LSHDuplicateCandidatesTest", "[LSHTest]")
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 600);
+  arma::mat queryData = arma::randu<arma::mat>(5, 40);
+
+  // The hash width is so large that all points share a bucket, and the bucket
+  // size is unlimited.
+  LSHSearch<> lsh(referenceData, 3, 4, 1e6, 99901, 0);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> trueNeighbors, neighbors;
+  arma::mat trueDistances, distances;
+
+  knn.Search(queryData, 5, trueNeighbors, trueDistances);
+  lsh.Search(queryData, 5, neighbors, distances);
+  CheckMatrices(neighbors, trueNeighbors);
+  CheckMatrices(distances, trueDistances);
+  REQUIRE(lsh.DistanceEvaluations() == queryData.n_cols * referenceData.n_cols);
+
+  knn.Search(5, trueNeighbors, trueDistances);
+  lsh.Search(5, neighbors, distances);
+  CheckMatrices(neighbors, trueNeighbors);
+  CheckMatrices(distances, trueDistances);
+}
+
+/**
+ * Test: without a budget, the adaptive search probes every bin and returns the
+ * same results as the multiprobe search; with a budget, it stops early.
+ */
+TEST_CASE("AdaptiveSearchTest", "[LSHTest]")
+{
+  const size_t numTables = 8;
+  const size_t T = 3;
+  arma::mat rdata = arma::randu<arma::mat>(6, 1000);
+  arma::mat qdata = arma::randu<arma::mat>(6, 50);
+
+  LSHSearch<> lsh(rdata, 4, numTables);
+
+  arma::Mat<size_t> neighbors, adaptiveNeighbors, statistics;
+  arma::mat distances, adaptiveDistances;
+  lsh.Search(qdata, 5, neighbors, distances, 0, T);
+  const size_t evaluations = lsh.DistanceEvaluations();
+
+  lsh.AdaptiveSearch(qdata, 5, adaptiveNeighbors, adaptiveDistances,
+      statistics, 0, T);
+  CheckMatrices(adaptiveDistances, distances);
+  REQUIRE(statistics.n_rows == 3);
+  REQUIRE(statistics.n_cols == qdata.n_cols);
+  REQUIRE(arma::all(statistics.row(0) == numTables * (T + 1)));
+  REQUIRE(arma::all(statistics.row(1) >= statistics.row(2)));
+  REQUIRE(arma::accu(statistics.row(2)) == evaluations);
+  REQUIRE(lsh.DistanceEvaluations() == 2 * evaluations);
+
+  // Probing stops once the target is reached (or every bin has been probed).
+  lsh.AdaptiveSearch(qdata, 5, adaptiveNeighbors, adaptiveDistances,
+      statistics, 100, T);
+  for (size_t i = 0; i < qdata.n_cols; ++i)
+  {
+    REQUIRE((statistics(2, i) >= 100 ||
+        statistics(0, i) == numTables * (T + 1)));
+  }
+
+  // An expired deadline still probes one bin.
+  lsh.AdaptiveSearch(5, adaptiveNeighbors, adaptiveDistances, statistics, 0,
+      T, 1e-12);
+  REQUIRE(statistics.n_cols == rdata.n_cols);
+  REQUIRE(arma::all(statistics.row(0) == 1));
+  for (size_t i = 0; i < rdata.n_cols; ++i)
+    REQUIRE(adaptiveNeighbors(0, i) != i);
+
+  REQUIRE_THROWS_AS(lsh.AdaptiveSearch(qdata, 5, adaptiveNeighbors,
+      adaptiveDistances, statistics, 0, T, -1.0), std::invalid_argument);
+
+  // Too many neighbors can't be requested, with or without a query set.
+  REQUIRE_THROWS_AS(lsh.AdaptiveSearch(qdata, rdata.n_cols + 1,
+      adaptiveNeighbors, adaptiveDistances, statistics, 0, T),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(lsh.AdaptiveSearch(rdata.n_cols, adaptiveNeighbors,
+      adaptiveDistances, statistics, 0, T), std::invalid_argument);
+}
+
+/**
+ * Test: the buckets are packed without padding, and hold every point of every
+ * table when the bucket size is unlimited.
+ */
+TEST_CASE("LSHPackedBucketsTest", "[LSHTest]")
+{
+  arma::mat rdata = arma::randu<arma::mat>(4, 500);
+
+  LSHSearch<> lsh(rdata, 3, 6, 0.3, 99901, 0);
+  const arma::Col<size_t>& offsets = lsh.BucketOffsets();
+  const arma::Col<size_t>& points = lsh.BucketPoints();
+  REQUIRE(offsets.n_elem == 99902);
+  REQUIRE(offsets[0] == 0);
+  REQUIRE(offsets[offsets.n_elem - 1] == points.n_elem);
+  REQUIRE(points.n_elem == 6 * rdata.n_cols);
+
+  // Every point appears once per table.
+  arma::Col<size_t> counts(rdata.n_cols, arma::fill::zeros);
+  for (size_t j = 0; j < points.n_elem; ++j)
+    counts[points[j]]++;
+  REQUIRE(arma::all(counts == 6));
+
+  // With a bucket size, only full buckets lose points.
+  LSHSearch<> truncatedLSH(rdata, 3, 6, 0.3, 99901, 5);
+  REQUIRE(truncatedLSH.BucketPoints().n_elem <= points.n_elem);
+  const arma::Col<size_t>& truncatedOffsets = truncatedLSH.BucketOffsets();
+  for (size_t h = 0; h + 1 < offsets.n_elem; ++h)
+  {
+    REQUIRE(truncatedOffsets[h + 1] - truncatedOffsets[h] ==
+        std::min(offsets[h + 1] - offsets[h], (size_t) 5));
+  }
+}
+
+/**
+ * The layout of LSHSearch models serialized before the buckets were packed
+ * (version 0), which held the buckets in a padded table.
+ */
+struct OldLSHSearch
+{
+  arma::mat referenceSet;
+  size_t numProj;
+  size_t numTables;
+  arma::cube projections;
+  arma::mat offsets;
+  double hashWidth;
+  size_t secondHashSize;
+  arma::vec secondHashWeights;
+  size_t bucketSize;
+  std::vector<arma::Col<size_t>> secondHashTable;
+  arma::Col<size_t> bucketContentSize;
+  arma::Col<size_t> bucketRowInHashTable;
+  size_t distanceEvaluations;
+
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */)
+  {
+    ar(CEREAL_NVP(referenceSet));
+    ar(CEREAL_NVP(numProj));
+    ar(CEREAL_NVP(numTables));
+    ar(CEREAL_NVP(projections));
+    ar(CEREAL_NVP(offsets));
+    ar(CEREAL_NVP(hashWidth));
+    ar(CEREAL_NVP(secondHashSize));
+    ar(CEREAL_NVP(secondHashWeights));
+    ar(CEREAL_NVP(bucketSize));
+    ar(CEREAL_NVP(secondHashTable));
+    ar(CEREAL_NVP(bucketContentSize));
+    ar(CEREAL_NVP(bucketRowInHashTable));
+    ar(CEREAL_NVP(distanceEvaluations));
+  }
+};
+
+/**
+ * Test: a model serialized with the padded table of older versions is
+ * converted to packed buckets when it is loaded.
+ */
+TEST_CASE("LSHOldFormatLoadTest", "[LSHTest]")
+{
+  arma::mat rdata = arma::randu<arma::mat>(4, 500);
+  arma::mat qdata = arma::randu<arma::mat>(4, 50);
+
+  const double hashWidth = 0.3;
+  LSHSearch<> lsh(rdata, 3, 6, hashWidth, 99901, 0);
+  const arma::Col<size_t>& offsets = lsh.BucketOffsets();
+  const arma::Col<size_t>& points = lsh.BucketPoints();
+
+  // Build the old layout of the same model; each row is padded by one
+  // element, as rows of the old table could be.
+  OldLSHSearch old;
+  old.referenceSet = rdata;
+  old.projections = lsh.Projections();
+  old.numProj = old.projections.n_cols;
+  old.numTables = old.projections.n_slices;
+  old.offsets = lsh.Offsets();
+  old.hashWidth = hashWidth;
+  old.secondHashSize = offsets.n_elem - 1;
+  old.secondHashWeights = lsh.SecondHashWeights();
+  old.bucketSize = lsh.BucketSize();
+  old.bucketRowInHashTable.set_size(old.secondHashSize);
+  old.bucketRowInHashTable.fill(old.secondHashSize);
+  std::vector<size_t> contentSizes;
+  for (size_t h = 0; h < old.secondHashSize; ++h)
+  {
+    const size_t size = offsets[h + 1] - offsets[h];
+    if (size == 0)
+      continue;
+
+    old.bucketRowInHashTable[h] = old.secondHashTable.size();
+    arma::Col<size_t> row(size + 1);
+    row.subvec(0, size - 1) = points.subvec(offsets[h], offsets[h + 1] - 1);
+    row[size] = rdata.n_cols;
+    old.secondHashTable.push_back(row);
+    contentSizes.push_back(size);
+  }
+  old.bucketContentSize = arma::Col<size_t>(contentSizes);
+  old.distanceEvaluations = 0;
+
+  std::stringstream stream;
+  {
+    cereal::BinaryOutputArchive ar(stream);
+    ar(cereal::make_nvp("model", old));
+  }
+
+  LSHSearch<> loaded;
+  {
+    cereal::BinaryInputArchive ar(stream);
+    ar(cereal::make_nvp("model", loaded));
+  }
+
+  CheckMatrices(loaded.BucketOffsets(), offsets);
+  CheckMatrices(loaded.BucketPoints(), points);
+
+  arma::Mat<size_t> neighbors, loadedNeighbors;
+  arma::mat distances, loadedDistances;
+  lsh.Search(qdata, 3, neighbors, distances);
+  loaded.Search(qdata, 3, loadedNeighbors, loadedDistances);
+  CheckMatrices(loadedNeighbors, neighbors);
+  CheckMatrices(loadedDistances, distances);
+}
+
+/**
+ * Test: a model saved in the memory-mapped format gives the same results when
+ * it is loaded, and corrupt files are rejected.
+ */
+TEST_CASE("LSHMappedModelTest", "[LSHTest]")
+{
+  arma::mat rdata = arma::randu<arma::mat>(5, 800);
+  arma::mat qdata = arma::randu<arma::mat>(5, 50);
+
+  LSHSearch<> lsh(rdata, 4, 8, 0.0, 99901, 0);
+  arma::Mat<size_t> neighbors, mappedNeighbors;
+  arma::mat distances, mappedDistances;
+  lsh.Search(qdata, 5, neighbors, distances, 0, 2);
+
+  REQUIRE(data::Save("lsh_model.mmap", "lsh_model", lsh, true));
+
+  LSHSearch<> mappedLSH;
+  REQUIRE(data::Load("lsh_model.mmap", "lsh_model", mappedLSH, true));
+  CheckMatrices(mappedLSH.ReferenceSet(), rdata);
+  CheckMatrices(mappedLSH.BucketOffsets(), lsh.BucketOffsets());
+  CheckMatrices(mappedLSH.BucketPoints(), lsh.BucketPoints());
+
+  mappedLSH.Search(qdata, 5, mappedNeighbors, mappedDistances, 0, 2);
+  CheckMatrices(mappedNeighbors, neighbors);
+  CheckMatrices(mappedDistances, distances);
+
+  // Copies and retrained models do not depend on the file.
+  LSHSearch<> copiedLSH(mappedLSH);
+  mappedLSH.Train(qdata, 2, 2);
+  copiedLSH.Search(qdata, 5, mappedNeighbors, mappedDistances, 0, 2);
+  CheckMatrices(mappedNeighbors, neighbors);
+
+  // Truncate the file.
+  std::ofstream ofs("lsh_model.mmap", std::ofstream::out |
+      std::ofstream::binary | std::ofstream::trunc);
+  ofs.write("MLPKLSH", 8);
+  ofs.close();
+  REQUIRE_THROWS_AS(copiedLSH.LoadMapped("lsh_model.mmap"),
+      std::invalid_argument);
+
+  remove("lsh_model.mmap");
+}
+
 /**
  * Test: this verifies ComputeRecall works correctly by providing two identical
  * vectors and requiring that Recall is equal to 1.
@@ -842,6 +1111,31 @@ TEST_CASE("ParallelMonochromatic", "[LSHTest]")
       sequentialNeighbors, parallelNeighbors);
   REQUIRE(recall == 1);
 }
+
+/**
+ * Test: the hash tables built in parallel must be the same as the hash tables
+ * built with one thread, including which points are dropped from full buckets.
+ */
+TEST_CASE("ParallelTrain", "[LSHTest]")
+{
+  arma::mat rdata = arma::randu<arma::mat>(4, 2000);
+
+  // A small bucket size makes sure that some buckets overflow.
+  math::RandomSeed(42);
+  LSHSearch<> parallelLSH(rdata, 3, 10, 0.5, 101, 30);
+
+  size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  math::RandomSeed(42);
+  LSHSearch<> sequentialLSH(rdata, 3, 10, 0.5, 101, 30);
+  omp_set_num_threads(prevNumThreads);
+
+  const arma::Col<size_t>& offsets = parallelLSH.BucketOffsets();
+  REQUIRE(arma::max(offsets.tail(offsets.n_elem - 1) -
+      offsets.head(offsets.n_elem - 1)) <= 30);
+  CheckMatrices(parallelLSH.BucketOffsets(), sequentialLSH.BucketOffsets());
+  CheckMatrices(parallelLSH.BucketPoints(), sequentialLSH.BucketPoints());
+}
 #endif
 
 // Test the copy constructor and the copy operator.
@@ -475,3 +475,45 @@ TEST_CASE_METHOD(DBSCANTestFixture, "DBSCANRandomSelectionFlagTest",
 
   REQUIRE(arma::accu(orderedOutput != randomOutput) > 0);
 }
+
+/**
+ * Check that the parallel mode gives the same clusters with every tree type
+ * and with naive search.
+ */
+TEST_CASE_METHOD(DBSCANTestFixture, "DBSCANParallelTest",
+                 "[DBSCANMainTest][BindingTests]")
+{
+  arma::mat inputData;
+  if (!data::Load("iris.csv", inputData))
+    FAIL("Unable to load dataset iris.csv!");
+
+  SetInputParam("input", inputData);
+  SetInputParam("epsilon", (double) 0.4);
+  SetInputParam("min_size", 5);
+  SetInputParam("parallel", true);
+  SetInputParam("naive", true);
+
+  mlpackMain();
+
+  const arma::Row<size_t> naiveOutput =
+      IO::GetParam<arma::Row<size_t>>("assignments");
+  REQUIRE(naiveOutput.n_elem == inputData.n_cols);
+
+  for (const std::string treeType : { "kd", "cover", "ball", "r" })
+  {
+    bindings::tests::CleanMemory();
+    IO::ClearSettings();
+    IO::RestoreSettings(testName);
+
+    SetInputParam("input", inputData);
+    SetInputParam("epsilon", (double) 0.4);
+    SetInputParam("min_size", 5);
+    SetInputParam("parallel", true);
+    SetInputParam("tree_type", treeType);
+
+    mlpackMain();
+
+    CheckMatrices(IO::GetParam<arma::Row<size_t>>("assignments"),
+        naiveOutput);
+  }
+}
@@ -708,3 +708,88 @@ TEST_CASE_METHOD(FastMKSTestFixture, "FastMKSBandwidthTest",
   CheckMatricesNotEqual(triKernel,
       IO::GetParam<arma::mat>("kernels"));
 }
+
+/**
+ * Ensure that parallel search gives the same results as serial search.
+ */
+TEST_CASE_METHOD(FastMKSTestFixture, "FastMKSParallelTest",
+                 "[FastMKSMainTest][BindingTests]")
+{
+  // 200 points in 3 dimensions.
+  arma::mat referenceData(3, 200, arma::fill::randu);
+
+  SetInputParam("reference", referenceData);
+  SetInputParam("k", (int) 10);
+  SetInputParam("single", true);
+
+  mlpackMain();
+
+  arma::Mat<size_t> indices = std::move(
+      IO::GetParam<arma::Mat<size_t>>("indices"));
+  arma::mat kernels = std::move(IO::GetParam<arma::mat>("kernels"));
+
+  bindings::tests::CleanMemory();
+
+  IO::GetSingleton().Parameters()["reference"].wasPassed = false;
+
+  SetInputParam("reference", referenceData);
+  SetInputParam("parallel", true);
+
+  mlpackMain();
+
+  CheckMatrices(indices, IO::GetParam<arma::Mat<size_t>>("indices"));
+  CheckMatrices(kernels, IO::GetParam<arma::mat>("kernels"));
+}
+
+/**
+ * Ensure that norm bucket search gives the same results as naive search.
+ */
+TEST_CASE_METHOD(FastMKSTestFixture, "FastMKSNormBucketsTest",
+                 "[FastMKSMainTest][BindingTests]")
+{
+  // 300 points in 4 dimensions, with very different norms.
+  arma::mat referenceData(4, 300, arma::fill::randn);
+  referenceData.each_row() %= arma::exp(arma::randn<arma::rowvec>(300));
+
+  SetInputParam("reference", referenceData);
+  SetInputParam("k", (int) 5);
+  SetInputParam("naive", true);
+
+  mlpackMain();
+
+  arma::Mat<size_t> indices = std::move(
+      IO::GetParam<arma::Mat<size_t>>("indices"));
+  arma::mat kernels = std::move(IO::GetParam<arma::mat>("kernels"));
+
+  bindings::tests::CleanMemory();
+
+  IO::GetSingleton().Parameters()["reference"].wasPassed = false;
+  IO::GetSingleton().Parameters()["naive"].wasPassed = false;
+
+  SetInputParam("reference", referenceData);
+  SetInputParam("norm_buckets", true);
+  SetInputParam("bucket_size", (int) 16);
+
+  mlpackMain();
+
+  CheckMatrices(indices, IO::GetParam<arma::Mat<size_t>>("indices"));
+  CheckMatrices(kernels, IO::GetParam<arma::mat>("kernels"));
+}
+
+/**
+ * Ensure that a non-positive bucket size is rejected.
+ */
+TEST_CASE_METHOD(FastMKSTestFixture, "FastMKSInvalidBucketSizeTest",
+                 "[FastMKSMainTest][BindingTests]")
+{
+  arma::mat referenceData(3, 50, arma::fill::randu);
+
+  SetInputParam("reference", std::move(referenceData));
+  SetInputParam("k", (int) 5);
+  SetInputParam("norm_buckets", true);
+  SetInputParam("bucket_size", (int) 0);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
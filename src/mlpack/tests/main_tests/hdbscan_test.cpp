@@ -0,0 +1,140 @@
+/**
+ * @file tests/main_tests/hdbscan_test.cpp
+ *
+ * Test mlpackMain() of hdbscan_main.cpp.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <string>
+
+#define BINDING_TYPE BINDING_TYPE_TEST
+static const std::string testName = "HDBSCAN";
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/mlpack_main.hpp>
+#include "test_helper.hpp"
+#include <mlpack/methods/hdbscan/hdbscan_main.cpp>
+
+#include "../catch.hpp"
+#include "../test_catch_tools.hpp"
+
+using namespace mlpack;
+
+struct HDBSCANTestFixture
+{
+ public:
+  HDBSCANTestFixture()
+  {
+    // Cache in the options for this program.
+    IO::RestoreSettings(testName);
+  }
+
+  ~HDBSCANTestFixture()
+  {
+    // Clear the settings.
+    bindings::tests::CleanMemory();
+    IO::ClearSettings();
+  }
+};
+
+/**
+ * Check that the number of output labels is the number of input points, and
+ * that the condensed tree has four rows.
+ */
+TEST_CASE_METHOD(HDBSCANTestFixture, "HDBSCANOutputDimensionTest",
+                 "[HDBSCANMainTest][BindingTests]")
+{
+  arma::mat inputData;
+  if (!data::Load("iris.csv", inputData))
+    FAIL("Unable to load dataset iris.csv!");
+
+  const size_t inputSize = inputData.n_cols;
+
+  SetInputParam("input", std::move(inputData));
+
+  mlpackMain();
+
+  REQUIRE(IO::GetParam<arma::Row<size_t>>("assignments").n_cols == inputSize);
+  REQUIRE(IO::GetParam<arma::Row<size_t>>("assignments").n_rows == 1);
+  REQUIRE(IO::GetParam<arma::mat>("condensed_tree").n_rows == 4);
+  REQUIRE(IO::GetParam<arma::mat>("condensed_tree").n_cols >= inputSize);
+}
+
+/**
+ * Check that the minimum cluster size must be at least 2.
+ */
+TEST_CASE_METHOD(HDBSCANTestFixture, "HDBSCANMinClusterSizeTest",
+                 "[HDBSCANMainTest][BindingTests]")
+{
+  arma::mat inputData;
+  if (!data::Load("iris.csv", inputData))
+    FAIL("Unable to load dataset iris.csv!");
+
+  SetInputParam("input", std::move(inputData));
+  SetInputParam("min_cluster_size", (int) 1);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
+
+/**
+ * Check that min_points must not be larger than the number of points.
+ */
+TEST_CASE_METHOD(HDBSCANTestFixture, "HDBSCANMinPointsTest",
+                 "[HDBSCANMainTest][BindingTests]")
+{
+  arma::mat inputData(3, 20, arma::fill::randu);
+
+  SetInputParam("input", std::move(inputData));
+  SetInputParam("min_points", (int) 21);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
+
+/**
+ * Check that every tree type gives the same number of clusters and noise
+ * points as the naive computation.
+ */
+TEST_CASE_METHOD(HDBSCANTestFixture, "HDBSCANTreeTypeTest",
+                 "[HDBSCANMainTest][BindingTests]")
+{
+  arma::mat inputData;
+  if (!data::Load("iris.csv", inputData))
+    FAIL("Unable to load dataset iris.csv!");
+
+  SetInputParam("input", inputData);
+  SetInputParam("naive", true);
+
+  mlpackMain();
+
+  const arma::Row<size_t> naiveAssignments =
+      IO::GetParam<arma::Row<size_t>>("assignments");
+  const size_t naiveNoise = arma::accu(naiveAssignments == SIZE_MAX);
+  const size_t naiveLabels = arma::Row<size_t>(
+      arma::unique(naiveAssignments)).n_elem;
+
+  for (const std::string treeType : { "kd", "ball", "cover" })
+  {
+    bindings::tests::CleanMemory();
+    IO::ClearSettings();
+    IO::RestoreSettings(testName);
+
+    SetInputParam("input", inputData);
+    SetInputParam("tree_type", treeType);
+
+    mlpackMain();
+
+    const arma::Row<size_t>& assignments =
+        IO::GetParam<arma::Row<size_t>>("assignments");
+    REQUIRE(assignments.n_elem == naiveAssignments.n_elem);
+    REQUIRE(arma::accu(assignments == SIZE_MAX) == naiveNoise);
+    REQUIRE(arma::Row<size_t>(arma::unique(assignments)).n_elem ==
+        naiveLabels);
+  }
+}
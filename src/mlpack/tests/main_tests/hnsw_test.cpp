@@ -0,0 +1,153 @@
+/**
+ * @file tests/main_tests/hnsw_test.cpp
+ *
+ * Test mlpackMain() of hnsw_main.cpp.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <string>
+
+#define BINDING_TYPE BINDING_TYPE_TEST
+static const std::string testName = "HNSW";
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/mlpack_main.hpp>
+#include "test_helper.hpp"
+#include <mlpack/methods/hnsw/hnsw_main.cpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include "../catch.hpp"
+#include "../test_catch_tools.hpp"
+
+using namespace mlpack;
+
+struct HNSWTestFixture
+{
+ public:
+  HNSWTestFixture()
+  {
+    // Cache in the options for this program.
+    IO::RestoreSettings(testName);
+  }
+
+  ~HNSWTestFixture()
+  {
+    // Clear the settings.
+    bindings::tests::CleanMemory();
+    IO::ClearSettings();
+  }
+};
+
+/**
+ * Check that output neighbors and distances have valid dimensions, both for
+ * monochromatic and bichromatic search.
+ */
+TEST_CASE_METHOD(HNSWTestFixture, "HNSWOutputDimensionTest",
+                 "[HNSWMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu<arma::mat>(5, 100);
+  arma::mat query = arma::randu<arma::mat>(5, 30);
+
+  SetInputParam("reference", reference);
+  SetInputParam("k", (int) 6);
+
+  mlpackMain();
+
+  REQUIRE(IO::GetParam<arma::Mat<size_t>>("neighbors").n_rows == 6);
+  REQUIRE(IO::GetParam<arma::Mat<size_t>>("neighbors").n_cols == 100);
+  REQUIRE(IO::GetParam<arma::mat>("distances").n_rows == 6);
+  REQUIRE(IO::GetParam<arma::mat>("distances").n_cols == 100);
+
+  bindings::tests::CleanMemory();
+
+  SetInputParam("reference", std::move(reference));
+  SetInputParam("query", std::move(query));
+  SetInputParam("k", (int) 6);
+
+  mlpackMain();
+
+  REQUIRE(IO::GetParam<arma::Mat<size_t>>("neighbors").n_rows == 6);
+  REQUIRE(IO::GetParam<arma::Mat<size_t>>("neighbors").n_cols == 30);
+  REQUIRE(IO::GetParam<arma::mat>("distances").n_rows == 6);
+  REQUIRE(IO::GetParam<arma::mat>("distances").n_cols == 30);
+}
+
+/**
+ * Ensure that invalid graph parameters and k are rejected.
+ */
+TEST_CASE_METHOD(HNSWTestFixture, "HNSWParamValidityTest",
+                 "[HNSWMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu<arma::mat>(5, 100);
+
+  SetInputParam("reference", reference);
+  SetInputParam("k", (int) 6);
+  SetInputParam("links", (int) 1);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+
+  SetInputParam("links", (int) 16);
+  SetInputParam("ef_construction", (int) 0);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+
+  SetInputParam("ef_construction", (int) 200);
+  SetInputParam("k", (int) 100);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
+
+/**
+ * Check that a saved model gives the same results, and that the recall is
+ * computed against the true neighbors.
+ */
+TEST_CASE_METHOD(HNSWTestFixture, "HNSWModelReuseTest",
+                 "[HNSWMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu<arma::mat>(5, 200);
+  arma::mat query = arma::randu<arma::mat>(5, 40);
+
+  neighbor::KNN knn(reference);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(query, 4, trueNeighbors, trueDistances);
+
+  SetInputParam("reference", std::move(reference));
+  SetInputParam("query", query);
+  SetInputParam("k", (int) 4);
+  SetInputParam("true_neighbors", trueNeighbors);
+
+  mlpackMain();
+
+  arma::Mat<size_t> neighbors = IO::GetParam<arma::Mat<size_t>>("neighbors");
+  arma::mat distances = IO::GetParam<arma::mat>("distances");
+  REQUIRE(neighbor::HNSWSearch<>::ComputeRecall(neighbors, trueNeighbors) >=
+      0.9);
+
+  IO::GetSingleton().Parameters()["reference"].wasPassed = false;
+
+  SetInputParam("input_model",
+      IO::GetParam<neighbor::HNSWSearch<>*>("output_model"));
+  SetInputParam("query", std::move(query));
+
+  mlpackMain();
+
+  CheckMatrices(neighbors, IO::GetParam<arma::Mat<size_t>>("neighbors"));
+  CheckMatrices(distances, IO::GetParam<arma::mat>("distances"));
+
+  // True neighbors of the wrong size are rejected.
+  SetInputParam("true_neighbors", arma::Mat<size_t>(3, 40));
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
@@ -574,3 +574,120 @@ TEST_CASE_METHOD(KDETestFixture, "KDEMainMonteCarloFlag",
   const double sumDifferences = arma::accu(differences);
   REQUIRE(sumDifferences > 0);
 }
+
+/**
+ * Ensure that parallel estimations are the same as serial estimations, when
+ * no error is allowed.
+ */
+TEST_CASE_METHOD(KDETestFixture, "KDEMainParallel",
+                "[KDEMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu(2, 500);
+  arma::mat query = arma::randu(2, 100);
+  arma::vec serialEstimations, parallelEstimations;
+
+  for (const std::string algorithm : { "dual-tree", "single-tree" })
+  {
+    // Serial estimations.
+    SetInputParam("reference", reference);
+    SetInputParam("query", query);
+    SetInputParam("algorithm", algorithm);
+    SetInputParam("rel_error", 0.0);
+    SetInputParam("bandwidth", 0.3);
+
+    mlpackMain();
+    serialEstimations = std::move(IO::GetParam<arma::vec>("predictions"));
+
+    bindings::tests::CleanMemory();
+    ResetKDESettings();
+
+    // Parallel estimations.
+    SetInputParam("reference", reference);
+    SetInputParam("query", query);
+    SetInputParam("algorithm", algorithm);
+    SetInputParam("rel_error", 0.0);
+    SetInputParam("bandwidth", 0.3);
+    SetInputParam("parallel", true);
+
+    mlpackMain();
+    parallelEstimations = std::move(IO::GetParam<arma::vec>("predictions"));
+
+    bindings::tests::CleanMemory();
+    ResetKDESettings();
+
+    REQUIRE(parallelEstimations.n_elem == query.n_cols);
+    for (size_t i = 0; i < query.n_cols; ++i)
+    {
+      REQUIRE(parallelEstimations[i] ==
+          Approx(serialEstimations[i]).epsilon(1e-7));
+    }
+  }
+}
+
+/**
+ * Ensure that series expansions give results within the relative error of the
+ * exact results.
+ */
+TEST_CASE_METHOD(KDETestFixture, "KDEMainSeriesExpansion",
+                "[KDEMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu(2, 500);
+  arma::mat query = arma::randu(2, 100);
+  arma::vec exactEstimations, seriesEstimations;
+  const double relError = 0.01;
+
+  for (const std::string algorithm : { "dual-tree", "single-tree" })
+  {
+    // Exact estimations.
+    SetInputParam("reference", reference);
+    SetInputParam("query", query);
+    SetInputParam("algorithm", algorithm);
+    SetInputParam("rel_error", 0.0);
+    SetInputParam("bandwidth", 0.8);
+
+    mlpackMain();
+    exactEstimations = std::move(IO::GetParam<arma::vec>("predictions"));
+
+    bindings::tests::CleanMemory();
+    ResetKDESettings();
+
+    // Estimations with series expansions.
+    SetInputParam("reference", reference);
+    SetInputParam("query", query);
+    SetInputParam("algorithm", algorithm);
+    SetInputParam("rel_error", relError);
+    SetInputParam("bandwidth", 0.8);
+    SetInputParam("series_expansion", true);
+    SetInputParam("series_order", 5);
+
+    mlpackMain();
+    seriesEstimations = std::move(IO::GetParam<arma::vec>("predictions"));
+
+    bindings::tests::CleanMemory();
+    ResetKDESettings();
+
+    REQUIRE(seriesEstimations.n_elem == query.n_cols);
+    for (size_t i = 0; i < query.n_cols; ++i)
+    {
+      REQUIRE(seriesEstimations[i] ==
+          Approx(exactEstimations[i]).epsilon(relError));
+    }
+  }
+}
+
+/**
+ * Ensure that the order of series expansions must be positive.
+ */
+TEST_CASE_METHOD(KDETestFixture, "KDEMainInvalidSeriesOrder",
+                "[KDEMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu(2, 50);
+
+  SetInputParam("reference", std::move(reference));
+  SetInputParam("series_expansion", true);
+  SetInputParam("series_order", 0);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
@@ -548,8 +548,9 @@ TEST_CASE_METHOD(KNNTestFixture, "KNNTrueNeighborDistanceTest",
 TEST_CASE_METHOD(KNNTestFixture, "KNNAllAlgorithmsTest",
                  "[KNNMainTest][BindingTests]")
 {
-  string algorithms[] = {"dual_tree", "naive", "single_tree"};
-  const int nofalgorithms = 3;
+  string algorithms[] = {"dual_tree", "naive", "single_tree",
+      "parallel_dual_tree"};
+  const int nofalgorithms = 4;
 
   arma::mat referenceData;
   referenceData.randu(3, 100); // 100 points in 3 dimensions.
@@ -698,3 +699,106 @@ TEST_CASE_METHOD(KNNTestFixture, "KNNDifferentLeafSizes",
   REQUIRE(IO::GetParam<KNNModel*>("output_model")->LeafSize() == (int) 10);
   delete output_model;
 }
+
+/*
+ * Ensure that streaming the query points in chunks gives the same results as
+ * searching them all at once.
+ */
+TEST_CASE_METHOD(KNNTestFixture, "KNNStreamingQueryTest",
+                 "[KNNMainTest][BindingTests]")
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 100); // 100 points in 3 dimensions.
+
+  arma::mat queryData;
+  queryData.randu(3, 90); // 90 points in 3 dimensions.
+  data::Save("knn_stream_query.csv", queryData);
+  // Search the values that were written, in case any precision was lost.
+  data::Load("knn_stream_query.csv", queryData);
+
+  SetInputParam("reference", referenceData);
+  SetInputParam("query", queryData);
+  SetInputParam("k", (int) 5);
+
+  mlpackMain();
+
+  arma::Mat<size_t> neighbors =
+      std::move(IO::GetParam<arma::Mat<size_t>>("neighbors"));
+  arma::mat distances = std::move(IO::GetParam<arma::mat>("distances"));
+
+  delete IO::GetParam<KNNModel*>("output_model");
+  IO::GetParam<KNNModel*>("output_model") = NULL;
+  IO::GetSingleton().Parameters()["query"].wasPassed = false;
+
+  // Use a chunk size that does not divide the number of query points.
+  SetInputParam("reference", referenceData);
+  SetInputParam("query_stream_file", std::string("knn_stream_query.csv"));
+  SetInputParam("chunk_size", (int) 7);
+  SetInputParam("neighbors_stream_file",
+      std::string("knn_stream_neighbors.csv"));
+  SetInputParam("distances_stream_file",
+      std::string("knn_stream_distances.csv"));
+
+  mlpackMain();
+
+  arma::Mat<size_t> streamedNeighbors;
+  arma::mat streamedDistances;
+  REQUIRE(data::Load("knn_stream_neighbors.csv", streamedNeighbors));
+  REQUIRE(data::Load("knn_stream_distances.csv", streamedDistances));
+
+  CheckMatrices(neighbors, streamedNeighbors);
+  CheckMatrices(distances, streamedDistances);
+
+  remove("knn_stream_query.csv");
+  remove("knn_stream_neighbors.csv");
+  remove("knn_stream_distances.csv");
+}
+
+/**
+ * Ensure that search works with neither a query set nor a query stream file,
+ * using the reference set as the query set.
+ */
+TEST_CASE_METHOD(KNNTestFixture, "KNNMonochromaticNoQueryTest",
+                 "[KNNMainTest][BindingTests]")
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 100); // 100 points in 3 dimensions.
+
+  SetInputParam("reference", std::move(referenceData));
+  SetInputParam("k", (int) 5);
+
+  mlpackMain();
+
+  const arma::Mat<size_t>& neighbors =
+      IO::GetParam<arma::Mat<size_t>>("neighbors");
+  REQUIRE(neighbors.n_rows == 5);
+  REQUIRE(neighbors.n_cols == 100);
+  REQUIRE(IO::GetParam<arma::mat>("distances").n_rows == 5);
+  REQUIRE(IO::GetParam<arma::mat>("distances").n_cols == 100);
+
+  // No point should be returned as its own neighbor.
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+      REQUIRE(neighbors(j, i) != i);
+}
+
+/**
+ * Ensure that passing both a query set and a query stream file is rejected.
+ */
+TEST_CASE_METHOD(KNNTestFixture, "KNNQueryAndQueryStreamTest",
+                 "[KNNMainTest][BindingTests]")
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 100); // 100 points in 3 dimensions.
+  arma::mat queryData;
+  queryData.randu(3, 90); // 90 points in 3 dimensions.
+
+  SetInputParam("reference", std::move(referenceData));
+  SetInputParam("query", std::move(queryData));
+  SetInputParam("query_stream_file", std::string("knn_stream_query.csv"));
+  SetInputParam("k", (int) 5);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
@@ -392,3 +392,64 @@ TEST_CASE_METHOD(LSHTestFixture, "LSHModelTrueNighborsDimTest",
   REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
   Log::Fatal.ignoreInput = false;
 }
+
+/**
+ * Make sure that a probing budget is respected and that the statistics of each
+ * query are returned.
+ */
+TEST_CASE_METHOD(LSHTestFixture, "LSHProbeBudgetTest",
+                 "[LSHMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu<arma::mat>(5, 300);
+  arma::mat query = arma::randu<arma::mat>(5, 40);
+
+  SetInputParam("reference", std::move(reference));
+  SetInputParam("query", std::move(query));
+  SetInputParam("k", (int) 3);
+  SetInputParam("tables", (int) 10);
+  SetInputParam("num_probes", (int) 4);
+  SetInputParam("candidate_target", (int) 20);
+
+  mlpackMain();
+
+  const arma::Mat<size_t>& statistics =
+      IO::GetParam<arma::Mat<size_t>>("probe_statistics");
+  REQUIRE(statistics.n_rows == 3);
+  REQUIRE(statistics.n_cols == 40);
+  for (size_t i = 0; i < statistics.n_cols; ++i)
+  {
+    // Probing stops at the target, unless every bucket has been probed.
+    REQUIRE(statistics(0, i) <= 50);
+    REQUIRE((statistics(2, i) >= 20 || statistics(0, i) == 50));
+    REQUIRE(statistics(2, i) <= statistics(1, i));
+  }
+}
+
+/**
+ * Make sure that the probing budget must not be negative.
+ */
+TEST_CASE_METHOD(LSHTestFixture, "LSHNegativeProbeBudgetTest",
+                 "[LSHMainTest][BindingTests]")
+{
+  arma::mat reference = arma::randu<arma::mat>(5, 100);
+
+  SetInputParam("reference", reference);
+  SetInputParam("k", (int) 3);
+  SetInputParam("candidate_target", (int) -1);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+
+  bindings::tests::CleanMemory();
+  IO::ClearSettings();
+  IO::RestoreSettings(testName);
+
+  SetInputParam("reference", std::move(reference));
+  SetInputParam("k", (int) 3);
+  SetInputParam("time_limit", -1.0);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+}
@@ -249,3 +249,35 @@ TEST_CASE_METHOD(
   REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
   Log::Fatal.ignoreInput = false;
 }
+
+/**
+ * Ensure that the minimum bin frequency must be at least 1, and that a larger
+ * one still gives a label to each point.
+ */
+TEST_CASE_METHOD(
+    MeanShiftTestFixture, "MeanShiftMinBinFrequencyTest",
+    "[MeanShiftMainTest][BindingTests]")
+{
+  arma::mat x;
+  x.randu(3, 100); // 100 points in 3 dimension
+
+  SetInputParam("input", x);
+  SetInputParam("min_bin_frequency", (int) 0);
+
+  Log::Fatal.ignoreInput = true;
+  REQUIRE_THROWS_AS(mlpackMain(), std::runtime_error);
+  Log::Fatal.ignoreInput = false;
+
+  bindings::tests::CleanMemory();
+  IO::ClearSettings();
+  IO::RestoreSettings(testName);
+
+  SetInputParam("input", std::move(x));
+  SetInputParam("min_bin_frequency", (int) 5);
+  SetInputParam("labels_only", true);
+
+  mlpackMain();
+
+  REQUIRE(IO::GetParam<arma::mat>("output").n_rows == 1);
+  REQUIRE(IO::GetParam<arma::mat>("output").n_cols == 100);
+}
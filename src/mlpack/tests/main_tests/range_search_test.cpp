@@ -208,6 +208,58 @@ TEST_CASE_METHOD(RangeSearchTestFixture, "RangeSearchTest",
   remove(distanceFile.c_str());
 }
 
+/**
+ * Check that the results written to results_file as they are found are the
+ * same as the ones stored in neighbors_file and distances_file.
+ */
+TEST_CASE_METHOD(RangeSearchTestFixture, "RangeSearchResultsFileTest",
+                 "[RangeSearchMainTest][BindingTests]")
+{
+  arma::mat x = {{0, 3, 3, 4, 3, 1},
+                 {4, 4, 4, 5, 5, 2},
+                 {0, 1, 2, 2, 3, 3}};
+
+  string resultsFile = "results.csv";
+  double minVal = 0, maxVal = 3;
+  vector<vector<size_t>> neighborVal = {{},
+                                        {2, 3, 4},
+                                        {1, 3, 4, 5},
+                                        {1, 2, 4},
+                                        {1, 2, 3},
+                                        {2}};
+  vector<vector<double>> distanceVal = {{},
+                                        {1, 1.73205, 2.23607},
+                                        {1, 1.41421, 1.41421, 3},
+                                        {1.73205, 1.41421, 1.41421},
+                                        {2.23607, 1.41421, 1.41421},
+                                        {3}};
+
+  SetInputParam("reference", move(x));
+  SetInputParam("min", minVal);
+  SetInputParam("max", maxVal);
+  SetInputParam("results_file", resultsFile);
+
+  mlpackMain();
+
+  // Each line holds one result, in no particular order.
+  vector<vector<double>> results = ReadData<double>(resultsFile);
+  vector<vector<size_t>> neighbors(neighborVal.size());
+  vector<vector<double>> distances(distanceVal.size());
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    REQUIRE(results[i].size() == 3);
+    const size_t query = (size_t) results[i][0];
+    REQUIRE(query < neighbors.size());
+    neighbors[query].push_back((size_t) results[i][1]);
+    distances[query].push_back(results[i][2]);
+  }
+
+  CheckMatrices(neighbors, neighborVal);
+  CheckMatrices(distances, distanceVal);
+
+  remove(resultsFile.c_str());
+}
+
 /**
  * Check that the correct output is returned for a small synthetic input case,
  * when a query set is provided.
@@ -162,3 +162,63 @@ TEST_CASE("GaussianClustering", "[MeanShiftTest]")
 
   REQUIRE(success == true);
 }
+
+/**
+ * Make sure that the three classes of the 30-point dataset are in three
+ * different clusters.
+ */
+void CheckMeanShiftClasses(const arma::Row<size_t>& assignments)
+{
+  for (size_t i = 1; i < 13; ++i)
+    REQUIRE(assignments(i) == assignments(0));
+  for (size_t i = 14; i < 20; ++i)
+    REQUIRE(assignments(i) == assignments(13));
+  for (size_t i = 21; i < 30; ++i)
+    REQUIRE(assignments(i) == assignments(20));
+
+  REQUIRE(assignments(0) != assignments(13));
+  REQUIRE(assignments(0) != assignments(20));
+  REQUIRE(assignments(13) != assignments(20));
+}
+
+/**
+ * Make sure that the classes are found when the centroids are computed with a
+ * kernel.
+ */
+TEST_CASE("MeanShiftKernelTest", "[MeanShiftTest]")
+{
+  MeanShift<true> meanShift(3.0);
+
+  arma::Row<size_t> assignments;
+  arma::mat centroids;
+  meanShift.Cluster((arma::mat) trans(meanShiftData), assignments, centroids);
+
+  REQUIRE(centroids.n_cols == 3);
+  CheckMeanShiftClasses(assignments);
+}
+
+/**
+ * Make sure that the classes are still found with fewer seeds, and that every
+ * point is used as a seed if no bin is large enough.
+ */
+TEST_CASE("MeanShiftMinBinFrequencyTest", "[MeanShiftTest]")
+{
+  const arma::mat data = trans(meanShiftData);
+
+  MeanShift<> meanShift(3.0);
+  meanShift.MinBinFrequency() = 3;
+
+  arma::Row<size_t> assignments;
+  arma::mat centroids;
+  meanShift.Cluster(data, assignments, centroids);
+
+  REQUIRE(centroids.n_cols == 3);
+  CheckMeanShiftClasses(assignments);
+
+  meanShift.MinBinFrequency() = 100;
+  centroids.clear();
+  meanShift.Cluster(data, assignments, centroids);
+
+  REQUIRE(centroids.n_cols == 3);
+  CheckMeanShiftClasses(assignments);
+}
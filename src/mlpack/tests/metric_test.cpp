@@ -71,6 +71,44 @@ TEST_CASE("L2MetricTest", "[MetricTest]")
       Approx(lMetric.Evaluate(a2, b2)).epsilon(1e-7));
 }
 
+/**
+ * Make sure that the batched L-metric distances match Evaluate() to within the
+ * error bound that BatchEvaluate() returns.
+ */
+TEST_CASE("LMetricBatchEvaluateTest", "[MetricTest]")
+{
+  arma::mat a = arma::randn<arma::mat>(7, 30);
+  arma::mat b = arma::randn<arma::mat>(7, 40);
+  // Include an exact duplicate, whose distance must not be negative.
+  b.col(3) = a.col(5);
+
+  arma::mat distances, squaredDistances, l1Distances;
+  const double error = EuclideanDistance::BatchEvaluate(a, b, distances);
+  const double squaredError = SquaredEuclideanDistance::BatchEvaluate(a, b,
+      squaredDistances);
+  const double l1Error = ManhattanDistance::BatchEvaluate(a, b, l1Distances);
+
+  REQUIRE(distances.n_rows == 30);
+  REQUIRE(distances.n_cols == 40);
+  REQUIRE(l1Error == 0.0);
+  for (size_t j = 0; j < b.n_cols; ++j)
+  {
+    for (size_t i = 0; i < a.n_cols; ++i)
+    {
+      REQUIRE(std::abs(distances(i, j) -
+          EuclideanDistance::Evaluate(a.col(i), b.col(j))) <= error);
+      REQUIRE(std::abs(squaredDistances(i, j) -
+          SquaredEuclideanDistance::Evaluate(a.col(i), b.col(j))) <=
+          squaredError);
+      REQUIRE(l1Distances(i, j) ==
+          ManhattanDistance::Evaluate(a.col(i), b.col(j)));
+    }
+  }
+
+  REQUIRE(distances(5, 3) >= 0.0);
+  REQUIRE(distances(5, 3) <= error);
+}
+
 /**
  * Simple test for L-Infinity metric.
  */
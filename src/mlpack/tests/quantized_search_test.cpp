@@ -0,0 +1,257 @@
+/**
+ * @file tests/quantized_search_test.cpp
+ *
+ * Tests for the quantizers and the QuantizedSearch class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/quantized_search.hpp>
+#include "catch.hpp"
+#include "serialization_catch.hpp"
+#include "test_catch_tools.hpp"
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+/**
+ * Make sure that the scalar quantizer approximates every value within half a
+ * level, and that its distance tables give the distance to the decoded point.
+ */
+TEST_CASE("ScalarQuantizerTest", "[QuantizedSearchTest]")
+{
+  arma::mat data = arma::randu<arma::mat>(6, 200);
+  data.row(2) *= 100.0;
+  data.row(5).fill(3.0);
+
+  ScalarQuantizer quantizer;
+  quantizer.Train(data);
+  REQUIRE(quantizer.CodeSize() == 6);
+
+  arma::Mat<unsigned char> codes;
+  quantizer.Encode(data, codes);
+  arma::mat decoded;
+  quantizer.Decode(codes, decoded);
+
+  REQUIRE(decoded.n_rows == data.n_rows);
+  REQUIRE(decoded.n_cols == data.n_cols);
+  for (size_t j = 0; j < data.n_rows; ++j)
+  {
+    const double halfLevel = 0.5 * quantizer.Widths()[j];
+    REQUIRE(arma::max(arma::abs(decoded.row(j) - data.row(j))) <=
+        halfLevel + 1e-10);
+  }
+
+  const arma::vec query = arma::randu<arma::vec>(6);
+  arma::mat table;
+  quantizer.DistanceTable(query, table);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    REQUIRE(quantizer.Distance(table, codes.colptr(i)) ==
+        Approx(arma::accu(arma::square(query - decoded.col(i))))
+        .epsilon(1e-7));
+  }
+}
+
+/**
+ * Make sure that the product quantizer encodes points with one byte per
+ * subspace, and that its distance tables give the distance to the decoded
+ * point.
+ */
+TEST_CASE("ProductQuantizerTest", "[QuantizedSearchTest]")
+{
+  arma::mat data = arma::randu<arma::mat>(10, 500);
+
+  // The subspaces do not need to divide the dimensionality.
+  ProductQuantizer quantizer(4);
+  quantizer.Train(data);
+  REQUIRE(quantizer.CodeSize() == 4);
+
+  arma::Mat<unsigned char> codes;
+  quantizer.Encode(data, codes);
+  REQUIRE(codes.n_rows == 4);
+  REQUIRE(codes.n_cols == data.n_cols);
+
+  arma::mat decoded;
+  quantizer.Decode(codes, decoded);
+  REQUIRE(decoded.n_rows == data.n_rows);
+
+  // Every point is encoded with the closest centroid of each subspace, so the
+  // reconstruction must be better than that of the mean.
+  arma::mat centered = data.each_col() - arma::mean(data, 1);
+  REQUIRE(arma::accu(arma::square(decoded - data)) <
+      0.5 * arma::accu(arma::square(centered)));
+
+  const arma::vec query = arma::randu<arma::vec>(10);
+  arma::mat table;
+  quantizer.DistanceTable(query, table);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    REQUIRE(quantizer.Distance(table, codes.colptr(i)) ==
+        Approx(arma::accu(arma::square(query - decoded.col(i))))
+        .epsilon(1e-7));
+  }
+
+  ProductQuantizer tooManySubspaces(11);
+  REQUIRE_THROWS_AS(tooManySubspaces.Train(data), std::invalid_argument);
+}
+
+/**
+ * When every cell is scanned and every point is re-ranked, the search must be
+ * exact, whichever mode the coarse search uses.
+ */
+template<typename CoarseSearchType>
+void CheckExactSearch(CoarseSearchType coarseSearch)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(8, 400);
+  arma::mat queryData = arma::randu<arma::mat>(8, 50);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(queryData, 5, trueNeighbors, trueDistances);
+
+  QuantizedSearch<ProductQuantizer, CoarseSearchType> search(referenceData, 10,
+      ProductQuantizer(4), coarseSearch);
+  search.Probes() = 10;
+  search.Shortlist() = referenceData.n_cols;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  search.Search(queryData, referenceData, 5, neighbors, distances);
+
+  CheckMatrices(neighbors, trueNeighbors);
+  CheckMatrices(distances, trueDistances);
+}
+
+TEST_CASE("QuantizedSearchExactTest", "[QuantizedSearchTest]")
+{
+  CheckExactSearch(KNN(SINGLE_TREE_MODE));
+  CheckExactSearch(KNN(NAIVE_MODE));
+}
+
+/**
+ * Make sure that the search finds most of the true neighbors with only a few
+ * probed cells, both with and without re-ranking, and with both quantizers.
+ */
+TEST_CASE("QuantizedSearchRecallTest", "[QuantizedSearchTest]")
+{
+  const size_t k = 10;
+  arma::mat referenceData = arma::randu<arma::mat>(16, 3000);
+  arma::mat queryData = arma::randu<arma::mat>(16, 100);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(queryData, k, trueNeighbors, trueDistances);
+
+  QuantizedSearch<> pqSearch(referenceData, 16, ProductQuantizer(8),
+      KNN(SINGLE_TREE_MODE));
+  pqSearch.Probes() = 8;
+  pqSearch.Shortlist() = 200;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  pqSearch.Search(queryData, k, neighbors, distances);
+  const double adcRecall = LSHSearch<>::ComputeRecall(neighbors,
+      trueNeighbors);
+  REQUIRE(adcRecall >= 0.3);
+
+  pqSearch.Search(queryData, referenceData, k, neighbors, distances);
+  const double rerankedRecall = LSHSearch<>::ComputeRecall(neighbors,
+      trueNeighbors);
+  REQUIRE(rerankedRecall >= 0.8);
+  REQUIRE(rerankedRecall >= adcRecall);
+
+  // LSH may miss some of the closest cells, but the closest one is always
+  // scanned.
+  QuantizedSearch<ProductQuantizer, LSHSearch<>> lshSearch(referenceData, 16,
+      ProductQuantizer(8));
+  lshSearch.Probes() = 8;
+  lshSearch.Shortlist() = 200;
+  lshSearch.Search(queryData, referenceData, k, neighbors, distances);
+  REQUIRE(LSHSearch<>::ComputeRecall(neighbors, trueNeighbors) >= 0.5);
+
+  // The scalar quantizer is much more accurate, with 16 bytes per point.
+  QuantizedSearch<ScalarQuantizer> sqSearch(referenceData, 1);
+  REQUIRE(sqSearch.Quantizer().CodeSize() == 16);
+  sqSearch.Search(queryData, k, neighbors, distances);
+  REQUIRE(LSHSearch<>::ComputeRecall(neighbors, trueNeighbors) >= 0.8);
+}
+
+/**
+ * Make sure that points added in chunks get the same indices and results as
+ * points added at once.
+ */
+TEST_CASE("QuantizedSearchAddTest", "[QuantizedSearchTest]")
+{
+  arma::mat referenceData = arma::randu<arma::mat>(6, 600);
+  arma::mat queryData = arma::randu<arma::mat>(6, 30);
+
+  QuantizedSearch<ScalarQuantizer> search(ScalarQuantizer(),
+      KNN(SINGLE_TREE_MODE));
+  REQUIRE_THROWS_AS(search.Add(referenceData), std::invalid_argument);
+
+  search.Train(referenceData, 5);
+  search.Probes() = 2;
+  QuantizedSearch<ScalarQuantizer> chunkedSearch(search);
+
+  search.Add(referenceData);
+  for (size_t i = 0; i < referenceData.n_cols; i += 250)
+  {
+    chunkedSearch.Add(referenceData.cols(i,
+        std::min(i + 250, (size_t) referenceData.n_cols) - 1));
+  }
+  REQUIRE(chunkedSearch.Size() == referenceData.n_cols);
+
+  arma::Mat<size_t> neighbors, chunkedNeighbors;
+  arma::mat distances, chunkedDistances;
+  search.Search(queryData, 4, neighbors, distances);
+  chunkedSearch.Search(queryData, 4, chunkedNeighbors, chunkedDistances);
+
+  CheckMatrices(neighbors, chunkedNeighbors);
+  CheckMatrices(distances, chunkedDistances);
+
+  REQUIRE_THROWS_AS(search.Add(arma::mat(5, 10, arma::fill::randu)),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(search.Search(queryData, referenceData.cols(0, 9), 4,
+      neighbors, distances), std::invalid_argument);
+  REQUIRE_THROWS_AS(search.Search(queryData, 601, neighbors, distances),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that a serialized model gives the same results as the original.
+ */
+TEST_CASE("QuantizedSearchSerializationTest", "[QuantizedSearchTest]")
+{
+  arma::mat referenceData = arma::randu<arma::mat>(8, 300);
+  arma::mat queryData = arma::randu<arma::mat>(8, 20);
+
+  QuantizedSearch<> search(referenceData, 4, ProductQuantizer(4));
+  search.Probes() = 2;
+  QuantizedSearch<> xmlSearch, jsonSearch, binarySearch;
+
+  SerializeObjectAll(search, xmlSearch, jsonSearch, binarySearch);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  search.Search(queryData, 3, neighbors, distances);
+
+  for (QuantizedSearch<>* model : { &xmlSearch, &jsonSearch, &binarySearch })
+  {
+    REQUIRE(model->Size() == search.Size());
+    REQUIRE(model->NumCells() == search.NumCells());
+    REQUIRE(model->Probes() == search.Probes());
+    CheckMatrices(model->Centroids(), search.Centroids());
+
+    arma::Mat<size_t> modelNeighbors;
+    arma::mat modelDistances;
+    model->Search(queryData, 3, modelNeighbors, modelDistances);
+    CheckMatrices(modelNeighbors, neighbors);
+    CheckMatrices(modelDistances, distances);
+  }
+}
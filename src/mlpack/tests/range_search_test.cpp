@@ -1714,3 +1714,183 @@ TEST_CASE("MoveOperatorNaiveTest", "[RangeSearchTest]")
     }
   }
 }
+
+/**
+ * Make sure that the compact output and the counts match the results of the
+ * search into vectors.
+ */
+template<typename RSType>
+void CheckCompactOutput(RSType& rs, const arma::mat& querySet)
+{
+  const Range range(0.1, 0.3);
+  vector<vector<size_t>> neighbors;
+  vector<vector<double>> distances;
+  arma::Col<size_t> offsets, flatNeighbors, counts;
+  arma::vec flatDistances;
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    // The first trial is bichromatic, the second is monochromatic.
+    if (trial == 0)
+    {
+      rs.Search(querySet, range, neighbors, distances);
+      rs.Search(querySet, range, offsets, flatNeighbors, flatDistances);
+      rs.Count(querySet, range, counts);
+    }
+    else
+    {
+      rs.Search(range, neighbors, distances);
+      rs.Search(range, offsets, flatNeighbors, flatDistances);
+      rs.Count(range, counts);
+    }
+
+    vector<vector<pair<double, size_t>>> sorted;
+    SortResults(neighbors, distances, sorted);
+
+    REQUIRE(offsets.n_elem == neighbors.size() + 1);
+    REQUIRE(counts.n_elem == neighbors.size());
+    REQUIRE(offsets[offsets.n_elem - 1] == flatNeighbors.n_elem);
+    REQUIRE(flatDistances.n_elem == flatNeighbors.n_elem);
+    for (size_t i = 0; i < neighbors.size(); ++i)
+    {
+      REQUIRE(counts[i] == neighbors[i].size());
+      REQUIRE(offsets[i + 1] - offsets[i] == neighbors[i].size());
+
+      vector<pair<double, size_t>> flatSorted;
+      for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+        flatSorted.push_back(make_pair(flatDistances[j], flatNeighbors[j]));
+      sort(flatSorted.begin(), flatSorted.end());
+
+      for (size_t j = 0; j < flatSorted.size(); ++j)
+      {
+        REQUIRE(flatSorted[j].second == sorted[i][j].second);
+        REQUIRE(flatSorted[j].first ==
+            Approx(sorted[i][j].first).epsilon(1e-7));
+      }
+    }
+  }
+}
+
+TEST_CASE("RangeSearchCompactOutputTest", "[RangeSearchTest]")
+{
+  arma::mat referenceSet = arma::randu<arma::mat>(3, 800);
+  arma::mat querySet = arma::randu<arma::mat>(3, 300);
+
+  RangeSearch<> dualTree(referenceSet);
+  CheckCompactOutput(dualTree, querySet);
+  RangeSearch<> singleTree(referenceSet, false, true);
+  CheckCompactOutput(singleTree, querySet);
+  RangeSearch<> naive(referenceSet, true);
+  CheckCompactOutput(naive, querySet);
+
+  RangeSearch<EuclideanDistance, arma::mat, StandardCoverTree>
+      coverTree(referenceSet);
+  CheckCompactOutput(coverTree, querySet);
+  RangeSearch<EuclideanDistance, arma::mat, StandardCoverTree>
+      singleCoverTree(referenceSet, false, true);
+  CheckCompactOutput(singleCoverTree, querySet);
+}
+
+/**
+ * Make sure that the (parallel) searches of every mode count the same results
+ * as the naive search.
+ */
+TEST_CASE("RangeSearchParallelVsNaive", "[RangeSearchTest]")
+{
+  arma::mat referenceSet = arma::randu<arma::mat>(4, 2000);
+  arma::mat querySet = arma::randu<arma::mat>(4, 1000);
+  const Range range(0.05, 0.25);
+
+  RangeSearch<> naive(referenceSet, true);
+  arma::Col<size_t> naiveCounts;
+  naive.Count(querySet, range, naiveCounts);
+  REQUIRE(arma::accu(naiveCounts) > 0);
+
+  RangeSearch<> dualTree(referenceSet);
+  RangeSearch<> singleTree(referenceSet, false, true);
+  RangeSearch<EuclideanDistance, arma::mat, BallTree> ballTree(referenceSet);
+  for (RangeSearch<>* rs : { &dualTree, &singleTree })
+  {
+    arma::Col<size_t> counts;
+    rs->Count(querySet, range, counts);
+    CheckMatrices(counts, naiveCounts);
+  }
+
+  arma::Col<size_t> ballCounts;
+  ballTree.Count(querySet, range, ballCounts);
+  CheckMatrices(ballCounts, naiveCounts);
+
+  // The base cases must be counted over every thread.
+  REQUIRE(naive.BaseCases() == referenceSet.n_cols * querySet.n_cols);
+  REQUIRE(dualTree.BaseCases() > 0);
+  REQUIRE(dualTree.BaseCases() < naive.BaseCases());
+}
+
+/**
+ * Make sure that the results given to a callback are the same as the results
+ * that are stored, for bichromatic and monochromatic search.
+ */
+template<typename RangeSearchType>
+void CheckCallbackOutput(RangeSearchType& rs,
+                         const arma::mat& querySet,
+                         const bool monochromatic)
+{
+  const Range range(0.1, 0.3);
+  const size_t numQueries = monochromatic ? rs.ReferenceSet().n_cols :
+      querySet.n_cols;
+
+  vector<vector<size_t>> neighbors, callbackNeighbors(numQueries);
+  vector<vector<double>> distances, callbackDistances(numQueries);
+  auto callback = [&](const size_t query, const size_t reference,
+      const double distance)
+  {
+    // The results of different queries may be given by different threads.
+    #pragma omp critical
+    {
+      callbackNeighbors[query].push_back(reference);
+      callbackDistances[query].push_back(distance);
+    }
+  };
+
+  if (monochromatic)
+  {
+    rs.Search(range, neighbors, distances);
+    rs.Search(range, callback);
+  }
+  else
+  {
+    rs.Search(querySet, range, neighbors, distances);
+    rs.Search(querySet, range, callback);
+  }
+
+  vector<vector<pair<double, size_t>>> sorted, callbackSorted;
+  SortResults(neighbors, distances, sorted);
+  SortResults(callbackNeighbors, callbackDistances, callbackSorted);
+
+  REQUIRE(callbackSorted.size() == sorted.size());
+  for (size_t i = 0; i < sorted.size(); ++i)
+  {
+    REQUIRE(callbackSorted[i].size() == sorted[i].size());
+    for (size_t j = 0; j < sorted[i].size(); ++j)
+    {
+      REQUIRE(callbackSorted[i][j].second == sorted[i][j].second);
+      REQUIRE(callbackSorted[i][j].first ==
+          Approx(sorted[i][j].first).epsilon(1e-7));
+    }
+  }
+}
+
+TEST_CASE("RangeSearchCallbackTest", "[RangeSearchTest]")
+{
+  arma::mat referenceSet = arma::randu<arma::mat>(3, 600);
+  arma::mat querySet = arma::randu<arma::mat>(3, 200);
+
+  RangeSearch<> dualTree(referenceSet);
+  RangeSearch<> singleTree(referenceSet, false, true);
+  RangeSearch<> naive(referenceSet, true);
+  for (RangeSearch<>* rs : { &dualTree, &singleTree, &naive })
+  {
+    CheckCallbackOutput(*rs, querySet, false);
+    CheckCallbackOutput(*rs, querySet, true);
+  }
+}
@@ -2287,3 +2287,257 @@ TEST_CASE("CoverTreeDescendantTest", "[TreeTest]")
   // using the recursive function above.
   CheckDescendants(&tree);
 }
+
+// Recursively checks that two trees built on the same dataset are identical.
+template<typename TreeType>
+void CheckSameTree(const TreeType& a, const TreeType& b)
+{
+  REQUIRE(a.Begin() == b.Begin());
+  REQUIRE(a.Count() == b.Count());
+  REQUIRE(a.NumChildren() == b.NumChildren());
+  REQUIRE(a.ParentDistance() == Approx(b.ParentDistance()).epsilon(1e-7));
+  REQUIRE(a.FurthestDescendantDistance() ==
+      Approx(b.FurthestDescendantDistance()).epsilon(1e-7));
+
+  for (size_t i = 0; i < a.NumChildren(); ++i)
+  {
+    REQUIRE(a.Child(i).Parent() == &a);
+    CheckSameTree(a.Child(i), b.Child(i));
+  }
+}
+
+/**
+ * Make sure that freezing a kd-tree does not change it, and that frozen trees
+ * can be copied and moved.
+ */
+TEST_CASE("BinarySpaceTreeFreezeTest", "[TreeTest]")
+{
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+
+  arma::mat dataset;
+  dataset.randu(5, 1000);
+
+  TreeType tree(dataset);
+  TreeType frozenTree(tree);
+  REQUIRE(!frozenTree.IsFrozen());
+
+  frozenTree.Freeze();
+  REQUIRE(frozenTree.IsFrozen());
+  REQUIRE(frozenTree.Left()->IsFrozen());
+  CheckSameTree(tree, frozenTree);
+
+  // The bounds must not have changed.
+  std::stack<std::pair<TreeType*, TreeType*>> nodeStack;
+  nodeStack.push(std::make_pair(&tree, &frozenTree));
+  while (!nodeStack.empty())
+  {
+    TreeType* node = nodeStack.top().first;
+    TreeType* frozenNode = nodeStack.top().second;
+    nodeStack.pop();
+
+    REQUIRE(node->Bound().Dim() == frozenNode->Bound().Dim());
+    for (size_t d = 0; d < node->Bound().Dim(); ++d)
+    {
+      REQUIRE(node->Bound()[d].Lo() == frozenNode->Bound()[d].Lo());
+      REQUIRE(node->Bound()[d].Hi() == frozenNode->Bound()[d].Hi());
+    }
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      nodeStack.push(std::make_pair(&node->Child(i), &frozenNode->Child(i)));
+  }
+
+  // A copy of a frozen tree is an ordinary tree.
+  TreeType copiedTree(frozenTree);
+  REQUIRE(!copiedTree.IsFrozen());
+  CheckSameTree(tree, copiedTree);
+
+  // Moving a frozen tree keeps it frozen.
+  TreeType movedTree(std::move(frozenTree));
+  REQUIRE(movedTree.IsFrozen());
+  REQUIRE(!frozenTree.IsFrozen());
+  CheckSameTree(tree, movedTree);
+
+  // Only the root can be frozen.
+  REQUIRE_THROWS_AS(tree.Left()->Freeze(), std::invalid_argument);
+}
+
+// Check that every node of a tree that has been modified holds a contiguous
+// range of the points of its parent, and that its bound contains its points.
+template<typename TreeType>
+void CheckModifiedTree(const TreeType& node, const size_t maxLeafSize)
+{
+  for (size_t i = 0; i < node.NumPoints(); ++i)
+    REQUIRE(node.Bound().Contains(node.Dataset().col(node.Point(i))));
+
+  if (node.IsLeaf())
+  {
+    // A leaf may only hold too many points if they cannot be split.
+    if (node.Count() > maxLeafSize)
+    {
+      const arma::mat points = node.Dataset().cols(node.Begin(),
+          node.Begin() + node.Count() - 1);
+      REQUIRE(arma::all(arma::vectorise(points.each_col() -
+          points.col(0)) == 0));
+    }
+    return;
+  }
+
+  REQUIRE(node.Left()->Parent() == &node);
+  REQUIRE(node.Right()->Parent() == &node);
+  REQUIRE(node.Left()->Begin() == node.Begin());
+  REQUIRE(node.Right()->Begin() == node.Begin() + node.Left()->Count());
+  REQUIRE(node.Left()->Count() + node.Right()->Count() == node.Count());
+
+  CheckModifiedTree(*node.Left(), maxLeafSize);
+  CheckModifiedTree(*node.Right(), maxLeafSize);
+}
+
+/**
+ * Insert points into and remove points from a kd-tree, and make sure that the
+ * tree stays valid and that the mapping tracks the points.
+ */
+TEST_CASE("BinarySpaceTreeInsertRemoveTest", "[TreeTest]")
+{
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew, 10);
+
+  // Insert points from a shifted distribution, so that some subtrees become
+  // unbalanced.
+  arma::mat points;
+  points.randu(3, 1500);
+  points.row(0) += 0.5;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    tree.Insert(points.cols(500 * i, 500 * i + 499), oldFromNew, 10);
+    REQUIRE(tree.Count() == 1500 + 500 * i);
+    CheckModifiedTree(tree, 10);
+  }
+
+  arma::mat original = arma::join_rows(dataset, points);
+  REQUIRE(tree.Dataset().n_cols == original.n_cols);
+  REQUIRE(oldFromNew.size() == original.n_cols);
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    REQUIRE(arma::approx_equal(tree.Dataset().col(i),
+        original.col(oldFromNew[i]), "absdiff", 0.0));
+
+  // Now remove every third point of the original dataset.
+  std::vector<size_t> removed;
+  std::vector<size_t> newFromOld(oldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    newFromOld[oldFromNew[i]] = i;
+  for (size_t i = 0; i < original.n_cols; i += 3)
+    removed.push_back(newFromOld[i]);
+
+  tree.Remove(removed, oldFromNew, 10);
+  CheckModifiedTree(tree, 10);
+
+  for (size_t i = original.n_cols; i > 0; --i)
+    if ((i - 1) % 3 == 0)
+      original.shed_col(i - 1);
+
+  REQUIRE(tree.Count() == original.n_cols);
+  REQUIRE(oldFromNew.size() == original.n_cols);
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    REQUIRE(arma::approx_equal(tree.Dataset().col(i),
+        original.col(oldFromNew[i]), "absdiff", 0.0));
+
+  // Removing every point leaves an empty leaf.
+  std::vector<size_t> all(oldFromNew.size());
+  for (size_t i = 0; i < all.size(); ++i)
+    all[i] = i;
+  tree.Remove(all, oldFromNew, 10);
+  REQUIRE(tree.IsLeaf());
+  REQUIRE(tree.Count() == 0);
+  REQUIRE(oldFromNew.empty());
+
+  // Frozen trees and nodes other than the root cannot be modified.
+  std::vector<size_t> frozenOldFromNew;
+  TreeType frozenTree(dataset, frozenOldFromNew);
+  frozenTree.Freeze();
+  REQUIRE_THROWS_AS(frozenTree.Insert(points, frozenOldFromNew),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(frozenTree.Remove(removed, frozenOldFromNew),
+      std::invalid_argument);
+
+  std::vector<size_t> otherOldFromNew;
+  TreeType otherTree(dataset, otherOldFromNew);
+  REQUIRE_THROWS_AS(otherTree.Left()->Insert(points, otherOldFromNew),
+      std::invalid_argument);
+}
+
+// These tests are only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+
+// Build a tree with one thread and with all threads, and make sure the results
+// are the same.
+template<typename TreeType>
+void CheckParallelBuild(const arma::mat& dataset)
+{
+  std::vector<size_t> sequentialOldFromNew, parallelOldFromNew;
+
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  TreeType sequentialTree(dataset, sequentialOldFromNew);
+  omp_set_num_threads(std::max(prevNumThreads, (size_t) 4));
+  TreeType parallelTree(dataset, parallelOldFromNew);
+  omp_set_num_threads(prevNumThreads);
+
+  // Since the mappings are the same, the datasets are ordered the same way.
+  REQUIRE(sequentialOldFromNew == parallelOldFromNew);
+  CheckSameTree(sequentialTree, parallelTree);
+}
+
+/**
+ * Make sure that trees with deterministic splits are the same whether or not
+ * their children are built in parallel.
+ */
+TEST_CASE("ParallelBinarySpaceTreeBuildTest", "[TreeTest]")
+{
+  // Use enough points that the nodes near the root are built in parallel.
+  arma::mat dataset;
+  dataset.randu(4, 5 * KDTree<EuclideanDistance, EmptyStatistic,
+      arma::mat>::ParallelBuildThreshold);
+
+  CheckParallelBuild<KDTree<EuclideanDistance, EmptyStatistic, arma::mat>>(
+      dataset);
+  CheckParallelBuild<MeanSplitKDTree<EuclideanDistance, EmptyStatistic,
+      arma::mat>>(dataset);
+  CheckParallelBuild<BallTree<EuclideanDistance, EmptyStatistic, arma::mat>>(
+      dataset);
+  CheckParallelBuild<UBTree<EuclideanDistance, EmptyStatistic, arma::mat>>(
+      dataset);
+}
+
+/**
+ * Make sure that trees with random splits are valid when their children are
+ * built in parallel.
+ */
+TEST_CASE("ParallelRandomBinarySpaceTreeBuildTest", "[TreeTest]")
+{
+  arma::mat dataset;
+  dataset.randu(4, 5 * KDTree<EuclideanDistance, EmptyStatistic,
+      arma::mat>::ParallelBuildThreshold);
+
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(std::max(prevNumThreads, (size_t) 4));
+
+  VPTree<EuclideanDistance, EmptyStatistic, arma::mat> vpTree(dataset);
+  MaxRPTree<EuclideanDistance, EmptyStatistic, arma::mat> maxRPTree(dataset);
+  RPTree<EuclideanDistance, EmptyStatistic, arma::mat> rpTree(dataset);
+
+  omp_set_num_threads(prevNumThreads);
+
+  REQUIRE(vpTree.NumDescendants() == dataset.n_cols);
+  REQUIRE(maxRPTree.NumDescendants() == dataset.n_cols);
+  REQUIRE(rpTree.NumDescendants() == dataset.n_cols);
+
+  REQUIRE(CheckPointBounds(vpTree));
+  REQUIRE(CheckPointBounds(maxRPTree));
+  REQUIRE(CheckPointBounds(rpTree));
+}
+#endif
@@ -10,6 +10,7 @@
  * http://www.opensource.org/licenses/BSD-3-Clause for more information.
  */
 #include <mlpack/methods/emst/union_find.hpp>
+#include <mlpack/methods/emst/concurrent_union_find.hpp>
 
 #include <mlpack/core.hpp>
 #include "catch.hpp"
@@ -47,3 +48,53 @@ TEST_CASE("TestUnion", "[UnionFindTest]")
   REQUIRE(testUnionFind.Find(1) == testUnionFind.Find(5));
   REQUIRE(testUnionFind.Find(6) == testUnionFind.Find(3));
 }
+
+TEST_CASE("TestConcurrentUnion", "[UnionFindTest]")
+{
+  static const size_t testSize = 10;
+  ConcurrentUnionFind testUnionFind(testSize);
+
+  for (size_t i = 0; i < testSize; ++i)
+    REQUIRE(testUnionFind.Find(i) == i);
+
+  REQUIRE(testUnionFind.Union(0, 1));
+  REQUIRE(testUnionFind.Union(2, 3));
+  REQUIRE(testUnionFind.Union(0, 2));
+  REQUIRE(testUnionFind.Union(5, 0));
+  REQUIRE(testUnionFind.Union(0, 6));
+  REQUIRE(!testUnionFind.Union(6, 3));
+
+  // The root of a component is its smallest index.
+  REQUIRE(testUnionFind.Find(6) == 0);
+  REQUIRE(testUnionFind.Find(3) == 0);
+  REQUIRE(testUnionFind.Find(4) == 4);
+}
+
+/**
+ * Unite points from several threads at once, and make sure that exactly the
+ * unions that connect two components succeed.
+ */
+TEST_CASE("TestConcurrentUnionParallel", "[UnionFindTest]")
+{
+  static const size_t testSize = 10000;
+  ConcurrentUnionFind testUnionFind(testSize);
+
+  // Connect every point to its neighbor in both directions, in a random order,
+  // so that only the first union of each pair succeeds and the points form
+  // one component.
+  arma::uvec order = arma::randperm(2 * (testSize - 1));
+  size_t successes = 0;
+  #pragma omp parallel for reduction(+:successes)
+  for (omp_size_t i = 0; i < (omp_size_t) order.n_elem; ++i)
+  {
+    const size_t pair = order[i] / 2;
+    const bool forward = (order[i] % 2 == 0);
+    if (testUnionFind.Union(forward ? pair : pair + 1,
+                            forward ? pair + 1 : pair))
+      ++successes;
+  }
+
+  REQUIRE(successes == testSize - 1);
+  for (size_t i = 0; i < testSize; ++i)
+    REQUIRE(testUnionFind.Find(i) == 0);
+}